@@ -0,0 +1,164 @@
+#include "core/gpu_sw_backend.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <memory>
+#include <random>
+
+namespace {
+
+class GPUSWBackendTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Without Initialize(), the backends don't start any threads and execute commands as they are pushed.
+    m_scalar = std::make_unique<GPU_SW_Backend>();
+    m_scalar->SetVectorSpanWidth(0);
+    m_vector = std::make_unique<GPU_SW_Backend>();
+  }
+
+  // Draws random polygons with both backends, the vector one limited to vector_span_width pixels.
+  void DrawAndCompare(u32 vector_span_width)
+  {
+    m_vector->SetVectorSpanWidth(vector_span_width);
+    for (u32 batch = 0; batch < 32; batch++)
+    {
+      FillVRAM();
+      SetDrawingArea();
+      for (u32 i = 0; i < 64; i++)
+        DrawRandomPolygon();
+
+      ASSERT_TRUE(VRAMMatches()) << "batch " << batch;
+    }
+  }
+
+  template<typename T>
+  u32 Random(T max)
+  {
+    return std::uniform_int_distribution<u32>(0, static_cast<u32>(max))(m_random);
+  }
+
+  void FillVRAM()
+  {
+    u16* scalar_vram = m_scalar->GetVRAM();
+    u16* vector_vram = m_vector->GetVRAM();
+    for (u32 i = 0; i < VRAM_WIDTH * VRAM_HEIGHT; i++)
+      scalar_vram[i] = vector_vram[i] = static_cast<u16>(Random(0xFFFF));
+  }
+
+  void SetDrawingArea()
+  {
+    Common::Rectangle<u32> area;
+    area.left = Random(VRAM_WIDTH - 1);
+    area.top = Random(VRAM_HEIGHT - 1);
+    area.right = area.left + Random(VRAM_WIDTH - 1 - area.left);
+    area.bottom = area.top + Random(VRAM_HEIGHT - 1 - area.top);
+
+    for (GPU_SW_Backend* backend : {m_scalar.get(), m_vector.get()})
+    {
+      GPUBackendSetDrawingAreaCommand* cmd = backend->NewSetDrawingAreaCommand();
+      cmd->params.bits = 0;
+      cmd->new_area = area;
+      backend->PushCommand(cmd);
+    }
+  }
+
+  void DrawRandomPolygon()
+  {
+    GPUBackendCommandParameters params;
+    params.bits = static_cast<u8>(Random(0x0F));
+
+    GPURenderCommand rc;
+    rc.bits = 0;
+    rc.primitive = GPUPrimitive::Polygon;
+    rc.quad_polygon = (Random(1) != 0);
+    rc.shading_enable = (Random(1) != 0);
+    rc.texture_enable = (Random(1) != 0);
+    rc.raw_texture_enable = (Random(1) != 0);
+    rc.transparency_enable = (Random(1) != 0);
+
+    GPUDrawModeReg draw_mode;
+    draw_mode.bits = static_cast<u16>(Random(GPUDrawModeReg::MASK));
+
+    GPUTexturePaletteReg palette;
+    palette.bits = static_cast<u16>(Random(GPUTexturePaletteReg::MASK));
+
+    GPUTextureWindow window = {0xFF, 0xFF, 0x00, 0x00};
+    if (Random(1) != 0)
+    {
+      const u32 mask_x = Random(0x1F);
+      const u32 mask_y = Random(0x1F);
+      window.and_x = static_cast<u8>(~(mask_x * 8u));
+      window.and_y = static_cast<u8>(~(mask_y * 8u));
+      window.or_x = static_cast<u8>((Random(0x1F) & mask_x) * 8u);
+      window.or_y = static_cast<u8>((Random(0x1F) & mask_y) * 8u);
+    }
+
+    // Keep the polygon small enough that the GPU wouldn't cull it, anywhere in VRAM.
+    const u32 num_vertices = rc.quad_polygon ? 4 : 3;
+    const s32 base_x = static_cast<s32>(Random(VRAM_WIDTH - 1)) - 128;
+    const s32 base_y = static_cast<s32>(Random(VRAM_HEIGHT - 1)) - 128;
+    GPUBackendDrawPolygonCommand::Vertex vertices[4];
+    for (u32 i = 0; i < num_vertices; i++)
+    {
+      vertices[i].x = base_x + static_cast<s32>(Random(255));
+      vertices[i].y = base_y + static_cast<s32>(Random(255));
+      vertices[i].color = Random(0xFFFFFF);
+      vertices[i].texcoord = static_cast<u16>(Random(0xFFFF));
+    }
+
+    for (GPU_SW_Backend* backend : {m_scalar.get(), m_vector.get()})
+    {
+      GPUBackendDrawPolygonCommand* cmd = backend->NewDrawPolygonCommand(num_vertices);
+      cmd->params.bits = params.bits;
+      cmd->draw_mode.bits = draw_mode.bits;
+      cmd->rc.bits = rc.bits;
+      cmd->palette.bits = palette.bits;
+      cmd->window = window;
+      cmd->num_vertices = static_cast<u16>(num_vertices);
+      std::memcpy(cmd->vertices, vertices, sizeof(GPUBackendDrawPolygonCommand::Vertex) * num_vertices);
+      backend->PushCommand(cmd);
+    }
+  }
+
+  ::testing::AssertionResult VRAMMatches()
+  {
+    m_scalar->Sync();
+    m_vector->Sync();
+
+    const u16* scalar_vram = m_scalar->GetVRAM();
+    const u16* vector_vram = m_vector->GetVRAM();
+    for (u32 i = 0; i < VRAM_WIDTH * VRAM_HEIGHT; i++)
+    {
+      if (scalar_vram[i] != vector_vram[i])
+      {
+        return ::testing::AssertionFailure() << "pixel " << (i % VRAM_WIDTH) << "," << (i / VRAM_WIDTH) << " is "
+                                             << vector_vram[i] << ", expected " << scalar_vram[i];
+      }
+    }
+
+    return ::testing::AssertionSuccess();
+  }
+
+  std::unique_ptr<GPU_SW_Backend> m_scalar;
+  std::unique_ptr<GPU_SW_Backend> m_vector;
+  std::mt19937 m_random{12345};
+};
+
+} // namespace
+
+TEST_F(GPUSWBackendTest, VectorSpansMatchScalarSpans)
+{
+  if (GPU_SW_Backend::GetMaxVectorSpanWidth() < 8)
+    GTEST_SKIP();
+
+  DrawAndCompare(8);
+}
+
+TEST_F(GPUSWBackendTest, WideVectorSpansMatchScalarSpans)
+{
+  if (GPU_SW_Backend::GetMaxVectorSpanWidth() < 16)
+    GTEST_SKIP();
+
+  DrawAndCompare(16);
+}
@@ -0,0 +1,134 @@
+#include "common/jit_code_buffer.h"
+#include "core/cpu_code_cache.h"
+#include "core/cpu_core.h"
+#include "core/cpu_recompiler_code_generator.h"
+#include "core/gte.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+#if defined(WITH_RECOMPILER) && (defined(CPU_X64) || defined(CPU_AARCH64))
+
+namespace {
+
+class GTERecompilerTest : public testing::Test
+{
+protected:
+  static constexpr u32 CODE_SIZE = 16 * 1024 * 1024;
+  static constexpr u32 FAR_CODE_SIZE = 1024 * 1024;
+  static constexpr u32 BLOCK_PC = 0x80000000u;
+  static constexpr u32 NUM_GTE_REGS = 64;
+
+  void SetUp() override
+  {
+    ASSERT_TRUE(m_code_buffer.Allocate(CODE_SIZE, FAR_CODE_SIZE));
+
+    CPU::Recompiler::CodeGenerator cg(&m_code_buffer, GetSettings());
+    m_dispatcher = cg.CompileSingleBlockDispatcher();
+    ASSERT_NE(m_dispatcher, nullptr);
+  }
+
+  static CPU::Recompiler::CodeGeneratorSettings GetSettings()
+  {
+    CPU::Recompiler::CodeGeneratorSettings settings = {};
+    settings.fastmem_mode = CPUFastmemMode::Disabled;
+    return settings;
+  }
+
+  void RandomizeRegisters()
+  {
+    for (u32 i = 0; i < NUM_GTE_REGS; i++)
+    {
+      // Mix full-range values with small ones, so that both the saturating and the in-range paths are covered.
+      s32 value = static_cast<s32>(m_random());
+      if (m_random() & 1)
+        value >>= (m_random() % 28);
+
+      GTE::WriteRegister(i, static_cast<u32>(value));
+    }
+  }
+
+  CPU::CodeBlock::HostCodePointer GetBlock(u32 inst_bits)
+  {
+    auto iter = m_blocks.find(inst_bits);
+    if (iter != m_blocks.end())
+      return iter->second->host_code;
+
+    CPU::CodeBlockKey key = {};
+    key.SetPC(BLOCK_PC);
+
+    std::unique_ptr<CPU::CodeBlock> block = std::make_unique<CPU::CodeBlock>(key);
+    CPU::CodeBlockInstruction cbi = {};
+    cbi.instruction.bits = inst_bits;
+    cbi.pc = BLOCK_PC;
+    cbi.is_last_instruction = true;
+    block->instructions.push_back(cbi);
+
+    CPU::Recompiler::CodeGenerator cg(&m_code_buffer, GetSettings());
+    if (!cg.CompileBlock(block.get(), &block->host_code, &block->host_code_size))
+      return nullptr;
+
+    CPU::CodeBlock::HostCodePointer host_code = block->host_code;
+    m_blocks.emplace(inst_bits, std::move(block));
+    return host_code;
+  }
+
+  ::testing::AssertionResult CheckInstruction(u32 command)
+  {
+    const u32 inst_bits = 0x4A000000u | (command & 0x01FFFFFFu);
+    const CPU::CodeBlock::HostCodePointer host_code = GetBlock(inst_bits);
+    if (!host_code)
+      return ::testing::AssertionFailure() << "failed to compile instruction " << inst_bits;
+
+    RandomizeRegisters();
+    u32 initial[NUM_GTE_REGS];
+    std::memcpy(initial, CPU::g_state.gte_regs.r32, sizeof(initial));
+
+    GTE::ExecuteInstruction(inst_bits);
+    u32 expected[NUM_GTE_REGS];
+    std::memcpy(expected, CPU::g_state.gte_regs.r32, sizeof(expected));
+
+    std::memcpy(CPU::g_state.gte_regs.r32, initial, sizeof(initial));
+    CPU::g_state.regs.pc = BLOCK_PC;
+    m_dispatcher(host_code);
+
+    for (u32 i = 0; i < NUM_GTE_REGS; i++)
+    {
+      if (CPU::g_state.gte_regs.r32[i] != expected[i])
+      {
+        return ::testing::AssertionFailure() << "instruction " << inst_bits << ": register " << i << " is "
+                                             << CPU::g_state.gte_regs.r32[i] << ", expected " << expected[i] << " (was "
+                                             << initial[i] << ")";
+      }
+    }
+
+    return ::testing::AssertionSuccess();
+  }
+
+  // Command with random sf, mx, v, cv and lm fields.
+  u32 RandomCommand(u32 command)
+  {
+    return (m_random() & ((1u << 19) | (3u << 17) | (3u << 15) | (3u << 13) | (1u << 10))) | command;
+  }
+
+  JitCodeBuffer m_code_buffer;
+  CPU::CodeCache::SingleBlockDispatcherFunction m_dispatcher = nullptr;
+  std::unordered_map<u32, std::unique_ptr<CPU::CodeBlock>> m_blocks;
+  std::mt19937 m_random{12345};
+};
+
+} // namespace
+
+TEST_F(GTERecompilerTest, InlineInstructionsMatchInterpreter)
+{
+  static constexpr u32 commands[] = {0x01, 0x06, 0x12, 0x13, 0x16, 0x1B, 0x1E, 0x20, 0x2D, 0x2E, 0x30, 0x3F};
+  for (u32 i = 0; i < 20000; i++)
+  {
+    for (const u32 command : commands)
+      ASSERT_TRUE(CheckInstruction(RandomCommand(command)));
+  }
+}
+
+#endif
@@ -0,0 +1,74 @@
+#include "common/jit_code_buffer.h"
+#include "gtest/gtest.h"
+
+static constexpr u32 CODE_SIZE = 64 * 1024;
+static constexpr u32 FAR_CODE_SIZE = 32 * 1024;
+static constexpr u32 FIXED_CODE_SIZE = 256;
+static constexpr u32 REGION_COUNT = 4;
+
+TEST(JitCodeBuffer, RegionsStartAfterFixedCode)
+{
+  JitCodeBuffer buffer;
+  ASSERT_TRUE(buffer.Allocate(CODE_SIZE, FAR_CODE_SIZE));
+
+  u8* const fixed_code = buffer.GetFreeCodePointer();
+  buffer.CommitCode(FIXED_CODE_SIZE);
+  buffer.InitializeRegions(REGION_COUNT);
+
+  ASSERT_EQ(buffer.GetRegionCount(), REGION_COUNT);
+  ASSERT_EQ(buffer.GetCurrentRegion(), 0u);
+  ASSERT_EQ(buffer.GetRegionCodeSize(), (CODE_SIZE - FIXED_CODE_SIZE) / REGION_COUNT);
+  ASSERT_EQ(buffer.GetRegionFarCodeSize(), FAR_CODE_SIZE / REGION_COUNT);
+  ASSERT_EQ(buffer.GetRegionCodePointer(0), fixed_code + FIXED_CODE_SIZE);
+  ASSERT_EQ(buffer.GetFreeCodePointer(), buffer.GetRegionCodePointer(0));
+  ASSERT_EQ(buffer.GetFreeCodeSpace(), buffer.GetRegionCodeSize());
+  ASSERT_EQ(buffer.GetFreeFarCodeSpace(), buffer.GetRegionFarCodeSize());
+}
+
+TEST(JitCodeBuffer, AdvanceRegionWrapsAround)
+{
+  JitCodeBuffer buffer;
+  ASSERT_TRUE(buffer.Allocate(CODE_SIZE, FAR_CODE_SIZE));
+  buffer.CommitCode(FIXED_CODE_SIZE);
+  buffer.InitializeRegions(REGION_COUNT);
+
+  for (u32 i = 1; i <= REGION_COUNT; i++)
+  {
+    buffer.CommitCode(16);
+    buffer.CommitFarCode(16);
+    buffer.AdvanceRegion();
+
+    const u32 region = i % REGION_COUNT;
+    ASSERT_EQ(buffer.GetCurrentRegion(), region);
+    ASSERT_EQ(buffer.GetFreeCodePointer(), buffer.GetRegionCodePointer(region));
+    ASSERT_EQ(buffer.GetFreeFarCodePointer(), buffer.GetRegionFarCodePointer(region));
+    ASSERT_EQ(buffer.GetFreeCodeSpace(), buffer.GetRegionCodeSize());
+    ASSERT_EQ(buffer.GetFreeFarCodeSpace(), buffer.GetRegionFarCodeSize());
+  }
+}
+
+TEST(JitCodeBuffer, CommitIsLimitedToRegion)
+{
+  JitCodeBuffer buffer;
+  ASSERT_TRUE(buffer.Allocate(CODE_SIZE, FAR_CODE_SIZE));
+  buffer.InitializeRegions(REGION_COUNT);
+
+  buffer.CommitCode(buffer.GetRegionCodeSize() - 16);
+  ASSERT_EQ(buffer.GetFreeCodeSpace(), 16u);
+  ASSERT_EQ(buffer.GetFreeCodePointer() + 16, buffer.GetRegionCodePointer(1));
+}
+
+TEST(JitCodeBuffer, ResetDiscardsRegions)
+{
+  JitCodeBuffer buffer;
+  ASSERT_TRUE(buffer.Allocate(CODE_SIZE, FAR_CODE_SIZE));
+  buffer.CommitCode(FIXED_CODE_SIZE);
+  buffer.InitializeRegions(REGION_COUNT);
+  buffer.AdvanceRegion();
+  buffer.Reset();
+
+  ASSERT_EQ(buffer.GetRegionCount(), 0u);
+  ASSERT_EQ(buffer.GetFreeCodePointer(), buffer.GetCodePointer());
+  ASSERT_EQ(buffer.GetFreeCodeSpace(), CODE_SIZE);
+  ASSERT_EQ(buffer.GetFreeFarCodeSpace(), FAR_CODE_SIZE);
+}
@@ -0,0 +1,71 @@
+#include "common/parallel_for.h"
+#include "common/progress_callback.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+class CountingProgressCallback final : public BaseProgressCallback
+{
+public:
+  u32 GetProgressValue() const { return m_progress_value; }
+  bool WasCalledFromOtherThread() const { return m_called_from_other_thread; }
+
+  void SetProgressValue(u32 value) override
+  {
+    m_called_from_other_thread |= (std::this_thread::get_id() != m_thread_id);
+    BaseProgressCallback::SetProgressValue(value);
+  }
+
+  void SetTitle(const char* title) override {}
+  void DisplayError(const char* message) override {}
+  void DisplayWarning(const char* message) override {}
+  void DisplayInformation(const char* message) override {}
+  void DisplayDebugMessage(const char* message) override {}
+  void ModalError(const char* message) override {}
+  bool ModalConfirmation(const char* message) override { return false; }
+  void ModalInformation(const char* message) override {}
+
+private:
+  std::thread::id m_thread_id = std::this_thread::get_id();
+  bool m_called_from_other_thread = false;
+};
+} // namespace
+
+TEST(ParallelFor, CallsEachIndexOnce)
+{
+  std::vector<std::atomic<u32>> calls(1000);
+  ASSERT_TRUE(Common::ParallelFor(static_cast<u32>(calls.size()), [&calls](u32 index) {
+    calls[index].fetch_add(1);
+    return true;
+  }, nullptr, 4));
+
+  for (const std::atomic<u32>& count : calls)
+    ASSERT_EQ(count.load(), 1u);
+}
+
+TEST(ParallelFor, NoItems)
+{
+  ASSERT_TRUE(Common::ParallelFor(0, [](u32 index) { return false; }));
+}
+
+TEST(ParallelFor, FailureStopsRemainingItems)
+{
+  std::atomic<u32> num_calls{0};
+  ASSERT_FALSE(Common::ParallelFor(100000, [&num_calls](u32 index) {
+    num_calls.fetch_add(1);
+    return (index != 10);
+  }, nullptr, 4));
+
+  ASSERT_LT(num_calls.load(), 100000u);
+}
+
+TEST(ParallelFor, ReportsProgressOnCallingThread)
+{
+  CountingProgressCallback progress;
+  progress.SetProgressRange(500);
+  ASSERT_TRUE(Common::ParallelFor(500, [](u32 index) { return true; }, &progress, 4));
+  ASSERT_EQ(progress.GetProgressValue(), 500u);
+  ASSERT_FALSE(progress.WasCalledFromOtherThread());
+}
@@ -0,0 +1,87 @@
+#include "common/byte_stream.h"
+#include "common/state_wrapper.h"
+#include "core/cpu_core.h"
+#include "core/save_state_version.h"
+#include "core/timing_event.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+namespace {
+
+class TimingEventsTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    CPU::ResetPendingTicks();
+    TimingEvents::Initialize();
+    s_log.clear();
+
+    // A, B and C always share a downcount, so the order they run in comes down to how ties are broken.
+    m_events[0] = CreateEvent("A", 100);
+    m_events[1] = CreateEvent("B", 100);
+    m_events[2] = CreateEvent("C", 100);
+    m_events[3] = CreateEvent("D", 50);
+  }
+
+  void TearDown() override
+  {
+    for (std::unique_ptr<TimingEvent>& event : m_events)
+      event.reset();
+
+    TimingEvents::Shutdown();
+  }
+
+  static std::unique_ptr<TimingEvent> CreateEvent(const char* name, TickCount interval)
+  {
+    return TimingEvents::CreateTimingEvent(
+      name, interval, interval,
+      [](void* param, TickCount ticks, TickCount ticks_late) { s_log += static_cast<const char*>(param); },
+      const_cast<char*>(name), true);
+  }
+
+  static void Run(TickCount ticks)
+  {
+    CPU::AddPendingTicks(ticks);
+    TimingEvents::RunEvents();
+  }
+
+  static std::string s_log;
+  std::unique_ptr<TimingEvent> m_events[4];
+};
+
+std::string TimingEventsTest::s_log;
+
+} // namespace
+
+TEST_F(TimingEventsTest, SimultaneousEventOrder)
+{
+  // Newly added and rescheduled events go in front of events with the same downcount.
+  Run(300);
+  ASSERT_EQ(s_log, "DDCBADDABCDDCBA");
+}
+
+TEST_F(TimingEventsTest, SimultaneousEventOrderAfterLoadingState)
+{
+  // Rescheduling moves the events behind D, in front of events with the same downcount, giving D, A, B, C.
+  m_events[2]->Schedule(200);
+  m_events[1]->Schedule(200);
+  m_events[0]->Schedule(200);
+
+  std::unique_ptr<GrowableMemoryByteStream> stream = ByteStream_CreateGrowableMemoryStream();
+  {
+    StateWrapper sw(stream.get(), StateWrapper::Mode::Write, SAVE_STATE_VERSION);
+    ASSERT_TRUE(TimingEvents::DoState(sw));
+  }
+
+  // Loading re-sorts the events by adding them again, which reverses the order of ties.
+  ASSERT_TRUE(stream->SeekAbsolute(0));
+  {
+    StateWrapper sw(stream.get(), StateWrapper::Mode::Read, SAVE_STATE_VERSION);
+    ASSERT_TRUE(TimingEvents::DoState(sw));
+  }
+
+  Run(300);
+  ASSERT_EQ(s_log, "DDDDCBADDABC");
+}
@@ -209,9 +209,13 @@ ShaderCache::CacheIndexKey ShaderCache::GetCacheKey(ShaderCompiler::Type type, c
 ShaderCache::ComPtr<ID3DBlob> ShaderCache::GetShaderBlob(ShaderCompiler::Type type, std::string_view shader_code)
 {
   const auto key = GetCacheKey(type, shader_code);
+  std::unique_lock<std::mutex> lock(m_mutex);
   auto iter = m_index.find(key);
   if (iter == m_index.end())
+  {
+    lock.unlock();
     return CompileAndAddShaderBlob(key, shader_code);
+  }
 
   ComPtr<ID3DBlob> blob;
   HRESULT hr = D3DCreateBlob(iter->second.blob_size, blob.GetAddressOf());
@@ -270,6 +274,7 @@ ShaderCache::ComPtr<ID3DBlob> ShaderCache::CompileAndAddShaderBlob(const CacheIn
   if (!blob)
     return {};
 
+  std::lock_guard<std::mutex> guard(m_mutex);
   if (!m_blob_file || std::fseek(m_blob_file, 0, SEEK_END) != 0)
     return blob;
 
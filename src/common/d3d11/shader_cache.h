@@ -5,6 +5,7 @@
 #include "shader_compiler.h"
 #include <cstdio>
 #include <d3d11.h>
+#include <mutex>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
@@ -23,6 +24,7 @@ public:
 
   void Open(std::string_view base_path, D3D_FEATURE_LEVEL feature_level, bool debug);
 
+  /// Shaders can be requested from multiple threads at once.
   ComPtr<ID3DBlob> GetShaderBlob(ShaderCompiler::Type type, std::string_view shader_code);
 
   ComPtr<ID3D11VertexShader> GetVertexShader(ID3D11Device* device, std::string_view shader_code);
@@ -76,6 +78,9 @@ private:
 
   CacheIndex m_index;
 
+  // Protects the index and the files, shaders are compiled outside of the lock.
+  std::mutex m_mutex;
+
   D3D_FEATURE_LEVEL m_feature_level = D3D_FEATURE_LEVEL_11_0;
   bool m_debug = false;
 };
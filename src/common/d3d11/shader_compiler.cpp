@@ -2,13 +2,15 @@
 #include "../log.h"
 #include "../string_util.h"
 #include <array>
+#include <atomic>
 #include <d3dcompiler.h>
 #include <fstream>
 Log_SetChannel(D3D11);
 
 namespace D3D11::ShaderCompiler {
 
-static unsigned s_next_bad_shader_id = 1;
+// shaders can be compiled from several threads
+static std::atomic<unsigned> s_next_bad_shader_id{1};
 
 ComPtr<ID3DBlob> CompileShader(Type type, D3D_FEATURE_LEVEL feature_level, std::string_view code, bool debug)
 {
@@ -16,17 +16,16 @@ Log_SetChannel(GL::Context);
 #endif
 
 #ifdef USE_EGL
-#if defined(USE_X11) || defined(USE_WAYLAND)
+#if defined(ANDROID)
+#include "context_egl_android.h"
+#else
+#include "context_egl_headless.h"
 #if defined(USE_X11)
 #include "context_egl_x11.h"
 #endif
 #if defined(USE_WAYLAND)
 #include "context_egl_wayland.h"
 #endif
-#elif defined(ANDROID)
-#include "context_egl_android.h"
-#else
-#error Unknown EGL platform
 #endif
 #endif
 
@@ -105,6 +104,11 @@ std::unique_ptr<GL::Context> Context::Create(const WindowInfo& wi, const Version
     context = ContextEGLWayland::Create(wi, versions_to_try, num_versions_to_try);
 #endif
 
+#if defined(USE_EGL) && !defined(ANDROID)
+  if (wi.type == WindowInfo::Type::Surfaceless)
+    context = ContextEGLHeadless::Create(wi, versions_to_try, num_versions_to_try);
+#endif
+
   if (!context)
     return nullptr;
 
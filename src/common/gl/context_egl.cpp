@@ -33,12 +33,8 @@ bool ContextEGL::Initialize(const Version* versions_to_try, size_t num_versions_
     return false;
   }
 
-  m_display = eglGetDisplay(static_cast<EGLNativeDisplayType>(m_wi.display_connection));
-  if (!m_display)
-  {
-    Log_ErrorPrintf("eglGetDisplay() failed: %d", eglGetError());
+  if (!CreateDisplay())
     return false;
-  }
 
   int egl_major, egl_minor;
   if (!eglInitialize(m_display, &egl_major, &egl_minor))
@@ -66,6 +62,18 @@ bool ContextEGL::Initialize(const Version* versions_to_try, size_t num_versions_
   return false;
 }
 
+bool ContextEGL::CreateDisplay()
+{
+  m_display = eglGetDisplay(static_cast<EGLNativeDisplayType>(m_wi.display_connection));
+  if (!m_display)
+  {
+    Log_ErrorPrintf("eglGetDisplay() failed: %d", eglGetError());
+    return false;
+  }
+
+  return true;
+}
+
 void* ContextEGL::GetProcAddress(const char* name)
 {
   return reinterpret_cast<void*>(eglGetProcAddress(name));
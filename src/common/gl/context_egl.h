@@ -25,8 +25,9 @@ public:
 protected:
   virtual EGLNativeWindowType GetNativeWindow(EGLConfig config);
 
+  virtual bool CreateDisplay();
+
   bool Initialize(const Version* versions_to_try, size_t num_versions_to_try);
-  bool CreateDisplay();
   bool CreateContext(const Version& version, EGLContext share_context);
   bool CreateContextAndSurface(const Version& version, EGLContext share_context, bool make_current);
   bool CreateSurface();
@@ -0,0 +1,77 @@
+#include "context_egl_headless.h"
+#include "../log.h"
+#include <cstring>
+Log_SetChannel(GL::ContextEGLHeadless);
+
+namespace GL {
+ContextEGLHeadless::ContextEGLHeadless(const WindowInfo& wi) : ContextEGL(wi) {}
+ContextEGLHeadless::~ContextEGLHeadless() = default;
+
+std::unique_ptr<Context> ContextEGLHeadless::Create(const WindowInfo& wi, const Version* versions_to_try,
+                                                    size_t num_versions_to_try)
+{
+  std::unique_ptr<ContextEGLHeadless> context = std::make_unique<ContextEGLHeadless>(wi);
+  if (!context->Initialize(versions_to_try, num_versions_to_try))
+    return nullptr;
+
+  return context;
+}
+
+std::unique_ptr<Context> ContextEGLHeadless::CreateSharedContext(const WindowInfo& wi)
+{
+  std::unique_ptr<ContextEGLHeadless> context = std::make_unique<ContextEGLHeadless>(wi);
+  context->m_display = m_display;
+  context->m_supports_surfaceless = m_supports_surfaceless;
+
+  if (!context->CreateContextAndSurface(m_version, m_context, false))
+    return nullptr;
+
+  return context;
+}
+
+bool ContextEGLHeadless::CreateDisplay()
+{
+  // Client extensions are queried without a display.
+  const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (client_extensions && eglGetPlatformDisplayEXT)
+  {
+    // Mesa's surfaceless platform works with software rasterizers, as well as render nodes.
+    if (std::strstr(client_extensions, "EGL_MESA_platform_surfaceless"))
+    {
+      m_display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+      if (m_display != EGL_NO_DISPLAY)
+      {
+        Log_InfoPrintf("Using surfaceless EGL platform");
+        return true;
+      }
+
+      Log_WarningPrintf("eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA) failed: %d", eglGetError());
+    }
+
+    // Otherwise, pick the first device, which is what the proprietary drivers offer.
+    if (std::strstr(client_extensions, "EGL_EXT_platform_device") && eglQueryDevicesEXT)
+    {
+      EGLDeviceEXT device = EGL_NO_DEVICE_EXT;
+      EGLint num_devices = 0;
+      if (eglQueryDevicesEXT(1, &device, &num_devices) && num_devices > 0)
+      {
+        m_display = eglGetPlatformDisplayEXT(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+        if (m_display != EGL_NO_DISPLAY)
+        {
+          Log_InfoPrintf("Using device EGL platform");
+          return true;
+        }
+
+        Log_WarningPrintf("eglGetPlatformDisplayEXT(EGL_PLATFORM_DEVICE_EXT) failed: %d", eglGetError());
+      }
+      else
+      {
+        Log_WarningPrintf("No EGL devices available");
+      }
+    }
+  }
+
+  Log_WarningPrintf("No headless EGL platform available, trying the default display");
+  return ContextEGL::CreateDisplay();
+}
+} // namespace GL
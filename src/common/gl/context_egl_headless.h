@@ -0,0 +1,22 @@
+#pragma once
+#include "context_egl.h"
+
+namespace GL {
+
+// Context which isn't attached to any window system, for rendering offscreen.
+class ContextEGLHeadless final : public ContextEGL
+{
+public:
+  ContextEGLHeadless(const WindowInfo& wi);
+  ~ContextEGLHeadless() override;
+
+  static std::unique_ptr<Context> Create(const WindowInfo& wi, const Version* versions_to_try,
+                                         size_t num_versions_to_try);
+
+  std::unique_ptr<Context> CreateSharedContext(const WindowInfo& wi) override;
+
+protected:
+  bool CreateDisplay() override;
+};
+
+} // namespace GL
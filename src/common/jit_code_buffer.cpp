@@ -60,11 +60,15 @@ bool JitCodeBuffer::Allocate(u32 size /* = 64 * 1024 * 1024 */, u32 far_code_siz
   m_free_code_ptr = m_code_ptr;
   m_code_size = size;
   m_code_used = 0;
+  m_code_limit = size;
 
   m_far_code_ptr = static_cast<u8*>(m_code_ptr) + size;
   m_free_far_code_ptr = m_far_code_ptr;
   m_far_code_size = far_code_size;
   m_far_code_used = 0;
+  m_far_code_limit = far_code_size;
+  m_region_count = 0;
+  m_current_region = 0;
 
   m_old_protection = 0;
   m_owns_buffer = true;
@@ -131,11 +135,15 @@ bool JitCodeBuffer::Initialize(void* buffer, u32 size, u32 far_code_size /* = 0
   m_free_code_ptr = m_code_ptr + guard_size;
   m_code_size = size - far_code_size - (guard_size * 2);
   m_code_used = 0;
+  m_code_limit = m_code_size;
 
   m_far_code_ptr = static_cast<u8*>(m_code_ptr) + m_code_size;
   m_free_far_code_ptr = m_far_code_ptr;
   m_far_code_size = far_code_size - guard_size;
   m_far_code_used = 0;
+  m_far_code_limit = m_far_code_size;
+  m_region_count = 0;
+  m_current_region = 0;
 
   m_guard_size = guard_size;
   m_owns_buffer = false;
@@ -173,7 +181,7 @@ void JitCodeBuffer::CommitCode(u32 length)
   FlushInstructionCache(m_free_code_ptr, length);
 #endif
 
-  Assert(length <= (m_code_size - m_code_used));
+  Assert(length <= (m_code_limit - m_code_used));
   m_free_code_ptr += length;
   m_code_used += length;
 }
@@ -188,7 +196,7 @@ void JitCodeBuffer::CommitFarCode(u32 length)
   FlushInstructionCache(m_free_far_code_ptr, length);
 #endif
 
-  Assert(length <= (m_far_code_size - m_far_code_used));
+  Assert(length <= (m_far_code_limit - m_far_code_used));
   m_free_far_code_ptr += length;
   m_far_code_used += length;
 }
@@ -197,6 +205,7 @@ void JitCodeBuffer::Reset()
 {
   m_free_code_ptr = m_code_ptr + m_guard_size;
   m_code_used = 0;
+  m_code_limit = m_code_size;
   std::memset(m_free_code_ptr, 0, m_code_size);
   FlushInstructionCache(m_free_code_ptr, m_code_size);
 
@@ -207,6 +216,49 @@ void JitCodeBuffer::Reset()
     std::memset(m_free_far_code_ptr, 0, m_far_code_size);
     FlushInstructionCache(m_free_far_code_ptr, m_far_code_size);
   }
+  m_far_code_limit = m_far_code_size;
+
+  m_region_count = 0;
+  m_current_region = 0;
+}
+
+void JitCodeBuffer::InitializeRegions(u32 count)
+{
+  DebugAssert(count > 0);
+  m_region_count = count;
+  m_current_region = 0;
+
+  m_region_code_start = m_code_used;
+  m_region_code_size = (m_code_size - m_code_used) / count;
+  m_code_limit = m_region_code_start + m_region_code_size;
+
+  m_region_far_code_start = m_far_code_used;
+  m_region_far_code_size = (m_far_code_size - m_far_code_used) / count;
+  m_far_code_limit = m_region_far_code_start + m_region_far_code_size;
+}
+
+void JitCodeBuffer::AdvanceRegion()
+{
+  DebugAssert(m_region_count > 0);
+  m_current_region = (m_current_region + 1) % m_region_count;
+
+  m_free_code_ptr = GetRegionCodePointer(m_current_region);
+  m_code_used = m_region_code_start + (m_current_region * m_region_code_size);
+  m_code_limit = m_code_used + m_region_code_size;
+
+  m_free_far_code_ptr = GetRegionFarCodePointer(m_current_region);
+  m_far_code_used = m_region_far_code_start + (m_current_region * m_region_far_code_size);
+  m_far_code_limit = m_far_code_used + m_region_far_code_size;
+}
+
+u8* JitCodeBuffer::GetRegionCodePointer(u32 region) const
+{
+  return GetCodePointer() + m_region_code_start + (region * m_region_code_size);
+}
+
+u8* JitCodeBuffer::GetRegionFarCodePointer(u32 region) const
+{
+  return m_far_code_ptr + m_region_far_code_start + (region * m_region_far_code_size);
 }
 
 void JitCodeBuffer::Align(u32 alignment, u8 padding_value)
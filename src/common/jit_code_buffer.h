@@ -14,14 +14,33 @@ public:
   void Destroy();
   void Reset();
 
+  u8* GetCodePointer() const { return m_free_code_ptr - m_code_used; }
+  u32 GetUsedCodeSpace() const { return m_code_used; }
   u8* GetFreeCodePointer() const { return m_free_code_ptr; }
-  u32 GetFreeCodeSpace() const { return static_cast<u32>(m_code_size - m_code_used); }
+  u32 GetFreeCodeSpace() const { return static_cast<u32>(m_code_limit - m_code_used); }
   void CommitCode(u32 length);
 
+  u8* GetFarCodePointer() const { return m_far_code_ptr; }
+  u32 GetUsedFarCodeSpace() const { return m_far_code_used; }
   u8* GetFreeFarCodePointer() const { return m_free_far_code_ptr; }
-  u32 GetFreeFarCodeSpace() const { return static_cast<u32>(m_far_code_size - m_far_code_used); }
+  u32 GetFreeFarCodeSpace() const { return static_cast<u32>(m_far_code_limit - m_far_code_used); }
   void CommitFarCode(u32 length);
 
+  /// Splits the remaining free space into the specified number of equally-sized regions, for both near and far code.
+  /// Code which was committed before this call (e.g. dispatchers) stays valid until the buffer is reset. Allocations
+  /// are made from the current region only, the free space reported is the remaining space in that region.
+  void InitializeRegions(u32 count);
+
+  /// Moves allocation to the next region, wrapping around. Anything previously in that region must be discarded.
+  void AdvanceRegion();
+
+  u32 GetRegionCount() const { return m_region_count; }
+  u32 GetCurrentRegion() const { return m_current_region; }
+  u8* GetRegionCodePointer(u32 region) const;
+  u32 GetRegionCodeSize() const { return m_region_code_size; }
+  u8* GetRegionFarCodePointer(u32 region) const;
+  u32 GetRegionFarCodeSize() const { return m_region_far_code_size; }
+
   /// Adjusts the free code pointer to the specified alignment, padding with bytes.
   /// Assumes alignment is a power-of-two.
   void Align(u32 alignment, u8 padding_value);
@@ -34,11 +53,20 @@ private:
   u8* m_free_code_ptr = nullptr;
   u32 m_code_size = 0;
   u32 m_code_used = 0;
+  u32 m_code_limit = 0;
 
   u8* m_far_code_ptr = nullptr;
   u8* m_free_far_code_ptr = nullptr;
   u32 m_far_code_size = 0;
   u32 m_far_code_used = 0;
+  u32 m_far_code_limit = 0;
+
+  u32 m_region_count = 0;
+  u32 m_current_region = 0;
+  u32 m_region_code_start = 0;
+  u32 m_region_code_size = 0;
+  u32 m_region_far_code_start = 0;
+  u32 m_region_far_code_size = 0;
 
   u32 m_total_size = 0;
   u32 m_guard_size = 0;
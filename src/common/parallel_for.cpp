@@ -0,0 +1,96 @@
+#include "parallel_for.h"
+#include "progress_callback.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Common {
+
+u32 GetParallelWorkerCount()
+{
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+bool ParallelFor(u32 count, const std::function<bool(u32 index)>& func, ProgressCallback* progress /* = nullptr */,
+                 u32 num_workers /* = 0 */)
+{
+  num_workers = std::min((num_workers > 0) ? num_workers : GetParallelWorkerCount(), count);
+  if (num_workers <= 1)
+  {
+    for (u32 i = 0; i < count; i++)
+    {
+      if (!func(i))
+        return false;
+
+      if (progress)
+        progress->IncrementProgressValue();
+    }
+
+    return true;
+  }
+
+  std::atomic<u32> next_index{0};
+  std::atomic_bool failed{false};
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  u32 num_completed = 0;
+  u32 num_running_workers = num_workers;
+
+  auto worker = [&]() {
+    for (;;)
+    {
+      const u32 index = next_index.fetch_add(1);
+      if (index >= count || failed.load())
+        break;
+
+      if (!func(index))
+        failed.store(true);
+
+      std::unique_lock<std::mutex> lock(mutex);
+      num_completed++;
+      cv.notify_one();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    num_running_workers--;
+    cv.notify_one();
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_workers);
+  for (u32 i = 0; i < num_workers; i++)
+    threads.emplace_back(worker);
+
+  // progress is reported from this thread, since callbacks generally aren't thread-safe
+  u32 num_reported = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;)
+  {
+    cv.wait(lock, [&]() { return num_completed != num_reported || num_running_workers == 0; });
+    const u32 completed = num_completed;
+    const bool done = (num_running_workers == 0);
+    lock.unlock();
+
+    for (; num_reported < completed; num_reported++)
+    {
+      if (progress)
+        progress->IncrementProgressValue();
+    }
+
+    if (done)
+      break;
+
+    lock.lock();
+  }
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  return !failed.load();
+}
+
+} // namespace Common
@@ -0,0 +1,19 @@
+#pragma once
+#include "types.h"
+#include <functional>
+
+class ProgressCallback;
+
+namespace Common {
+
+/// Returns the number of threads which should be used for CPU-bound work, i.e. the number of hardware threads.
+u32 GetParallelWorkerCount();
+
+/// Calls func once for each index in [0, count), from a set of worker threads. The calling thread waits for all of the
+/// work to finish, incrementing the progress value as items complete. Items must not depend on each other, and are not
+/// started in any particular order. If func returns false for any item, no further items are started, and false is
+/// returned once the items which are already running have finished.
+bool ParallelFor(u32 count, const std::function<bool(u32 index)>& func, ProgressCallback* progress = nullptr,
+                 u32 num_workers = 0);
+
+} // namespace Common
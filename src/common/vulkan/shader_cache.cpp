@@ -426,14 +426,19 @@ std::optional<ShaderCompiler::SPIRVCodeVector> ShaderCache::GetShaderSPV(ShaderC
                                                                          std::string_view shader_code)
 {
   const auto key = GetCacheKey(type, shader_code);
+  std::unique_lock<std::mutex> lock(m_mutex);
   auto iter = m_index.find(key);
   if (iter == m_index.end())
+  {
+    lock.unlock();
     return CompileAndAddShaderSPV(key, shader_code);
+  }
 
   SPIRVCodeVector spv(iter->second.blob_size);
   if (std::fseek(m_blob_file, iter->second.file_offset, SEEK_SET) != 0 ||
       std::fread(spv.data(), sizeof(SPIRVCodeType), iter->second.blob_size, m_blob_file) != iter->second.blob_size)
   {
+    lock.unlock();
     Log_ErrorPrintf("Read blob from file failed, recompiling");
     return ShaderCompiler::CompileShader(type, shader_code, m_debug);
   }
@@ -488,6 +493,7 @@ std::optional<ShaderCompiler::SPIRVCodeVector> ShaderCache::CompileAndAddShaderS
   if (!spv.has_value())
     return {};
 
+  std::lock_guard<std::mutex> guard(m_mutex);
   if (!m_blob_file || std::fseek(m_blob_file, 0, SEEK_END) != 0)
     return spv;
 
@@ -5,6 +5,7 @@
 #include "vulkan_loader.h"
 #include <cstdio>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -27,6 +28,7 @@ public:
   /// Writes pipeline cache to file, saving all newly compiled pipelines.
   bool FlushPipelineCache();
 
+  /// Shaders can be requested from multiple threads at once.
   std::optional<ShaderCompiler::SPIRVCodeVector> GetShaderSPV(ShaderCompiler::Type type, std::string_view shader_code);
   VkShaderModule GetShaderModule(ShaderCompiler::Type type, std::string_view shader_code);
 
@@ -92,6 +94,9 @@ private:
 
   CacheIndex m_index;
 
+  // Protects the index and the files, shaders are compiled outside of the lock.
+  std::mutex m_mutex;
+
   VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
   bool m_debug = false;
   bool m_pipeline_cache_dirty = false;
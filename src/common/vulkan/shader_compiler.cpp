@@ -8,9 +8,11 @@
 #include "../log.h"
 #include "../string_util.h"
 #include "util.h"
+#include <atomic>
 #include <cstring>
 #include <fstream>
 #include <memory>
+#include <mutex>
 Log_SetChannel(Vulkan::ShaderCompiler);
 
 // glslang includes
@@ -22,8 +24,9 @@ namespace Vulkan::ShaderCompiler {
 // Registers itself for cleanup via atexit
 bool InitializeGlslang();
 
-static unsigned s_next_bad_shader_id = 1;
+static std::atomic<unsigned> s_next_bad_shader_id{1};
 
+static std::mutex glslang_init_mutex;
 static bool glslang_initialized = false;
 
 static std::optional<SPIRVCodeVector> CompileShaderToSPV(EShLanguage stage, const char* stage_filename,
@@ -115,6 +118,8 @@ static std::optional<SPIRVCodeVector> CompileShaderToSPV(EShLanguage stage, cons
 
 bool InitializeGlslang()
 {
+  // shaders can be compiled from several threads, the first ones in would all try to initialize
+  std::lock_guard<std::mutex> guard(glslang_init_mutex);
   if (glslang_initialized)
     return true;
 
@@ -134,6 +139,7 @@ bool InitializeGlslang()
 
 void DeinitializeGlslang()
 {
+  std::lock_guard<std::mutex> guard(glslang_init_mutex);
   if (!glslang_initialized)
     return;
 
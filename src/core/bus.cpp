@@ -18,6 +18,7 @@
 #include "sio.h"
 #include "spu.h"
 #include "timers.h"
+#include <algorithm>
 #include <cstdio>
 #include <tuple>
 Log_SetChannel(Bus);
@@ -71,6 +72,7 @@ union MEMCTRL
 };
 
 std::bitset<RAM_CODE_PAGE_COUNT> m_ram_code_bits{};
+std::bitset<RAM_CODE_LINE_COUNT> m_ram_code_line_bits{};
 u8* g_ram = nullptr;    // 2MB RAM
 u8 g_bios[BIOS_SIZE]{}; // 512K BIOS ROM
 
@@ -169,6 +171,7 @@ void Reset()
   m_MEMCTRL.common_delay.bits = 0x00031125;
   m_ram_size_reg = UINT32_C(0x00000B88);
   m_ram_code_bits = {};
+  m_ram_code_line_bits = {};
   RecalculateMemoryTimings();
 }
 
@@ -472,6 +475,29 @@ void SetRAMCodePage(u32 index)
   SetCodePageFastmemProtection(index, false);
 }
 
+bool HasRAMCodeLinesInPage(u32 page_index)
+{
+  const u32 start_line = page_index * RAM_CODE_LINES_PER_PAGE;
+  for (u32 line = start_line; line < (start_line + RAM_CODE_LINES_PER_PAGE); line++)
+  {
+    if (m_ram_code_line_bits[line])
+      return true;
+  }
+
+  return false;
+}
+
+void SetRAMCodeLine(u32 index)
+{
+  m_ram_code_line_bits[index] = true;
+  SetRAMCodePage(index / RAM_CODE_LINES_PER_PAGE);
+}
+
+void ClearRAMCodeLine(u32 index)
+{
+  m_ram_code_line_bits[index] = false;
+}
+
 void ClearRAMCodePage(u32 index)
 {
   if (!m_ram_code_bits[index])
@@ -514,6 +540,7 @@ void SetCodePageFastmemProtection(u32 page_index, bool writable)
 void ClearRAMCodePageFlags()
 {
   m_ram_code_bits.reset();
+  m_ram_code_line_bits.reset();
 
 #ifdef WITH_MMAP_FASTMEM
   if (m_fastmem_mode == CPUFastmemMode::MMap)
@@ -542,7 +569,7 @@ void ClearRAMCodePageFlags()
 
 bool IsCodePageAddress(PhysicalMemoryAddress address)
 {
-  return IsRAMAddress(address) ? m_ram_code_bits[(address & RAM_MASK) / HOST_PAGE_SIZE] : false;
+  return IsRAMAddress(address) ? m_ram_code_line_bits[GetRAMCodeLineIndex(address)] : false;
 }
 
 bool HasCodePagesInRange(PhysicalMemoryAddress start_address, u32 size)
@@ -552,14 +579,15 @@ bool HasCodePagesInRange(PhysicalMemoryAddress start_address, u32 size)
 
   start_address = (start_address & RAM_MASK);
 
-  const u32 end_address = start_address + size;
-  while (start_address < end_address)
+  if (size == 0)
+    return false;
+
+  const u32 start_line = start_address >> RAM_CODE_LINE_SHIFT;
+  const u32 end_line = std::min<u32>(start_address + size - 1, RAM_SIZE - 1) >> RAM_CODE_LINE_SHIFT;
+  for (u32 line = start_line; line <= end_line; line++)
   {
-    const u32 code_page_index = start_address / HOST_PAGE_SIZE;
-    if (m_ram_code_bits[code_page_index])
+    if (m_ram_code_line_bits[line])
       return true;
-
-    start_address += HOST_PAGE_SIZE;
   }
 
   return false;
@@ -617,9 +645,9 @@ ALWAYS_INLINE static TickCount DoRAMAccess(u32 offset, u32& value)
   }
   else
   {
-    const u32 page_index = offset / HOST_PAGE_SIZE;
-    if (m_ram_code_bits[page_index])
-      CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
+    const u32 line_index = offset >> RAM_CODE_LINE_SHIFT;
+    if (m_ram_code_line_bits[line_index])
+      CPU::CodeCache::InvalidateBlocksWithLineIndex(line_index);
 
     if constexpr (size == MemoryAccessSize::Byte)
     {
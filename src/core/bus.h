@@ -89,6 +89,13 @@ enum : size_t
 
   RAM_CODE_PAGE_COUNT = (RAM_SIZE + (HOST_PAGE_SIZE + 1)) / HOST_PAGE_SIZE,
 
+  // Code is tracked at a finer granularity than host pages, so writes to data which shares a page with code don't
+  // throw away every block in the page.
+  RAM_CODE_LINE_SHIFT = 8,
+  RAM_CODE_LINE_SIZE = 1u << RAM_CODE_LINE_SHIFT,
+  RAM_CODE_LINE_COUNT = RAM_SIZE / RAM_CODE_LINE_SIZE,
+  RAM_CODE_LINES_PER_PAGE = HOST_PAGE_SIZE / RAM_CODE_LINE_SIZE,
+
   FASTMEM_LUT_NUM_PAGES = 0x100000, // 0x100000000 >> 12
   FASTMEM_LUT_NUM_SLOTS = FASTMEM_LUT_NUM_PAGES * 2,
 };
@@ -106,6 +113,7 @@ void SetExpansionROM(std::vector<u8> data);
 void SetBIOS(const std::vector<u8>& image);
 
 extern std::bitset<RAM_CODE_PAGE_COUNT> m_ram_code_bits;
+extern std::bitset<RAM_CODE_LINE_COUNT> m_ram_code_line_bits;
 extern u8* g_ram;            // 2MB RAM
 extern u8 g_bios[BIOS_SIZE]; // 512K BIOS ROM
 
@@ -121,9 +129,30 @@ ALWAYS_INLINE static u32 GetRAMCodePageIndex(PhysicalMemoryAddress address)
   return (address & RAM_MASK) / HOST_PAGE_SIZE;
 }
 
+/// Returns the code line index for a RAM address.
+ALWAYS_INLINE static u32 GetRAMCodeLineIndex(PhysicalMemoryAddress address)
+{
+  return (address & RAM_MASK) >> RAM_CODE_LINE_SHIFT;
+}
+
 /// Returns true if the specified page contains code.
 bool IsRAMCodePage(u32 index);
 
+/// Returns true if the specified line contains code.
+ALWAYS_INLINE static bool IsRAMCodeLine(u32 index)
+{
+  return m_ram_code_line_bits[index];
+}
+
+/// Returns true if any line in the specified page contains code.
+bool HasRAMCodeLinesInPage(u32 page_index);
+
+/// Flags a RAM line as code, and protects the page containing it.
+void SetRAMCodeLine(u32 index);
+
+/// Unflags a RAM line as code. The page stays protected until ClearRAMCodePage() is called.
+void ClearRAMCodeLine(u32 index);
+
 /// Flags a RAM region as code, so we know when to invalidate blocks.
 void SetRAMCodePage(u32 index);
 
@@ -136,7 +165,7 @@ void ClearRAMCodePageFlags();
 /// Returns true if the specified address is in a code page.
 bool IsCodePageAddress(PhysicalMemoryAddress address);
 
-/// Returns true if the range specified overlaps with a code page.
+/// Returns true if the range specified overlaps with a code line.
 bool HasCodePagesInRange(PhysicalMemoryAddress start_address, u32 size);
 
 /// Returns the number of cycles stolen by DMA RAM access.
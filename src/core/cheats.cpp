@@ -88,9 +88,9 @@ static void DoMemoryWrite(PhysicalMemoryAddress address, T value)
     {
       std::memcpy(&Bus::g_ram[address & Bus::RAM_MASK], &value, sizeof(value));
 
-      const u32 code_page_index = Bus::GetRAMCodePageIndex(address & Bus::RAM_MASK);
-      if (Bus::IsRAMCodePage(code_page_index))
-        CPU::CodeCache::InvalidateBlocksWithPageIndex(code_page_index);
+      const u32 code_line_index = Bus::GetRAMCodeLineIndex(address);
+      if (Bus::IsRAMCodeLine(code_line_index))
+        CPU::CodeCache::InvalidateBlocksWithLineIndex(code_line_index);
     }
 
     return;
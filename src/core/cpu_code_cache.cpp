@@ -1,17 +1,38 @@
 #include "cpu_code_cache.h"
 #include "bus.h"
 #include "common/assert.h"
+#include "common/byte_stream.h"
+#include "common/file_system.h"
 #include "common/log.h"
+#include "common/string_util.h"
+#include "common/timer.h"
 #include "cpu_core.h"
 #include "cpu_core_private.h"
 #include "cpu_disasm.h"
+#include "host_interface.h"
 #include "settings.h"
 #include "system.h"
 #include "timing_event.h"
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
 Log_SetChannel(CPU::CodeCache);
 
+#ifdef WITH_IMGUI
+#include "imgui.h"
+#endif
+
 #ifdef WITH_RECOMPILER
 #include "cpu_recompiler_code_generator.h"
+#include "cpu_recompiler_dataflow.h"
+#include "gte.h"
+#include "pgxp.h"
+#include "xxhash.h"
 #endif
 
 namespace CPU::CodeCache {
@@ -35,15 +56,26 @@ static constexpr u32 RECOMPILER_FAR_CODE_CACHE_SIZE = 16 * 1024 * 1024;
 #endif
 static constexpr u32 CODE_WRITE_FAULT_THRESHOLD_FOR_SLOWMEM = 10;
 
+// When the code buffer fills up, only the oldest region is discarded, instead of flushing every block.
+static constexpr u32 RECOMPILER_CODE_REGION_COUNT = 8;
+
 #ifdef USE_STATIC_CODE_BUFFER
 static constexpr u32 RECOMPILER_GUARD_SIZE = 4096;
 alignas(Recompiler::CODE_STORAGE_ALIGNMENT) static u8
   s_code_storage[RECOMPILER_CODE_CACHE_SIZE + RECOMPILER_FAR_CODE_CACHE_SIZE];
+
+// The persistent block cache relies on the code buffer being at a fixed offset from the rest of the executable, so
+// that any RIP/PC-relative references to globals and thunks remain valid when the code is reloaded. AArch32 embeds
+// absolute addresses in the generated code, so it can't be used there.
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+#define USE_PERSISTENT_BLOCK_CACHE 1
+#endif
 #endif
 
 static JitCodeBuffer s_code_buffer;
 
 std::array<CodeBlock::HostCodePointer, FAST_MAP_TOTAL_SLOT_COUNT> s_fast_map;
+ReturnStack s_return_stack;
 DispatcherFunction s_asm_dispatcher;
 SingleBlockDispatcherFunction s_single_block_asm_dispatcher;
 
@@ -56,17 +88,115 @@ ALWAYS_INLINE static u32 GetFastMapIndex(u32 pc)
 
 static void CompileDispatcher();
 static void FastCompileBlockFunction();
+static void FastPromoteBlockFunction();
+static void EvictOldestCodeRegion();
+static bool HasCodeSpaceForInstructions(const std::vector<CodeBlockInstruction>& instructions);
+static void LogReturnStackStats();
+static void ProfileGuestRegisterUses(const CodeBlock& block);
+static u32 GetMostUsedGuestRegisters(std::array<Reg, Recompiler::MAX_PINNED_GUEST_REGISTERS>* regs);
+static void SelectPinnedGuestRegisters();
+static void ReselectPinnedGuestRegisters();
+
+// The register profile is frozen after this many blocks, so later flushes don't keep changing the pinned registers.
+static constexpr u32 PINNED_REGISTER_PROFILE_BLOCK_COUNT = 4096;
+
+static std::array<u32, 32> s_guest_register_uses = {};
+static u32 s_guest_register_profiled_blocks = 0;
+static bool s_pinned_registers_reselect_pending = false;
+static std::array<Reg, Recompiler::MAX_PINNED_GUEST_REGISTERS> s_pinned_guest_registers = {};
+static u32 s_pinned_guest_register_count = 0;
+
+static u32 s_code_regions_evicted = 0;
 
 static void ResetFastMap()
 {
   s_fast_map.fill(FastCompileBlockFunction);
+  s_return_stack.fast_map_generation++;
+  s_return_stack.compile_stub = FastCompileBlockFunction;
+  s_return_stack.promote_stub = FastPromoteBlockFunction;
 }
 
 static void SetFastMap(u32 pc, CodeBlock::HostCodePointer function)
 {
   s_fast_map[GetFastMapIndex(pc)] = function;
+  s_return_stack.fast_map_generation++;
 }
 
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+
+static constexpr u32 BLOCK_CACHE_FILE_MAGIC = 0x43424344; // DCBC
+static constexpr u32 BLOCK_CACHE_FILE_VERSION = 2;
+
+#pragma pack(push, 1)
+struct BlockCacheFileHeader
+{
+  u32 magic;
+  u32 version;
+  u64 settings_hash;
+  u64 layout_hash;
+  u32 code_start;
+  u32 code_end;
+  u32 far_code_start;
+  u32 far_code_end;
+  u32 num_blocks;
+};
+
+struct BlockCacheFileBlock
+{
+  u32 key;
+  u32 num_instructions;
+  u64 guest_code_hash;
+  u32 host_code_offset;
+  u32 host_code_size;
+  u32 num_backpatch_entries;
+};
+
+struct BlockCacheFileBackpatchEntry
+{
+  u32 host_pc_offset;
+  u32 host_slowmem_pc_offset;
+  u32 host_code_size;
+  u8 address_host_reg;
+  u8 value_host_reg;
+  u32 guest_pc;
+  u32 fault_count;
+};
+#pragma pack(pop)
+
+struct CachedBlock
+{
+  u32 num_instructions;
+  u64 guest_code_hash;
+  u32 host_code_offset;
+  u32 host_code_size;
+  std::vector<Recompiler::LoadStoreBackpatchInfo> loadstore_backpatch_info;
+};
+
+using CachedBlockMap = std::unordered_map<u32, CachedBlock>;
+
+static std::string GetBlockCacheFileName();
+static u64 GetBlockCacheSettingsHash();
+static u64 GetBlockCacheLayoutHash();
+static u64 GetGuestCodeHash(const CodeBlock* block);
+static void LoadBlockCache();
+static void SaveBlockCache();
+static bool LookupCachedBlock(CodeBlock* block);
+
+static CachedBlockMap s_cached_blocks;
+static std::string s_block_cache_filename;
+static u64 s_block_cache_settings_hash = 0;
+static u64 s_block_cache_layout_hash = 0;
+static u32 s_dispatcher_code_end = 0;
+static u32 s_dispatcher_far_code_end = 0;
+static bool s_block_cache_active = false;
+static bool s_block_cache_dirty = false;
+
+static u32 s_block_cache_hits = 0;
+static u32 s_block_cache_misses = 0;
+static double s_block_cache_compile_time = 0.0;
+
+#endif
+
 #endif
 
 using BlockMap = std::unordered_map<u32, CodeBlock*>;
@@ -85,6 +215,8 @@ static CodeBlock* LookupBlock(CodeBlockKey key);
 static bool RevalidateBlock(CodeBlock* block);
 
 static bool CompileBlock(CodeBlock* block);
+static bool IsIdleLoop(const CodeBlock& block);
+static bool CanSkipIdleLoop(const CodeBlock& block);
 static void FlushBlock(CodeBlock* block);
 static void AddBlockToPageMap(CodeBlock* block);
 static void RemoveBlockFromPageMap(CodeBlock* block);
@@ -98,7 +230,18 @@ static void UnlinkBlock(CodeBlock* block);
 static void ClearState();
 
 static BlockMap s_blocks;
-static std::array<std::vector<CodeBlock*>, Bus::RAM_CODE_PAGE_COUNT> m_ram_block_map;
+static std::array<std::vector<CodeBlock*>, Bus::RAM_CODE_LINE_COUNT> m_ram_block_map;
+
+static void InvalidateBlock(CodeBlock* block);
+
+static u32 s_invalidation_count = 0;
+static u32 s_compile_count = 0;
+
+static constexpr u32 INVALID_BLOCK_KEY = 0xFFFFFFFFu;
+static u32 s_idle_loop_key = INVALID_BLOCK_KEY;
+static u32 s_idle_loop_global_tick_counter = 0;
+static TickCount s_idle_loop_pending_ticks = 0;
+static u64 s_idle_loop_skipped_ticks = 0;
 
 #ifdef WITH_RECOMPILER
 static HostCodeMap s_host_code_map;
@@ -106,6 +249,53 @@ static HostCodeMap s_host_code_map;
 static void AddBlockToHostCodeMap(CodeBlock* block);
 static void RemoveBlockFromHostCodeMap(CodeBlock* block);
 
+/// Block compile running on the background thread. The worker only sees its own copy of the block, the original is
+/// matched back up by key and id when the result is published on the CPU thread.
+struct AsyncCompileJob
+{
+  CodeBlock* target;
+  u32 id;
+  std::unique_ptr<CodeBlock> block;
+  std::array<u32, static_cast<u8>(Reg::count)> regs;
+  Recompiler::CodeGeneratorSettings settings;
+  bool compiled;
+  bool out_of_space;
+};
+
+static bool IsUsingAsyncCompile();
+static void StartAsyncCompileThread();
+static void StopAsyncCompileThread();
+static void QueueAsyncCompile(CodeBlock* block);
+static void WaitForAsyncCompiles();
+static void CancelAsyncCompiles();
+static void PublishAsyncCompiles();
+static void PublishAsyncCompile(AsyncCompileJob& job);
+static void InterpretPendingBlock(CodeBlock& block);
+static void AsyncCompileThreadEntryPoint();
+
+// While the background thread is running, it is the only one allocating from the code buffer. The CPU thread waits
+// for it to go idle before touching the buffer itself, e.g. to evict a region.
+static std::thread s_async_compile_thread;
+static std::mutex s_async_compile_mutex;
+static std::condition_variable s_async_compile_wake_cv;
+static std::condition_variable s_async_compile_idle_cv;
+static std::deque<AsyncCompileJob> s_async_compile_queue;
+static std::vector<AsyncCompileJob> s_async_compile_results;
+static std::atomic_bool s_async_compile_results_ready{false};
+static u32 s_async_compile_next_id = 1;
+static bool s_async_compile_busy = false;
+static bool s_async_compile_out_of_space = false;
+static bool s_async_compile_shutdown = false;
+
+static bool CanPromoteBlock(const CodeBlock* block);
+static u32 GetHotSuccessorPC(const CodeBlock* block);
+static void PromoteBlock(CodeBlock* block);
+static void LogSuperblockStats();
+
+static u32 s_superblocks_formed = 0;
+static u64 s_superblock_executions = 0;
+static u64 s_superblock_side_exits = 0;
+
 static bool InitializeFastmem();
 static void ShutdownFastmem();
 static Common::PageFaultHandler::HandlerResult LUTPageFaultHandler(void* exception_pc, void* fault_address,
@@ -116,6 +306,14 @@ static Common::PageFaultHandler::HandlerResult MMapPageFaultHandler(void* except
 #endif
 #endif // WITH_RECOMPILER
 
+static CodeBlockProfile& GetBlockProfile(CodeBlockKey key);
+static void UpdateBlockProfile(const CodeBlock* block);
+
+// Node-based, so the pointer to the current profile stays valid as blocks are added.
+static std::unordered_map<u32, CodeBlockProfile> s_block_profiles;
+static CodeBlockProfile* s_current_block_profile = nullptr;
+static u32 s_current_block_profile_start_tick = 0;
+
 void Initialize()
 {
   Assert(s_blocks.empty());
@@ -137,14 +335,26 @@ void Initialize()
     if (g_settings.IsUsingFastmem() && !InitializeFastmem())
       Panic("Failed to initialize fastmem");
 
+    s_guest_register_uses.fill(0);
+    s_guest_register_profiled_blocks = 0;
+    s_pinned_registers_reselect_pending = false;
+
     ResetFastMap();
     CompileDispatcher();
+    s_code_buffer.InitializeRegions(RECOMPILER_CODE_REGION_COUNT);
+    StartAsyncCompileThread();
   }
 #endif
 }
 
 void ClearState()
 {
+#ifdef WITH_RECOMPILER
+  CancelAsyncCompiles();
+  LogSuperblockStats();
+  LogReturnStackStats();
+#endif
+
   Bus::ClearRAMCodePageFlags();
   for (auto& it : m_ram_block_map)
     it.clear();
@@ -153,16 +363,32 @@ void ClearState()
     delete it.second;
 
   s_blocks.clear();
+  s_idle_loop_key = INVALID_BLOCK_KEY;
 #ifdef WITH_RECOMPILER
   s_host_code_map.clear();
   s_code_buffer.Reset();
+  s_code_regions_evicted = 0;
   ResetFastMap();
 #endif
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+  s_cached_blocks.clear();
+  s_block_cache_active = false;
+  s_block_cache_dirty = false;
+#endif
 }
 
 void Shutdown()
 {
+#ifdef WITH_RECOMPILER
+  StopAsyncCompileThread();
+#endif
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+  SaveBlockCache();
+#endif
+
   ClearState();
+  s_block_profiles.clear();
+  s_current_block_profile = nullptr;
 #ifdef WITH_RECOMPILER
   ShutdownFastmem();
   s_code_buffer.Destroy();
@@ -208,10 +434,15 @@ static void ExecuteImpl()
       LogCurrentState();
 #endif
 
+      if (g_settings.cpu_recompiler_block_profiling)
+        ProfileBlockEntry(block->key.bits);
+
       if (g_settings.cpu_recompiler_icache)
         CheckAndUpdateICacheTags(block->icache_line_count, block->uncached_fetch_ticks);
 
       InterpretCachedBlock<pgxp_mode>(*block);
+      if (block->idle_loop)
+        IdleLoopIteration(block->key.bits);
 
       if (g_state.pending_ticks >= g_state.downcount)
         break;
@@ -284,12 +515,14 @@ void Execute()
 
 void CompileDispatcher()
 {
+  SelectPinnedGuestRegisters();
+
   {
-    Recompiler::CodeGenerator cg(&s_code_buffer);
+    Recompiler::CodeGenerator cg(&s_code_buffer, Recompiler::CodeGeneratorSettings::FromGlobalSettings());
     s_asm_dispatcher = cg.CompileDispatcher();
   }
   {
-    Recompiler::CodeGenerator cg(&s_code_buffer);
+    Recompiler::CodeGenerator cg(&s_code_buffer, Recompiler::CodeGeneratorSettings::FromGlobalSettings());
     s_single_block_asm_dispatcher = cg.CompileSingleBlockDispatcher();
   }
 }
@@ -299,6 +532,107 @@ CodeBlock::HostCodePointer* GetFastMapPointer()
   return s_fast_map.data();
 }
 
+CodeBlock::HostCodePointer* GetFastMapSlot(u32 pc)
+{
+  return &s_fast_map[GetFastMapIndex(pc)];
+}
+
+ReturnStack* GetReturnStack()
+{
+  return &s_return_stack;
+}
+
+u32 GetPinnedGuestRegisterCount()
+{
+  return s_pinned_guest_register_count;
+}
+
+Reg GetPinnedGuestRegister(u32 index)
+{
+  DebugAssert(index < s_pinned_guest_register_count);
+  return s_pinned_guest_registers[index];
+}
+
+CodeBlock::HostCodePointer GetCompileBlockStub()
+{
+  return FastCompileBlockFunction;
+}
+
+CodeBlock::HostCodePointer GetPromoteBlockStub()
+{
+  return FastPromoteBlockFunction;
+}
+
+void ProfileGuestRegisterUses(const CodeBlock& block)
+{
+  if (s_guest_register_profiled_blocks >= PINNED_REGISTER_PROFILE_BLOCK_COUNT)
+    return;
+
+  Recompiler::CountBlockRegisterUses(block, &s_guest_register_uses);
+  if (++s_guest_register_profiled_blocks == PINNED_REGISTER_PROFILE_BLOCK_COUNT)
+    s_pinned_registers_reselect_pending = (g_settings.cpu_recompiler_pinned_registers > 0);
+}
+
+u32 GetMostUsedGuestRegisters(std::array<Reg, Recompiler::MAX_PINNED_GUEST_REGISTERS>* regs)
+{
+  const u32 count = std::min<u32>(g_settings.cpu_recompiler_pinned_registers, Recompiler::MAX_PINNED_GUEST_REGISTERS);
+  if (count == 0)
+    return 0;
+
+  // Until the game has run enough code, use the registers which most compiled MIPS code leans on.
+  std::array<Reg, 31> order = {Reg::sp, Reg::ra, Reg::v0, Reg::a0, Reg::v1, Reg::a1, Reg::a2, Reg::a3,
+                               Reg::s0, Reg::s1, Reg::s2, Reg::s3, Reg::s4, Reg::s5, Reg::s6, Reg::s7,
+                               Reg::t0, Reg::t1, Reg::t2, Reg::t3, Reg::t4, Reg::t5, Reg::t6, Reg::t7,
+                               Reg::t8, Reg::t9, Reg::at, Reg::gp, Reg::fp, Reg::k0, Reg::k1};
+  if (s_guest_register_profiled_blocks >= PINNED_REGISTER_PROFILE_BLOCK_COUNT)
+  {
+    std::stable_sort(order.begin(), order.end(), [](Reg lhs, Reg rhs) {
+      return s_guest_register_uses[static_cast<u8>(lhs)] > s_guest_register_uses[static_cast<u8>(rhs)];
+    });
+  }
+
+  std::copy_n(order.begin(), count, regs->begin());
+  return count;
+}
+
+void SelectPinnedGuestRegisters()
+{
+  s_pinned_guest_register_count = GetMostUsedGuestRegisters(&s_pinned_guest_registers);
+  if (s_pinned_guest_register_count == 0)
+    return;
+
+  std::string names;
+  for (u32 i = 0; i < s_pinned_guest_register_count; i++)
+  {
+    if (i > 0)
+      names += ", ";
+    names += GetRegName(s_pinned_guest_registers[i]);
+  }
+  Log_InfoPrintf("Pinning guest registers %s%s", names.c_str(),
+                 (s_guest_register_profiled_blocks >= PINNED_REGISTER_PROFILE_BLOCK_COUNT) ? " (profiled)" : "");
+}
+
+void ReselectPinnedGuestRegisters()
+{
+  std::array<Reg, Recompiler::MAX_PINNED_GUEST_REGISTERS> regs = {};
+  const u32 count = GetMostUsedGuestRegisters(&regs);
+  if (count == s_pinned_guest_register_count &&
+      std::equal(regs.begin(), regs.begin() + count, s_pinned_guest_registers.begin()))
+  {
+    return;
+  }
+
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+  // The cached blocks were compiled with the current registers, keep using them rather than throwing them away.
+  if (s_block_cache_active)
+    return;
+#endif
+
+  // The dispatcher and every block depend on the pinned registers, so everything has to be recompiled.
+  Log_InfoPrintf("Guest register profile differs from pinned registers, flushing all blocks");
+  Flush();
+}
+
 void ExecuteRecompiler()
 {
   g_state.frame_done = false;
@@ -324,6 +658,13 @@ void ExecuteRecompiler()
     TimingEvents::RunEvents();
   }
 #else
+  if (s_pinned_registers_reselect_pending)
+  {
+    s_pinned_registers_reselect_pending = false;
+    ReselectPinnedGuestRegisters();
+  }
+
+  PublishAsyncCompiles();
   s_asm_dispatcher();
 #endif
 
@@ -335,6 +676,13 @@ void ExecuteRecompiler()
 
 void Reinitialize()
 {
+#ifdef WITH_RECOMPILER
+  StopAsyncCompileThread();
+#endif
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+  SaveBlockCache();
+#endif
+
   ClearState();
 
 #ifdef WITH_RECOMPILER
@@ -360,16 +708,34 @@ void Reinitialize()
 
     ResetFastMap();
     CompileDispatcher();
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+    LoadBlockCache();
+#endif
+    s_code_buffer.InitializeRegions(RECOMPILER_CODE_REGION_COUNT);
+    StartAsyncCompileThread();
   }
 #endif
 }
 
 void Flush()
 {
+#ifdef WITH_RECOMPILER
+  CancelAsyncCompiles();
+#endif
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+  SaveBlockCache();
+#endif
+
   ClearState();
 #ifdef WITH_RECOMPILER
   if (g_settings.IsUsingRecompiler())
+  {
     CompileDispatcher();
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+    LoadBlockCache();
+#endif
+    s_code_buffer.InitializeRegions(RECOMPILER_CODE_REGION_COUNT);
+  }
 #endif
 }
 
@@ -404,18 +770,33 @@ CodeBlock* LookupBlock(CodeBlockKey key)
     // ensure it hasn't been invalidated
     CodeBlock* existing_block = iter->second;
     if (!existing_block || !existing_block->invalidated || RevalidateBlock(existing_block))
+    {
+#ifdef WITH_RECOMPILER
+      // didn't fit in the queue last time?
+      if (existing_block && !existing_block->host_code && existing_block->async_compile_id == 0 &&
+          IsUsingAsyncCompile())
+      {
+        QueueAsyncCompile(existing_block);
+      }
+#endif
       return existing_block;
+    }
   }
 
   CodeBlock* block = new CodeBlock(key);
   if (CompileBlock(block))
   {
+    UpdateBlockProfile(block);
+
     // add it to the page map if it's in ram
     AddBlockToPageMap(block);
 
 #ifdef WITH_RECOMPILER
-    SetFastMap(block->GetPC(), block->host_code);
-    AddBlockToHostCodeMap(block);
+    if (block->host_code)
+    {
+      SetFastMap(block->GetPC(), block->host_code);
+      AddBlockToHostCodeMap(block);
+    }
 #endif
   }
   else
@@ -447,7 +828,8 @@ bool RevalidateBlock(CodeBlock* block)
   block->invalidated = false;
   AddBlockToPageMap(block);
 #ifdef WITH_RECOMPILER
-  SetFastMap(block->GetPC(), block->host_code);
+  if (block->host_code)
+    SetFastMap(block->GetPC(), block->host_code);
 #endif
   return true;
 
@@ -457,6 +839,7 @@ recompile:
 #endif
 
   block->instructions.clear();
+  block->interpreter_instructions.clear();
   if (!CompileBlock(block))
   {
     Log_WarningPrintf("Failed to recompile block 0x%08X - flushing.", block->GetPC());
@@ -464,9 +847,16 @@ recompile:
     return false;
   }
 
+  UpdateBlockProfile(block);
+  block->invalidated = false;
+
 #ifdef WITH_RECOMPILER
   // re-add to page map again
-  AddBlockToHostCodeMap(block);
+  if (block->host_code)
+  {
+    AddBlockToHostCodeMap(block);
+    SetFastMap(block->GetPC(), block->host_code);
+  }
 #endif
   if (block->IsInRAM())
     AddBlockToPageMap(block);
@@ -481,6 +871,12 @@ bool CompileBlock(CodeBlock* block)
   bool is_unconditional_branch_delay_slot = false;
   bool is_load_delay_slot = false;
 
+  // superblocks get demoted back to a normal block when they're recompiled
+  block->execution_count = 0;
+  block->branch_taken_count = 0;
+  block->side_exit_count = 0;
+  block->superblock_length = 0;
+
 #if 0
   if (pc == 0x0005aa90)
     __debugbreak();
@@ -580,28 +976,69 @@ bool CompileBlock(CodeBlock* block)
     return false;
   }
 
+  block->idle_loop = g_settings.cpu_idle_loop_skipping && IsIdleLoop(*block);
+  if (block->idle_loop)
+    Log_DevPrintf("Idle loop detected at 0x%08X", block->GetPC());
+
 #ifdef WITH_RECOMPILER
   if (g_settings.IsUsingRecompiler())
   {
+    ProfileGuestRegisterUses(*block);
+
+    if (IsUsingAsyncCompile())
+    {
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+      if (s_block_cache_active && LookupCachedBlock(block))
+      {
+        s_compile_count++;
+        return true;
+      }
+#endif
+
+      // interpreted until the background thread is done with it
+      block->host_code = nullptr;
+      block->host_code_size = 0;
+      block->loadstore_backpatch_info.clear();
+      block->can_promote = false;
+      QueueAsyncCompile(block);
+      return true;
+    }
+
     // Ensure we're not going to run out of space while compiling this block.
-    if (s_code_buffer.GetFreeCodeSpace() <
-          (block->instructions.size() * Recompiler::MAX_NEAR_HOST_BYTES_PER_INSTRUCTION) ||
-        s_code_buffer.GetFreeFarCodeSpace() <
-          (block->instructions.size() * Recompiler::MAX_FAR_HOST_BYTES_PER_INSTRUCTION))
+    if (!HasCodeSpaceForInstructions(block->instructions))
+      EvictOldestCodeRegion();
+
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+    if (s_block_cache_active && LookupCachedBlock(block))
     {
-      Log_WarningPrintf("Out of code space, flushing all blocks.");
-      Flush();
+      s_compile_count++;
+      return true;
     }
 
-    Recompiler::CodeGenerator codegen(&s_code_buffer);
+    Common::Timer compile_timer;
+#endif
+
+    block->can_promote = CanPromoteBlock(block);
+
+    Recompiler::CodeGenerator codegen(&s_code_buffer, Recompiler::CodeGeneratorSettings::FromGlobalSettings());
     if (!codegen.CompileBlock(block, &block->host_code, &block->host_code_size))
     {
       Log_ErrorPrintf("Failed to compile host code for block at 0x%08X", block->key.GetPC());
       return false;
     }
+
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+    if (s_block_cache_active)
+    {
+      s_block_cache_misses++;
+      s_block_cache_compile_time += compile_timer.GetTimeMilliseconds();
+      s_block_cache_dirty = true;
+    }
+#endif
   }
 #endif
 
+  s_compile_count++;
   return true;
 }
 
@@ -609,179 +1046,1173 @@ bool CompileBlock(CodeBlock* block)
 
 void FastCompileBlockFunction()
 {
+  PublishAsyncCompiles();
+
   CodeBlock* block = LookupBlock(GetNextBlockKey());
-  if (block)
+  if (block && block->host_code)
     s_single_block_asm_dispatcher(block->host_code);
+  else if (block)
+    InterpretPendingBlock(*block);
   else
     InterpretUncachedBlock();
 }
 
-#endif
+bool IsUsingAsyncCompile()
+{
+  return s_async_compile_thread.joinable();
+}
+
+void StartAsyncCompileThread()
+{
+  if (!g_settings.cpu_recompiler_async_compile || IsUsingAsyncCompile())
+    return;
+
+  s_async_compile_shutdown = false;
+  s_async_compile_out_of_space = false;
+  s_async_compile_thread = std::thread(AsyncCompileThreadEntryPoint);
+}
 
-void InvalidateBlocksWithPageIndex(u32 page_index)
+void StopAsyncCompileThread()
 {
-  DebugAssert(page_index < Bus::RAM_CODE_PAGE_COUNT);
-  auto& blocks = m_ram_block_map[page_index];
-  for (CodeBlock* block : blocks)
+  if (!IsUsingAsyncCompile())
+    return;
+
+  CancelAsyncCompiles();
   {
-    // Invalidate forces the block to be checked again.
-    Log_DebugPrintf("Invalidating block at 0x%08X", block->GetPC());
-    block->invalidated = true;
-#ifdef WITH_RECOMPILER
-    SetFastMap(block->GetPC(), FastCompileBlockFunction);
-#endif
+    std::unique_lock<std::mutex> lock(s_async_compile_mutex);
+    s_async_compile_shutdown = true;
+    s_async_compile_wake_cv.notify_one();
   }
 
-  // Block will be re-added next execution.
-  blocks.clear();
-  Bus::ClearRAMCodePage(page_index);
+  s_async_compile_thread.join();
 }
 
-void FlushBlock(CodeBlock* block)
+void QueueAsyncCompile(CodeBlock* block)
 {
-  BlockMap::iterator iter = s_blocks.find(block->key.GetPC());
-  Assert(iter != s_blocks.end() && iter->second == block);
-  Log_DevPrintf("Flushing block at address 0x%08X", block->GetPC());
+  {
+    // only this thread adds to the queue, so it can't fill up before we push
+    std::unique_lock<std::mutex> lock(s_async_compile_mutex);
+    if (s_async_compile_queue.size() >= g_settings.cpu_recompiler_async_compile_queue_depth)
+      return;
+  }
 
-#ifdef WITH_RECOMPILER
-  SetFastMap(block->GetPC(), FastCompileBlockFunction);
-#endif
+  AsyncCompileJob job;
+  job.target = block;
+  job.id = s_async_compile_next_id++;
+  if (s_async_compile_next_id == 0)
+    s_async_compile_next_id = 1;
 
-  // if it's been invalidated it won't be in the page map
-  if (block->invalidated)
-    RemoveBlockFromPageMap(block);
+  job.block = std::make_unique<CodeBlock>(block->key);
+  job.block->instructions.reserve(block->instructions.size());
+  for (const CodeBlockInstruction& cbi : block->instructions)
+    job.block->instructions.push_back(cbi);
+  job.block->uncached_fetch_ticks = block->uncached_fetch_ticks;
+  job.block->icache_line_count = block->icache_line_count;
+  job.block->contains_loadstore_instructions = block->contains_loadstore_instructions;
+  job.block->contains_double_branches = block->contains_double_branches;
+  job.block->idle_loop = block->idle_loop;
+  std::copy(std::begin(g_state.regs.r), std::end(g_state.regs.r), job.regs.begin());
+  job.settings = Recompiler::CodeGeneratorSettings::FromGlobalSettings();
+  job.compiled = false;
+  job.out_of_space = false;
+  block->async_compile_id = job.id;
+
+  std::unique_lock<std::mutex> lock(s_async_compile_mutex);
+  s_async_compile_queue.push_back(std::move(job));
+  s_async_compile_wake_cv.notify_one();
+}
 
-  UnlinkBlock(block);
-#ifdef WITH_RECOMPILER
-  RemoveBlockFromHostCodeMap(block);
-#endif
+void WaitForAsyncCompiles()
+{
+  if (!IsUsingAsyncCompile())
+    return;
 
-  s_blocks.erase(iter);
-  delete block;
+  std::unique_lock<std::mutex> lock(s_async_compile_mutex);
+  s_async_compile_idle_cv.wait(lock, []() { return s_async_compile_queue.empty() && !s_async_compile_busy; });
 }
 
-void AddBlockToPageMap(CodeBlock* block)
+void CancelAsyncCompiles()
 {
-  if (!block->IsInRAM())
+  if (!IsUsingAsyncCompile())
     return;
 
-  const u32 start_page = block->GetStartPageIndex();
-  const u32 end_page = block->GetEndPageIndex();
-  for (u32 page = start_page; page <= end_page; page++)
-  {
-    m_ram_block_map[page].push_back(block);
-    Bus::SetRAMCodePage(page);
-  }
+  std::unique_lock<std::mutex> lock(s_async_compile_mutex);
+  s_async_compile_queue.clear();
+  s_async_compile_idle_cv.wait(lock, []() { return !s_async_compile_busy; });
+  s_async_compile_results.clear();
+  s_async_compile_results_ready.store(false);
+  s_async_compile_out_of_space = false;
 }
 
-void RemoveBlockFromPageMap(CodeBlock* block)
+void PublishAsyncCompiles()
 {
-  if (!block->IsInRAM())
+  if (!s_async_compile_results_ready.load())
     return;
 
-  const u32 start_page = block->GetStartPageIndex();
-  const u32 end_page = block->GetEndPageIndex();
-  for (u32 page = start_page; page <= end_page; page++)
+  std::vector<AsyncCompileJob> results;
   {
-    auto& page_blocks = m_ram_block_map[page];
-    auto page_block_iter = std::find(page_blocks.begin(), page_blocks.end(), block);
-    Assert(page_block_iter != page_blocks.end());
-    page_blocks.erase(page_block_iter);
+    std::unique_lock<std::mutex> lock(s_async_compile_mutex);
+    results.swap(s_async_compile_results);
+    s_async_compile_results_ready.store(false);
   }
-}
-
-void LinkBlock(CodeBlock* from, CodeBlock* to)
-{
-  Log_DebugPrintf("Linking block %p(%08x) to %p(%08x)", from, from->GetPC(), to, to->GetPC());
-  from->link_successors.push_back(to);
-  to->link_predecessors.push_back(from);
-}
 
-void UnlinkBlock(CodeBlock* block)
-{
-  for (CodeBlock* predecessor : block->link_predecessors)
+  bool out_of_space = false;
+  for (AsyncCompileJob& job : results)
   {
-    auto iter = std::find(predecessor->link_successors.begin(), predecessor->link_successors.end(), block);
-    Assert(iter != predecessor->link_successors.end());
-    predecessor->link_successors.erase(iter);
+    out_of_space |= job.out_of_space;
+    PublishAsyncCompile(job);
   }
-  block->link_predecessors.clear();
 
-  for (CodeBlock* successor : block->link_successors)
+  if (!out_of_space)
+    return;
+
+  // The background thread skips everything after running out of space, so let it drain the queue, then make room.
+  WaitForAsyncCompiles();
   {
-    auto iter = std::find(successor->link_predecessors.begin(), successor->link_predecessors.end(), block);
-    Assert(iter != successor->link_predecessors.end());
-    successor->link_predecessors.erase(iter);
+    std::unique_lock<std::mutex> lock(s_async_compile_mutex);
+    results.clear();
+    results.swap(s_async_compile_results);
+    s_async_compile_results_ready.store(false);
   }
-  block->link_successors.clear();
-}
+  for (AsyncCompileJob& job : results)
+    PublishAsyncCompile(job);
 
-#ifdef WITH_RECOMPILER
+  EvictOldestCodeRegion();
 
-void AddBlockToHostCodeMap(CodeBlock* block)
+  std::unique_lock<std::mutex> lock(s_async_compile_mutex);
+  s_async_compile_out_of_space = false;
+}
+
+void PublishAsyncCompile(AsyncCompileJob& job)
 {
-  if (!g_settings.IsUsingRecompiler())
+  // The block could have been flushed, or changed and queued again, while it was being compiled.
+  CodeBlock* block = job.target;
+  const CodeBlockKey key = job.block->key;
+  BlockMap::iterator iter = s_blocks.find(key.bits);
+  if (iter == s_blocks.end() || iter->second != block || block->async_compile_id != job.id)
     return;
 
-  auto ir = s_host_code_map.emplace(block->host_code, block);
-  Assert(ir.second);
-}
+  block->async_compile_id = 0;
+  if (!job.compiled)
+  {
+    // Blocks which didn't fit are queued again on their next lookup.
+    if (job.out_of_space)
+      return;
 
-void RemoveBlockFromHostCodeMap(CodeBlock* block)
-{
-  if (!g_settings.IsUsingRecompiler())
+    Log_ErrorPrintf("Failed to compile host code for block at 0x%08X", key.GetPC());
+    FlushBlock(block);
+    s_blocks.emplace(key.bits, nullptr);
     return;
+  }
 
-  HostCodeMap::iterator hc_iter = s_host_code_map.find(block->host_code);
-  Assert(hc_iter != s_host_code_map.end());
-  s_host_code_map.erase(hc_iter);
-}
+  block->host_code = job.block->host_code;
+  block->host_code_size = job.block->host_code_size;
+  block->loadstore_backpatch_info = std::move(job.block->loadstore_backpatch_info);
+  AddBlockToHostCodeMap(block);
 
-bool InitializeFastmem()
-{
-  const CPUFastmemMode mode = g_settings.cpu_fastmem_mode;
-  Assert(mode != CPUFastmemMode::Disabled);
+  // Invalidated blocks still have to be checked against RAM, which the lookup will do.
+  if (!block->invalidated)
+    SetFastMap(block->GetPC(), block->host_code);
 
-#ifdef WITH_MMAP_FASTMEM
-  const auto handler = (mode == CPUFastmemMode::MMap) ? MMapPageFaultHandler : LUTPageFaultHandler;
-#else
-  const auto handler = LUTPageFaultHandler;
-  Assert(mode != CPUFastmemMode::MMap);
-#endif
+  s_compile_count++;
+  UpdateBlockProfile(block);
 
-  if (!Common::PageFaultHandler::InstallHandler(&s_host_code_map, handler))
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+  if (s_block_cache_active)
   {
-    Log_ErrorPrintf("Failed to install page fault handler");
-    return false;
+    s_block_cache_misses++;
+    s_block_cache_dirty = true;
   }
-
-  Bus::UpdateFastmemViews(mode, g_state.cop0_regs.sr.Isc);
-  return true;
+#endif
 }
 
-void ShutdownFastmem()
+void InterpretPendingBlock(CodeBlock& block)
 {
-  Common::PageFaultHandler::RemoveHandler(&s_host_code_map);
-  Bus::UpdateFastmemViews(CPUFastmemMode::Disabled, false);
-}
+  if (g_settings.cpu_recompiler_block_profiling)
+    ProfileBlockEntry(block.key.bits);
 
-#ifdef WITH_MMAP_FASTMEM
+  if (g_settings.cpu_recompiler_icache)
+    CheckAndUpdateICacheTags(block.icache_line_count, block.uncached_fetch_ticks);
 
-Common::PageFaultHandler::HandlerResult MMapPageFaultHandler(void* exception_pc, void* fault_address, bool is_write)
-{
-  if (static_cast<u8*>(fault_address) < g_state.fastmem_base ||
-      (static_cast<u8*>(fault_address) - g_state.fastmem_base) >= Bus::FASTMEM_REGION_SIZE)
+  if (g_settings.gpu_pgxp_enable)
   {
-    return Common::PageFaultHandler::HandlerResult::ExecuteNextHandler;
+    if (g_settings.gpu_pgxp_cpu)
+      InterpretCachedBlock<PGXPMode::CPU>(block);
+    else
+      InterpretCachedBlock<PGXPMode::Memory>(block);
+  }
+  else
+  {
+    InterpretCachedBlock<PGXPMode::Disabled>(block);
   }
 
-  const PhysicalMemoryAddress fastmem_address =
-    static_cast<PhysicalMemoryAddress>(static_cast<ptrdiff_t>(static_cast<u8*>(fault_address) - g_state.fastmem_base));
+  if (block.idle_loop)
+    IdleLoopIteration(block.key.bits);
+}
 
-  Log_DevPrintf("Page fault handler invoked at PC=%p Address=%p %s, fastmem offset 0x%08X", exception_pc, fault_address,
-                is_write ? "(write)" : "(read)", fastmem_address);
+void AsyncCompileThreadEntryPoint()
+{
+  std::unique_lock<std::mutex> lock(s_async_compile_mutex);
+  for (;;)
+  {
+    s_async_compile_wake_cv.wait(lock, []() { return s_async_compile_shutdown || !s_async_compile_queue.empty(); });
+    if (s_async_compile_shutdown)
+      break;
 
-  // use upper_bound to find the next block after the pc
+    AsyncCompileJob job = std::move(s_async_compile_queue.front());
+    s_async_compile_queue.pop_front();
+    s_async_compile_busy = true;
+    job.out_of_space = s_async_compile_out_of_space;
+    lock.unlock();
+
+    if (!job.out_of_space && !HasCodeSpaceForInstructions(job.block->instructions))
+      job.out_of_space = true;
+
+    if (!job.out_of_space)
+    {
+      Recompiler::CodeGenerator codegen(&s_code_buffer, job.settings);
+      codegen.SetSpeculativeRegisterSnapshot(job.regs.data());
+      job.compiled = codegen.CompileBlock(job.block.get(), &job.block->host_code, &job.block->host_code_size);
+    }
+
+    lock.lock();
+    s_async_compile_busy = false;
+    s_async_compile_out_of_space |= job.out_of_space;
+    s_async_compile_results.push_back(std::move(job));
+    s_async_compile_results_ready.store(true);
+    if (s_async_compile_queue.empty())
+      s_async_compile_idle_cv.notify_all();
+  }
+}
+
+bool HasCodeSpaceForInstructions(const std::vector<CodeBlockInstruction>& instructions)
+{
+  size_t near_bytes = 0;
+  for (const CodeBlockInstruction& cbi : instructions)
+  {
+    // GTE commands can be emitted inline, which is much larger than anything else.
+    const bool is_gte_command = (cbi.instruction.op == InstructionOp::cop2 && !cbi.instruction.cop.IsCommonInstruction());
+    near_bytes += is_gte_command ? Recompiler::MAX_NEAR_HOST_BYTES_PER_GTE_INSTRUCTION :
+                                   Recompiler::MAX_NEAR_HOST_BYTES_PER_INSTRUCTION;
+  }
+
+  return (s_code_buffer.GetFreeCodeSpace() >= near_bytes &&
+          s_code_buffer.GetFreeFarCodeSpace() >= (instructions.size() * Recompiler::MAX_FAR_HOST_BYTES_PER_INSTRUCTION));
+}
+
+void EvictOldestCodeRegion()
+{
+  // Blocks are only executed through the fast map, so once they're gone from it nothing references the code.
+  s_code_buffer.AdvanceRegion();
+  const u32 region = s_code_buffer.GetCurrentRegion();
+  const auto region_start = reinterpret_cast<CodeBlock::HostCodePointer>(s_code_buffer.GetRegionCodePointer(region));
+  const auto region_end = reinterpret_cast<CodeBlock::HostCodePointer>(s_code_buffer.GetRegionCodePointer(region) +
+                                                                       s_code_buffer.GetRegionCodeSize());
+
+  std::vector<CodeBlock*> evicted_blocks;
+  for (auto iter = s_host_code_map.lower_bound(region_start);
+       iter != s_host_code_map.end() && iter->first < region_end; ++iter)
+  {
+    evicted_blocks.push_back(iter->second);
+  }
+
+  for (CodeBlock* block : evicted_blocks)
+    FlushBlock(block);
+
+  s_code_regions_evicted++;
+  Log_DevPrintf("Out of code space, evicted %zu blocks from region %u", evicted_blocks.size(), region);
+}
+
+void RequestBlockPromotion(u32 pc)
+{
+  // Can't recompile from inside the block, so do it when the dispatcher next looks it up.
+  SetFastMap(pc, FastPromoteBlockFunction);
+}
+
+void FastPromoteBlockFunction()
+{
+  CodeBlock* block = LookupBlock(GetNextBlockKey());
+  if (block)
+  {
+    if (block->can_promote)
+      PromoteBlock(block);
+
+    SetFastMap(block->GetPC(), block->host_code);
+    s_single_block_asm_dispatcher(block->host_code);
+  }
+  else
+  {
+    InterpretUncachedBlock();
+  }
+}
+
+bool CanPromoteBlock(const CodeBlock* block)
+{
+  // The icache check only covers the lines of the first block, so superblocks can't be used with it.
+  if (!g_settings.cpu_recompiler_tiering || g_settings.cpu_recompiler_icache || block->instructions.size() < 2)
+    return false;
+
+  // The profiling counters live in the block, which the background thread doesn't have access to.
+  if (IsUsingAsyncCompile())
+    return false;
+
+  // Idle loops spend most of their time being skipped, there's nothing to gain.
+  if (block->idle_loop)
+    return false;
+
+  // Block has to end with a direct branch and its delay slot, so we know where it can go.
+  const CodeBlockInstruction& branch = block->instructions[block->instructions.size() - 2];
+  if (!block->instructions.back().is_branch_delay_slot || !IsDirectBranchInstruction(branch.instruction))
+    return false;
+
+  for (const CodeBlockInstruction& cbi : block->instructions)
+  {
+    if (cbi.is_branch_delay_slot && cbi.is_branch_instruction)
+      return false;
+  }
+
+  return true;
+}
+
+u32 GetHotSuccessorPC(const CodeBlock* block)
+{
+  const CodeBlockInstruction& branch = block->instructions[block->instructions.size() - 2];
+  const u32 taken_pc = GetBranchInstructionTarget(branch.instruction, branch.pc);
+  const bool always_taken =
+    (branch.instruction.op == InstructionOp::j || branch.instruction.op == InstructionOp::jal ||
+     (branch.instruction.op == InstructionOp::beq && branch.instruction.i.rs == Reg::zero &&
+      branch.instruction.i.rt == Reg::zero));
+  if (always_taken || (block->branch_taken_count * 2) >= block->execution_count)
+    return taken_pc;
+  else
+    return block->instructions.back().pc + sizeof(Instruction);
+}
+
+void PromoteBlock(CodeBlock* block)
+{
+  // Only try once, if it fails we keep the profiled block.
+  block->can_promote = false;
+
+  std::vector<CodeBlockInstruction> instructions = block->instructions;
+  std::vector<u32> merged_pcs = {block->GetPC()};
+  const CodeBlock* current = block;
+  while (merged_pcs.size() < g_settings.cpu_recompiler_superblock_max_blocks && CanPromoteBlock(current))
+  {
+    CodeBlockKey key = block->key;
+    key.SetPC(GetHotSuccessorPC(current));
+    if (std::find(merged_pcs.begin(), merged_pcs.end(), key.GetPC()) != merged_pcs.end())
+      break;
+
+    // Successor has to be compiled and still valid, otherwise we don't have a profile for it.
+    BlockMap::iterator iter = s_blocks.find(key.bits);
+    if (iter == s_blocks.end() || !iter->second || iter->second->invalidated || iter->second->superblock_length > 0 ||
+        iter->second->IsInRAM() != block->IsInRAM())
+    {
+      break;
+    }
+
+    const CodeBlock* next = iter->second;
+    instructions.back().is_last_instruction = false;
+    instructions.back().is_superblock_exit = true;
+    for (const CodeBlockInstruction& cbi : next->instructions)
+      instructions.push_back(cbi);
+    merged_pcs.push_back(key.GetPC());
+    current = next;
+  }
+
+  if (merged_pcs.size() < 2)
+    return;
+
+  // Don't flush the code buffer from here, the block is still live.
+  if (!HasCodeSpaceForInstructions(instructions))
+    return;
+
+  RemoveBlockFromPageMap(block);
+  RemoveBlockFromHostCodeMap(block);
+
+  std::vector<CodeBlockInstruction> old_instructions = std::move(block->instructions);
+  std::vector<Recompiler::LoadStoreBackpatchInfo> old_backpatch_info = std::move(block->loadstore_backpatch_info);
+  const CodeBlock::HostCodePointer old_host_code = block->host_code;
+  const u32 old_host_code_size = block->host_code_size;
+  const bool old_contains_loadstore_instructions = block->contains_loadstore_instructions;
+
+  block->instructions = std::move(instructions);
+  block->interpreter_instructions.clear();
+  block->loadstore_backpatch_info.clear();
+  block->superblock_length = static_cast<u32>(merged_pcs.size());
+  block->execution_count = 0;
+  block->side_exit_count = 0;
+  for (const CodeBlockInstruction& cbi : block->instructions)
+    block->contains_loadstore_instructions |= (cbi.is_load_instruction || cbi.is_store_instruction);
+
+  Recompiler::CodeGenerator codegen(&s_code_buffer, Recompiler::CodeGeneratorSettings::FromGlobalSettings());
+  if (codegen.CompileBlock(block, &block->host_code, &block->host_code_size))
+  {
+    Log_DevPrintf("Formed superblock at 0x%08X from %u blocks, %zu instructions", block->GetPC(),
+                  block->superblock_length, block->instructions.size());
+    s_superblocks_formed++;
+    s_compile_count++;
+    UpdateBlockProfile(block);
+  }
+  else
+  {
+    Log_ErrorPrintf("Failed to compile superblock at 0x%08X", block->GetPC());
+    block->instructions = std::move(old_instructions);
+    block->loadstore_backpatch_info = std::move(old_backpatch_info);
+    block->host_code = old_host_code;
+    block->host_code_size = old_host_code_size;
+    block->contains_loadstore_instructions = old_contains_loadstore_instructions;
+    block->superblock_length = 0;
+  }
+
+  AddBlockToHostCodeMap(block);
+  AddBlockToPageMap(block);
+}
+
+void LogSuperblockStats()
+{
+  u64 executions = s_superblock_executions;
+  u64 side_exits = s_superblock_side_exits;
+  for (const auto& it : s_blocks)
+  {
+    if (it.second && it.second->superblock_length > 0)
+    {
+      executions += it.second->execution_count;
+      side_exits += it.second->side_exit_count;
+    }
+  }
+
+  if (s_superblocks_formed > 0)
+  {
+    Log_InfoPrintf("Superblocks: %u formed, %" PRIu64 " executions, %" PRIu64 " side exits (%.2f%%)",
+                   s_superblocks_formed, executions, side_exits,
+                   (executions > 0) ? (static_cast<double>(side_exits) * 100.0 / static_cast<double>(executions)) :
+                                      0.0);
+  }
+
+  s_superblocks_formed = 0;
+  s_superblock_executions = 0;
+  s_superblock_side_exits = 0;
+}
+
+void LogReturnStackStats()
+{
+  const u64 predictions = s_return_stack.hits + s_return_stack.misses;
+  if (predictions > 0)
+  {
+    Log_InfoPrintf("Return stack: %" PRIu64 " predictions, %" PRIu64 " hits (%.2f%%)", predictions,
+                   s_return_stack.hits,
+                   static_cast<double>(s_return_stack.hits) * 100.0 / static_cast<double>(predictions));
+  }
+
+  s_return_stack.hits = 0;
+  s_return_stack.misses = 0;
+}
+
+#endif
+
+void InvalidateBlock(CodeBlock* block)
+{
+  // Invalidate forces the block to be checked again.
+  Log_DebugPrintf("Invalidating block at 0x%08X", block->GetPC());
+  RemoveBlockFromPageMap(block);
+  block->invalidated = true;
+  s_invalidation_count++;
+  if (g_settings.cpu_recompiler_block_profiling)
+    GetBlockProfile(block->key).invalidation_count++;
+#ifdef WITH_RECOMPILER
+  SetFastMap(block->GetPC(), FastCompileBlockFunction);
+#endif
+}
+
+void InvalidateBlocksWithLineIndex(u32 line_index)
+{
+  DebugAssert(line_index < Bus::RAM_CODE_LINE_COUNT);
+
+  // Blocks are removed from every line they overlap, which includes this one. They'll be re-added next execution.
+  auto& blocks = m_ram_block_map[line_index];
+  while (!blocks.empty())
+    InvalidateBlock(blocks.back());
+
+  // Other blocks in the same page can keep it write-protected, writes which don't overlap them go through slowmem.
+  const u32 page_index = line_index / Bus::RAM_CODE_LINES_PER_PAGE;
+  if (!Bus::HasRAMCodeLinesInPage(page_index))
+    Bus::ClearRAMCodePage(page_index);
+}
+
+u32 GetInvalidationCount()
+{
+  return s_invalidation_count;
+}
+
+u32 GetCompileCount()
+{
+  return s_compile_count;
+}
+
+static bool GetIdleLoopInstructionRegisters(const Instruction inst, u32* read_mask, u32* write_mask)
+{
+  const auto reg_bit = [](Reg reg) { return (reg != Reg::zero) ? (1u << static_cast<u8>(reg)) : 0u; };
+
+  switch (inst.op)
+  {
+    case InstructionOp::funct:
+    {
+      switch (inst.r.funct)
+      {
+        case InstructionFunct::sll:
+        case InstructionFunct::srl:
+        case InstructionFunct::sra:
+          *read_mask = reg_bit(inst.r.rt);
+          *write_mask = reg_bit(inst.r.rd);
+          return true;
+
+        case InstructionFunct::sllv:
+        case InstructionFunct::srlv:
+        case InstructionFunct::srav:
+        case InstructionFunct::and_:
+        case InstructionFunct::or_:
+        case InstructionFunct::xor_:
+        case InstructionFunct::nor:
+        case InstructionFunct::add:
+        case InstructionFunct::addu:
+        case InstructionFunct::sub:
+        case InstructionFunct::subu:
+        case InstructionFunct::slt:
+        case InstructionFunct::sltu:
+          *read_mask = reg_bit(inst.r.rs) | reg_bit(inst.r.rt);
+          *write_mask = reg_bit(inst.r.rd);
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+    case InstructionOp::lui:
+      *read_mask = 0;
+      *write_mask = reg_bit(inst.i.rt);
+      return true;
+
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+    case InstructionOp::addi:
+    case InstructionOp::addiu:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+    case InstructionOp::lb:
+    case InstructionOp::lbu:
+    case InstructionOp::lh:
+    case InstructionOp::lhu:
+    case InstructionOp::lw:
+      *read_mask = reg_bit(inst.i.rs);
+      *write_mask = reg_bit(inst.i.rt);
+      return true;
+
+    case InstructionOp::lwl:
+    case InstructionOp::lwr:
+      *read_mask = reg_bit(inst.i.rs) | reg_bit(inst.i.rt);
+      *write_mask = reg_bit(inst.i.rt);
+      return true;
+
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+      *read_mask = reg_bit(inst.i.rs) | reg_bit(inst.i.rt);
+      *write_mask = 0;
+      return true;
+
+    case InstructionOp::bgtz:
+    case InstructionOp::blez:
+      *read_mask = reg_bit(inst.i.rs);
+      *write_mask = 0;
+      return true;
+
+    case InstructionOp::b:
+    {
+      // the linking variants write ra
+      if ((static_cast<u8>(inst.i.rt.GetValue()) & u8(0x1E)) == u8(0x10))
+        return false;
+
+      *read_mask = reg_bit(inst.i.rs);
+      *write_mask = 0;
+      return true;
+    }
+
+    case InstructionOp::j:
+      *read_mask = 0;
+      *write_mask = 0;
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+bool IsIdleLoop(const CodeBlock& block)
+{
+  // The block has to be a single branch back to itself, with no stores or other side effects.
+  if (block.contains_double_branches || block.instructions.size() < 2)
+    return false;
+
+  const CodeBlockInstruction& branch = block.instructions[block.instructions.size() - 2];
+  if (!block.instructions.back().is_branch_delay_slot || block.instructions.back().has_load_delay ||
+      !IsDirectBranchInstruction(branch.instruction) ||
+      GetBranchInstructionTarget(branch.instruction, branch.pc) != block.GetPC())
+  {
+    return false;
+  }
+
+  // Every register the loop writes has to be written before it's read, so each iteration only depends on memory and
+  // registers the loop doesn't touch. Loaded values aren't visible until the instruction after the load delay slot.
+  u32 written_regs = 0;
+  u32 delayed_regs = 0;
+  u32 read_before_written_regs = 0;
+  u32 all_written_regs = 0;
+  for (const CodeBlockInstruction& cbi : block.instructions)
+  {
+    u32 read_mask, write_mask;
+    if ((cbi.is_branch_instruction && &cbi != &branch) || cbi.is_store_instruction ||
+        !GetIdleLoopInstructionRegisters(cbi.instruction, &read_mask, &write_mask))
+    {
+      return false;
+    }
+
+    read_before_written_regs |= read_mask & ~written_regs;
+    written_regs |= delayed_regs;
+    delayed_regs = 0;
+    if (cbi.has_load_delay)
+      delayed_regs = write_mask;
+    else
+      written_regs |= write_mask;
+
+    all_written_regs |= write_mask;
+  }
+
+  return (read_before_written_regs & all_written_regs) == 0;
+}
+
+static bool IsIdleLoopReadAddress(VirtualMemoryAddress address)
+{
+  // kseg2 is the cache control register
+  const u32 segment = address >> 29;
+  if (segment >= 6)
+    return false;
+
+  const PhysicalMemoryAddress phys_addr = address & PHYSICAL_MEMORY_ADDRESS_MASK;
+  if (phys_addr < Bus::RAM_MIRROR_END || (phys_addr >= Bus::BIOS_BASE && phys_addr < (Bus::BIOS_BASE + Bus::BIOS_SIZE)))
+    return true;
+
+  // scratchpad isn't accessible through kseg1
+  if ((address & DCACHE_LOCATION_MASK) == DCACHE_LOCATION)
+    return (segment != 5);
+
+  // the interrupt controller has no read side effects, and only changes when events run
+  return (phys_addr == Bus::INTERRUPT_CONTROLLER_BASE || phys_addr == (Bus::INTERRUPT_CONTROLLER_BASE + 4));
+}
+
+bool CanSkipIdleLoop(const CodeBlock& block)
+{
+  // Reads through the isolated cache don't go to memory.
+  if (g_state.cop0_regs.sr.Isc)
+    return false;
+
+  // The base registers are either loop-invariant or written earlier in the iteration, so the registers at the end of
+  // this iteration give the addresses the next iteration will read.
+  for (const CodeBlockInstruction& cbi : block.instructions)
+  {
+    if (!cbi.is_load_instruction)
+      continue;
+
+    const VirtualMemoryAddress address =
+      g_state.regs.r[static_cast<u8>(cbi.instruction.i.rs.GetValue())] + cbi.instruction.i.imm_sext32();
+    if (!IsIdleLoopReadAddress(address))
+      return false;
+  }
+
+  return true;
+}
+
+void IdleLoopIteration(u32 key_bits)
+{
+  // The iteration length is only known once the loop has run back into itself without any events in between.
+  CodeBlockKey key;
+  key.bits = key_bits;
+  const u32 global_tick_counter = TimingEvents::GetGlobalTickCounter();
+  if (g_state.regs.pc != key.GetPC())
+  {
+    s_idle_loop_key = INVALID_BLOCK_KEY;
+    return;
+  }
+  else if (s_idle_loop_key != key_bits || s_idle_loop_global_tick_counter != global_tick_counter)
+  {
+    s_idle_loop_key = key_bits;
+    s_idle_loop_global_tick_counter = global_tick_counter;
+    s_idle_loop_pending_ticks = g_state.pending_ticks;
+    return;
+  }
+
+  const TickCount iteration_ticks = g_state.pending_ticks - s_idle_loop_pending_ticks;
+  s_idle_loop_pending_ticks = g_state.pending_ticks;
+  if (iteration_ticks <= 0)
+    return;
+
+  auto iter = s_blocks.find(key_bits);
+  if (iter == s_blocks.end() || !iter->second || !CanSkipIdleLoop(*iter->second))
+    return;
+
+  const TickCount skipped_ticks = TimingEvents::FastForwardIdleLoop(iteration_ticks);
+  s_idle_loop_pending_ticks += skipped_ticks;
+  s_idle_loop_skipped_ticks += static_cast<u64>(skipped_ticks);
+}
+
+u64 GetIdleLoopSkippedTicks()
+{
+  return s_idle_loop_skipped_ticks;
+}
+
+CodeBlockProfile& GetBlockProfile(CodeBlockKey key)
+{
+  CodeBlockProfile& profile = s_block_profiles[key.bits];
+  profile.key = key;
+  return profile;
+}
+
+void UpdateBlockProfile(const CodeBlock* block)
+{
+  // background compiles are counted when they're published
+  if (!g_settings.cpu_recompiler_block_profiling || block->async_compile_id != 0)
+    return;
+
+  CodeBlockProfile& profile = GetBlockProfile(block->key);
+  profile.instruction_count = static_cast<u32>(block->instructions.size());
+  profile.instruction_pcs.clear();
+  for (const CodeBlockInstruction& cbi : block->instructions)
+    profile.instruction_pcs.push_back(cbi.pc);
+  profile.host_code_size = block->host_code_size;
+  profile.compile_count++;
+}
+
+void ProfileBlockEntry(u32 key_bits)
+{
+  // Events can run between blocks, so use the global counter rather than pending ticks.
+  const u32 tick = TimingEvents::GetGlobalTickCounter() + static_cast<u32>(g_state.pending_ticks);
+  if (s_current_block_profile)
+    s_current_block_profile->cycles += tick - s_current_block_profile_start_tick;
+
+  CodeBlockProfile& profile = s_block_profiles[key_bits];
+  profile.execution_count++;
+  s_current_block_profile = &profile;
+  s_current_block_profile_start_tick = tick;
+}
+
+std::vector<CodeBlockProfile> GetBlockProfiles()
+{
+  std::vector<CodeBlockProfile> profiles;
+  profiles.reserve(s_block_profiles.size());
+  for (const auto& it : s_block_profiles)
+  {
+    if (it.second.execution_count > 0)
+      profiles.push_back(it.second);
+  }
+
+  std::sort(profiles.begin(), profiles.end(), [](const CodeBlockProfile& lhs, const CodeBlockProfile& rhs) {
+    return (lhs.cycles != rhs.cycles) ? (lhs.cycles > rhs.cycles) : (lhs.key.bits < rhs.key.bits);
+  });
+  return profiles;
+}
+
+void ResetBlockProfiles()
+{
+  // Entries are kept, since the blocks still refer to them.
+  for (auto& it : s_block_profiles)
+  {
+    it.second.execution_count = 0;
+    it.second.cycles = 0;
+    it.second.compile_count = 0;
+    it.second.invalidation_count = 0;
+  }
+
+  s_current_block_profile = nullptr;
+}
+
+static void DisassembleBlockProfile(const CodeBlockProfile& profile, std::vector<std::string>* lines)
+{
+  SmallString disasm;
+  for (const u32 pc : profile.instruction_pcs)
+  {
+    // Disassemble what's in memory now, the block may have been flushed since.
+    u32 bits;
+    if (!SafeReadInstruction(pc, &bits))
+      break;
+
+    DisassembleInstruction(&disasm, pc, bits, nullptr);
+    lines->push_back(StringUtil::StdStringFromFormat("%08X %s", pc, disasm.GetCharArray()));
+  }
+}
+
+bool WriteBlockProfileReport(const char* filename)
+{
+  auto fp = FileSystem::OpenManagedCFile(filename, "wb");
+  if (!fp)
+  {
+    Log_ErrorPrintf("Failed to open '%s' for writing", filename);
+    return false;
+  }
+
+  const std::vector<CodeBlockProfile> profiles = GetBlockProfiles();
+  u64 total_cycles = 0;
+  for (const CodeBlockProfile& profile : profiles)
+    total_cycles += profile.cycles;
+
+  const char* extension = std::strrchr(filename, '.');
+  const bool json = (extension && StringUtil::Strcasecmp(extension, ".json") == 0);
+  if (json)
+    std::fprintf(fp.get(), "{\n  \"total_cycles\": %" PRIu64 ",\n  \"blocks\": [", total_cycles);
+  else
+    std::fprintf(fp.get(), "pc,user_mode,executions,cycles,percent,instructions,host_code_size,compiles,"
+                           "invalidations,disassembly\n");
+
+  std::vector<std::string> lines;
+  for (size_t i = 0; i < profiles.size(); i++)
+  {
+    const CodeBlockProfile& profile = profiles[i];
+    const double percent =
+      (total_cycles > 0) ? (static_cast<double>(profile.cycles) * 100.0 / static_cast<double>(total_cycles)) : 0.0;
+
+    lines.clear();
+    DisassembleBlockProfile(profile, &lines);
+
+    if (json)
+    {
+      std::fprintf(fp.get(),
+                   "%s\n    {\"pc\": \"0x%08X\", \"user_mode\": %s, \"executions\": %" PRIu64 ", \"cycles\": %" PRIu64
+                   ", \"percent\": %.4f, \"instructions\": %u, \"host_code_size\": %u, \"compiles\": %u, "
+                   "\"invalidations\": %u, \"disassembly\": [",
+                   (i > 0) ? "," : "", profile.key.GetPC(), profile.key.user_mode ? "true" : "false",
+                   profile.execution_count, profile.cycles, percent, profile.instruction_count,
+                   profile.host_code_size, profile.compile_count, profile.invalidation_count);
+      for (size_t j = 0; j < lines.size(); j++)
+        std::fprintf(fp.get(), "%s\"%s\"", (j > 0) ? ", " : "", lines[j].c_str());
+      std::fprintf(fp.get(), "]}");
+    }
+    else
+    {
+      std::fprintf(fp.get(), "0x%08X,%u,%" PRIu64 ",%" PRIu64 ",%.4f,%u,%u,%u,%u,\"", profile.key.GetPC(),
+                   profile.key.user_mode ? 1u : 0u, profile.execution_count, profile.cycles, percent,
+                   profile.instruction_count, profile.host_code_size, profile.compile_count,
+                   profile.invalidation_count);
+      for (size_t j = 0; j < lines.size(); j++)
+        std::fprintf(fp.get(), "%s%s", (j > 0) ? "; " : "", lines[j].c_str());
+      std::fprintf(fp.get(), "\"\n");
+    }
+  }
+
+  if (json)
+    std::fprintf(fp.get(), "\n  ]\n}\n");
+
+  Log_InfoPrintf("Wrote profile of %zu blocks to '%s'", profiles.size(), filename);
+  return true;
+}
+
+void DrawDebugWindow()
+{
+#ifdef WITH_IMGUI
+  static constexpr u32 NUM_COLUMNS = 8;
+  static constexpr std::array<const char*, NUM_COLUMNS> column_names = {
+    {"Address", "Executions", "Cycles", "%", "Cycles/Exec", "Instructions", "Host Bytes", "Compiles/Invalidations"}};
+  static constexpr size_t MAX_DISPLAYED_BLOCKS = 200;
+  static u32 selected_key = 0;
+
+  const float framebuffer_scale = ImGui::GetIO().DisplayFramebufferScale.x;
+
+  ImGui::SetNextWindowSize(ImVec2(800.0f * framebuffer_scale, 500.0f * framebuffer_scale), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Block Profile", &g_settings.debugging.show_block_profile))
+  {
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Text("Invalidations: %.0f/s  Compiles: %.0f/s", System::GetBlockInvalidationsPerSecond(),
+              System::GetBlockCompilesPerSecond());
+
+#ifdef WITH_RECOMPILER
+  if (g_settings.IsUsingRecompiler() && g_settings.cpu_recompiler_return_stack)
+  {
+    const u64 predictions = s_return_stack.hits + s_return_stack.misses;
+    const double hit_rate =
+      (predictions > 0) ? (static_cast<double>(s_return_stack.hits) * 100.0 / static_cast<double>(predictions)) : 0.0;
+    ImGui::Text("Return Predictions: %" PRIu64 "  Hit Rate: %.2f%%", predictions, hit_rate);
+  }
+#endif
+
+  if (!g_settings.cpu_recompiler_block_profiling || g_settings.cpu_execution_mode == CPUExecutionMode::Interpreter)
+  {
+    ImGui::TextUnformatted("Block profiling requires the recompiler or cached interpreter, and the");
+    ImGui::TextUnformatted("\"Enable Recompiler Block Profiling\" option in the advanced settings.");
+    ImGui::End();
+    return;
+  }
+
+  if (ImGui::Button("Reset"))
+    ResetBlockProfiles();
+
+  ImGui::SameLine();
+  const bool save_csv = ImGui::Button("Save CSV");
+  ImGui::SameLine();
+  const bool save_json = ImGui::Button("Save JSON");
+  if (save_csv || save_json)
+  {
+    const std::string& code = System::GetRunningCode();
+    const std::string filename = g_host_interface->GetUserDirectoryRelativePath(
+      "blockprofile_%s.%s", code.empty() ? "default" : code.c_str(), save_json ? "json" : "csv");
+    if (WriteBlockProfileReport(filename.c_str()))
+      g_host_interface->AddFormattedOSDMessage(5.0f, "Block profile saved to '%s'.", filename.c_str());
+  }
+
+  const std::vector<CodeBlockProfile> profiles = GetBlockProfiles();
+  u64 total_cycles = 0;
+  for (const CodeBlockProfile& profile : profiles)
+    total_cycles += profile.cycles;
+
+  ImGui::Text("%zu blocks executed, %" PRIu64 " cycles", profiles.size(), total_cycles);
+  ImGui::Separator();
+
+  const CodeBlockProfile* selected_profile = nullptr;
+  ImGui::BeginChild("Blocks", ImVec2(0.0f, ImGui::GetWindowHeight() * 0.6f));
+  ImGui::Columns(NUM_COLUMNS);
+  for (const char* title : column_names)
+  {
+    ImGui::TextUnformatted(title);
+    ImGui::NextColumn();
+  }
+
+  for (size_t i = 0; i < std::min(profiles.size(), MAX_DISPLAYED_BLOCKS); i++)
+  {
+    const CodeBlockProfile& profile = profiles[i];
+    const bool selected = (profile.key.bits == selected_key);
+    if (selected)
+      selected_profile = &profile;
+
+    TinyString label;
+    label.Format("%08X%s##%u", profile.key.GetPC(), profile.key.user_mode ? " (U)" : "", profile.key.bits);
+    if (ImGui::Selectable(label, selected, ImGuiSelectableFlags_SpanAllColumns))
+      selected_key = profile.key.bits;
+    ImGui::NextColumn();
+    ImGui::Text("%" PRIu64, profile.execution_count);
+    ImGui::NextColumn();
+    ImGui::Text("%" PRIu64, profile.cycles);
+    ImGui::NextColumn();
+    ImGui::Text("%.2f",
+                (total_cycles > 0) ? (static_cast<double>(profile.cycles) * 100.0 / static_cast<double>(total_cycles)) :
+                                     0.0);
+    ImGui::NextColumn();
+    ImGui::Text("%.1f", static_cast<double>(profile.cycles) / static_cast<double>(profile.execution_count));
+    ImGui::NextColumn();
+    ImGui::Text("%u", profile.instruction_count);
+    ImGui::NextColumn();
+    ImGui::Text("%u", profile.host_code_size);
+    ImGui::NextColumn();
+    ImGui::Text("%u/%u", profile.compile_count, profile.invalidation_count);
+    ImGui::NextColumn();
+  }
+
+  ImGui::Columns(1);
+  ImGui::EndChild();
+  ImGui::Separator();
+
+  if (selected_profile)
+  {
+    std::vector<std::string> lines;
+    DisassembleBlockProfile(*selected_profile, &lines);
+    ImGui::BeginChild("Disassembly");
+    for (const std::string& line : lines)
+      ImGui::TextUnformatted(line.c_str());
+    ImGui::EndChild();
+  }
+  else
+  {
+    ImGui::TextUnformatted("Select a block to show its disassembly.");
+  }
+
+  ImGui::End();
+#endif
+}
+
+void FlushBlock(CodeBlock* block)
+{
+  BlockMap::iterator iter = s_blocks.find(block->key.GetPC());
+  Assert(iter != s_blocks.end() && iter->second == block);
+  Log_DevPrintf("Flushing block at address 0x%08X", block->GetPC());
+
+#ifdef WITH_RECOMPILER
+  SetFastMap(block->GetPC(), FastCompileBlockFunction);
+#endif
+
+  // if it's been invalidated it won't be in the page map
+  if (!block->invalidated)
+    RemoveBlockFromPageMap(block);
+
+  UnlinkBlock(block);
+#ifdef WITH_RECOMPILER
+  RemoveBlockFromHostCodeMap(block);
+  if (block->superblock_length > 0)
+  {
+    s_superblock_executions += block->execution_count;
+    s_superblock_side_exits += block->side_exit_count;
+  }
+#endif
+
+  s_blocks.erase(iter);
+  delete block;
+}
+
+template<typename T>
+static void EnumerateBlockLines(const CodeBlock* block, T callback)
+{
+  if (block->superblock_length == 0)
+  {
+    // blocks running off the end of RAM continue in the mirror
+    const u32 start_line = block->GetStartLineIndex();
+    const u32 end_line = block->GetEndLineIndex();
+    for (u32 line = start_line; line <= end_line; line++)
+      callback(line % Bus::RAM_CODE_LINE_COUNT);
+
+    return;
+  }
+
+  // superblocks aren't contiguous, so go by the instructions instead
+  std::vector<u32> lines;
+  for (const CodeBlockInstruction& cbi : block->instructions)
+  {
+    const u32 line = Bus::GetRAMCodeLineIndex(cbi.pc & PHYSICAL_MEMORY_ADDRESS_MASK);
+    if (std::find(lines.begin(), lines.end(), line) == lines.end())
+      lines.push_back(line);
+  }
+  for (const u32 line : lines)
+    callback(line);
+}
+
+void AddBlockToPageMap(CodeBlock* block)
+{
+  if (!block->IsInRAM())
+    return;
+
+  EnumerateBlockLines(block, [block](u32 line) {
+    m_ram_block_map[line].push_back(block);
+    Bus::SetRAMCodeLine(line);
+  });
+}
+
+void RemoveBlockFromPageMap(CodeBlock* block)
+{
+  if (!block->IsInRAM())
+    return;
+
+  // The line bit is dropped with the last block, but the page stays protected until it's invalidated. Otherwise
+  // recompiling a block would toggle the page protection on every call.
+  EnumerateBlockLines(block, [block](u32 line) {
+    auto& line_blocks = m_ram_block_map[line];
+    auto line_block_iter = std::find(line_blocks.begin(), line_blocks.end(), block);
+    Assert(line_block_iter != line_blocks.end());
+    line_blocks.erase(line_block_iter);
+    if (line_blocks.empty())
+      Bus::ClearRAMCodeLine(line);
+  });
+}
+
+void LinkBlock(CodeBlock* from, CodeBlock* to)
+{
+  Log_DebugPrintf("Linking block %p(%08x) to %p(%08x)", from, from->GetPC(), to, to->GetPC());
+  from->link_successors.push_back(to);
+  to->link_predecessors.push_back(from);
+}
+
+void UnlinkBlock(CodeBlock* block)
+{
+  for (CodeBlock* predecessor : block->link_predecessors)
+  {
+    auto iter = std::find(predecessor->link_successors.begin(), predecessor->link_successors.end(), block);
+    Assert(iter != predecessor->link_successors.end());
+    predecessor->link_successors.erase(iter);
+  }
+  block->link_predecessors.clear();
+
+  for (CodeBlock* successor : block->link_successors)
+  {
+    auto iter = std::find(successor->link_predecessors.begin(), successor->link_predecessors.end(), block);
+    Assert(iter != successor->link_predecessors.end());
+    successor->link_predecessors.erase(iter);
+  }
+  block->link_successors.clear();
+}
+
+#ifdef WITH_RECOMPILER
+
+void AddBlockToHostCodeMap(CodeBlock* block)
+{
+  if (!g_settings.IsUsingRecompiler() || !block->host_code)
+    return;
+
+  auto ir = s_host_code_map.emplace(block->host_code, block);
+  Assert(ir.second);
+}
+
+void RemoveBlockFromHostCodeMap(CodeBlock* block)
+{
+  if (!g_settings.IsUsingRecompiler() || !block->host_code)
+    return;
+
+  HostCodeMap::iterator hc_iter = s_host_code_map.find(block->host_code);
+  Assert(hc_iter != s_host_code_map.end());
+  s_host_code_map.erase(hc_iter);
+}
+
+bool InitializeFastmem()
+{
+  const CPUFastmemMode mode = g_settings.cpu_fastmem_mode;
+  Assert(mode != CPUFastmemMode::Disabled);
+
+#ifdef WITH_MMAP_FASTMEM
+  const auto handler = (mode == CPUFastmemMode::MMap) ? MMapPageFaultHandler : LUTPageFaultHandler;
+#else
+  const auto handler = LUTPageFaultHandler;
+  Assert(mode != CPUFastmemMode::MMap);
+#endif
+
+  if (!Common::PageFaultHandler::InstallHandler(&s_host_code_map, handler))
+  {
+    Log_ErrorPrintf("Failed to install page fault handler");
+    return false;
+  }
+
+  Bus::UpdateFastmemViews(mode, g_state.cop0_regs.sr.Isc);
+  return true;
+}
+
+void ShutdownFastmem()
+{
+  Common::PageFaultHandler::RemoveHandler(&s_host_code_map);
+  Bus::UpdateFastmemViews(CPUFastmemMode::Disabled, false);
+}
+
+#ifdef WITH_MMAP_FASTMEM
+
+Common::PageFaultHandler::HandlerResult MMapPageFaultHandler(void* exception_pc, void* fault_address, bool is_write)
+{
+  if (static_cast<u8*>(fault_address) < g_state.fastmem_base ||
+      (static_cast<u8*>(fault_address) - g_state.fastmem_base) >= Bus::FASTMEM_REGION_SIZE)
+  {
+    return Common::PageFaultHandler::HandlerResult::ExecuteNextHandler;
+  }
+
+  const PhysicalMemoryAddress fastmem_address =
+    static_cast<PhysicalMemoryAddress>(static_cast<ptrdiff_t>(static_cast<u8*>(fault_address) - g_state.fastmem_base));
+
+  Log_DevPrintf("Page fault handler invoked at PC=%p Address=%p %s, fastmem offset 0x%08X", exception_pc, fault_address,
+                is_write ? "(write)" : "(read)", fastmem_address);
+
+  // use upper_bound to find the next block after the pc
   HostCodeMap::iterator upper_iter =
     s_host_code_map.upper_bound(reinterpret_cast<CodeBlock::HostCodePointer>(exception_pc));
   if (upper_iter == s_host_code_map.begin())
@@ -806,8 +2237,19 @@ Common::PageFaultHandler::HandlerResult MMapPageFaultHandler(void* exception_pc,
         {
           if (++lbi.fault_count < CODE_WRITE_FAULT_THRESHOLD_FOR_SLOWMEM)
           {
-            InvalidateBlocksWithPageIndex(code_page_index);
-            return Common::PageFaultHandler::HandlerResult::ContinueExecution;
+            // only throw away the blocks which overlap the write, stores are never wider than a word
+            const u32 code_line_index = Bus::GetRAMCodeLineIndex(fastmem_address);
+            if (Bus::IsRAMCodeLine(code_line_index))
+              InvalidateBlocksWithLineIndex(code_line_index);
+            else if (!Bus::HasRAMCodeLinesInPage(code_page_index))
+              Bus::ClearRAMCodePage(code_page_index);
+
+            if (!Bus::IsRAMCodePage(code_page_index))
+              return Common::PageFaultHandler::HandlerResult::ContinueExecution;
+
+            // the rest of the page still has code, so the write has to go through slowmem
+            Log_DevPrintf("Backpatching data write at %p (%08X) address %p (%08X) to slowmem, page contains code",
+                          exception_pc, lbi.guest_pc, fault_address, fastmem_address);
           }
           else
           {
@@ -878,6 +2320,360 @@ Common::PageFaultHandler::HandlerResult LUTPageFaultHandler(void* exception_pc,
   return Common::PageFaultHandler::HandlerResult::ExecuteNextHandler;
 }
 
+
+#ifdef USE_PERSISTENT_BLOCK_CACHE
+
+std::string GetBlockCacheFileName()
+{
+  const std::string& code = System::GetRunningCode();
+  return g_host_interface->GetUserDirectoryRelativePath("cache" FS_OSPATH_SEPARATOR_STR "recompiler_%s.bin",
+                                                       code.empty() ? "default" : code.c_str());
+}
+
+u64 GetBlockCacheSettingsHash()
+{
+  // Everything which changes the code generated for a block goes in here. This is called after the dispatcher is
+  // compiled, so the pinned registers are the ones the blocks would be compiled with, not just the configured count.
+  const u32 values[] = {static_cast<u32>(g_settings.cpu_fastmem_mode),
+                        static_cast<u32>(g_settings.cpu_recompiler_memory_exceptions),
+                        static_cast<u32>(g_settings.cpu_recompiler_icache),
+                        static_cast<u32>(g_settings.gpu_pgxp_enable),
+                        static_cast<u32>(g_settings.gpu_pgxp_culling),
+                        static_cast<u32>(g_settings.gpu_widescreen_hack),
+                        static_cast<u32>(g_settings.cpu_recompiler_block_profiling),
+                        static_cast<u32>(g_settings.cpu_idle_loop_skipping),
+                        static_cast<u32>(g_settings.cpu_recompiler_return_stack),
+                        static_cast<u32>(s_pinned_guest_register_count),
+                        static_cast<u32>(sizeof(State)),
+                        static_cast<u32>(sizeof(Recompiler::LoadStoreBackpatchInfo))};
+
+  XXH64_state_t* state = XXH64_createState();
+  XXH64_reset(state, 0);
+  XXH64_update(state, values, sizeof(values));
+  XXH64_update(state, s_pinned_guest_registers.data(), s_pinned_guest_register_count * sizeof(Reg));
+  const u64 hash = XXH64_digest(state);
+  XXH64_freeState(state);
+  return hash;
+}
+
+u64 GetBlockCacheLayoutHash()
+{
+  // The dispatcher contains relative references to the CPU state, fast map and event functions. On top of that, mix
+  // in the locations of the thunks, which the blocks call, so that a rebuilt executable invalidates the cache. Loads
+  // and stores to constant addresses embed pointers to RAM and the BIOS, and RAM is a memory arena view which can be
+  // mapped somewhere else in the next session.
+  const u8* code_storage = s_code_storage;
+  const auto offset_of = [code_storage](const void* ptr) {
+    return static_cast<s64>(reinterpret_cast<intptr_t>(ptr) - reinterpret_cast<intptr_t>(code_storage));
+  };
+
+  std::vector<s64> offsets = {
+    offset_of(&g_state),
+    offset_of(s_fast_map.data()),
+    offset_of(Bus::g_ram),
+    offset_of(Bus::g_bios),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::InterpretInstruction)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::InterpretInstructionPGXP)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::ReadMemoryByte)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::ReadMemoryHalfWord)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::ReadMemoryWord)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::WriteMemoryByte)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::WriteMemoryHalfWord)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::WriteMemoryWord)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::UncheckedReadMemoryByte)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::UncheckedReadMemoryHalfWord)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::UncheckedReadMemoryWord)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::UncheckedWriteMemoryByte)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::UncheckedWriteMemoryHalfWord)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::UncheckedWriteMemoryWord)),
+    offset_of(reinterpret_cast<const void*>(&Recompiler::Thunks::UpdateFastmemMapping)),
+    offset_of(reinterpret_cast<const void*>(&PGXP::CPU_MTC2)),
+    offset_of(reinterpret_cast<const void*>(&IdleLoopIteration)),
+    offset_of(&s_return_stack),
+    offset_of(GTE::GetUNRTable()),
+  };
+  const bool pgxp_culling = g_settings.gpu_pgxp_enable && g_settings.gpu_pgxp_culling;
+  for (u32 command = 0; command < 64; command++)
+    offsets.push_back(offset_of(reinterpret_cast<const void*>(GTE::GetInstructionImpl(command, pgxp_culling))));
+
+  XXH64_state_t* state = XXH64_createState();
+  XXH64_reset(state, 0);
+  XXH64_update(state, offsets.data(), offsets.size() * sizeof(s64));
+  XXH64_update(state, s_code_buffer.GetCodePointer(),
+               static_cast<size_t>((s_code_storage + s_dispatcher_code_end) - s_code_buffer.GetCodePointer()));
+  XXH64_update(state, s_code_buffer.GetFarCodePointer(),
+               static_cast<size_t>((s_code_storage + s_dispatcher_far_code_end) - s_code_buffer.GetFarCodePointer()));
+  const u64 hash = XXH64_digest(state);
+  XXH64_freeState(state);
+  return hash;
+}
+
+u64 GetGuestCodeHash(const CodeBlock* block)
+{
+  XXH64_state_t* state = XXH64_createState();
+  XXH64_reset(state, 0);
+  for (const CodeBlockInstruction& cbi : block->instructions)
+    XXH64_update(state, &cbi.instruction.bits, sizeof(cbi.instruction.bits));
+  const u64 hash = XXH64_digest(state);
+  XXH64_freeState(state);
+  return hash;
+}
+
+void LoadBlockCache()
+{
+  s_cached_blocks.clear();
+  s_block_cache_active = false;
+  s_block_cache_dirty = false;
+  s_dispatcher_code_end = static_cast<u32>(s_code_buffer.GetFreeCodePointer() - s_code_storage);
+  s_dispatcher_far_code_end = static_cast<u32>(s_code_buffer.GetFreeFarCodePointer() - s_code_storage);
+  if (!g_settings.cpu_recompiler_block_cache)
+    return;
+
+  // Profiled blocks reference their counters by address, which won't be valid in the next session.
+  if (g_settings.cpu_recompiler_tiering || g_settings.cpu_recompiler_block_profiling)
+  {
+    Log_WarningPrintf("Recompiler block cache is not supported with tiering or block profiling, ignoring.");
+    return;
+  }
+
+  s_block_cache_filename = GetBlockCacheFileName();
+  s_block_cache_settings_hash = GetBlockCacheSettingsHash();
+  s_block_cache_layout_hash = GetBlockCacheLayoutHash();
+  s_block_cache_active = true;
+
+  auto fp = FileSystem::OpenManagedCFile(s_block_cache_filename.c_str(), "rb");
+  if (!fp)
+  {
+    Log_InfoPrintf("No recompiler block cache found at '%s'", s_block_cache_filename.c_str());
+    return;
+  }
+
+  BlockCacheFileHeader header;
+  if (std::fread(&header, sizeof(header), 1, fp.get()) != 1 || header.magic != BLOCK_CACHE_FILE_MAGIC ||
+      header.version != BLOCK_CACHE_FILE_VERSION)
+  {
+    Log_WarningPrintf("Recompiler block cache '%s' is corrupted or from an old version, ignoring",
+                      s_block_cache_filename.c_str());
+    return;
+  }
+
+  if (header.settings_hash != s_block_cache_settings_hash || header.layout_hash != s_block_cache_layout_hash ||
+      header.code_start != s_dispatcher_code_end || header.far_code_start != s_dispatcher_far_code_end)
+  {
+    Log_WarningPrintf("Recompiler block cache '%s' was created with different settings or executable, ignoring",
+                      s_block_cache_filename.c_str());
+    return;
+  }
+
+  const u32 code_size = header.code_end - header.code_start;
+  const u32 far_code_size = header.far_code_end - header.far_code_start;
+  if (header.code_end < header.code_start || header.far_code_end < header.far_code_start ||
+      code_size > (s_code_buffer.GetFreeCodeSpace() / 2) || far_code_size > (s_code_buffer.GetFreeFarCodeSpace() / 2))
+  {
+    Log_WarningPrintf("Recompiler block cache '%s' is too large, ignoring", s_block_cache_filename.c_str());
+    return;
+  }
+
+  // Read straight into the free space, it doesn't get committed until the block list is validated.
+  if ((code_size > 0 && std::fread(s_code_buffer.GetFreeCodePointer(), code_size, 1, fp.get()) != 1) ||
+      (far_code_size > 0 && std::fread(s_code_buffer.GetFreeFarCodePointer(), far_code_size, 1, fp.get()) != 1))
+  {
+    Log_ErrorPrintf("Failed to read code from recompiler block cache '%s'", s_block_cache_filename.c_str());
+    return;
+  }
+
+  CachedBlockMap blocks;
+  blocks.reserve(header.num_blocks);
+  for (u32 i = 0; i < header.num_blocks; i++)
+  {
+    BlockCacheFileBlock fblock;
+    if (std::fread(&fblock, sizeof(fblock), 1, fp.get()) != 1 || fblock.host_code_offset < header.code_start ||
+        (fblock.host_code_offset + fblock.host_code_size) > header.code_end)
+    {
+      Log_ErrorPrintf("Failed to read block %u from recompiler block cache '%s'", i, s_block_cache_filename.c_str());
+      return;
+    }
+
+    CachedBlock cblock;
+    cblock.num_instructions = fblock.num_instructions;
+    cblock.guest_code_hash = fblock.guest_code_hash;
+    cblock.host_code_offset = fblock.host_code_offset;
+    cblock.host_code_size = fblock.host_code_size;
+    cblock.loadstore_backpatch_info.reserve(fblock.num_backpatch_entries);
+    for (u32 j = 0; j < fblock.num_backpatch_entries; j++)
+    {
+      BlockCacheFileBackpatchEntry fbpi;
+      if (std::fread(&fbpi, sizeof(fbpi), 1, fp.get()) != 1 || fbpi.host_pc_offset >= header.code_end ||
+          fbpi.host_slowmem_pc_offset >= header.far_code_end)
+      {
+        Log_ErrorPrintf("Failed to read backpatch info for block %u from recompiler block cache '%s'", i,
+                        s_block_cache_filename.c_str());
+        return;
+      }
+
+      Recompiler::LoadStoreBackpatchInfo& lbi = cblock.loadstore_backpatch_info.emplace_back();
+      lbi.host_pc = s_code_storage + fbpi.host_pc_offset;
+      lbi.host_slowmem_pc = s_code_storage + fbpi.host_slowmem_pc_offset;
+      lbi.host_code_size = fbpi.host_code_size;
+      lbi.address_host_reg = static_cast<Recompiler::HostReg>(fbpi.address_host_reg);
+      lbi.value_host_reg = static_cast<Recompiler::HostReg>(fbpi.value_host_reg);
+      lbi.guest_pc = fbpi.guest_pc;
+      lbi.fault_count = fbpi.fault_count;
+    }
+
+    blocks.emplace(fblock.key, std::move(cblock));
+  }
+
+  s_code_buffer.CommitCode(code_size);
+  s_code_buffer.CommitFarCode(far_code_size);
+  s_cached_blocks = std::move(blocks);
+
+  Log_InfoPrintf("Loaded %zu blocks (%u bytes of host code) from recompiler block cache '%s'", s_cached_blocks.size(),
+                 code_size + far_code_size, s_block_cache_filename.c_str());
+}
+
+void SaveBlockCache()
+{
+  if (!s_block_cache_active)
+    return;
+
+  Log_InfoPrintf("Recompiler block cache: %u hits, %u misses, %.2f ms spent compiling, ~%.2f ms saved",
+                 s_block_cache_hits, s_block_cache_misses, s_block_cache_compile_time,
+                 (s_block_cache_misses > 0) ?
+                   (s_block_cache_compile_time / static_cast<double>(s_block_cache_misses) * s_block_cache_hits) :
+                   0.0);
+
+  if (!s_block_cache_dirty)
+    return;
+
+  // Once the code buffer has wrapped around, the used space is no longer contiguous.
+  if (s_code_regions_evicted > 0)
+  {
+    Log_WarningPrintf("Not saving recompiler block cache, code buffer has wrapped around");
+    return;
+  }
+
+  const u32 code_end = static_cast<u32>(s_code_buffer.GetFreeCodePointer() - s_code_storage);
+  const u32 far_code_end = static_cast<u32>(s_code_buffer.GetFreeFarCodePointer() - s_code_storage);
+  const u32 code_size = code_end - s_dispatcher_code_end;
+  const u32 far_code_size = far_code_end - s_dispatcher_far_code_end;
+  if (code_size > ((code_size + s_code_buffer.GetFreeCodeSpace()) / 2) ||
+      far_code_size > ((far_code_size + s_code_buffer.GetFreeFarCodeSpace()) / 2))
+  {
+    // Keep whatever we had before, otherwise we'd never be able to load it.
+    Log_WarningPrintf("Not saving recompiler block cache, %u bytes of host code is too large", code_size);
+    return;
+  }
+
+  // Written to a temporary file which replaces the cache on commit, so a crash can't leave a truncated cache behind.
+  std::unique_ptr<ByteStream> stream = FileSystem::OpenFile(
+    s_block_cache_filename.c_str(), BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_TRUNCATE | BYTESTREAM_OPEN_WRITE |
+                                      BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
+  if (!stream)
+  {
+    Log_ErrorPrintf("Failed to open recompiler block cache '%s' for writing", s_block_cache_filename.c_str());
+    return;
+  }
+
+  BlockCacheFileHeader header = {};
+  header.magic = BLOCK_CACHE_FILE_MAGIC;
+  header.version = BLOCK_CACHE_FILE_VERSION;
+  header.settings_hash = s_block_cache_settings_hash;
+  header.layout_hash = s_block_cache_layout_hash;
+  header.code_start = s_dispatcher_code_end;
+  header.code_end = code_end;
+  header.far_code_start = s_dispatcher_far_code_end;
+  header.far_code_end = far_code_end;
+
+  // Blocks which were compiled this session, and blocks from the previous session which weren't used this time.
+  std::vector<std::pair<BlockCacheFileBlock, const std::vector<Recompiler::LoadStoreBackpatchInfo>*>> blocks;
+  blocks.reserve(s_blocks.size() + s_cached_blocks.size());
+  for (const auto& it : s_blocks)
+  {
+    const CodeBlock* block = it.second;
+    if (!block || !block->host_code)
+      continue;
+
+    BlockCacheFileBlock fblock = {};
+    fblock.key = block->key.bits;
+    fblock.num_instructions = static_cast<u32>(block->instructions.size());
+    fblock.guest_code_hash = GetGuestCodeHash(block);
+    fblock.host_code_offset =
+      static_cast<u32>(reinterpret_cast<const u8*>(block->host_code) - static_cast<const u8*>(s_code_storage));
+    fblock.host_code_size = block->host_code_size;
+    fblock.num_backpatch_entries = static_cast<u32>(block->loadstore_backpatch_info.size());
+    blocks.emplace_back(fblock, &block->loadstore_backpatch_info);
+  }
+  for (const auto& it : s_cached_blocks)
+  {
+    BlockCacheFileBlock fblock = {};
+    fblock.key = it.first;
+    fblock.num_instructions = it.second.num_instructions;
+    fblock.guest_code_hash = it.second.guest_code_hash;
+    fblock.host_code_offset = it.second.host_code_offset;
+    fblock.host_code_size = it.second.host_code_size;
+    fblock.num_backpatch_entries = static_cast<u32>(it.second.loadstore_backpatch_info.size());
+    blocks.emplace_back(fblock, &it.second.loadstore_backpatch_info);
+  }
+  header.num_blocks = static_cast<u32>(blocks.size());
+
+  bool result = stream->Write2(&header, sizeof(header));
+  result = result && (code_size == 0 || stream->Write2(s_code_storage + s_dispatcher_code_end, code_size));
+  result = result &&
+           (far_code_size == 0 || stream->Write2(s_code_storage + s_dispatcher_far_code_end, far_code_size));
+  for (const auto& it : blocks)
+  {
+    result = result && stream->Write2(&it.first, sizeof(it.first));
+    for (const Recompiler::LoadStoreBackpatchInfo& lbi : *it.second)
+    {
+      BlockCacheFileBackpatchEntry fbpi = {};
+      fbpi.host_pc_offset = static_cast<u32>(static_cast<const u8*>(lbi.host_pc) - s_code_storage);
+      fbpi.host_slowmem_pc_offset = static_cast<u32>(static_cast<const u8*>(lbi.host_slowmem_pc) - s_code_storage);
+      fbpi.host_code_size = lbi.host_code_size;
+      fbpi.address_host_reg = static_cast<u8>(lbi.address_host_reg);
+      fbpi.value_host_reg = static_cast<u8>(lbi.value_host_reg);
+      fbpi.guest_pc = lbi.guest_pc;
+      fbpi.fault_count = lbi.fault_count;
+      result = result && stream->Write2(&fbpi, sizeof(fbpi));
+    }
+  }
+
+  if (!result || !stream->Commit())
+  {
+    Log_ErrorPrintf("Failed to write recompiler block cache '%s'", s_block_cache_filename.c_str());
+    stream->Discard();
+    return;
+  }
+
+  Log_InfoPrintf("Saved %u blocks (%u bytes of host code) to recompiler block cache '%s'", header.num_blocks,
+                 code_size + far_code_size, s_block_cache_filename.c_str());
+  s_block_cache_dirty = false;
+}
+
+bool LookupCachedBlock(CodeBlock* block)
+{
+  auto iter = s_cached_blocks.find(block->key.bits);
+  if (iter == s_cached_blocks.end())
+    return false;
+
+  // Each cached block can only be used once, if the guest code changed it'll get recompiled.
+  CachedBlock cblock = std::move(iter->second);
+  s_cached_blocks.erase(iter);
+  if (cblock.num_instructions != block->instructions.size() || cblock.guest_code_hash != GetGuestCodeHash(block))
+  {
+    Log_DevPrintf("Cached block at 0x%08X does not match guest code, recompiling", block->GetPC());
+    return false;
+  }
+
+  block->host_code = reinterpret_cast<CodeBlock::HostCodePointer>(s_code_storage + cblock.host_code_offset);
+  block->host_code_size = cblock.host_code_size;
+  block->loadstore_backpatch_info = std::move(cblock.loadstore_backpatch_info);
+  s_block_cache_hits++;
+  return true;
+}
+
+#endif // USE_PERSISTENT_BLOCK_CACHE
+
 #endif // WITH_RECOMPILER
 
 } // namespace CPU::CodeCache
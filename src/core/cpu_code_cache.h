@@ -60,6 +60,18 @@ struct CodeBlockInstruction
   bool is_last_instruction : 1;
   bool has_load_delay : 1;
   bool can_trap : 1;
+  bool is_superblock_exit : 1;
+};
+
+// Instruction prepared for the cached interpreter, the handler executes exactly one opcode.
+struct CachedInterpreterInstruction
+{
+  using Handler = void (*)();
+
+  Handler handler;
+  Instruction instruction;
+  u32 pc;
+  bool is_branch_delay_slot;
 };
 
 struct CodeBlock
@@ -83,16 +95,33 @@ struct CodeBlock
   std::vector<Recompiler::LoadStoreBackpatchInfo> loadstore_backpatch_info;
 #endif
 
+  // Built on the first interpretation of the block, using the handlers for interpreter_pgxp_mode.
+  std::vector<CachedInterpreterInstruction> interpreter_instructions;
+  PGXPMode interpreter_pgxp_mode = PGXPMode::Disabled;
+
+  // Tiering profile, updated by the generated code.
+  u32 execution_count = 0;
+  u32 branch_taken_count = 0;
+  u32 side_exit_count = 0;
+
+  // Number of blocks merged into this block, zero if this isn't a superblock.
+  u32 superblock_length = 0;
+
+  // Non-zero while the block is queued for compilation on the background thread.
+  u32 async_compile_id = 0;
+
   bool contains_loadstore_instructions = false;
   bool contains_double_branches = false;
   bool invalidated = false;
+  bool can_promote = false;
+  bool idle_loop = false;
 
   const u32 GetPC() const { return key.GetPC(); }
   const u32 GetSizeInBytes() const { return static_cast<u32>(instructions.size()) * sizeof(Instruction); }
-  const u32 GetStartPageIndex() const { return (key.GetPCPhysicalAddress() / HOST_PAGE_SIZE); }
-  const u32 GetEndPageIndex() const
+  const u32 GetStartLineIndex() const { return (key.GetPCPhysicalAddress() >> Bus::RAM_CODE_LINE_SHIFT); }
+  const u32 GetEndLineIndex() const
   {
-    return ((key.GetPCPhysicalAddress() + GetSizeInBytes()) / HOST_PAGE_SIZE);
+    return ((key.GetPCPhysicalAddress() + GetSizeInBytes() - sizeof(Instruction)) >> Bus::RAM_CODE_LINE_SHIFT);
   }
   bool IsInRAM() const
   {
@@ -101,6 +130,21 @@ struct CodeBlock
   }
 };
 
+// Per-block statistics, keyed by the block address so they survive recompiles and flushes.
+struct CodeBlockProfile
+{
+  CodeBlockKey key;
+  u32 instruction_count;
+  u32 host_code_size;
+  u32 compile_count;
+  u32 invalidation_count;
+  u64 execution_count;
+  u64 cycles;
+
+  // Address of each instruction, superblocks are made of blocks which aren't necessarily contiguous.
+  std::vector<u32> instruction_pcs;
+};
+
 namespace CodeCache {
 
 void Initialize();
@@ -112,7 +156,47 @@ using DispatcherFunction = void (*)();
 using SingleBlockDispatcherFunction = void(*)(const CodeBlock::HostCodePointer);
 
 CodeBlock::HostCodePointer* GetFastMapPointer();
+CodeBlock::HostCodePointer* GetFastMapSlot(u32 pc);
 void ExecuteRecompiler();
+
+enum : u32
+{
+  RETURN_STACK_SIZE = 16
+};
+
+struct ReturnStackEntry
+{
+  u32 pc;
+  u32 fast_map_generation;
+  CodeBlock::HostCodePointer host_code;
+};
+
+/// Shadow stack of return addresses, pushed by jal/jalr and popped by jr $ra in recompiled code. A prediction is only
+/// used while the fast map hasn't changed since it was pushed, so the host code it points to is still valid.
+struct ReturnStack
+{
+  std::array<ReturnStackEntry, RETURN_STACK_SIZE> entries;
+  u32 top;
+  u32 fast_map_generation;
+  CodeBlock::HostCodePointer compile_stub;
+  CodeBlock::HostCodePointer promote_stub;
+  u64 hits;
+  u64 misses;
+};
+
+ReturnStack* GetReturnStack();
+
+/// Guest registers which stay in host registers while running compiled code, picked by how often the game's code uses
+/// them. The dispatcher loads them on entry, and writes them back to the CPU state before leaving compiled code.
+u32 GetPinnedGuestRegisterCount();
+Reg GetPinnedGuestRegister(u32 index);
+
+/// Functions placed in the fast map for blocks which still need compiling or promoting.
+CodeBlock::HostCodePointer GetCompileBlockStub();
+CodeBlock::HostCodePointer GetPromoteBlockStub();
+
+/// Called by profiled blocks when they become hot, recompiles them as a superblock on the next dispatch.
+void RequestBlockPromotion(u32 pc);
 #endif
 
 /// Flushes the code cache, forcing all blocks to be recompiled.
@@ -121,22 +205,54 @@ void Flush();
 /// Changes whether the recompiler is enabled.
 void Reinitialize();
 
-/// Invalidates all blocks which are in the range of the specified code page.
-void InvalidateBlocksWithPageIndex(u32 page_index);
+/// Invalidates all blocks which overlap the specified code line. Once no code is left in the page containing the line,
+/// the page is no longer write-protected.
+void InvalidateBlocksWithLineIndex(u32 line_index);
+
+/// Returns the total number of block invalidations and compiles since the code cache was initialized.
+u32 GetInvalidationCount();
+u32 GetCompileCount();
+
+/// Called on entry to each block when block profiling is enabled. Charges the cycles since the last call to the
+/// previously-executed block.
+void ProfileBlockEntry(u32 key_bits);
+
+/// Called at the end of each iteration of an idle loop block. Once the loop has branched back to itself, skips the
+/// iterations which would run before the next event.
+void IdleLoopIteration(u32 key_bits);
+
+/// Returns the total number of cycles skipped in idle loops.
+u64 GetIdleLoopSkippedTicks();
+
+/// Returns all block profiles, sorted by the number of cycles spent in each block.
+std::vector<CodeBlockProfile> GetBlockProfiles();
+
+/// Clears the counters of all block profiles.
+void ResetBlockProfiles();
+
+/// Writes the block profiles with disassembly to the specified file. JSON is used if the extension is .json,
+/// otherwise CSV.
+bool WriteBlockProfileReport(const char* filename);
+
+/// Draws the block profile window.
+void DrawDebugWindow();
 
 template<PGXPMode pgxp_mode>
-void InterpretCachedBlock(const CodeBlock& block);
+void InterpretCachedBlock(CodeBlock& block);
 void InterpretUncachedBlock();
 
-/// Invalidates any code pages which overlap the specified range.
-ALWAYS_INLINE void InvalidateCodePages(PhysicalMemoryAddress address, u32 word_count)
+/// Invalidates any code lines which overlap the specified range. The range wraps around the end of RAM.
+ALWAYS_INLINE void InvalidateCodeLines(PhysicalMemoryAddress address, u32 word_count)
 {
-  const u32 start_page = address / HOST_PAGE_SIZE;
-  const u32 end_page = (address + word_count * sizeof(u32) - sizeof(u32)) / HOST_PAGE_SIZE;
-  for (u32 page = start_page; page <= end_page; page++)
+  const u32 start_line = Bus::GetRAMCodeLineIndex(address);
+  const u32 line_count =
+    ((address & (Bus::RAM_CODE_LINE_SIZE - 1)) + word_count * sizeof(u32) + (Bus::RAM_CODE_LINE_SIZE - 1)) /
+    Bus::RAM_CODE_LINE_SIZE;
+  for (u32 i = 0; i < line_count && i < Bus::RAM_CODE_LINE_COUNT; i++)
   {
-    if (Bus::m_ram_code_bits[page])
-      CPU::CodeCache::InvalidateBlocksWithPageIndex(page);
+    const u32 line = (start_line + i) % Bus::RAM_CODE_LINE_COUNT;
+    if (Bus::m_ram_code_line_bits[line])
+      CPU::CodeCache::InvalidateBlocksWithLineIndex(line);
   }
 }
 
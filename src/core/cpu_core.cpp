@@ -11,7 +11,9 @@
 #include "pgxp.h"
 #include "settings.h"
 #include "timing_event.h"
+#include <array>
 #include <cstdio>
+#include <utility>
 Log_SetChannel(CPU::Core);
 
 namespace CPU {
@@ -476,7 +478,15 @@ void DisassembleAndPrint(u32 addr, u32 instructions_before /* = 0 */, u32 instru
   }
 }
 
-template<PGXPMode pgxp_mode>
+// Passed as the opcode to ExecuteInstruction() when it isn't known at compile time.
+static constexpr u8 UNKNOWN_OPCODE = 0xFF;
+
+template<PGXPMode pgxp_mode, u8 known_op, u8 known_funct>
+static void ExecutePredecodedInstruction();
+
+/// Predecoded instruction handlers pass the opcode and function as template parameters, reducing the decode switches
+/// to a single case.
+template<PGXPMode pgxp_mode, u8 known_op = UNKNOWN_OPCODE, u8 known_funct = UNKNOWN_OPCODE>
 ALWAYS_INLINE_RELEASE static void ExecuteInstruction()
 {
 restart_instruction:
@@ -497,15 +507,15 @@ restart_instruction:
     LogInstruction(inst.bits, g_state.current_instruction_pc, &g_state.regs);
 #endif
 
-  // Skip nops. Makes PGXP-CPU quicker, but also the regular interpreter.
-  if (inst.bits == 0)
+  // Skip nops. Makes PGXP-CPU quicker, but also the regular interpreter. Predecoded nops never get here.
+  if (known_op == UNKNOWN_OPCODE && inst.bits == 0)
     return;
 
-  switch (inst.op)
+  switch ((known_op != UNKNOWN_OPCODE) ? static_cast<InstructionOp>(known_op) : inst.op.GetValue())
   {
     case InstructionOp::funct:
     {
-      switch (inst.r.funct)
+      switch ((known_funct != UNKNOWN_OPCODE) ? static_cast<InstructionFunct>(known_funct) : inst.r.funct.GetValue())
       {
         case InstructionFunct::sll:
         {
@@ -1405,6 +1415,13 @@ restart_instruction:
         Log_ErrorPrintf("Stale icache at 0x%08X - ICache: %08X RAM: %08X", g_state.current_instruction_pc,
                         g_state.current_instruction.bits, ram_value);
         g_state.current_instruction.bits = ram_value;
+        if constexpr (known_op != UNKNOWN_OPCODE)
+        {
+          // the predecoded handler no longer matches the instruction
+          ExecutePredecodedInstruction<pgxp_mode, UNKNOWN_OPCODE, UNKNOWN_OPCODE>();
+          return;
+        }
+
         goto restart_instruction;
       }
 
@@ -1492,23 +1509,75 @@ void Execute()
   }
 }
 
+template<PGXPMode pgxp_mode, u8 known_op, u8 known_funct>
+void ExecutePredecodedInstruction()
+{
+  ExecuteInstruction<pgxp_mode, known_op, known_funct>();
+}
+
+static void ExecutePredecodedNop() {}
+
+template<PGXPMode pgxp_mode, size_t... op>
+static constexpr std::array<CachedInterpreterInstruction::Handler, sizeof...(op)>
+MakeOpHandlerTable(std::index_sequence<op...>)
+{
+  return {{&ExecutePredecodedInstruction<pgxp_mode, static_cast<u8>(op), UNKNOWN_OPCODE>...}};
+}
+
+template<PGXPMode pgxp_mode, size_t... funct>
+static constexpr std::array<CachedInterpreterInstruction::Handler, sizeof...(funct)>
+MakeFunctHandlerTable(std::index_sequence<funct...>)
+{
+  return {{&ExecutePredecodedInstruction<pgxp_mode, static_cast<u8>(InstructionOp::funct), static_cast<u8>(funct)>...}};
+}
+
+template<PGXPMode pgxp_mode>
+static void PredecodeBlock(CodeBlock& block)
+{
+  static constexpr auto op_handlers = MakeOpHandlerTable<pgxp_mode>(std::make_index_sequence<64>());
+  static constexpr auto funct_handlers = MakeFunctHandlerTable<pgxp_mode>(std::make_index_sequence<64>());
+
+  block.interpreter_instructions.clear();
+  block.interpreter_instructions.reserve(block.instructions.size());
+  for (const CodeBlockInstruction& cbi : block.instructions)
+  {
+    CachedInterpreterInstruction& cii = block.interpreter_instructions.emplace_back();
+    if (cbi.instruction.bits == 0)
+      cii.handler = &ExecutePredecodedNop;
+    else if (cbi.instruction.op == InstructionOp::funct)
+      cii.handler = funct_handlers[static_cast<u8>(cbi.instruction.r.funct.GetValue())];
+    else
+      cii.handler = op_handlers[static_cast<u8>(cbi.instruction.op.GetValue())];
+
+    cii.instruction.bits = cbi.instruction.bits;
+    cii.pc = cbi.pc;
+    cii.is_branch_delay_slot = cbi.is_branch_delay_slot;
+  }
+
+  block.interpreter_pgxp_mode = pgxp_mode;
+}
+
 namespace CodeCache {
 
 template<PGXPMode pgxp_mode>
-void InterpretCachedBlock(const CodeBlock& block)
+void InterpretCachedBlock(CodeBlock& block)
 {
+  // the PGXP mode can change without the cache being flushed
+  if (block.interpreter_instructions.empty() || block.interpreter_pgxp_mode != pgxp_mode)
+    PredecodeBlock<pgxp_mode>(block);
+
   // set up the state so we've already fetched the instruction
   DebugAssert(g_state.regs.pc == block.GetPC());
   g_state.regs.npc = block.GetPC() + 4;
 
-  for (const CodeBlockInstruction& cbi : block.instructions)
+  for (const CachedInterpreterInstruction& cii : block.interpreter_instructions)
   {
     g_state.pending_ticks++;
 
     // now executing the instruction we previously fetched
-    g_state.current_instruction.bits = cbi.instruction.bits;
-    g_state.current_instruction_pc = cbi.pc;
-    g_state.current_instruction_in_branch_delay_slot = cbi.is_branch_delay_slot;
+    g_state.current_instruction.bits = cii.instruction.bits;
+    g_state.current_instruction_pc = cii.pc;
+    g_state.current_instruction_in_branch_delay_slot = cii.is_branch_delay_slot;
     g_state.current_instruction_was_branch_taken = g_state.branch_was_taken;
     g_state.branch_was_taken = false;
     g_state.exception_raised = false;
@@ -1518,7 +1587,7 @@ void InterpretCachedBlock(const CodeBlock& block)
     g_state.regs.npc += 4;
 
     // execute the instruction we previously fetched
-    ExecuteInstruction<pgxp_mode>();
+    cii.handler();
 
     // next load delay
     UpdateLoadDelay();
@@ -1531,9 +1600,9 @@ void InterpretCachedBlock(const CodeBlock& block)
   g_state.next_instruction_is_branch_delay_slot = false;
 }
 
-template void InterpretCachedBlock<PGXPMode::Disabled>(const CodeBlock& block);
-template void InterpretCachedBlock<PGXPMode::Memory>(const CodeBlock& block);
-template void InterpretCachedBlock<PGXPMode::CPU>(const CodeBlock& block);
+template void InterpretCachedBlock<PGXPMode::Disabled>(CodeBlock& block);
+template void InterpretCachedBlock<PGXPMode::Memory>(CodeBlock& block);
+template void InterpretCachedBlock<PGXPMode::CPU>(CodeBlock& block);
 
 void InterpretUncachedBlock()
 {
@@ -14,11 +14,31 @@ Log_SetChannel(CPU::Recompiler);
 
 namespace CPU::Recompiler {
 
+CodeGeneratorSettings CodeGeneratorSettings::FromGlobalSettings()
+{
+  CodeGeneratorSettings settings;
+  settings.fastmem_mode = g_settings.cpu_fastmem_mode;
+  settings.tiering_threshold = g_settings.cpu_recompiler_tiering_threshold;
+  settings.fastmem = g_settings.IsUsingFastmem();
+  settings.memory_exceptions = g_settings.cpu_recompiler_memory_exceptions;
+  settings.block_profiling = g_settings.cpu_recompiler_block_profiling;
+  settings.return_stack = g_settings.cpu_recompiler_return_stack;
+  settings.pgxp_enable = g_settings.gpu_pgxp_enable;
+  settings.pgxp_culling = g_settings.gpu_pgxp_culling;
+  settings.widescreen_hack = g_settings.gpu_widescreen_hack;
+  return settings;
+}
+
 u32 CodeGenerator::CalculateRegisterOffset(Reg reg)
 {
   return u32(offsetof(State, regs.r[0]) + (static_cast<u32>(reg) * sizeof(u32)));
 }
 
+u32 CodeGenerator::CalculateGTERegisterOffset(u32 index)
+{
+  return u32(offsetof(State, gte_regs.r32[0]) + (index * sizeof(u32)));
+}
+
 bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size)
 {
   // TODO: Align code buffer.
@@ -26,6 +46,7 @@ bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* o
   m_block = block;
   m_block_start = block->instructions.data();
   m_block_end = block->instructions.data() + block->instructions.size();
+  AnalyzeBlockDataflow(*block, m_settings.memory_exceptions, m_settings.pgxp_enable, &m_dataflow_info);
 
   EmitBeginBlock();
   BlockPrologue();
@@ -49,6 +70,9 @@ bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* o
       return false;
     }
 
+    if (cbi->is_superblock_exit)
+      GenerateSuperblockGuard(*cbi);
+
     cbi++;
   }
 
@@ -70,6 +94,10 @@ bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* o
 
 bool CodeGenerator::CompileInstruction(const CodeBlockInstruction& cbi)
 {
+  const InstructionDataflowInfo& dfi = GetDataflowInfo(cbi);
+  if (dfi.is_dead || dfi.has_constant_result)
+    return Compile_DataflowResult(cbi);
+
   bool result;
   switch (cbi.instruction.op)
   {
@@ -903,15 +931,33 @@ void CodeGenerator::BlockPrologue()
 {
   InitSpeculativeRegs();
 
+  if (m_settings.block_profiling)
+    EmitFunctionCall(nullptr, &CodeCache::ProfileBlockEntry, Value::FromConstantU32(m_block->key.bits));
+
   EmitStoreCPUStructField(offsetof(State, exception_raised), Value::FromConstantU8(0));
 
   if (m_block->uncached_fetch_ticks > 0)
     EmitICacheCheckAndUpdate();
 
+  // Profiled blocks request promotion to a superblock once they hit the threshold.
+  if (m_block->can_promote || m_block->superblock_length > 0)
+  {
+    Value count = m_register_cache.AllocateScratch(RegSize_32);
+    IncrementBlockCounter(&m_block->execution_count, count);
+    if (m_block->can_promote)
+    {
+      LabelType not_hot;
+      EmitConditionalBranch(Condition::NotEqual, false, count.host_reg,
+                            Value::FromConstantU32(m_settings.tiering_threshold), &not_hot);
+      EmitFunctionCall(nullptr, &CodeCache::RequestBlockPromotion, Value::FromConstantU32(m_block->GetPC()));
+      EmitBindLabel(&not_hot);
+    }
+  }
+
   // we don't know the state of the last block, so assume load delays might be in progress
   // TODO: Pull load delay into register cache
-  m_current_instruction_in_branch_delay_slot_dirty = g_settings.cpu_recompiler_memory_exceptions;
-  m_branch_was_taken_dirty = g_settings.cpu_recompiler_memory_exceptions;
+  m_current_instruction_in_branch_delay_slot_dirty = m_settings.memory_exceptions;
+  m_branch_was_taken_dirty = m_settings.memory_exceptions;
   m_current_instruction_was_branch_taken_dirty = false;
   m_load_delay_dirty = true;
 
@@ -926,11 +972,19 @@ void CodeGenerator::BlockEpilogue()
   m_emit->nop();
 #endif
 
-  m_register_cache.FlushAllGuestRegisters(true, true);
+  // pinned registers aren't written back at the end of the block, but the idle loop check reads the CPU state
+  if (m_block->idle_loop)
+    m_register_cache.FlushAllGuestRegisters(false, true);
+
+  m_register_cache.FlushAllGuestRegistersForBlockExit(true);
   if (m_register_cache.HasLoadDelay())
     m_register_cache.WriteLoadDelayToCPU(true);
 
   AddPendingCycles(true);
+
+  // needs the new pc and the cycles for this iteration
+  if (m_block->idle_loop)
+    EmitFunctionCall(nullptr, &CodeCache::IdleLoopIteration, Value::FromConstantU32(m_block->key.bits));
 }
 
 void CodeGenerator::InstructionPrologue(const CodeBlockInstruction& cbi, TickCount cycles,
@@ -974,7 +1028,7 @@ void CodeGenerator::InstructionPrologue(const CodeBlockInstruction& cbi, TickCou
     return;
   }
 
-  if (cbi.is_branch_delay_slot && g_settings.cpu_recompiler_memory_exceptions)
+  if (cbi.is_branch_delay_slot && m_settings.memory_exceptions)
   {
     // m_current_instruction_in_branch_delay_slot = true
     EmitStoreCPUStructField(offsetof(State, current_instruction_in_branch_delay_slot), Value::FromConstantU8(1));
@@ -1019,6 +1073,84 @@ void CodeGenerator::AddPendingCycles(bool commit)
     m_delayed_cycles_add = 0;
 }
 
+void CodeGenerator::IncrementBlockCounter(u32* counter, const Value& temp)
+{
+  EmitLoadGlobal(temp.host_reg, RegSize_32, counter);
+  EmitAdd(temp.host_reg, temp.host_reg, Value::FromConstantU32(1), false);
+  EmitStoreGlobal(counter, temp);
+}
+
+bool CodeGenerator::IsReturnBlock() const
+{
+  // the block has to end with jr $ra and its delay slot, otherwise the pc isn't a return address
+  if (!m_settings.return_stack || m_block->instructions.size() < 2 ||
+      !m_block->instructions.back().is_branch_delay_slot)
+  {
+    return false;
+  }
+
+  const Instruction branch = m_block->instructions[m_block->instructions.size() - 2].instruction;
+  return (branch.op == InstructionOp::funct && branch.r.funct == InstructionFunct::jr && branch.r.rs == Reg::ra);
+}
+
+void CodeGenerator::GenerateSuperblockGuard(const CodeBlockInstruction& cbi)
+{
+  // The next block was picked from the profile. Leave the superblock if the branch went the other way, or if the
+  // dispatcher would've done something before running the next block (interrupts, events).
+  const u32 next_pc = (&cbi + 1)->pc;
+  AddPendingCycles(true);
+
+  LabelType side_exit;
+  LabelType no_interrupt;
+  LabelType continue_superblock;
+  {
+    Value temp = m_register_cache.AllocateScratch(RegSize_32);
+    Value temp2 = m_register_cache.AllocateScratch(RegSize_32);
+
+    EmitLoadGuestRegister(temp.host_reg, Reg::pc);
+    EmitConditionalBranch(Condition::NotEqual, false, temp.host_reg, Value::FromConstantU32(next_pc), &side_exit);
+
+    // if (sr.IEc && ((sr & cause) & 0xFF00) != 0) goto side_exit
+    EmitLoadCPUStructField(temp.host_reg, RegSize_32, offsetof(State, cop0_regs.sr.bits));
+    EmitLoadCPUStructField(temp2.host_reg, RegSize_32, offsetof(State, cop0_regs.cause.bits));
+    EmitAnd(temp2.host_reg, temp2.host_reg, temp);
+    EmitTest(temp2.host_reg, Value::FromConstantU32(0xFF00));
+    EmitConditionalBranch(Condition::Zero, false, &no_interrupt);
+    EmitTest(temp.host_reg, Value::FromConstantU32(1));
+    EmitConditionalBranch(Condition::NotZero, false, &side_exit);
+    EmitBindLabel(&no_interrupt);
+
+    // if (pending_ticks < downcount) goto continue_superblock
+    EmitLoadCPUStructField(temp.host_reg, RegSize_32, offsetof(State, pending_ticks));
+    EmitLoadCPUStructField(temp2.host_reg, RegSize_32, offsetof(State, downcount));
+    EmitConditionalBranch(Condition::Less, false, temp.host_reg, temp2, &continue_superblock);
+  }
+
+  EmitBindLabel(&side_exit);
+  m_register_cache.PushState();
+  const bool load_delay_dirty = m_load_delay_dirty;
+
+  EmitBranch(GetCurrentFarCodePointer());
+  SwitchToFarCode();
+  {
+    Value temp = m_register_cache.AllocateScratch(RegSize_32);
+    IncrementBlockCounter(&m_block->side_exit_count, temp);
+  }
+  EmitSuperblockSideExit();
+  SwitchToNearCode();
+
+  m_load_delay_dirty = load_delay_dirty;
+  m_register_cache.PopState();
+
+  EmitBindLabel(&continue_superblock);
+
+  // same state the dispatcher sets up for a new block
+  EmitStoreCPUStructField(offsetof(State, current_instruction_pc), Value::FromConstantU32(next_pc));
+  m_pc_offset = 0;
+  m_current_instruction_pc_offset = 0;
+  m_next_pc_offset = 4;
+}
+
 Value CodeGenerator::CalculatePC(u32 offset /* = 0 */)
 {
   Value value = m_register_cache.AllocateScratch(RegSize_32);
@@ -1063,6 +1195,30 @@ void CodeGenerator::WriteNewPC(const Value& value, bool commit)
     m_next_pc_offset = 0;
 }
 
+const InstructionDataflowInfo& CodeGenerator::GetDataflowInfo(const CodeBlockInstruction& cbi) const
+{
+  DebugAssert(&cbi >= m_block_start && &cbi < m_block_end);
+  return m_dataflow_info[static_cast<size_t>(&cbi - m_block_start)];
+}
+
+Value CodeGenerator::CalculateLoadStoreAddress(const CodeBlockInstruction& cbi, SpeculativeValue* address_spec)
+{
+  // rs + sext(imm), or a constant if the base register was propagated through the block
+  const InstructionDataflowInfo& dfi = GetDataflowInfo(cbi);
+  if (dfi.has_constant_address)
+  {
+    *address_spec = dfi.constant_address;
+    return Value::FromConstantU32(dfi.constant_address);
+  }
+
+  *address_spec = SpeculativeReadReg(cbi.instruction.i.rs);
+  if (*address_spec)
+    *address_spec = **address_spec + cbi.instruction.i.imm_sext32();
+
+  return AddValues(m_register_cache.ReadGuestRegister(cbi.instruction.i.rs),
+                   Value::FromConstantU32(cbi.instruction.i.imm_sext32()), false);
+}
+
 bool CodeGenerator::Compile_Fallback(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1, true);
@@ -1083,13 +1239,13 @@ bool CodeGenerator::Compile_Fallback(const CodeBlockInstruction& cbi)
     // TODO: Use carry flag or something here too
     Value return_value = m_register_cache.AllocateScratch(RegSize_8);
     EmitFunctionCall(&return_value,
-                     g_settings.gpu_pgxp_enable ? &Thunks::InterpretInstructionPGXP : &Thunks::InterpretInstruction);
+                     m_settings.pgxp_enable ? &Thunks::InterpretInstructionPGXP : &Thunks::InterpretInstruction);
     EmitExceptionExitOnBool(return_value);
   }
   else
   {
     EmitFunctionCall(nullptr,
-                     g_settings.gpu_pgxp_enable ? &Thunks::InterpretInstructionPGXP : &Thunks::InterpretInstruction);
+                     m_settings.pgxp_enable ? &Thunks::InterpretInstructionPGXP : &Thunks::InterpretInstruction);
   }
 
   m_current_instruction_in_branch_delay_slot_dirty = cbi.is_branch_instruction;
@@ -1100,6 +1256,26 @@ bool CodeGenerator::Compile_Fallback(const CodeBlockInstruction& cbi)
   return true;
 }
 
+bool CodeGenerator::Compile_DataflowResult(const CodeBlockInstruction& cbi)
+{
+  InstructionPrologue(cbi, 1);
+
+  // the result is either known at compile time, or never read, so there's no need to emit the operation
+  const InstructionDataflowInfo& dfi = GetDataflowInfo(cbi);
+  if (dfi.is_dead)
+  {
+    SpeculativeWriteReg(dfi.result_register, std::nullopt);
+  }
+  else
+  {
+    m_register_cache.WriteGuestRegister(dfi.result_register, Value::FromConstantU32(dfi.constant_result));
+    SpeculativeWriteReg(dfi.result_register, dfi.constant_result);
+  }
+
+  InstructionEpilogue(cbi);
+  return true;
+}
+
 bool CodeGenerator::Compile_Bitwise(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1);
@@ -1284,14 +1460,9 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
   InstructionPrologue(cbi, 1);
 
   // rt <- mem[rs + sext(imm)]
-  Value base = m_register_cache.ReadGuestRegister(cbi.instruction.i.rs);
-  Value offset = Value::FromConstantU32(cbi.instruction.i.imm_sext32());
-  Value address = AddValues(base, offset, false);
-
-  SpeculativeValue address_spec = SpeculativeReadReg(cbi.instruction.i.rs);
+  SpeculativeValue address_spec;
   SpeculativeValue value_spec;
-  if (address_spec)
-    address_spec = *address_spec + cbi.instruction.i.imm_sext32();
+  Value address = CalculateLoadStoreAddress(cbi, &address_spec);
 
   Value result;
   switch (cbi.instruction.op)
@@ -1301,7 +1472,7 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
     {
       result = EmitLoadGuestMemory(cbi, address, address_spec, RegSize_8);
       ConvertValueSizeInPlace(&result, RegSize_32, (cbi.instruction.op == InstructionOp::lb));
-      if (g_settings.gpu_pgxp_enable)
+      if (m_settings.pgxp_enable)
         EmitFunctionCall(nullptr, PGXP::CPU_LBx, Value::FromConstantU32(cbi.instruction.bits), result, address);
 
       if (address_spec)
@@ -1319,7 +1490,7 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
       result = EmitLoadGuestMemory(cbi, address, address_spec, RegSize_16);
       ConvertValueSizeInPlace(&result, RegSize_32, (cbi.instruction.op == InstructionOp::lh));
 
-      if (g_settings.gpu_pgxp_enable)
+      if (m_settings.pgxp_enable)
         EmitFunctionCall(nullptr, PGXP::CPU_LHx, Value::FromConstantU32(cbi.instruction.bits), result, address);
 
       if (address_spec)
@@ -1334,7 +1505,7 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
     case InstructionOp::lw:
     {
       result = EmitLoadGuestMemory(cbi, address, address_spec, RegSize_32);
-      if (g_settings.gpu_pgxp_enable)
+      if (m_settings.pgxp_enable)
         EmitFunctionCall(nullptr, PGXP::CPU_LW, Value::FromConstantU32(cbi.instruction.bits), result, address);
 
       if (address_spec)
@@ -1347,7 +1518,11 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
       break;
   }
 
-  m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(result));
+  // nothing can observe the old value if the delay slot doesn't touch rt
+  if (GetDataflowInfo(cbi).skip_load_delay && !m_load_delay_dirty)
+    m_register_cache.WriteGuestRegister(cbi.instruction.i.rt, std::move(result));
+  else
+    m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(result));
   SpeculativeWriteReg(cbi.instruction.i.rt, value_spec);
 
   InstructionEpilogue(cbi);
@@ -1359,21 +1534,16 @@ bool CodeGenerator::Compile_Store(const CodeBlockInstruction& cbi)
   InstructionPrologue(cbi, 1);
 
   // mem[rs + sext(imm)] <- rt
-  Value base = m_register_cache.ReadGuestRegister(cbi.instruction.i.rs);
-  Value offset = Value::FromConstantU32(cbi.instruction.i.imm_sext32());
-  Value address = AddValues(base, offset, false);
+  SpeculativeValue address_spec;
+  Value address = CalculateLoadStoreAddress(cbi, &address_spec);
   Value value = m_register_cache.ReadGuestRegister(cbi.instruction.i.rt);
-
-  SpeculativeValue address_spec = SpeculativeReadReg(cbi.instruction.i.rs);
   SpeculativeValue value_spec = SpeculativeReadReg(cbi.instruction.i.rt);
-  if (address_spec)
-    address_spec = *address_spec + cbi.instruction.i.imm_sext32();
 
   switch (cbi.instruction.op)
   {
     case InstructionOp::sb:
     {
-      if (g_settings.gpu_pgxp_enable)
+      if (m_settings.pgxp_enable)
       {
         EmitFunctionCall(nullptr, PGXP::CPU_SB, Value::FromConstantU32(cbi.instruction.bits),
                          value.ViewAsSize(RegSize_8), address);
@@ -1404,7 +1574,7 @@ bool CodeGenerator::Compile_Store(const CodeBlockInstruction& cbi)
 
     case InstructionOp::sh:
     {
-      if (g_settings.gpu_pgxp_enable)
+      if (m_settings.pgxp_enable)
       {
         EmitFunctionCall(nullptr, PGXP::CPU_SH, Value::FromConstantU32(cbi.instruction.bits),
                          value.ViewAsSize(RegSize_16), address);
@@ -1435,7 +1605,7 @@ bool CodeGenerator::Compile_Store(const CodeBlockInstruction& cbi)
 
     case InstructionOp::sw:
     {
-      if (g_settings.gpu_pgxp_enable)
+      if (m_settings.pgxp_enable)
         EmitFunctionCall(nullptr, PGXP::CPU_SW, Value::FromConstantU32(cbi.instruction.bits), value, address);
 
       EmitStoreGuestMemory(cbi, address, address_spec, value);
@@ -1458,14 +1628,8 @@ bool CodeGenerator::Compile_LoadLeftRight(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1);
 
-  Value base = m_register_cache.ReadGuestRegister(cbi.instruction.i.rs);
-  Value offset = Value::FromConstantU32(cbi.instruction.i.imm_sext32());
-  Value address = AddValues(base, offset, false);
-  base.ReleaseAndClear();
-
-  SpeculativeValue address_spec = SpeculativeReadReg(cbi.instruction.i.rs);
-  if (address_spec)
-    address_spec = *address_spec + cbi.instruction.i.imm_sext32();
+  SpeculativeValue address_spec;
+  Value address = CalculateLoadStoreAddress(cbi, &address_spec);
 
   Value shift = ShlValues(AndValues(address, Value::FromConstantU32(3)), Value::FromConstantU32(3)); // * 8
   address = AndValues(address, Value::FromConstantU32(~u32(3)));
@@ -1508,10 +1672,13 @@ bool CodeGenerator::Compile_LoadLeftRight(const CodeBlockInstruction& cbi)
 
   shift.ReleaseAndClear();
 
-  if (g_settings.gpu_pgxp_enable)
+  if (m_settings.pgxp_enable)
     EmitFunctionCall(nullptr, PGXP::CPU_LW, Value::FromConstantU32(cbi.instruction.bits), mem, address);
 
-  m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(mem));
+  if (GetDataflowInfo(cbi).skip_load_delay && !m_load_delay_dirty)
+    m_register_cache.WriteGuestRegister(cbi.instruction.i.rt, std::move(mem));
+  else
+    m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(mem));
 
   // TODO: Speculative values
   SpeculativeWriteReg(cbi.instruction.r.rt, std::nullopt);
@@ -1524,18 +1691,11 @@ bool CodeGenerator::Compile_StoreLeftRight(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1);
 
-  Value base = m_register_cache.ReadGuestRegister(cbi.instruction.i.rs);
-  Value offset = Value::FromConstantU32(cbi.instruction.i.imm_sext32());
-  Value address = AddValues(base, offset, false);
-  base.ReleaseAndClear();
-
   // TODO: Speculative values
-  SpeculativeValue address_spec = SpeculativeReadReg(cbi.instruction.i.rs);
+  SpeculativeValue address_spec;
+  Value address = CalculateLoadStoreAddress(cbi, &address_spec);
   if (address_spec)
-  {
-    address_spec = *address_spec + cbi.instruction.i.imm_sext32();
     SpeculativeWriteMemory(*address_spec & ~3u, std::nullopt);
-  }
 
   Value shift = ShlValues(AndValues(address, Value::FromConstantU32(3)), Value::FromConstantU32(3)); // * 8
   address = AndValues(address, Value::FromConstantU32(~u32(3)));
@@ -1565,7 +1725,7 @@ bool CodeGenerator::Compile_StoreLeftRight(const CodeBlockInstruction& cbi)
   shift.ReleaseAndClear();
 
   EmitStoreGuestMemory(cbi, address, address_spec, mem);
-  if (g_settings.gpu_pgxp_enable)
+  if (m_settings.pgxp_enable)
     EmitFunctionCall(nullptr, PGXP::CPU_SW, Value::FromConstantU32(cbi.instruction.bits), mem, address);
 
   InstructionEpilogue(cbi);
@@ -1652,7 +1812,7 @@ bool CodeGenerator::Compile_Add(const CodeBlockInstruction& cbi)
   }
 
   // detect register moves and handle them for pgxp
-  if (g_settings.gpu_pgxp_enable && rhs.HasConstantValue(0))
+  if (m_settings.pgxp_enable && rhs.HasConstantValue(0))
   {
     EmitFunctionCall(nullptr, &PGXP::CPU_MOVE,
                      Value::FromConstantU32((static_cast<u32>(dest) << 8) | (static_cast<u32>(lhs_src))), lhs);
@@ -1957,9 +2117,16 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
   InstructionPrologue(cbi, 1);
 
   auto DoBranch = [this](Condition condition, const Value& lhs, const Value& rhs, Reg lr_reg, Value&& branch_target) {
+    // a pinned lr can be written directly, as long as the branch target isn't read from the same host register
+    const bool pinned_lr =
+      (condition == Condition::Always && lr_reg != Reg::count && lr_reg != Reg::zero &&
+       m_register_cache.IsGuestRegisterPinned(lr_reg) &&
+       (!branch_target.IsInHostRegister() ||
+        m_register_cache.GetHostRegisterForGuestRegister(lr_reg) != branch_target.GetHostRegister()));
+
     // ensure the lr register is flushed, since we want it's correct value after the branch
     // we don't want to invalidate it yet because of "jalr r0, r0", branch_target could be the lr_reg.
-    if (lr_reg != Reg::count && lr_reg != Reg::zero)
+    if (lr_reg != Reg::count && lr_reg != Reg::zero && !pinned_lr)
       m_register_cache.FlushGuestRegister(lr_reg, false, true);
 
     // compute return address, which is also set as the new pc when the branch isn't taken
@@ -1967,6 +2134,11 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
     if (condition != Condition::Always || lr_reg != Reg::count)
       next_pc = CalculatePC(4);
 
+    // profiled blocks count taken branches, so superblocks can follow the hot path
+    Value taken_count;
+    if (condition != Condition::Always && m_block->can_promote)
+      taken_count = m_register_cache.AllocateScratch(RegSize_32);
+
     LabelType branch_not_taken;
     if (condition != Condition::Always)
     {
@@ -1980,7 +2152,12 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
     }
 
     // save the old PC if we want to
-    if (lr_reg != Reg::count && lr_reg != Reg::zero)
+    if (pinned_lr)
+    {
+      m_register_cache.WriteGuestRegister(lr_reg, Value::FromHostReg(&m_register_cache, next_pc.GetHostRegister(),
+                                                                     RegSize_32));
+    }
+    else if (lr_reg != Reg::count && lr_reg != Reg::zero)
     {
       // Can't cache because we have two branches. Load delay cancel is due to the immediate flush afterwards,
       // if we don't cancel it, at the end of the instruction the value we write can be overridden.
@@ -1990,7 +2167,7 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
 
     // we don't need to test the address of constant branches unless they're definitely misaligned, which would be
     // strange.
-    if (g_settings.cpu_recompiler_memory_exceptions &&
+    if (m_settings.memory_exceptions &&
         (!branch_target.IsConstant() || (branch_target.constant_value & 0x3) != 0))
     {
       LabelType branch_okay;
@@ -2028,6 +2205,8 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
     {
       // branch taken path - modify the next pc
       EmitCopyValue(next_pc.GetHostRegister(), branch_target);
+      if (taken_count.IsValid())
+        IncrementBlockCounter(&m_block->branch_taken_count, taken_count);
 
       // converge point
       EmitBindLabel(&branch_not_taken);
@@ -2040,7 +2219,7 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
     }
 
     // now invalidate lr becuase it was possibly written in the branch
-    if (lr_reg != Reg::count && lr_reg != Reg::zero)
+    if (lr_reg != Reg::count && lr_reg != Reg::zero && !pinned_lr)
       m_register_cache.InvalidateGuestRegister(lr_reg);
   };
 
@@ -2057,6 +2236,9 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
 
       DoBranch(Condition::Always, Value(), Value(), (cbi.instruction.op == InstructionOp::jal) ? Reg::ra : Reg::count,
                std::move(branch_target));
+
+      if (cbi.instruction.op == InstructionOp::jal && m_settings.return_stack)
+        EmitReturnStackPush(cbi.pc + 8);
     }
     break;
 
@@ -2069,6 +2251,12 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
         DoBranch(Condition::Always, Value(), Value(),
                  (cbi.instruction.r.funct == InstructionFunct::jalr) ? cbi.instruction.r.rd : Reg::count,
                  std::move(branch_target));
+
+        if (cbi.instruction.r.funct == InstructionFunct::jalr && cbi.instruction.r.rd == Reg::ra &&
+            m_settings.return_stack)
+        {
+          EmitReturnStackPush(cbi.pc + 8);
+        }
       }
       else if (cbi.instruction.r.funct == InstructionFunct::syscall ||
                cbi.instruction.r.funct == InstructionFunct::break_)
@@ -2261,7 +2449,7 @@ bool CodeGenerator::Compile_cop0(const CodeBlockInstruction& cbi)
             }
 
             // changing SR[Isc] needs to update fastmem views
-            if (reg == Cop0Reg::SR && g_settings.IsUsingFastmem())
+            if (reg == Cop0Reg::SR && m_settings.fastmem)
             {
               LabelType skip_fastmem_update;
               Value old_value = m_register_cache.AllocateScratch(RegSize_32);
@@ -2377,7 +2565,7 @@ Value CodeGenerator::DoGTERegisterRead(u32 index)
 
     default:
     {
-      EmitLoadCPUStructField(value.host_reg, RegSize_32, offsetof(State, gte_regs.r32[index]));
+      EmitLoadCPUStructField(value.host_reg, RegSize_32, CalculateGTERegisterOffset(index));
     }
     break;
   }
@@ -2406,7 +2594,7 @@ void CodeGenerator::DoGTERegisterWrite(u32 index, const Value& value)
     {
       // sign-extend z component of vector registers
       Value temp = ConvertValueSize(value.ViewAsSize(RegSize_16), RegSize_32, true);
-      EmitStoreCPUStructField(offsetof(State, gte_regs.r32[index]), temp);
+      EmitStoreCPUStructField(CalculateGTERegisterOffset(index), temp);
       return;
     }
     break;
@@ -2419,7 +2607,7 @@ void CodeGenerator::DoGTERegisterWrite(u32 index, const Value& value)
     {
       // zero-extend unsigned values
       Value temp = ConvertValueSize(value.ViewAsSize(RegSize_16), RegSize_32, false);
-      EmitStoreCPUStructField(offsetof(State, gte_regs.r32[index]), temp);
+      EmitStoreCPUStructField(CalculateGTERegisterOffset(index), temp);
       return;
     }
     break;
@@ -2461,7 +2649,7 @@ void CodeGenerator::DoGTERegisterWrite(u32 index, const Value& value)
     default:
     {
       // written as-is, 2x16 or 1x32 bits
-      EmitStoreCPUStructField(offsetof(State, gte_regs.r32[index]), value);
+      EmitStoreCPUStructField(CalculateGTERegisterOffset(index), value);
       return;
     }
   }
@@ -2474,18 +2662,15 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
     InstructionPrologue(cbi, 1);
 
     const u32 reg = static_cast<u32>(cbi.instruction.i.rt.GetValue());
-    Value address = AddValues(m_register_cache.ReadGuestRegister(cbi.instruction.i.rs),
-                              Value::FromConstantU32(cbi.instruction.i.imm_sext32()), false);
-    SpeculativeValue spec_address = SpeculativeReadReg(cbi.instruction.i.rs);
-    if (spec_address)
-      spec_address = *spec_address + cbi.instruction.i.imm_sext32();
+    SpeculativeValue spec_address;
+    Value address = CalculateLoadStoreAddress(cbi, &spec_address);
 
     if (cbi.instruction.op == InstructionOp::lwc2)
     {
       Value value = EmitLoadGuestMemory(cbi, address, spec_address, RegSize_32);
       DoGTERegisterWrite(reg, value);
 
-      if (g_settings.gpu_pgxp_enable)
+      if (m_settings.pgxp_enable)
         EmitFunctionCall(nullptr, PGXP::CPU_LWC2, Value::FromConstantU32(cbi.instruction.bits), value, address);
     }
     else
@@ -2493,11 +2678,10 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
       Value value = DoGTERegisterRead(reg);
       EmitStoreGuestMemory(cbi, address, spec_address, value);
 
-      if (g_settings.gpu_pgxp_enable)
+      if (m_settings.pgxp_enable)
         EmitFunctionCall(nullptr, PGXP::CPU_SWC2, Value::FromConstantU32(cbi.instruction.bits), value, address);
 
-      SpeculativeValue spec_base = SpeculativeReadReg(cbi.instruction.i.rs);
-      if (spec_base)
+      if (spec_address)
         SpeculativeWriteMemory(*spec_address, std::nullopt);
     }
 
@@ -2522,7 +2706,7 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
         Value value = DoGTERegisterRead(reg);
 
         // PGXP done first here before ownership is transferred.
-        if (g_settings.gpu_pgxp_enable)
+        if (m_settings.pgxp_enable)
         {
           EmitFunctionCall(
             nullptr, (cbi.instruction.cop.CommonOp() == CopCommonInstruction::cfcn) ? PGXP::CPU_CFC2 : PGXP::CPU_MFC2,
@@ -2547,7 +2731,7 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
         Value value = m_register_cache.ReadGuestRegister(cbi.instruction.r.rt);
         DoGTERegisterWrite(reg, value);
 
-        if (g_settings.gpu_pgxp_enable)
+        if (m_settings.pgxp_enable)
         {
           EmitFunctionCall(
             nullptr, (cbi.instruction.cop.CommonOp() == CopCommonInstruction::ctcn) ? PGXP::CPU_CTC2 : PGXP::CPU_MTC2,
@@ -2564,11 +2748,16 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
   }
   else
   {
-    // forward everything to the GTE.
     InstructionPrologue(cbi, 1);
 
-    Value instruction_bits = Value::FromConstantU32(cbi.instruction.bits & GTE::Instruction::REQUIRED_BITS_MASK);
-    EmitFunctionCall(nullptr, GTE::GetInstructionImpl(cbi.instruction.bits), instruction_bits);
+    // simple instructions are emitted inline, the rest are forwarded to the GTE.
+    if (!EmitInlineGTEInstruction(cbi.instruction.bits))
+    {
+      Value instruction_bits = Value::FromConstantU32(cbi.instruction.bits & GTE::Instruction::REQUIRED_BITS_MASK);
+      EmitFunctionCall(nullptr,
+                       GTE::GetInstructionImpl(cbi.instruction.bits, m_settings.pgxp_enable && m_settings.pgxp_culling),
+                       instruction_bits);
+    }
 
     InstructionEpilogue(cbi);
     return true;
@@ -2577,8 +2766,9 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
 
 void CodeGenerator::InitSpeculativeRegs()
 {
+  const u32* regs = m_speculative_register_snapshot ? m_speculative_register_snapshot : g_state.regs.r;
   for (u8 i = 0; i < static_cast<u8>(Reg::count); i++)
-    m_speculative_constants.regs[i] = g_state.regs.r[i];
+    m_speculative_constants.regs[i] = regs[i];
 }
 
 void CodeGenerator::InvalidateSpeculativeValues()
@@ -2605,6 +2795,10 @@ CodeGenerator::SpeculativeValue CodeGenerator::SpeculativeReadMemory(VirtualMemo
   if (it != m_speculative_constants.memory.end())
     return it->second;
 
+  // the CPU thread could be writing to memory
+  if (m_speculative_register_snapshot)
+    return std::nullopt;
+
   u32 value;
   if ((phys_addr & DCACHE_LOCATION_MASK) == DCACHE_LOCATION)
   {
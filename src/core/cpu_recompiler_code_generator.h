@@ -6,6 +6,7 @@
 #include "common/jit_code_buffer.h"
 
 #include "cpu_code_cache.h"
+#include "cpu_recompiler_dataflow.h"
 #include "cpu_recompiler_register_cache.h"
 #include "cpu_recompiler_thunks.h"
 #include "cpu_recompiler_types.h"
@@ -13,15 +14,34 @@
 
 namespace CPU::Recompiler {
 
+/// Settings which affect the generated code. Background compiles use a copy taken when the block was queued, as the
+/// CPU thread can replace g_settings while they are running.
+struct CodeGeneratorSettings
+{
+  CPUFastmemMode fastmem_mode;
+  u32 tiering_threshold;
+  bool fastmem;
+  bool memory_exceptions;
+  bool block_profiling;
+  bool return_stack;
+  bool pgxp_enable;
+  bool pgxp_culling;
+  bool widescreen_hack;
+
+  /// Captures the current settings. Only call on the CPU thread.
+  static CodeGeneratorSettings FromGlobalSettings();
+};
+
 class CodeGenerator
 {
 public:
   using SpeculativeValue = std::optional<u32>;
 
-  CodeGenerator(JitCodeBuffer* code_buffer);
+  CodeGenerator(JitCodeBuffer* code_buffer, const CodeGeneratorSettings& settings);
   ~CodeGenerator();
 
   static u32 CalculateRegisterOffset(Reg reg);
+  static u32 CalculateGTERegisterOffset(u32 index);
   static const char* GetHostRegName(HostReg reg, RegSize size = HostPointerSize);
   static void AlignCodeBuffer(JitCodeBuffer* code_buffer);
 
@@ -29,6 +49,10 @@ public:
 
   bool CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size);
 
+  /// Seeds speculative constants from a copy of the guest registers taken when the block was queued, and stops guest
+  /// memory being read at compile time. Required when compiling off the CPU thread.
+  void SetSpeculativeRegisterSnapshot(const u32* regs) { m_speculative_register_snapshot = regs; }
+
   CodeCache::DispatcherFunction CompileDispatcher();
   CodeCache::SingleBlockDispatcherFunction CompileSingleBlockDispatcher();
 
@@ -39,6 +63,9 @@ public:
   void EmitEndBlock();
   void EmitExceptionExit();
   void EmitExceptionExitOnBool(const Value& value);
+  void EmitSuperblockSideExit();
+  void EmitReturnStackPush(u32 return_pc);
+  void EmitReturnStackJump();
   void FinalizeBlock(CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size);
 
   void EmitSignExtend(HostReg to_reg, RegSize to_size, HostReg from_reg, RegSize from_size);
@@ -79,6 +106,12 @@ public:
   void EmitStoreGlobal(void* ptr, const Value& value);
   void EmitLoadGlobalAddress(HostReg host_reg, const void* ptr);
 
+  // Emits simple GTE instructions without calling out to the GTE. Returns false if the instruction must be called.
+  bool EmitInlineGTEInstruction(u32 instruction_bits);
+
+  // Emits RTPS, RTPT, MVMVA or one of the NCxx lighting commands. Implemented on x64 and AArch64.
+  void EmitInlineGTEMatrixInstruction(u32 instruction_bits);
+
   // Automatically generates an exception handler.
   Value GetFastmemLoadBase();
   Value GetFastmemStoreBase();
@@ -197,12 +230,18 @@ private:
   void InstructionPrologue(const CodeBlockInstruction& cbi, TickCount cycles, bool force_sync = false);
   void InstructionEpilogue(const CodeBlockInstruction& cbi);
   void AddPendingCycles(bool commit);
+  void IncrementBlockCounter(u32* counter, const Value& temp);
+  void GenerateSuperblockGuard(const CodeBlockInstruction& cbi);
+  bool IsReturnBlock() const;
 
   Value CalculatePC(u32 offset = 0);
   Value GetCurrentInstructionPC(u32 offset = 0);
   void UpdateCurrentInstructionPC(bool commit);
   void WriteNewPC(const Value& value, bool commit);
 
+  const InstructionDataflowInfo& GetDataflowInfo(const CodeBlockInstruction& cbi) const;
+  Value CalculateLoadStoreAddress(const CodeBlockInstruction& cbi, SpeculativeValue* address_spec);
+
   Value DoGTERegisterRead(u32 index);
   void DoGTERegisterWrite(u32 index, const Value& value);
 
@@ -211,6 +250,7 @@ private:
   //////////////////////////////////////////////////////////////////////////
   bool CompileInstruction(const CodeBlockInstruction& cbi);
   bool Compile_Fallback(const CodeBlockInstruction& cbi);
+  bool Compile_DataflowResult(const CodeBlockInstruction& cbi);
   bool Compile_Bitwise(const CodeBlockInstruction& cbi);
   bool Compile_Shift(const CodeBlockInstruction& cbi);
   bool Compile_Load(const CodeBlockInstruction& cbi);
@@ -234,6 +274,7 @@ private:
   const CodeBlockInstruction* m_block_start = nullptr;
   const CodeBlockInstruction* m_block_end = nullptr;
   const CodeBlockInstruction* m_current_instruction = nullptr;
+  std::vector<InstructionDataflowInfo> m_dataflow_info;
   RegisterCache m_register_cache;
   CodeEmitter m_near_emitter;
   CodeEmitter m_far_emitter;
@@ -271,6 +312,8 @@ private:
   void SpeculativeWriteMemory(VirtualMemoryAddress address, SpeculativeValue value);
 
   SpeculativeConstants m_speculative_constants;
+  const u32* m_speculative_register_snapshot = nullptr;
+  CodeGeneratorSettings m_settings;
 };
 
 } // namespace CPU::Recompiler
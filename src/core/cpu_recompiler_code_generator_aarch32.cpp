@@ -83,13 +83,13 @@ static const a32::Register GetCPUPtrReg()
   return GetHostReg32(RCPUPTR);
 }
 
-CodeGenerator::CodeGenerator(JitCodeBuffer* code_buffer)
+CodeGenerator::CodeGenerator(JitCodeBuffer* code_buffer, const CodeGeneratorSettings& settings)
   : m_code_buffer(code_buffer), m_register_cache(*this),
     m_near_emitter(static_cast<vixl::byte*>(code_buffer->GetFreeCodePointer()), code_buffer->GetFreeCodeSpace(),
                    a32::A32),
     m_far_emitter(static_cast<vixl::byte*>(code_buffer->GetFreeFarCodePointer()), code_buffer->GetFreeFarCodeSpace(),
                   a32::A32),
-    m_emit(&m_near_emitter)
+    m_emit(&m_near_emitter), m_settings(settings)
 {
   InitHostRegs();
 }
@@ -208,6 +208,26 @@ void CodeGenerator::EmitExceptionExit()
   m_emit->bx(a32::lr);
 }
 
+void CodeGenerator::EmitSuperblockSideExit()
+{
+  // same as the end of a block, but the state is kept for the path which stays in the superblock
+  m_register_cache.FlushAllGuestRegisters(false, false);
+  if (m_register_cache.HasLoadDelay())
+    m_register_cache.WriteLoadDelayToCPU(false);
+
+  m_register_cache.PopCalleeSavedRegisters(false);
+
+  m_emit->add(a32::sp, a32::sp, FUNCTION_STACK_SIZE);
+  m_emit->bx(a32::lr);
+}
+
+void CodeGenerator::EmitReturnStackPush(u32 return_pc)
+{
+  // return prediction isn't implemented, returns go through the dispatcher
+}
+
+void CodeGenerator::EmitReturnStackJump() {}
+
 void CodeGenerator::EmitExceptionExitOnBool(const Value& value)
 {
   Assert(!value.IsConstant() && value.IsInHostRegister());
@@ -1269,7 +1289,7 @@ void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi,
 void CodeGenerator::EmitLoadGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size,
                                                Value& result, bool in_far_code)
 {
-  if (g_settings.cpu_recompiler_memory_exceptions)
+  if (m_settings.memory_exceptions)
   {
     // NOTE: This can leave junk in the upper bits
     switch (size)
@@ -1423,7 +1443,7 @@ void CodeGenerator::EmitStoreGuestMemorySlowmem(const CodeBlockInstruction& cbi,
 
   Value value_in_hr = GetValueInHostRegister(value);
 
-  if (g_settings.cpu_recompiler_memory_exceptions)
+  if (m_settings.memory_exceptions)
   {
     Assert(!in_far_code);
 
@@ -1897,6 +1917,12 @@ void CodeGenerator::EmitLoadGlobalAddress(HostReg host_reg, const void* ptr)
   m_emit->Mov(GetHostReg32(host_reg), reinterpret_cast<uintptr_t>(ptr));
 }
 
+bool CodeGenerator::EmitInlineGTEInstruction(u32 instruction_bits)
+{
+  // Not implemented for AArch32, all instructions are forwarded to the GTE.
+  return false;
+}
+
 CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
 {
   m_emit->sub(a32::sp, a32::sp, FUNCTION_STACK_SIZE);
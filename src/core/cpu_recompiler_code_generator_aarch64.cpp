@@ -5,6 +5,7 @@
 #include "cpu_core_private.h"
 #include "cpu_recompiler_code_generator.h"
 #include "cpu_recompiler_thunks.h"
+#include "gte.h"
 #include "settings.h"
 #include "timing_event.h"
 Log_SetChannel(CPU::Recompiler);
@@ -28,6 +29,10 @@ constexpr u64 FUNCTION_CALLER_SAVED_SPACE_RESERVE = 144; // 18 registers -> 224
 constexpr u64 FUNCTION_STACK_SIZE =
   FUNCTION_CALLEE_SAVED_SPACE_RESERVE + FUNCTION_CALLER_SAVED_SPACE_RESERVE + FUNCTION_CALL_SHADOW_SPACE;
 
+// Callee-saved and never used for the CPU/fastmem pointers, so pinned guest registers survive calls out of the
+// generated code.
+constexpr std::array<HostReg, MAX_PINNED_GUEST_REGISTERS> PINNED_HOST_REGS = {26, 27, 28};
+
 // PC we return to after the end of the block
 static void* s_dispatcher_return_address;
 
@@ -92,13 +97,13 @@ static const a64::XRegister GetFastmemBasePtrReg()
   return GetHostReg64(RMEMBASEPTR);
 }
 
-CodeGenerator::CodeGenerator(JitCodeBuffer* code_buffer)
+CodeGenerator::CodeGenerator(JitCodeBuffer* code_buffer, const CodeGeneratorSettings& settings)
   : m_code_buffer(code_buffer), m_register_cache(*this),
     m_near_emitter(static_cast<vixl::byte*>(code_buffer->GetFreeCodePointer()), code_buffer->GetFreeCodeSpace(),
                    a64::PositionDependentCode),
     m_far_emitter(static_cast<vixl::byte*>(code_buffer->GetFreeFarCodePointer()), code_buffer->GetFreeFarCodeSpace(),
                   a64::PositionDependentCode),
-    m_emit(&m_near_emitter)
+    m_emit(&m_near_emitter), m_settings(settings)
 {
   // remove the temporaries from vixl's list to prevent it from using them.
   // eventually we won't use the macro assembler and this won't be a problem...
@@ -215,6 +220,10 @@ void CodeGenerator::EmitBeginBlock()
     Assert(fastmem_reg_allocated);
     m_emit->Ldr(GetFastmemBasePtrReg(), a64::MemOperand(GetCPUPtrReg(), offsetof(State, fastmem_base)));
   }
+
+  // The dispatcher loaded the pinned guest registers.
+  for (u32 i = 0; i < CodeCache::GetPinnedGuestRegisterCount(); i++)
+    m_register_cache.PinGuestRegister(CodeCache::GetPinnedGuestRegister(i), PINNED_HOST_REGS[i]);
 }
 
 void CodeGenerator::EmitEndBlock()
@@ -233,7 +242,7 @@ void CodeGenerator::EmitEndBlock()
 void CodeGenerator::EmitExceptionExit()
 {
   // ensure all unflushed registers are written back
-  m_register_cache.FlushAllGuestRegisters(false, false);
+  m_register_cache.FlushAllGuestRegistersForBlockExit(false);
 
   // the interpreter load delay might have its own value, but we'll overwrite it here anyway
   // technically RaiseException() and FlushPipeline() have already been called, but that should be okay
@@ -246,6 +255,26 @@ void CodeGenerator::EmitExceptionExit()
   m_emit->Ret();
 }
 
+void CodeGenerator::EmitSuperblockSideExit()
+{
+  // same as the end of a block, but the state is kept for the path which stays in the superblock
+  m_register_cache.FlushAllGuestRegistersForBlockExit(false);
+  if (m_register_cache.HasLoadDelay())
+    m_register_cache.WriteLoadDelayToCPU(false);
+
+  m_register_cache.PopCalleeSavedRegisters(false);
+
+  m_emit->Add(a64::sp, a64::sp, FUNCTION_STACK_SIZE);
+  m_emit->Ret();
+}
+
+void CodeGenerator::EmitReturnStackPush(u32 return_pc)
+{
+  // return prediction isn't implemented, returns go through the dispatcher
+}
+
+void CodeGenerator::EmitReturnStackJump() {}
+
 void CodeGenerator::EmitExceptionExitOnBool(const Value& value)
 {
   Assert(!value.IsConstant() && value.IsInHostRegister());
@@ -1322,7 +1351,7 @@ void CodeGenerator::EmitLoadGuestRAMFastmem(const Value& address, RegSize size,
     address_reg = address.host_reg;
   }
 
-  if (g_settings.cpu_fastmem_mode == CPUFastmemMode::MMap)
+  if (m_settings.fastmem_mode == CPUFastmemMode::MMap)
   {
     switch (size)
     {
@@ -1392,7 +1421,7 @@ void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi,
 
   m_register_cache.InhibitAllocation();
 
-  if (g_settings.cpu_fastmem_mode == CPUFastmemMode::MMap)
+  if (m_settings.fastmem_mode == CPUFastmemMode::MMap)
   {
     bpi.host_pc = GetCurrentNearCodePointer();
 
@@ -1465,7 +1494,7 @@ void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi,
 void CodeGenerator::EmitLoadGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size,
                                                Value& result, bool in_far_code)
 {
-  if (g_settings.cpu_recompiler_memory_exceptions)
+  if (m_settings.memory_exceptions)
   {
     // NOTE: This can leave junk in the upper bits
     switch (size)
@@ -1559,7 +1588,7 @@ void CodeGenerator::EmitStoreGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   }
 
   m_register_cache.InhibitAllocation();
-  if (g_settings.cpu_fastmem_mode == CPUFastmemMode::MMap)
+  if (m_settings.fastmem_mode == CPUFastmemMode::MMap)
   {
     bpi.host_pc = GetCurrentNearCodePointer();
 
@@ -1636,7 +1665,7 @@ void CodeGenerator::EmitStoreGuestMemorySlowmem(const CodeBlockInstruction& cbi,
 
   Value value_in_hr = GetValueInHostRegister(value);
 
-  if (g_settings.cpu_recompiler_memory_exceptions)
+  if (m_settings.memory_exceptions)
   {
     Assert(!in_far_code);
 
@@ -1800,6 +1829,14 @@ void CodeGenerator::EmitFlushInterpreterLoadDelay()
   // value = load_delay_value
   m_emit->Ldr(GetHostReg32(value), load_delay_value);
 
+  // pinned registers don't come from the CPU state, so they have to be updated too
+  for (u32 i = 0; i < CodeCache::GetPinnedGuestRegisterCount(); i++)
+  {
+    const a64::WRegister pinned_reg = GetHostReg32(PINNED_HOST_REGS[i]);
+    m_emit->Cmp(GetHostReg32(reg), static_cast<u8>(CodeCache::GetPinnedGuestRegister(i)));
+    m_emit->Csel(pinned_reg, GetHostReg32(value), pinned_reg, a64::eq);
+  }
+
   // reg = offset(r[0] + reg << 2)
   m_emit->Lsl(GetHostReg32(reg), GetHostReg32(reg), 2);
   m_emit->Add(GetHostReg32(reg), GetHostReg32(reg), offsetof(State, regs.r[0]));
@@ -2123,6 +2160,538 @@ void CodeGenerator::EmitLoadGlobalAddress(HostReg host_reg, const void* ptr)
   }
 }
 
+bool CodeGenerator::EmitInlineGTEInstruction(u32 instruction_bits)
+{
+  const GTE::Instruction inst{instruction_bits};
+  const bool is_rtps = (inst.command == 0x01);
+  const bool is_rtpt = (inst.command == 0x30);
+  const bool is_mvmva = (inst.command == 0x12);
+  const bool is_nclip = (inst.command == 0x06);
+  const bool is_avsz3 = (inst.command == 0x2D);
+  const bool is_avsz4 = (inst.command == 0x2E);
+  const bool is_lighting = (inst.command == 0x13 || inst.command == 0x16 || inst.command == 0x1B ||
+                            inst.command == 0x1E || inst.command == 0x20 || inst.command == 0x3F);
+
+  if (is_lighting)
+  {
+    EmitInlineGTEMatrixInstruction(instruction_bits);
+    return true;
+  }
+
+  if (is_rtps || is_rtpt || is_mvmva)
+  {
+    // PGXP and the widescreen hack change the projection, so leave those to the GTE.
+    if (!is_mvmva && (m_settings.pgxp_enable || m_settings.widescreen_hack))
+      return false;
+
+    EmitInlineGTEMatrixInstruction(instruction_bits);
+    return true;
+  }
+
+  // PGXP culling replaces the NCLIP result, so leave that to the GTE.
+  if (!(is_nclip && !(m_settings.pgxp_enable && m_settings.pgxp_culling)) && !is_avsz3 && !is_avsz4)
+    return false;
+
+  Value result = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp2 = m_register_cache.AllocateScratch(RegSize_64);
+  Value flags = m_register_cache.AllocateScratch(RegSize_32);
+  const a64::XRegister result64 = GetHostReg64(result);
+  const a64::WRegister result32 = GetHostReg32(result.host_reg);
+  const a64::XRegister temp64 = GetHostReg64(temp);
+  const a64::WRegister temp32 = GetHostReg32(temp.host_reg);
+  const a64::XRegister temp2_64 = GetHostReg64(temp2);
+  const a64::WRegister temp2_32 = GetHostReg32(temp2.host_reg);
+  const a64::WRegister flags32 = GetHostReg32(flags);
+
+  auto gte_reg = [](u32 index, u32 offset = 0) {
+    return a64::MemOperand(GetCPUPtrReg(), static_cast<s64>(ZeroExtend64(CalculateGTERegisterOffset(index) + offset)));
+  };
+
+  if (is_nclip)
+  {
+    // MAC0 = SX0*SY1 + SX1*SY2 + SX2*SY0 - SX0*SY2 - SX1*SY0 - SX2*SY1
+    auto emit_product = [&](u32 x_index, u32 y_index, bool subtract) {
+      m_emit->Ldrsh(temp32, gte_reg(x_index));
+      m_emit->Ldrsh(temp2_32, gte_reg(y_index, sizeof(u16)));
+      m_emit->Smull(temp64, temp32, temp2_32);
+      if (subtract)
+        m_emit->Sub(result64, result64, temp64);
+      else
+        m_emit->Add(result64, result64, temp64);
+    };
+
+    m_emit->Mov(result64, 0);
+    emit_product(12, 13, false);
+    emit_product(13, 14, false);
+    emit_product(14, 12, false);
+    emit_product(12, 14, true);
+    emit_product(13, 12, true);
+    emit_product(14, 13, true);
+  }
+  else
+  {
+    // MAC0 = ZSF3 * (SZ1 + SZ2 + SZ3), or ZSF4 * (SZ0 + SZ1 + SZ2 + SZ3)
+    m_emit->Ldrh(result32, gte_reg(17));
+    if (is_avsz4)
+    {
+      m_emit->Ldrh(temp32, gte_reg(16));
+      m_emit->Add(result32, result32, temp32);
+    }
+    m_emit->Ldrh(temp32, gte_reg(18));
+    m_emit->Add(result32, result32, temp32);
+    m_emit->Ldrh(temp32, gte_reg(19));
+    m_emit->Add(result32, result32, temp32);
+    m_emit->Ldrsh(temp32, gte_reg(is_avsz4 ? 62 : 61));
+    m_emit->Smull(result64, result32, temp32);
+  }
+
+  // MAC0 is truncated, overflow/underflow is flagged. FLAG is cleared by both instructions, so just overwrite it.
+  m_emit->Str(result32, gte_reg(24));
+  m_emit->Mov(flags32, 0);
+  m_emit->Mov(temp32, UINT32_C(0x80010000));
+  m_emit->Mov(temp2_64, INT64_C(0x7FFFFFFF));
+  m_emit->Cmp(result64, temp2_64);
+  m_emit->Csel(flags32, temp32, flags32, a64::gt);
+  m_emit->Mov(temp32, UINT32_C(0x80008000));
+  m_emit->Mov(temp2_64, -INT64_C(0x80000000));
+  m_emit->Cmp(result64, temp2_64);
+  m_emit->Csel(flags32, temp32, flags32, a64::lt);
+
+  if (!is_nclip)
+  {
+    // OTZ = clamp(MAC0 >> 12, 0, 0xFFFF)
+    m_emit->Asr(result64, result64, 12);
+    m_emit->Mov(temp32, 0xFFFF);
+    m_emit->Mov(temp2_32, UINT32_C(0x80040000));
+    m_emit->Orr(temp2_32, flags32, temp2_32);
+    m_emit->Cmp(result32, temp32);
+    m_emit->Csel(flags32, temp2_32, flags32, a64::hi);
+    m_emit->Csel(result32, temp32, result32, a64::gt);
+    m_emit->Cmp(result32, 0);
+    m_emit->Csel(result32, a64::wzr, result32, a64::lt);
+    m_emit->Str(result32, gte_reg(7));
+  }
+
+  m_emit->Str(flags32, gte_reg(63));
+  return true;
+}
+
+void CodeGenerator::EmitInlineGTEMatrixInstruction(u32 instruction_bits)
+{
+  const GTE::Instruction inst{instruction_bits};
+  const bool is_rtpt = (inst.command == 0x30);
+  const bool is_mvmva = (inst.command == 0x12);
+  const bool is_ncs = (inst.command == 0x1E || inst.command == 0x20);
+  const bool is_nccs = (inst.command == 0x1B || inst.command == 0x3F);
+  const bool is_ncds = (inst.command == 0x13 || inst.command == 0x16);
+  const bool is_lighting = (is_ncs || is_nccs || is_ncds);
+  const bool is_triple = (is_rtpt || inst.command == 0x20 || inst.command == 0x3F || inst.command == 0x16);
+  const u8 shift = inst.GetShift();
+  const bool lm = inst.lm;
+
+  Value acc = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp2 = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp3 = m_register_cache.AllocateScratch(RegSize_64);
+  Value limit = m_register_cache.AllocateScratch(RegSize_32);
+  Value flags = m_register_cache.AllocateScratch(RegSize_32);
+  Value new_flags = m_register_cache.AllocateScratch(RegSize_32);
+  const a64::XRegister acc64 = GetHostReg64(acc);
+  const a64::WRegister acc32 = GetHostReg32(acc);
+  const a64::XRegister temp64 = GetHostReg64(temp);
+  const a64::WRegister temp32 = GetHostReg32(temp);
+  const a64::XRegister temp2_64 = GetHostReg64(temp2);
+  const a64::WRegister temp2_32 = GetHostReg32(temp2);
+  const a64::XRegister temp3_64 = GetHostReg64(temp3);
+  const a64::WRegister temp3_32 = GetHostReg32(temp3);
+  const a64::WRegister limit32 = GetHostReg32(limit);
+  const a64::WRegister flags32 = GetHostReg32(flags);
+  const a64::WRegister new_flags32 = GetHostReg32(new_flags);
+  const auto gte_reg = [](u32 index, u32 byte_offset = 0) {
+    return a64::MemOperand(GetCPUPtrReg(),
+                           static_cast<s64>(ZeroExtend64(CalculateGTERegisterOffset(index) + byte_offset)));
+  };
+
+  // flags |= flag_bit if the last comparison matched cond.
+  const auto set_flag_if = [&](u32 flag_bit, a64::Condition cond) {
+    m_emit->Orr(new_flags32, flags32, flag_bit);
+    m_emit->Csel(flags32, new_flags32, flags32, cond);
+  };
+
+  // Flags the overflow/underflow of MAC0 (32 bits) or MAC1-3 (44 bits). Above the MAC width, the value is all sign bits
+  // unless it overflowed. Uses temp.
+  const auto check_mac = [&](u32 index) {
+    m_emit->Asr(temp64, acc64, (index == 0) ? 31 : 43);
+    m_emit->Cmp(temp64, 0);
+    set_flag_if((index == 0) ? (1u << 16) : (1u << (31 - index)), a64::gt);
+    m_emit->Cmn(temp64, 1);
+    set_flag_if((index == 0) ? (1u << 15) : (1u << (28 - index)), a64::lt);
+  };
+
+  // Clamps a signed 32-bit value, setting flag_bit if it was out of range.
+  const auto saturate = [&](const a64::WRegister& value, s32 min_value, s32 max_value, u32 flag_bit) {
+    m_emit->Mov(limit32, static_cast<u32>(max_value));
+    m_emit->Cmp(value, limit32);
+    m_emit->Csel(value, limit32, value, a64::gt);
+    if (flag_bit != 0)
+      set_flag_if(flag_bit, a64::gt);
+
+    m_emit->Mov(limit32, static_cast<u32>(min_value));
+    m_emit->Cmp(value, limit32);
+    m_emit->Csel(value, limit32, value, a64::lt);
+    if (flag_bit != 0)
+      set_flag_if(flag_bit, a64::lt);
+  };
+
+  // acc += M[row][column] * vector[column]. Matrix 3 is the garbage matrix MVMVA uses for mx=3. Uses temp and temp3.
+  const auto add_product = [&](u32 matrix, u32 row, u32 column, const a64::XRegister& vector_base,
+                               u32 vector_offset, u32 vector_stride) {
+    if (matrix < 3)
+    {
+      m_emit->Ldrsh(temp32, gte_reg(32 + (matrix * 8), ((row * 3) + column) * sizeof(s16)));
+    }
+    else if (row == 0 && column < 2)
+    {
+      m_emit->Ldrb(temp32, gte_reg(6));
+      m_emit->Lsl(temp32, temp32, 4);
+      if (column == 0)
+        m_emit->Neg(temp32, temp32);
+    }
+    else
+    {
+      m_emit->Ldrsh(temp32, (row == 0) ? gte_reg(8) : gte_reg(32, (row == 1) ? 4 : 8));
+    }
+
+    m_emit->Ldrsh(temp3_32, a64::MemOperand(vector_base, vector_offset + (column * vector_stride)));
+    m_emit->Smaddl(acc64, temp32, temp3_32, acc64);
+  };
+
+  // acc = T[row] * 1000h, from TR, BK, FC or zero.
+  const auto load_translation = [&](u32 translation, u32 row) {
+    if (translation < 3)
+    {
+      m_emit->Ldrsw(acc64, gte_reg(37 + (translation * 8) + row));
+      m_emit->Lsl(acc64, acc64, 12);
+    }
+    else
+    {
+      m_emit->Mov(acc64, 0);
+    }
+  };
+
+  const auto sign_extend_mac = [&]() { m_emit->Sbfx(acc64, acc64, 0, 44); };
+
+  // acc = T[row] * 1000h + M[row] . V, flagging MAC overflow and truncating to 44 bits after each addition.
+  const auto dot3 = [&](u32 matrix, u32 translation, u32 row, const a64::XRegister& vector_base, u32 vector_offset,
+                        u32 vector_stride) {
+    load_translation(translation, row);
+    add_product(matrix, row, 0, vector_base, vector_offset, vector_stride);
+    check_mac(row + 1);
+    sign_extend_mac();
+    add_product(matrix, row, 1, vector_base, vector_offset, vector_stride);
+    check_mac(row + 1);
+    sign_extend_mac();
+    add_product(matrix, row, 2, vector_base, vector_offset, vector_stride);
+    check_mac(row + 1);
+  };
+
+  const auto store_mac = [&](u32 index) {
+    if (shift > 0)
+      m_emit->Asr(acc64, acc64, shift);
+    m_emit->Str(acc32, gte_reg(24 + index));
+  };
+
+  // IR[index] = MAC[index] saturated to -8000h..7FFFh, or 0..7FFFh with lm. Uses temp.
+  const auto set_ir_from_mac = [&](u32 index, bool saturate_to_zero, bool set_flag) {
+    m_emit->Ldr(temp32, gte_reg(24 + index));
+    saturate(temp32, saturate_to_zero ? 0 : -0x8000, 0x7FFF, set_flag ? (1u << (25 - index)) : 0);
+    m_emit->Str(temp32, gte_reg(8 + index));
+  };
+
+  const a64::XRegister cpu_ptr = GetCPUPtrReg();
+  m_emit->Mov(flags32, 0);
+
+  if (is_mvmva)
+  {
+    // Vectors 0-2 are V0-V2, vector 3 is IR1-IR3. IR isn't written until all of MAC has been calculated.
+    const u32 matrix = inst.mvmva_multiply_matrix;
+    const u32 vector = inst.mvmva_multiply_vector;
+    const u32 translation = inst.mvmva_translation_vector;
+    const u32 vector_offset = CalculateGTERegisterOffset((vector < 3) ? (vector * 2) : 9);
+    const u32 vector_stride = (vector < 3) ? sizeof(s16) : sizeof(u32);
+    for (u32 row = 0; row < 3; row++)
+    {
+      if (translation == 2)
+      {
+        // FC is buggy: only the first column is added to it, which just sets the IR flag, and the MAC is the sum of
+        // the other two columns. That sum can't overflow 44 bits.
+        load_translation(translation, row);
+        add_product(matrix, row, 0, cpu_ptr, vector_offset, vector_stride);
+        check_mac(row + 1);
+        sign_extend_mac();
+        if (shift > 0)
+          m_emit->Asr(acc64, acc64, shift);
+        saturate(acc32, -0x8000, 0x7FFF, 1u << (24 - row));
+
+        m_emit->Mov(acc64, 0);
+        add_product(matrix, row, 1, cpu_ptr, vector_offset, vector_stride);
+        add_product(matrix, row, 2, cpu_ptr, vector_offset, vector_stride);
+      }
+      else
+      {
+        dot3(matrix, translation, row, cpu_ptr, vector_offset, vector_stride);
+      }
+
+      store_mac(row + 1);
+    }
+
+    for (u32 index = 1; index <= 3; index++)
+      set_ir_from_mac(index, lm, true);
+  }
+  else
+  {
+    // RTPT and the NCxT commands run the same code for V0, V1 and V2, with the CPU pointer offset by the vertex in
+    // vertex_base.
+    Value vertex;
+    a64::Label vertex_loop;
+    a64::XRegister vertex_base = cpu_ptr;
+    const u32 vertex_offset = CalculateGTERegisterOffset(0);
+    if (is_triple)
+    {
+      vertex = m_register_cache.AllocateScratch(RegSize_64);
+      vertex_base = GetHostReg64(vertex);
+      m_emit->Mov(vertex_base, cpu_ptr);
+      m_emit->Bind(&vertex_loop);
+    }
+
+    if (is_lighting)
+    {
+      // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V) SAR (sf*12)
+      for (u32 row = 0; row < 3; row++)
+      {
+        dot3(1, 3, row, vertex_base, vertex_offset, sizeof(s16));
+        store_mac(row + 1);
+      }
+      for (u32 index = 1; index <= 3; index++)
+        set_ir_from_mac(index, lm, true);
+
+      // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12), IR is read before any of it is written.
+      for (u32 row = 0; row < 3; row++)
+      {
+        dot3(2, 1, row, cpu_ptr, CalculateGTERegisterOffset(9), sizeof(u32));
+        store_mac(row + 1);
+      }
+      for (u32 index = 1; index <= 3; index++)
+        set_ir_from_mac(index, lm, true);
+
+      if (!is_ncs)
+      {
+        // Each channel only reads its own IR, so they can be done one at a time.
+        for (u32 index = 1; index <= 3; index++)
+        {
+          // temp2 = (color * IR) SHL 4, which can't overflow 32 bits.
+          m_emit->Ldrb(temp2_32, gte_reg(6, index - 1));
+          m_emit->Ldrsh(temp32, gte_reg(8 + index));
+          m_emit->Mul(temp2_32, temp2_32, temp32);
+          m_emit->Lsl(temp2_32, temp2_32, 4);
+
+          if (is_ncds)
+          {
+            // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = ((FC SHL 12) - temp2) SAR (sf*12), saturated without lm
+            m_emit->Ldrsw(acc64, gte_reg(52 + index));
+            m_emit->Lsl(acc64, acc64, 12);
+            m_emit->Sub(acc64, acc64, a64::Operand(temp2_32, a64::SXTW));
+            check_mac(index);
+            store_mac(index);
+            set_ir_from_mac(index, false, true);
+
+            // [MAC1,MAC2,MAC3] = ((IR * IR0) + temp2) SAR (sf*12)
+            m_emit->Ldrsh(acc32, gte_reg(8 + index));
+            m_emit->Ldrsh(temp32, gte_reg(8));
+            m_emit->Smull(acc64, acc32, temp32);
+            m_emit->Add(acc64, acc64, a64::Operand(temp2_32, a64::SXTW));
+          }
+          else
+          {
+            // [MAC1,MAC2,MAC3] = temp2 SAR (sf*12)
+            m_emit->Sxtw(acc64, temp2_32);
+          }
+
+          check_mac(index);
+          store_mac(index);
+          set_ir_from_mac(index, lm, true);
+        }
+      }
+
+      // Color FIFO = [MAC1 SAR 4, MAC2 SAR 4, MAC3 SAR 4, CODE], each saturated to 0..FFh
+      m_emit->Ldrb(acc32, gte_reg(6, 3));
+      m_emit->Lsl(acc32, acc32, 24);
+      for (u32 index = 1; index <= 3; index++)
+      {
+        m_emit->Ldr(temp32, gte_reg(24 + index));
+        m_emit->Asr(temp32, temp32, 4);
+        saturate(temp32, 0, 0xFF, 1u << (22 - index));
+        m_emit->Orr(acc32, acc32, a64::Operand(temp32, a64::LSL, (index - 1) * 8));
+      }
+      for (u32 i = 20; i < 22; i++)
+      {
+        m_emit->Ldr(temp32, gte_reg(i + 1));
+        m_emit->Str(temp32, gte_reg(i));
+      }
+      m_emit->Str(acc32, gte_reg(22));
+    }
+    else
+    {
+      for (u32 row = 0; row < 3; row++)
+      {
+        dot3(0, 0, row, vertex_base, vertex_offset, sizeof(s16));
+        if (row == 2)
+        {
+          // The IR3 flag and SZ3 both come from MAC3 SAR 12, regardless of sf.
+          m_emit->Asr(temp64, acc64, 12);
+          m_emit->Mov(temp3_32, temp32);
+          saturate(temp3_32, -0x8000, 0x7FFF, 1u << 22);
+          saturate(temp32, 0, 0xFFFF, 1u << 18);
+          for (u32 i = 16; i < 19; i++)
+          {
+            m_emit->Ldr(temp3_32, gte_reg(i + 1));
+            m_emit->Str(temp3_32, gte_reg(i));
+          }
+          m_emit->Str(temp32, gte_reg(19));
+        }
+
+        store_mac(row + 1);
+      }
+
+      set_ir_from_mac(1, lm, true);
+      set_ir_from_mac(2, lm, true);
+      set_ir_from_mac(3, lm, false);
+
+      // temp2 = UNR division of H by SZ3, as GTE::UNRDivide().
+      a64::Label divide_overflow, divide_done;
+      m_emit->Ldrh(temp32, gte_reg(19));
+      m_emit->Ldrh(temp2_32, gte_reg(58));
+      m_emit->Lsl(acc32, temp32, 1);
+      m_emit->Cmp(acc32, temp2_32);
+      m_emit->B(&divide_overflow, a64::ls);
+
+      // Normalize the divisor, shifting both sides left by 15 - (31 - clz(SZ3)).
+      m_emit->Clz(acc32, temp32);
+      m_emit->Sub(acc32, acc32, 16);
+      m_emit->Lsl(temp32, temp32, acc32);
+      m_emit->Lsl(temp2_32, temp2_32, acc32);
+      m_emit->Orr(temp32, temp32, 0x8000);
+
+      // x = 101h + table[((divisor & 7FFFh) + 40h) >> 7]
+      m_emit->And(acc32, temp32, 0x7FFF);
+      m_emit->Add(acc32, acc32, 0x40);
+      m_emit->Lsr(acc32, acc32, 7);
+      EmitLoadGlobalAddress(temp3.host_reg, GTE::GetUNRTable());
+      m_emit->Ldrb(acc32, a64::MemOperand(temp3_64, acc64));
+      m_emit->Add(acc32, acc32, 0x101);
+
+      // d = ((divisor * -x) + 80h) >> 8, recip = ((x * (20000h + d)) + 80h) >> 8
+      m_emit->Neg(temp3_32, acc32);
+      m_emit->Mul(temp3_32, temp3_32, temp32);
+      m_emit->Add(temp3_32, temp3_32, 0x80);
+      m_emit->Asr(temp3_32, temp3_32, 8);
+      m_emit->Add(temp3_32, temp3_32, 0x20000);
+      m_emit->Mul(temp3_32, temp3_32, acc32);
+      m_emit->Add(temp3_32, temp3_32, 0x80);
+      m_emit->Asr(temp3_32, temp3_32, 8);
+
+      // result = min(((lhs * recip) + 8000h) >> 16, 1FFFFh)
+      m_emit->Mul(temp2_64, temp2_64, temp3_64);
+      m_emit->Add(temp2_64, temp2_64, 0x8000);
+      m_emit->Lsr(temp2_64, temp2_64, 16);
+      m_emit->Mov(acc64, 0x1FFFF);
+      m_emit->Cmp(temp2_64, acc64);
+      m_emit->Csel(temp2_64, acc64, temp2_64, a64::hi);
+      m_emit->B(&divide_done);
+
+      m_emit->Bind(&divide_overflow);
+      m_emit->Orr(flags32, flags32, 1u << 17);
+      m_emit->Mov(temp2_64, 0x1FFFF);
+      m_emit->Bind(&divide_done);
+
+      // MAC0 = result * IR1 + OFX, SX2 = MAC0 SAR 16, and the same for Y.
+      m_emit->Ldrsh(acc64, gte_reg(9));
+      m_emit->Mul(acc64, acc64, temp2_64);
+      m_emit->Ldrsw(temp64, gte_reg(56));
+      m_emit->Add(acc64, acc64, temp64);
+      check_mac(0);
+      m_emit->Asr(acc64, acc64, 16);
+      saturate(acc32, -0x400, 0x3FF, 1u << 14);
+      m_emit->Uxth(temp3_32, acc32);
+
+      m_emit->Ldrsh(acc64, gte_reg(10));
+      m_emit->Mul(acc64, acc64, temp2_64);
+      m_emit->Ldrsw(temp64, gte_reg(57));
+      m_emit->Add(acc64, acc64, temp64);
+      check_mac(0);
+      m_emit->Asr(acc64, acc64, 16);
+      saturate(acc32, -0x400, 0x3FF, 1u << 13);
+      m_emit->Orr(acc32, temp3_32, a64::Operand(acc32, a64::LSL, 16));
+
+      for (u32 i = 12; i < 14; i++)
+      {
+        m_emit->Ldr(temp32, gte_reg(i + 1));
+        m_emit->Str(temp32, gte_reg(i));
+      }
+      m_emit->Str(acc32, gte_reg(14));
+    }
+
+    if (is_triple)
+    {
+      m_emit->Add(vertex_base, vertex_base, 2 * sizeof(u32));
+      m_emit->Sub(temp64, vertex_base, cpu_ptr);
+      m_emit->Cmp(temp64, 6 * sizeof(u32));
+      m_emit->B(&vertex_loop, a64::lo);
+    }
+  }
+
+  if (!is_mvmva && !is_lighting)
+  {
+    // MAC0 = result * DQA + DQB, IR0 = MAC0 SAR 12 saturated to 0..1000h
+    m_emit->Ldrsh(acc64, gte_reg(59));
+    m_emit->Mul(acc64, acc64, temp2_64);
+    m_emit->Ldrsw(temp64, gte_reg(60));
+    m_emit->Add(acc64, acc64, temp64);
+    check_mac(0);
+    m_emit->Str(acc32, gte_reg(24));
+    m_emit->Asr(acc64, acc64, 12);
+    saturate(acc32, 0, 0x1000, 1u << 12);
+    m_emit->Str(acc32, gte_reg(8));
+  }
+
+  // FLAG.31 is set if any of bits 30..23 or 18..13 are.
+  m_emit->Mov(limit32, 0x7F87E000);
+  m_emit->Tst(flags32, limit32);
+  set_flag_if(0x80000000u, a64::ne);
+  m_emit->Str(flags32, gte_reg(63));
+}
+
+static void EmitLoadPinnedGuestRegisters(a64::MacroAssembler* emit)
+{
+  for (u32 i = 0; i < CodeCache::GetPinnedGuestRegisterCount(); i++)
+  {
+    emit->Ldr(GetHostReg32(PINNED_HOST_REGS[i]),
+              a64::MemOperand(GetCPUPtrReg(),
+                              CodeGenerator::CalculateRegisterOffset(CodeCache::GetPinnedGuestRegister(i))));
+  }
+}
+
+static void EmitStorePinnedGuestRegisters(a64::MacroAssembler* emit)
+{
+  for (u32 i = 0; i < CodeCache::GetPinnedGuestRegisterCount(); i++)
+  {
+    emit->Str(GetHostReg32(PINNED_HOST_REGS[i]),
+              a64::MemOperand(GetCPUPtrReg(),
+                              CodeGenerator::CalculateRegisterOffset(CodeCache::GetPinnedGuestRegister(i))));
+  }
+}
+
 CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
 {
   m_emit->sub(a64::sp, a64::sp, FUNCTION_STACK_SIZE);
@@ -2131,6 +2700,9 @@ CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
 
   EmitLoadGlobalAddress(RCPUPTR, &g_state);
 
+  // pinned guest registers live in host registers until we leave compiled code or call into C++
+  EmitLoadPinnedGuestRegisters(m_emit);
+
   a64::Label frame_done_loop;
   a64::Label exit_dispatcher;
   m_emit->Bind(&frame_done_loop);
@@ -2156,7 +2728,9 @@ CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
   m_emit->b(&no_interrupt, a64::eq);
 
   // we have an interrupt
+  EmitStorePinnedGuestRegisters(m_emit);
   EmitCall(reinterpret_cast<const void*>(&DispatchInterrupt));
+  EmitLoadPinnedGuestRegisters(m_emit);
 
   // no interrupt or we just serviced it
   m_emit->Bind(&no_interrupt);
@@ -2209,6 +2783,28 @@ CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
   // ebx contains our index, rax <- fast_map[ebx * 8], rax(), continue
   EmitLoadGlobalAddress(9, CodeCache::GetFastMapPointer());
   m_emit->ldr(a64::x8, a64::MemOperand(a64::x9, a64::x8, a64::LSL, 3));
+
+  // the compile/promote stubs run C++ code which uses the CPU state, so write back the pinned registers around them
+  if (CodeCache::GetPinnedGuestRegisterCount() > 0)
+  {
+    a64::Label call_stub;
+    a64::Label call_block;
+    m_emit->Mov(a64::x9, reinterpret_cast<uintptr_t>(CodeCache::GetCompileBlockStub()));
+    m_emit->cmp(a64::x8, a64::x9);
+    m_emit->b(&call_stub, a64::eq);
+    m_emit->Mov(a64::x9, reinterpret_cast<uintptr_t>(CodeCache::GetPromoteBlockStub()));
+    m_emit->cmp(a64::x8, a64::x9);
+    m_emit->b(&call_block, a64::ne);
+
+    m_emit->Bind(&call_stub);
+    EmitStorePinnedGuestRegisters(m_emit);
+    m_emit->blr(a64::x8);
+    EmitLoadPinnedGuestRegisters(m_emit);
+    m_emit->b(&downcount_hit);
+
+    m_emit->Bind(&call_block);
+  }
+
   m_emit->blr(a64::x8);
 
   // end while
@@ -2221,11 +2817,14 @@ CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
   m_emit->ldr(a64::w9, a64::MemOperand(a64::x9, offsetof(TimingEvent, m_downcount)));
   m_emit->cmp(a64::w8, a64::w9);
   m_emit->b(&frame_done_loop, a64::lt);
+  EmitStorePinnedGuestRegisters(m_emit);
   EmitCall(reinterpret_cast<const void*>(&TimingEvents::RunEvents));
+  EmitLoadPinnedGuestRegisters(m_emit);
   m_emit->b(&frame_done_loop);
 
   // all done
   m_emit->Bind(&exit_dispatcher);
+  EmitStorePinnedGuestRegisters(m_emit);
   RestoreStackAfterCall(stack_adjust);
   m_register_cache.PopCalleeSavedRegisters(true);
   m_emit->add(a64::sp, a64::sp, FUNCTION_STACK_SIZE);
@@ -2246,7 +2845,9 @@ CodeCache::SingleBlockDispatcherFunction CodeGenerator::CompileSingleBlockDispat
 
   EmitLoadGlobalAddress(RCPUPTR, &g_state);
 
+  EmitLoadPinnedGuestRegisters(m_emit);
   m_emit->blr(GetHostReg64(RARG1));
+  EmitStorePinnedGuestRegisters(m_emit);
 
   RestoreStackAfterCall(stack_adjust);
   m_register_cache.PopCalleeSavedRegisters(true);
@@ -5,6 +5,7 @@
 #include "cpu_core_private.h"
 #include "cpu_recompiler_code_generator.h"
 #include "cpu_recompiler_thunks.h"
+#include "gte.h"
 #include "settings.h"
 #include "timing_event.h"
 Log_SetChannel(Recompiler::CodeGenerator);
@@ -33,6 +34,10 @@ constexpr u32 FUNCTION_CALL_SHADOW_SPACE = 0;
 constexpr u64 FUNCTION_CALL_STACK_ALIGNMENT = 16;
 #endif
 
+// Callee-saved in both ABIs, so pinned guest registers survive calls out of the generated code.
+constexpr std::array<HostReg, MAX_PINNED_GUEST_REGISTERS> PINNED_HOST_REGS = {
+  Xbyak::Operand::R13, Xbyak::Operand::R14, Xbyak::Operand::R15};
+
 static const Xbyak::Reg8 GetHostReg8(HostReg reg)
 {
   return Xbyak::Reg8(reg, reg >= Xbyak::Operand::SPL);
@@ -87,10 +92,11 @@ static const Xbyak::Reg64 GetFastmemBasePtrReg()
   return GetHostReg64(RMEMBASEPTR);
 }
 
-CodeGenerator::CodeGenerator(JitCodeBuffer* code_buffer)
+CodeGenerator::CodeGenerator(JitCodeBuffer* code_buffer, const CodeGeneratorSettings& settings)
   : m_code_buffer(code_buffer), m_register_cache(*this),
     m_near_emitter(code_buffer->GetFreeCodeSpace(), code_buffer->GetFreeCodePointer()),
-    m_far_emitter(code_buffer->GetFreeFarCodeSpace(), code_buffer->GetFreeFarCodePointer()), m_emit(&m_near_emitter)
+    m_far_emitter(code_buffer->GetFreeFarCodeSpace(), code_buffer->GetFreeFarCodePointer()), m_emit(&m_near_emitter),
+    m_settings(settings)
 {
   InitHostRegs();
 }
@@ -222,6 +228,10 @@ void CodeGenerator::EmitBeginBlock()
     Assert(fastmem_reg_allocated);
     m_emit->mov(GetFastmemBasePtrReg(), m_emit->qword[GetCPUPtrReg() + offsetof(CPU::State, fastmem_base)]);
   }
+
+  // The dispatcher loaded the pinned guest registers.
+  for (u32 i = 0; i < CodeCache::GetPinnedGuestRegisterCount(); i++)
+    m_register_cache.PinGuestRegister(CodeCache::GetPinnedGuestRegister(i), PINNED_HOST_REGS[i]);
 }
 
 void CodeGenerator::EmitEndBlock()
@@ -232,6 +242,9 @@ void CodeGenerator::EmitEndBlock()
 
   m_register_cache.PopCalleeSavedRegisters(true);
 
+  if (IsReturnBlock())
+    EmitReturnStackJump();
+
   m_emit->ret();
 }
 
@@ -240,7 +253,7 @@ void CodeGenerator::EmitExceptionExit()
   AddPendingCycles(false);
 
   // ensure all unflushed registers are written back
-  m_register_cache.FlushAllGuestRegisters(false, false);
+  m_register_cache.FlushAllGuestRegistersForBlockExit(false);
 
   // the interpreter load delay might have its own value, but we'll overwrite it here anyway
   // technically RaiseException() and FlushPipeline() have already been called, but that should be okay
@@ -250,6 +263,99 @@ void CodeGenerator::EmitExceptionExit()
   m_emit->ret();
 }
 
+void CodeGenerator::EmitSuperblockSideExit()
+{
+  // same as the end of a block, but the state is kept for the path which stays in the superblock
+  m_register_cache.FlushAllGuestRegistersForBlockExit(false);
+  if (m_register_cache.HasLoadDelay())
+    m_register_cache.WriteLoadDelayToCPU(false);
+
+  m_register_cache.PopCalleeSavedRegisters(false);
+  m_emit->ret();
+}
+
+void CodeGenerator::EmitReturnStackPush(u32 return_pc)
+{
+  static_assert(sizeof(CodeCache::ReturnStackEntry) == 16, "return stack entry is 16 bytes");
+  constexpr u32 entries_offset = offsetof(CodeCache::ReturnStack, entries);
+
+  Value base = m_register_cache.AllocateScratch(RegSize_64);
+  Value entry = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp = m_register_cache.AllocateScratch(RegSize_64);
+  EmitLoadGlobalAddress(base.GetHostRegister(), CodeCache::GetReturnStack());
+
+  // top <- (top + 1) % RETURN_STACK_SIZE
+  m_emit->mov(GetHostReg32(entry), m_emit->dword[GetHostReg64(base) + offsetof(CodeCache::ReturnStack, top)]);
+  m_emit->inc(GetHostReg32(entry));
+  m_emit->and_(GetHostReg32(entry), CodeCache::RETURN_STACK_SIZE - 1);
+  m_emit->mov(m_emit->dword[GetHostReg64(base) + offsetof(CodeCache::ReturnStack, top)], GetHostReg32(entry));
+  m_emit->shl(GetHostReg64(entry), 4);
+  m_emit->add(GetHostReg64(entry), GetHostReg64(base));
+
+  // entry <- { return_pc, fast_map_generation, fast_map[return_pc] }
+  m_emit->mov(m_emit->dword[GetHostReg64(entry) + entries_offset + offsetof(CodeCache::ReturnStackEntry, pc)],
+              return_pc);
+  m_emit->mov(GetHostReg32(temp),
+              m_emit->dword[GetHostReg64(base) + offsetof(CodeCache::ReturnStack, fast_map_generation)]);
+  m_emit->mov(
+    m_emit->dword[GetHostReg64(entry) + entries_offset + offsetof(CodeCache::ReturnStackEntry, fast_map_generation)],
+    GetHostReg32(temp));
+  EmitLoadGlobalAddress(temp.GetHostRegister(), CodeCache::GetFastMapSlot(return_pc));
+  m_emit->mov(GetHostReg64(temp), m_emit->qword[GetHostReg64(temp)]);
+  m_emit->mov(m_emit->qword[GetHostReg64(entry) + entries_offset + offsetof(CodeCache::ReturnStackEntry, host_code)],
+              GetHostReg64(temp));
+}
+
+void CodeGenerator::EmitReturnStackJump()
+{
+  // Called after the callee-saved registers are restored, so only caller-saved registers can be used. The stack is
+  // back to how it was on entry to the block, so the predicted block returns to the dispatcher in our place.
+  constexpr u32 entries_offset = offsetof(CodeCache::ReturnStack, entries);
+  Xbyak::Label miss;
+  Xbyak::Label use_dispatcher;
+
+  // rcx <- &entries[top], top <- (top - 1) % RETURN_STACK_SIZE
+  EmitLoadGlobalAddress(Xbyak::Operand::RAX, CodeCache::GetReturnStack());
+  m_emit->mov(m_emit->ecx, m_emit->dword[m_emit->rax + offsetof(CodeCache::ReturnStack, top)]);
+  m_emit->lea(m_emit->edx, m_emit->dword[m_emit->rcx - 1]);
+  m_emit->and_(m_emit->edx, CodeCache::RETURN_STACK_SIZE - 1);
+  m_emit->mov(m_emit->dword[m_emit->rax + offsetof(CodeCache::ReturnStack, top)], m_emit->edx);
+  m_emit->shl(m_emit->rcx, 4);
+  m_emit->add(m_emit->rcx, m_emit->rax);
+
+  // the prediction has to match the new pc, and the fast map can't have changed since it was pushed
+  m_emit->mov(m_emit->edx, m_emit->dword[GetCPUPtrReg() + offsetof(State, regs.pc)]);
+  m_emit->cmp(m_emit->edx, m_emit->dword[m_emit->rcx + entries_offset + offsetof(CodeCache::ReturnStackEntry, pc)]);
+  m_emit->jne(miss, Xbyak::CodeGenerator::T_NEAR);
+  m_emit->mov(m_emit->edx, m_emit->dword[m_emit->rax + offsetof(CodeCache::ReturnStack, fast_map_generation)]);
+  m_emit->cmp(m_emit->edx, m_emit->dword[m_emit->rcx + entries_offset +
+                                         offsetof(CodeCache::ReturnStackEntry, fast_map_generation)]);
+  m_emit->jne(miss, Xbyak::CodeGenerator::T_NEAR);
+
+  // the compile/promote stubs go through the single block dispatcher, which would nest
+  m_emit->mov(m_emit->rcx,
+              m_emit->qword[m_emit->rcx + entries_offset + offsetof(CodeCache::ReturnStackEntry, host_code)]);
+  m_emit->cmp(m_emit->rcx, m_emit->qword[m_emit->rax + offsetof(CodeCache::ReturnStack, compile_stub)]);
+  m_emit->je(miss, Xbyak::CodeGenerator::T_NEAR);
+  m_emit->cmp(m_emit->rcx, m_emit->qword[m_emit->rax + offsetof(CodeCache::ReturnStack, promote_stub)]);
+  m_emit->je(miss, Xbyak::CodeGenerator::T_NEAR);
+
+  // events still have to be run by the dispatcher
+  m_emit->mov(m_emit->edx, m_emit->dword[GetCPUPtrReg() + offsetof(State, pending_ticks)]);
+  m_emit->cmp(m_emit->edx, m_emit->dword[GetCPUPtrReg() + offsetof(State, downcount)]);
+  m_emit->jge(use_dispatcher, Xbyak::CodeGenerator::T_NEAR);
+
+  // current_instruction_pc <- pc, jump straight to the predicted block
+  m_emit->inc(m_emit->qword[m_emit->rax + offsetof(CodeCache::ReturnStack, hits)]);
+  m_emit->mov(m_emit->edx, m_emit->dword[GetCPUPtrReg() + offsetof(State, regs.pc)]);
+  m_emit->mov(m_emit->dword[GetCPUPtrReg() + offsetof(State, current_instruction_pc)], m_emit->edx);
+  m_emit->jmp(m_emit->rcx);
+
+  m_emit->L(miss);
+  m_emit->inc(m_emit->qword[m_emit->rax + offsetof(CodeCache::ReturnStack, misses)]);
+  m_emit->L(use_dispatcher);
+}
+
 void CodeGenerator::EmitExceptionExitOnBool(const Value& value)
 {
   Assert(!value.IsConstant() && value.IsInHostRegister());
@@ -1760,7 +1866,7 @@ void CodeGenerator::EmitAddCPUStructField(u32 offset, const Value& value)
 
 void CodeGenerator::EmitLoadGuestRAMFastmem(const Value& address, RegSize size, Value& result)
 {
-  if (g_settings.cpu_fastmem_mode == CPUFastmemMode::MMap)
+  if (m_settings.fastmem_mode == CPUFastmemMode::MMap)
   {
     // can't store displacements > 0x80000000 in-line
     const Value* actual_address = &address;
@@ -1855,7 +1961,7 @@ void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   bpi.value_host_reg = result.host_reg;
   bpi.guest_pc = m_current_instruction->pc;
 
-  if (g_settings.cpu_fastmem_mode == CPUFastmemMode::MMap)
+  if (m_settings.fastmem_mode == CPUFastmemMode::MMap)
   {
     // can't store displacements > 0x80000000 in-line
     const Value* actual_address = &address;
@@ -1975,7 +2081,7 @@ void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi,
 void CodeGenerator::EmitLoadGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size,
                                                Value& result, bool in_far_code)
 {
-  if (g_settings.cpu_recompiler_memory_exceptions)
+  if (m_settings.memory_exceptions)
   {
     // NOTE: This can leave junk in the upper bits
     switch (size)
@@ -2054,7 +2160,7 @@ void CodeGenerator::EmitStoreGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   bpi.value_host_reg = value.host_reg;
   bpi.guest_pc = m_current_instruction->pc;
 
-  if (g_settings.cpu_fastmem_mode == CPUFastmemMode::MMap)
+  if (m_settings.fastmem_mode == CPUFastmemMode::MMap)
   {
     // can't store displacements > 0x80000000 in-line
     const Value* actual_address = &address;
@@ -2235,7 +2341,7 @@ void CodeGenerator::EmitStoreGuestMemoryFastmem(const CodeBlockInstruction& cbi,
 void CodeGenerator::EmitStoreGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address,
                                                 const Value& value, bool in_far_code)
 {
-  if (g_settings.cpu_recompiler_memory_exceptions)
+  if (m_settings.memory_exceptions)
   {
     Assert(!in_far_code);
 
@@ -2538,6 +2644,16 @@ void CodeGenerator::EmitFlushInterpreterLoadDelay()
   m_emit->mov(GetHostReg32(value), load_delay_value);
   m_emit->mov(reg_ptr, GetHostReg32(value));
 
+  // pinned registers don't come from the CPU state, so they have to be updated too
+  for (u32 i = 0; i < CodeCache::GetPinnedGuestRegisterCount(); i++)
+  {
+    Xbyak::Label not_pinned_reg;
+    m_emit->cmp(GetHostReg32(reg.host_reg), static_cast<u8>(CodeCache::GetPinnedGuestRegister(i)));
+    m_emit->jne(not_pinned_reg);
+    m_emit->mov(GetHostReg32(PINNED_HOST_REGS[i]), GetHostReg32(value));
+    m_emit->L(not_pinned_reg);
+  }
+
   // load_delay_reg = Reg::count
   m_emit->mov(load_delay_reg, static_cast<u8>(Reg::count));
 
@@ -2889,6 +3005,542 @@ void CodeGenerator::EmitLoadGlobalAddress(HostReg host_reg, const void* ptr)
     m_emit->mov(GetHostReg64(host_reg), reinterpret_cast<size_t>(ptr));
 }
 
+bool CodeGenerator::EmitInlineGTEInstruction(u32 instruction_bits)
+{
+  const GTE::Instruction inst{instruction_bits};
+  const bool is_rtps = (inst.command == 0x01);
+  const bool is_rtpt = (inst.command == 0x30);
+  const bool is_mvmva = (inst.command == 0x12);
+  const bool is_nclip = (inst.command == 0x06);
+  const bool is_avsz3 = (inst.command == 0x2D);
+  const bool is_avsz4 = (inst.command == 0x2E);
+  const bool is_lighting = (inst.command == 0x13 || inst.command == 0x16 || inst.command == 0x1B ||
+                            inst.command == 0x1E || inst.command == 0x20 || inst.command == 0x3F);
+
+  if (is_lighting)
+  {
+    EmitInlineGTEMatrixInstruction(instruction_bits);
+    return true;
+  }
+
+  if (is_rtps || is_rtpt || is_mvmva)
+  {
+    // PGXP and the widescreen hack change the projection, so leave those to the GTE.
+    if (!is_mvmva && (m_settings.pgxp_enable || m_settings.widescreen_hack))
+      return false;
+
+    EmitInlineGTEMatrixInstruction(instruction_bits);
+    return true;
+  }
+
+  // PGXP culling replaces the NCLIP result, so leave that to the GTE.
+  if (!(is_nclip && !(m_settings.pgxp_enable && m_settings.pgxp_culling)) && !is_avsz3 && !is_avsz4)
+    return false;
+
+  Value result = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp = m_register_cache.AllocateScratch(RegSize_64);
+  Value flags = m_register_cache.AllocateScratch(RegSize_32);
+  const Xbyak::Reg64 result64 = GetHostReg64(result);
+  const Xbyak::Reg32 result32 = GetHostReg32(result.host_reg);
+  const Xbyak::Reg64 temp64 = GetHostReg64(temp);
+  const Xbyak::Reg32 temp32 = GetHostReg32(temp.host_reg);
+  const Xbyak::Reg32 flags32 = GetHostReg32(flags);
+
+  if (is_nclip)
+  {
+    // MAC0 = SX0*SY1 + SX1*SY2 + SX2*SY0 - SX0*SY2 - SX1*SY0 - SX2*SY1
+    const Xbyak::Reg32 rhs32 = flags32;
+    auto emit_product = [&](u32 x_index, u32 y_index, bool subtract) {
+      m_emit->movsx(temp32, m_emit->word[GetCPUPtrReg() + CalculateGTERegisterOffset(x_index)]);
+      m_emit->movsx(rhs32, m_emit->word[GetCPUPtrReg() + CalculateGTERegisterOffset(y_index) + sizeof(u16)]);
+      m_emit->imul(temp32, rhs32);
+      m_emit->movsxd(temp64, temp32);
+      if (subtract)
+        m_emit->sub(result64, temp64);
+      else
+        m_emit->add(result64, temp64);
+    };
+
+    m_emit->xor_(result32, result32);
+    emit_product(12, 13, false);
+    emit_product(13, 14, false);
+    emit_product(14, 12, false);
+    emit_product(12, 14, true);
+    emit_product(13, 12, true);
+    emit_product(14, 13, true);
+  }
+  else
+  {
+    // MAC0 = ZSF3 * (SZ1 + SZ2 + SZ3), or ZSF4 * (SZ0 + SZ1 + SZ2 + SZ3)
+    m_emit->movzx(result32, m_emit->word[GetCPUPtrReg() + CalculateGTERegisterOffset(17)]);
+    if (is_avsz4)
+    {
+      m_emit->movzx(temp32, m_emit->word[GetCPUPtrReg() + CalculateGTERegisterOffset(16)]);
+      m_emit->add(result32, temp32);
+    }
+    m_emit->movzx(temp32, m_emit->word[GetCPUPtrReg() + CalculateGTERegisterOffset(18)]);
+    m_emit->add(result32, temp32);
+    m_emit->movzx(temp32, m_emit->word[GetCPUPtrReg() + CalculateGTERegisterOffset(19)]);
+    m_emit->add(result32, temp32);
+    m_emit->movsx(temp64, m_emit->word[GetCPUPtrReg() + CalculateGTERegisterOffset(is_avsz4 ? 62 : 61)]);
+    m_emit->imul(result64, temp64);
+  }
+
+  // MAC0 is truncated, overflow/underflow is flagged. FLAG is cleared by both instructions, so just overwrite it.
+  m_emit->mov(m_emit->dword[GetCPUPtrReg() + CalculateGTERegisterOffset(24)], result32);
+  m_emit->xor_(flags32, flags32);
+  m_emit->mov(temp32, UINT32_C(0x80010000));
+  m_emit->cmp(result64, INT32_C(0x7FFFFFFF));
+  m_emit->cmovg(flags32, temp32);
+  m_emit->mov(temp32, UINT32_C(0x80008000));
+  m_emit->cmp(result64, UINT32_C(0x80000000)); // sign-extended to -0x80000000
+  m_emit->cmovl(flags32, temp32);
+
+  if (!is_nclip)
+  {
+    // OTZ = clamp(MAC0 >> 12, 0, 0xFFFF)
+    Xbyak::Label otz_done;
+    m_emit->sar(result64, 12);
+    m_emit->cmp(result32, 0xFFFF);
+    m_emit->jbe(otz_done);
+    m_emit->or_(flags32, UINT32_C(0x80040000));
+    m_emit->test(result32, result32);
+    m_emit->mov(result32, 0xFFFF);
+    m_emit->jns(otz_done);
+    m_emit->xor_(result32, result32);
+    m_emit->L(otz_done);
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + CalculateGTERegisterOffset(7)], result32);
+  }
+
+  m_emit->mov(m_emit->dword[GetCPUPtrReg() + CalculateGTERegisterOffset(63)], flags32);
+  return true;
+}
+
+void CodeGenerator::EmitInlineGTEMatrixInstruction(u32 instruction_bits)
+{
+  const GTE::Instruction inst{instruction_bits};
+  const bool is_rtpt = (inst.command == 0x30);
+  const bool is_mvmva = (inst.command == 0x12);
+  const bool is_ncs = (inst.command == 0x1E || inst.command == 0x20);
+  const bool is_nccs = (inst.command == 0x1B || inst.command == 0x3F);
+  const bool is_ncds = (inst.command == 0x13 || inst.command == 0x16);
+  const bool is_lighting = (is_ncs || is_nccs || is_ncds);
+  const bool is_triple = (is_rtpt || inst.command == 0x20 || inst.command == 0x3F || inst.command == 0x16);
+  const u8 shift = inst.GetShift();
+  const bool lm = inst.lm;
+
+  Value acc = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp2 = m_register_cache.AllocateScratch(RegSize_64);
+  Value temp3 = m_register_cache.AllocateScratch(RegSize_64);
+  Value flags = m_register_cache.AllocateScratch(RegSize_32);
+  const Xbyak::Reg64 acc64 = GetHostReg64(acc);
+  const Xbyak::Reg32 acc32 = GetHostReg32(acc);
+  const Xbyak::Reg64 temp64 = GetHostReg64(temp);
+  const Xbyak::Reg32 temp32 = GetHostReg32(temp);
+  const Xbyak::Reg64 temp2_64 = GetHostReg64(temp2);
+  const Xbyak::Reg32 temp2_32 = GetHostReg32(temp2);
+  const Xbyak::Reg64 temp3_64 = GetHostReg64(temp3);
+  const Xbyak::Reg32 temp3_32 = GetHostReg32(temp3);
+  const Xbyak::Reg32 flags32 = GetHostReg32(flags);
+  const auto gte_reg = [](u32 index, u32 byte_offset = 0) {
+    return GetCPUPtrReg() + (CalculateGTERegisterOffset(index) + byte_offset);
+  };
+
+  // Flags the overflow/underflow of MAC0 (32 bits) or MAC1-3 (44 bits). Above the MAC width, the value is all sign bits
+  // unless it overflowed. Uses temp.
+  const auto check_mac = [&](u32 index) {
+    Xbyak::Label not_overflow, done;
+    m_emit->mov(temp64, acc64);
+    m_emit->sar(temp64, (index == 0) ? 31 : 43);
+    m_emit->test(temp64, temp64);
+    m_emit->jle(not_overflow);
+    m_emit->or_(flags32, (index == 0) ? (1u << 16) : (1u << (31 - index)));
+    m_emit->jmp(done);
+    m_emit->L(not_overflow);
+    m_emit->cmp(temp64, -1);
+    m_emit->jge(done);
+    m_emit->or_(flags32, (index == 0) ? (1u << 15) : (1u << (28 - index)));
+    m_emit->L(done);
+  };
+
+  // Clamps the value, setting flag_bit (if any) when it was out of range.
+  const auto saturate = [&](const Xbyak::Reg32& value, s32 min_value, s32 max_value, u32 flag_bit) {
+    Xbyak::Label not_above, saturated, done;
+    m_emit->cmp(value, max_value);
+    m_emit->jle(not_above);
+    m_emit->mov(value, static_cast<u32>(max_value));
+    m_emit->jmp(saturated);
+    m_emit->L(not_above);
+    m_emit->cmp(value, min_value);
+    m_emit->jge(done);
+    m_emit->mov(value, static_cast<u32>(min_value));
+    m_emit->L(saturated);
+    if (flag_bit != 0)
+      m_emit->or_(flags32, flag_bit);
+    m_emit->L(done);
+  };
+
+  // acc += M[row][column] * V[column]. Matrix 3 is the garbage matrix MVMVA builds from RGBC, IR0, RT13 and RT22.
+  // Uses temp and temp3.
+  const auto add_product = [&](u32 matrix, u32 row, u32 column, const Xbyak::RegExp& vector, u32 vector_stride) {
+    if (matrix < 3)
+    {
+      m_emit->movsx(temp32, m_emit->word[gte_reg(32 + (matrix * 8), ((row * 3) + column) * sizeof(s16))]);
+    }
+    else if (row == 0 && column < 2)
+    {
+      m_emit->movzx(temp32, m_emit->byte[gte_reg(6)]);
+      m_emit->shl(temp32, 4);
+      if (column == 0)
+        m_emit->neg(temp32);
+    }
+    else
+    {
+      m_emit->movsx(temp32, m_emit->word[(row == 0) ? gte_reg(8) : gte_reg(32, (row == 1) ? 4 : 8)]);
+    }
+
+    m_emit->movsx(temp3_32, m_emit->word[vector + (column * vector_stride)]);
+    m_emit->imul(temp32, temp3_32);
+    m_emit->movsxd(temp64, temp32);
+    m_emit->add(acc64, temp64);
+  };
+
+  // acc = T[row] * 1000h, from TR, BK, FC or zero.
+  const auto load_translation = [&](u32 translation, u32 row) {
+    if (translation < 3)
+    {
+      m_emit->movsxd(acc64, m_emit->dword[gte_reg(37 + (translation * 8) + row)]);
+      m_emit->shl(acc64, 12);
+    }
+    else
+    {
+      m_emit->xor_(acc32, acc32);
+    }
+  };
+
+  const auto sign_extend_mac = [&]() {
+    m_emit->shl(acc64, 20);
+    m_emit->sar(acc64, 20);
+  };
+
+  // acc = T[row] * 1000h + M[row] . V, flagging MAC overflow and truncating to 44 bits after each addition.
+  const auto dot3 = [&](u32 matrix, u32 translation, u32 row, const Xbyak::RegExp& vector, u32 vector_stride) {
+    load_translation(translation, row);
+    add_product(matrix, row, 0, vector, vector_stride);
+    check_mac(row + 1);
+    sign_extend_mac();
+    add_product(matrix, row, 1, vector, vector_stride);
+    check_mac(row + 1);
+    sign_extend_mac();
+    add_product(matrix, row, 2, vector, vector_stride);
+    check_mac(row + 1);
+  };
+
+  const auto store_mac = [&](u32 index) {
+    if (shift > 0)
+      m_emit->sar(acc64, shift);
+    m_emit->mov(m_emit->dword[gte_reg(24 + index)], acc32);
+  };
+
+  // IR[index] = MAC[index] saturated to -8000h..7FFFh, or 0..7FFFh with lm. Uses temp.
+  const auto set_ir_from_mac = [&](u32 index, bool saturate_to_zero, bool set_flag) {
+    m_emit->mov(temp32, m_emit->dword[gte_reg(24 + index)]);
+    saturate(temp32, saturate_to_zero ? 0 : -0x8000, 0x7FFF, set_flag ? (1u << (25 - index)) : 0);
+    m_emit->mov(m_emit->dword[gte_reg(8 + index)], temp32);
+  };
+
+  m_emit->xor_(flags32, flags32);
+
+  if (is_mvmva)
+  {
+    // Vectors 0-2 are V0-V2, vector 3 is IR1-IR3. IR isn't written until all of MAC has been calculated.
+    const u32 matrix = inst.mvmva_multiply_matrix;
+    const u32 vector = inst.mvmva_multiply_vector;
+    const u32 translation = inst.mvmva_translation_vector;
+    const Xbyak::RegExp vector_base = (vector < 3) ? gte_reg(vector * 2) : gte_reg(9);
+    const u32 vector_stride = (vector < 3) ? sizeof(s16) : sizeof(u32);
+    for (u32 row = 0; row < 3; row++)
+    {
+      if (translation == 2)
+      {
+        // FC is buggy: only the first column is added to it, which just sets the IR flag, and the MAC is the sum of
+        // the other two columns. That sum can't overflow 44 bits.
+        load_translation(translation, row);
+        add_product(matrix, row, 0, vector_base, vector_stride);
+        check_mac(row + 1);
+        sign_extend_mac();
+        if (shift > 0)
+          m_emit->sar(acc64, shift);
+        saturate(acc32, -0x8000, 0x7FFF, 1u << (24 - row));
+
+        m_emit->xor_(acc32, acc32);
+        add_product(matrix, row, 1, vector_base, vector_stride);
+        add_product(matrix, row, 2, vector_base, vector_stride);
+      }
+      else
+      {
+        dot3(matrix, translation, row, vector_base, vector_stride);
+      }
+
+      store_mac(row + 1);
+    }
+
+    for (u32 index = 1; index <= 3; index++)
+      set_ir_from_mac(index, lm, true);
+  }
+  else
+  {
+    // RTPT and the NCxT commands run the same code for V0, V1 and V2, with the offset of the vertex in vertex_offset.
+    Value vertex_offset;
+    Xbyak::Label vertex_loop;
+    Xbyak::RegExp vertex_base = gte_reg(0);
+    if (is_triple)
+    {
+      vertex_offset = m_register_cache.AllocateScratch(RegSize_64);
+      vertex_base = vertex_base + GetHostReg64(vertex_offset);
+      m_emit->xor_(GetHostReg32(vertex_offset), GetHostReg32(vertex_offset));
+      m_emit->L(vertex_loop);
+    }
+
+    if (is_lighting)
+    {
+      // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V) SAR (sf*12)
+      for (u32 row = 0; row < 3; row++)
+      {
+        dot3(1, 3, row, vertex_base, sizeof(s16));
+        store_mac(row + 1);
+      }
+      for (u32 index = 1; index <= 3; index++)
+        set_ir_from_mac(index, lm, true);
+
+      // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12), IR is read before any of it is written.
+      for (u32 row = 0; row < 3; row++)
+      {
+        dot3(2, 1, row, gte_reg(9), sizeof(u32));
+        store_mac(row + 1);
+      }
+      for (u32 index = 1; index <= 3; index++)
+        set_ir_from_mac(index, lm, true);
+
+      if (!is_ncs)
+      {
+        // Each channel only reads its own IR, so they can be done one at a time.
+        for (u32 index = 1; index <= 3; index++)
+        {
+          // temp2 = (color * IR) SHL 4, which can't overflow 32 bits.
+          m_emit->movzx(temp2_32, m_emit->byte[gte_reg(6, index - 1)]);
+          m_emit->movsx(temp32, m_emit->word[gte_reg(8 + index)]);
+          m_emit->imul(temp2_32, temp32);
+          m_emit->shl(temp2_32, 4);
+
+          if (is_ncds)
+          {
+            // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = ((FC SHL 12) - temp2) SAR (sf*12), saturated without lm
+            m_emit->movsxd(acc64, m_emit->dword[gte_reg(52 + index)]);
+            m_emit->shl(acc64, 12);
+            m_emit->movsxd(temp64, temp2_32);
+            m_emit->sub(acc64, temp64);
+            check_mac(index);
+            store_mac(index);
+            set_ir_from_mac(index, false, true);
+
+            // [MAC1,MAC2,MAC3] = ((IR * IR0) + temp2) SAR (sf*12)
+            m_emit->movsx(acc32, m_emit->word[gte_reg(8 + index)]);
+            m_emit->movsx(temp32, m_emit->word[gte_reg(8)]);
+            m_emit->imul(acc32, temp32);
+            m_emit->movsxd(acc64, acc32);
+            m_emit->movsxd(temp64, temp2_32);
+            m_emit->add(acc64, temp64);
+          }
+          else
+          {
+            // [MAC1,MAC2,MAC3] = temp2 SAR (sf*12)
+            m_emit->movsxd(acc64, temp2_32);
+          }
+
+          check_mac(index);
+          store_mac(index);
+          set_ir_from_mac(index, lm, true);
+        }
+      }
+
+      // Color FIFO = [MAC1 SAR 4, MAC2 SAR 4, MAC3 SAR 4, CODE], each saturated to 0..FFh
+      m_emit->movzx(acc32, m_emit->byte[gte_reg(6, 3)]);
+      m_emit->shl(acc32, 24);
+      for (u32 index = 1; index <= 3; index++)
+      {
+        m_emit->mov(temp32, m_emit->dword[gte_reg(24 + index)]);
+        m_emit->sar(temp32, 4);
+        saturate(temp32, 0, 0xFF, 1u << (22 - index));
+        if (index > 1)
+          m_emit->shl(temp32, (index - 1) * 8);
+        m_emit->or_(acc32, temp32);
+      }
+      for (u32 i = 20; i < 22; i++)
+      {
+        m_emit->mov(temp32, m_emit->dword[gte_reg(i + 1)]);
+        m_emit->mov(m_emit->dword[gte_reg(i)], temp32);
+      }
+      m_emit->mov(m_emit->dword[gte_reg(22)], acc32);
+    }
+    else
+    {
+      for (u32 row = 0; row < 3; row++)
+      {
+        dot3(0, 0, row, vertex_base, sizeof(s16));
+        if (row == 2)
+        {
+          // The IR3 flag and SZ3 both come from MAC3 SAR 12, regardless of sf.
+          m_emit->mov(temp64, acc64);
+          m_emit->sar(temp64, 12);
+          m_emit->mov(temp3_32, temp32);
+          saturate(temp3_32, -0x8000, 0x7FFF, 1u << 22);
+          saturate(temp32, 0, 0xFFFF, 1u << 18);
+          for (u32 i = 16; i < 19; i++)
+          {
+            m_emit->mov(temp3_32, m_emit->dword[gte_reg(i + 1)]);
+            m_emit->mov(m_emit->dword[gte_reg(i)], temp3_32);
+          }
+          m_emit->mov(m_emit->dword[gte_reg(19)], temp32);
+        }
+
+        store_mac(row + 1);
+      }
+
+      set_ir_from_mac(1, lm, true);
+      set_ir_from_mac(2, lm, true);
+      set_ir_from_mac(3, lm, false);
+
+      // temp2 = UNR division of H by SZ3, as GTE::UNRDivide().
+      Xbyak::Label divide_overflow, divide_done;
+      m_emit->movzx(temp32, m_emit->word[gte_reg(19)]);
+      m_emit->movzx(temp2_32, m_emit->word[gte_reg(58)]);
+      m_emit->lea(acc32, m_emit->dword[temp64 + temp64]);
+      m_emit->cmp(acc32, temp2_32);
+      m_emit->jbe(divide_overflow, Xbyak::CodeGenerator::T_NEAR);
+
+      // Normalize the divisor, shifting both sides by multiplying with 1 << (15 - bsr(SZ3)).
+      m_emit->bsr(acc32, temp32);
+      m_emit->mov(temp3_32, 15);
+      m_emit->sub(temp3_32, acc32);
+      m_emit->xor_(acc32, acc32);
+      m_emit->bts(acc32, temp3_32);
+      m_emit->imul(temp32, acc32);
+      m_emit->imul(temp2_32, acc32);
+      m_emit->or_(temp32, 0x8000);
+
+      // x = 101h + table[((divisor & 7FFFh) + 40h) >> 7]
+      m_emit->mov(acc32, temp32);
+      m_emit->and_(acc32, 0x7FFF);
+      m_emit->add(acc32, 0x40);
+      m_emit->shr(acc32, 7);
+      EmitLoadGlobalAddress(temp3.host_reg, GTE::GetUNRTable());
+      m_emit->movzx(acc32, m_emit->byte[temp3_64 + acc64]);
+      m_emit->add(acc32, 0x101);
+
+      // d = ((divisor * -x) + 80h) >> 8, recip = ((x * (20000h + d)) + 80h) >> 8
+      m_emit->mov(temp3_32, acc32);
+      m_emit->neg(temp3_32);
+      m_emit->imul(temp3_32, temp32);
+      m_emit->add(temp3_32, 0x80);
+      m_emit->sar(temp3_32, 8);
+      m_emit->add(temp3_32, 0x20000);
+      m_emit->imul(temp3_32, acc32);
+      m_emit->add(temp3_32, 0x80);
+      m_emit->sar(temp3_32, 8);
+
+      // result = min(((lhs * recip) + 8000h) >> 16, 1FFFFh)
+      m_emit->imul(temp2_64, temp3_64);
+      m_emit->add(temp2_64, 0x8000);
+      m_emit->shr(temp2_64, 16);
+      m_emit->mov(acc32, 0x1FFFF);
+      m_emit->cmp(temp2_64, acc64);
+      m_emit->cmova(temp2_64, acc64);
+      m_emit->jmp(divide_done);
+
+      m_emit->L(divide_overflow);
+      m_emit->or_(flags32, 1u << 17);
+      m_emit->mov(temp2_32, 0x1FFFF);
+      m_emit->L(divide_done);
+
+      // MAC0 = result * IR1 + OFX, SX2 = MAC0 SAR 16, and the same for Y.
+      m_emit->movsx(acc64, m_emit->word[gte_reg(9)]);
+      m_emit->imul(acc64, temp2_64);
+      m_emit->movsxd(temp64, m_emit->dword[gte_reg(56)]);
+      m_emit->add(acc64, temp64);
+      check_mac(0);
+      m_emit->sar(acc64, 16);
+      saturate(acc32, -0x400, 0x3FF, 1u << 14);
+      m_emit->movzx(temp3_32, GetHostReg16(acc.host_reg));
+
+      m_emit->movsx(acc64, m_emit->word[gte_reg(10)]);
+      m_emit->imul(acc64, temp2_64);
+      m_emit->movsxd(temp64, m_emit->dword[gte_reg(57)]);
+      m_emit->add(acc64, temp64);
+      check_mac(0);
+      m_emit->sar(acc64, 16);
+      saturate(acc32, -0x400, 0x3FF, 1u << 13);
+      m_emit->shl(acc32, 16);
+      m_emit->or_(acc32, temp3_32);
+
+      for (u32 i = 12; i < 14; i++)
+      {
+        m_emit->mov(temp32, m_emit->dword[gte_reg(i + 1)]);
+        m_emit->mov(m_emit->dword[gte_reg(i)], temp32);
+      }
+      m_emit->mov(m_emit->dword[gte_reg(14)], acc32);
+    }
+
+    if (is_triple)
+    {
+      m_emit->add(GetHostReg32(vertex_offset), 2 * sizeof(u32));
+      m_emit->cmp(GetHostReg32(vertex_offset), 6 * sizeof(u32));
+      m_emit->jb(vertex_loop, Xbyak::CodeGenerator::T_NEAR);
+    }
+  }
+
+  if (!is_mvmva && !is_lighting)
+  {
+    // MAC0 = result * DQA + DQB, IR0 = MAC0 SAR 12 saturated to 0..1000h
+    m_emit->movsx(acc64, m_emit->word[gte_reg(59)]);
+    m_emit->imul(acc64, temp2_64);
+    m_emit->movsxd(temp64, m_emit->dword[gte_reg(60)]);
+    m_emit->add(acc64, temp64);
+    check_mac(0);
+    m_emit->mov(m_emit->dword[gte_reg(24)], acc32);
+    m_emit->sar(acc64, 12);
+    saturate(acc32, 0, 0x1000, 1u << 12);
+    m_emit->mov(m_emit->dword[gte_reg(8)], acc32);
+  }
+
+  // FLAG.31 is set if any of bits 30..23 or 18..13 are.
+  Xbyak::Label no_error;
+  m_emit->test(flags32, 0x7F87E000);
+  m_emit->jz(no_error);
+  m_emit->or_(flags32, 0x80000000u);
+  m_emit->L(no_error);
+  m_emit->mov(m_emit->dword[gte_reg(63)], flags32);
+}
+
+static void EmitLoadPinnedGuestRegisters(Xbyak::CodeGenerator* emit)
+{
+  for (u32 i = 0; i < CodeCache::GetPinnedGuestRegisterCount(); i++)
+  {
+    emit->mov(GetHostReg32(PINNED_HOST_REGS[i]),
+              emit->dword[emit->rbp + CodeGenerator::CalculateRegisterOffset(CodeCache::GetPinnedGuestRegister(i))]);
+  }
+}
+
+static void EmitStorePinnedGuestRegisters(Xbyak::CodeGenerator* emit)
+{
+  for (u32 i = 0; i < CodeCache::GetPinnedGuestRegisterCount(); i++)
+  {
+    emit->mov(emit->dword[emit->rbp + CodeGenerator::CalculateRegisterOffset(CodeCache::GetPinnedGuestRegister(i))],
+              GetHostReg32(PINNED_HOST_REGS[i]));
+  }
+}
+
 CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
 {
   m_register_cache.ReserveCalleeSavedRegisters();
@@ -2933,6 +3585,9 @@ CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
   m_emit->mov(m_emit->eax, m_emit->dword[m_emit->rax + offsetof(TimingEvent, m_downcount)]);
   m_emit->mov(m_emit->dword[m_emit->rbp + offsetof(State, downcount)], m_emit->eax);
 
+  // pinned guest registers live in host registers until we leave compiled code
+  EmitLoadPinnedGuestRegisters(m_emit);
+
   // main dispatch loop
   Xbyak::Label main_loop;
   m_emit->align(16);
@@ -2944,7 +3599,7 @@ CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
   // while eax < downcount
   Xbyak::Label downcount_hit;
   m_emit->cmp(m_emit->eax, m_emit->dword[m_emit->rbp + offsetof(State, downcount)]);
-  m_emit->jge(downcount_hit);
+  m_emit->jge(downcount_hit, Xbyak::CodeGenerator::T_NEAR);
 
   // time to lookup the block
   // eax <- pc
@@ -2972,11 +3627,34 @@ CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
   // ebx contains our index, rax <- fast_map[ebx * 8], rax(), continue
   EmitLoadGlobalAddress(Xbyak::Operand::RAX, CodeCache::GetFastMapPointer());
   m_emit->mov(m_emit->rax, m_emit->qword[m_emit->rax + m_emit->rbx * 8]);
+
+  // the compile/promote stubs run C++ code which uses the CPU state, so write back the pinned registers around them
+  if (CodeCache::GetPinnedGuestRegisterCount() > 0)
+  {
+    Xbyak::Label call_stub;
+    Xbyak::Label call_block;
+    m_emit->mov(m_emit->rcx, reinterpret_cast<size_t>(CodeCache::GetCompileBlockStub()));
+    m_emit->cmp(m_emit->rax, m_emit->rcx);
+    m_emit->je(call_stub);
+    m_emit->mov(m_emit->rcx, reinterpret_cast<size_t>(CodeCache::GetPromoteBlockStub()));
+    m_emit->cmp(m_emit->rax, m_emit->rcx);
+    m_emit->jne(call_block, Xbyak::CodeGenerator::T_NEAR);
+
+    m_emit->L(call_stub);
+    EmitStorePinnedGuestRegisters(m_emit);
+    m_emit->call(m_emit->rax);
+    EmitLoadPinnedGuestRegisters(m_emit);
+    m_emit->jmp(main_loop, Xbyak::CodeGenerator::T_NEAR);
+
+    m_emit->L(call_block);
+  }
+
   m_emit->call(m_emit->rax);
   m_emit->jmp(main_loop);
 
   // end while
   m_emit->L(downcount_hit);
+  EmitStorePinnedGuestRegisters(m_emit);
 
   // check events then for frame done
   EmitLoadGlobalAddress(Xbyak::Operand::RAX, TimingEvents::GetHeadEventPtr());
@@ -3007,7 +3685,9 @@ CodeCache::SingleBlockDispatcherFunction CodeGenerator::CompileSingleBlockDispat
 
   EmitLoadGlobalAddress(Xbyak::Operand::RBP, &g_state);
 
+  EmitLoadPinnedGuestRegisters(m_emit);
   m_emit->call(GetHostReg64(RARG1));
+  EmitStorePinnedGuestRegisters(m_emit);
 
   RestoreStackAfterCall(stack_adjust);
   m_register_cache.PopCalleeSavedRegisters(true);
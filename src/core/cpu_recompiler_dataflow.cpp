@@ -0,0 +1,564 @@
+#include "cpu_recompiler_dataflow.h"
+#include "common/bitutils.h"
+#include "common/log.h"
+#include <array>
+#include <optional>
+Log_SetChannel(CPU::Recompiler);
+
+namespace CPU::Recompiler {
+
+namespace {
+
+// r0 is never tracked, reads of it are free and writes to it are discarded.
+constexpr u32 ALL_REGISTERS = ~UINT32_C(1);
+
+struct RegisterUsage
+{
+  u32 reads = 0;
+  u32 writes = 0;
+  u32 delayed_writes = 0;
+};
+
+struct ConstantState
+{
+  std::array<u32, 32> values = {};
+  u32 known = UINT32_C(1);
+
+  ALWAYS_INLINE bool IsKnown(Reg reg) const { return (known & (UINT32_C(1) << static_cast<u8>(reg))) != 0; }
+  ALWAYS_INLINE u32 Get(Reg reg) const { return values[static_cast<u8>(reg)]; }
+};
+
+} // namespace
+
+static constexpr u32 RegBit(Reg reg)
+{
+  return (UINT32_C(1) << static_cast<u8>(reg)) & ALL_REGISTERS;
+}
+
+static bool GetRegisterUsage(const Instruction& inst, RegisterUsage* usage)
+{
+  switch (inst.op)
+  {
+    case InstructionOp::lui:
+      usage->writes = RegBit(inst.i.rt);
+      return true;
+
+    case InstructionOp::addi:
+    case InstructionOp::addiu:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+      usage->reads = RegBit(inst.i.rs);
+      usage->writes = RegBit(inst.i.rt);
+      return true;
+
+    case InstructionOp::lb:
+    case InstructionOp::lh:
+    case InstructionOp::lw:
+    case InstructionOp::lbu:
+    case InstructionOp::lhu:
+      usage->reads = RegBit(inst.i.rs);
+      usage->delayed_writes = RegBit(inst.i.rt);
+      return true;
+
+    case InstructionOp::lwl:
+    case InstructionOp::lwr:
+      usage->reads = RegBit(inst.i.rs) | RegBit(inst.i.rt);
+      usage->delayed_writes = RegBit(inst.i.rt);
+      return true;
+
+    case InstructionOp::sb:
+    case InstructionOp::sh:
+    case InstructionOp::sw:
+    case InstructionOp::swl:
+    case InstructionOp::swr:
+      usage->reads = RegBit(inst.i.rs) | RegBit(inst.i.rt);
+      return true;
+
+    case InstructionOp::lwc2:
+    case InstructionOp::swc2:
+      usage->reads = RegBit(inst.i.rs);
+      return true;
+
+    case InstructionOp::j:
+      return true;
+
+    case InstructionOp::jal:
+      usage->writes = RegBit(Reg::ra);
+      return true;
+
+    case InstructionOp::b:
+    {
+      usage->reads = RegBit(inst.i.rs);
+      if ((static_cast<u8>(inst.i.rt.GetValue()) & u8(0x1E)) == u8(0x10))
+        usage->writes = RegBit(Reg::ra);
+      return true;
+    }
+
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+      usage->reads = RegBit(inst.i.rs) | RegBit(inst.i.rt);
+      return true;
+
+    case InstructionOp::blez:
+    case InstructionOp::bgtz:
+      usage->reads = RegBit(inst.i.rs);
+      return true;
+
+    case InstructionOp::cop2:
+    {
+      if (!inst.cop.IsCommonInstruction())
+        return true;
+
+      switch (inst.cop.CommonOp())
+      {
+        case CopCommonInstruction::mfcn:
+        case CopCommonInstruction::cfcn:
+          usage->delayed_writes = RegBit(inst.r.rt);
+          return true;
+
+        case CopCommonInstruction::mtcn:
+        case CopCommonInstruction::ctcn:
+          usage->reads = RegBit(inst.r.rt);
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+    case InstructionOp::funct:
+    {
+      switch (inst.r.funct)
+      {
+        case InstructionFunct::sll:
+        case InstructionFunct::srl:
+        case InstructionFunct::sra:
+          usage->reads = RegBit(inst.r.rt);
+          usage->writes = RegBit(inst.r.rd);
+          return true;
+
+        case InstructionFunct::sllv:
+        case InstructionFunct::srlv:
+        case InstructionFunct::srav:
+        case InstructionFunct::add:
+        case InstructionFunct::addu:
+        case InstructionFunct::sub:
+        case InstructionFunct::subu:
+        case InstructionFunct::and_:
+        case InstructionFunct::or_:
+        case InstructionFunct::xor_:
+        case InstructionFunct::nor:
+        case InstructionFunct::slt:
+        case InstructionFunct::sltu:
+          usage->reads = RegBit(inst.r.rs) | RegBit(inst.r.rt);
+          usage->writes = RegBit(inst.r.rd);
+          return true;
+
+        case InstructionFunct::mfhi:
+        case InstructionFunct::mflo:
+          usage->writes = RegBit(inst.r.rd);
+          return true;
+
+        case InstructionFunct::mthi:
+        case InstructionFunct::mtlo:
+          usage->reads = RegBit(inst.r.rs);
+          return true;
+
+        case InstructionFunct::mult:
+        case InstructionFunct::multu:
+        case InstructionFunct::div:
+        case InstructionFunct::divu:
+          usage->reads = RegBit(inst.r.rs) | RegBit(inst.r.rt);
+          return true;
+
+        case InstructionFunct::jr:
+          usage->reads = RegBit(inst.r.rs);
+          return true;
+
+        case InstructionFunct::jalr:
+          usage->reads = RegBit(inst.r.rs);
+          usage->writes = RegBit(inst.r.rd);
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+    // cop0 can change the exception/interrupt state, so we don't try to reason about it.
+    default:
+      return false;
+  }
+}
+
+/// Returns the destination register if the instruction only computes a value from its operands, with no side effects.
+static std::optional<Reg> GetPureALUDestination(const Instruction& inst)
+{
+  switch (inst.op)
+  {
+    case InstructionOp::lui:
+    case InstructionOp::addiu:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+      return inst.i.rt;
+
+    case InstructionOp::funct:
+    {
+      switch (inst.r.funct)
+      {
+        case InstructionFunct::sll:
+        case InstructionFunct::srl:
+        case InstructionFunct::sra:
+        case InstructionFunct::sllv:
+        case InstructionFunct::srlv:
+        case InstructionFunct::srav:
+        case InstructionFunct::addu:
+        case InstructionFunct::subu:
+        case InstructionFunct::and_:
+        case InstructionFunct::or_:
+        case InstructionFunct::xor_:
+        case InstructionFunct::nor:
+        case InstructionFunct::slt:
+        case InstructionFunct::sltu:
+          return inst.r.rd;
+
+        default:
+          return std::nullopt;
+      }
+    }
+
+    default:
+      return std::nullopt;
+  }
+}
+
+/// Computes the value written by the instruction, if all of its inputs are known.
+static std::optional<u32> EvaluateConstantResult(const CodeBlockInstruction& cbi, const ConstantState& cs)
+{
+  const Instruction inst = cbi.instruction;
+  switch (inst.op)
+  {
+    case InstructionOp::lui:
+      return inst.i.imm_zext32() << 16;
+
+    case InstructionOp::jal:
+      return cbi.pc + 8;
+
+    case InstructionOp::b:
+      return cbi.pc + 8;
+
+    case InstructionOp::addi:
+    case InstructionOp::addiu:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+    {
+      if (!cs.IsKnown(inst.i.rs))
+        return std::nullopt;
+
+      const u32 rs = cs.Get(inst.i.rs);
+      const u32 imm = inst.i.imm_sext32();
+      switch (inst.op)
+      {
+        case InstructionOp::addi:
+        {
+          // Overflow raises an exception, and the destination isn't written.
+          const u32 result = rs + imm;
+          if (((rs ^ result) & (imm ^ result)) & UINT32_C(0x80000000))
+            return std::nullopt;
+          return result;
+        }
+        case InstructionOp::addiu:
+          return rs + imm;
+        case InstructionOp::slti:
+          return BoolToUInt32(static_cast<s32>(rs) < static_cast<s32>(imm));
+        case InstructionOp::sltiu:
+          return BoolToUInt32(rs < imm);
+        case InstructionOp::andi:
+          return rs & inst.i.imm_zext32();
+        case InstructionOp::ori:
+          return rs | inst.i.imm_zext32();
+        default:
+          return rs ^ inst.i.imm_zext32();
+      }
+    }
+
+    case InstructionOp::funct:
+    {
+      if (inst.r.funct == InstructionFunct::jalr)
+        return cbi.pc + 8;
+
+      if (!cs.IsKnown(inst.r.rt))
+        return std::nullopt;
+
+      const u32 rt = cs.Get(inst.r.rt);
+      switch (inst.r.funct)
+      {
+        case InstructionFunct::sll:
+          return rt << inst.r.shamt;
+        case InstructionFunct::srl:
+          return rt >> inst.r.shamt;
+        case InstructionFunct::sra:
+          return static_cast<u32>(static_cast<s32>(rt) >> inst.r.shamt);
+        default:
+          break;
+      }
+
+      if (!cs.IsKnown(inst.r.rs))
+        return std::nullopt;
+
+      const u32 rs = cs.Get(inst.r.rs);
+      switch (inst.r.funct)
+      {
+        case InstructionFunct::sllv:
+          return rt << (rs & 31u);
+        case InstructionFunct::srlv:
+          return rt >> (rs & 31u);
+        case InstructionFunct::srav:
+          return static_cast<u32>(static_cast<s32>(rt) >> (rs & 31u));
+        case InstructionFunct::add:
+        {
+          const u32 result = rs + rt;
+          if (((rs ^ result) & (rt ^ result)) & UINT32_C(0x80000000))
+            return std::nullopt;
+          return result;
+        }
+        case InstructionFunct::addu:
+          return rs + rt;
+        case InstructionFunct::sub:
+        {
+          const u32 result = rs - rt;
+          if (((rs ^ result) & (rs ^ rt)) & UINT32_C(0x80000000))
+            return std::nullopt;
+          return result;
+        }
+        case InstructionFunct::subu:
+          return rs - rt;
+        case InstructionFunct::and_:
+          return rs & rt;
+        case InstructionFunct::or_:
+          return rs | rt;
+        case InstructionFunct::xor_:
+          return rs ^ rt;
+        case InstructionFunct::nor:
+          return ~(rs | rt);
+        case InstructionFunct::slt:
+          return BoolToUInt32(static_cast<s32>(rs) < static_cast<s32>(rt));
+        case InstructionFunct::sltu:
+          return BoolToUInt32(rs < rt);
+        default:
+          return std::nullopt;
+      }
+    }
+
+    default:
+      return std::nullopt;
+  }
+}
+
+/// Returns the alignment mask of a load/store which goes through the direct memory path, or nullopt if it isn't one.
+static std::optional<u32> GetLoadStoreAlignmentMask(const Instruction& inst)
+{
+  switch (inst.op)
+  {
+    case InstructionOp::lb:
+    case InstructionOp::lbu:
+    case InstructionOp::sb:
+    case InstructionOp::lwl:
+    case InstructionOp::lwr:
+    case InstructionOp::swl:
+    case InstructionOp::swr:
+      return 0u;
+
+    case InstructionOp::lh:
+    case InstructionOp::lhu:
+    case InstructionOp::sh:
+      return 1u;
+
+    case InstructionOp::lw:
+    case InstructionOp::sw:
+    case InstructionOp::lwc2:
+    case InstructionOp::swc2:
+      return 3u;
+
+    default:
+      return std::nullopt;
+  }
+}
+
+static bool IsDelayedMemoryLoad(const Instruction& inst)
+{
+  switch (inst.op)
+  {
+    case InstructionOp::lb:
+    case InstructionOp::lh:
+    case InstructionOp::lw:
+    case InstructionOp::lbu:
+    case InstructionOp::lhu:
+    case InstructionOp::lwl:
+    case InstructionOp::lwr:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+/// Returns true if the register file can be observed outside the block while executing this instruction.
+static bool CanObserveRegisters(const CodeBlockInstruction& cbi, bool memory_exceptions)
+{
+  if (!cbi.can_trap)
+    return false;
+
+  // Without memory exceptions, loads and stores can't leave the block.
+  if (!memory_exceptions &&
+      (IsMemoryLoadInstruction(cbi.instruction) || IsMemoryStoreInstruction(cbi.instruction)))
+  {
+    return cbi.instruction.op == InstructionOp::lwc2 || cbi.instruction.op == InstructionOp::swc2;
+  }
+
+  return true;
+}
+
+void AnalyzeBlockDataflow(const CodeBlock& block, bool memory_exceptions, bool pgxp_enable,
+                          std::vector<InstructionDataflowInfo>* info)
+{
+  const size_t count = block.instructions.size();
+  info->clear();
+  info->resize(count);
+
+  // PGXP tracks values through the ALU instructions, so they have to execute even if the result is known.
+  const bool allow_elimination = !pgxp_enable;
+
+  std::vector<RegisterUsage> usage(count);
+  std::vector<bool> decoded(count);
+  for (size_t i = 0; i < count; i++)
+    decoded[i] = GetRegisterUsage(block.instructions[i].instruction, &usage[i]);
+
+  // Forward pass: constant propagation. Nothing is known on entry, since we can't tell where we came from.
+  u32 num_constant_addresses = 0;
+  u32 num_constant_results = 0;
+  ConstantState cs;
+  for (size_t i = 0; i < count; i++)
+  {
+    const CodeBlockInstruction& cbi = block.instructions[i];
+    InstructionDataflowInfo& ii = (*info)[i];
+
+    const std::optional<u32> alignment_mask = GetLoadStoreAlignmentMask(cbi.instruction);
+    if (alignment_mask.has_value() && cs.IsKnown(cbi.instruction.i.rs))
+    {
+      const u32 address = cs.Get(cbi.instruction.i.rs) + cbi.instruction.i.imm_sext32();
+      if ((address & alignment_mask.value()) == 0)
+      {
+        ii.constant_address = address;
+        ii.has_constant_address = true;
+        num_constant_addresses++;
+      }
+    }
+
+    if (!decoded[i])
+    {
+      cs.known = UINT32_C(1);
+      continue;
+    }
+
+    const std::optional<u32> result = EvaluateConstantResult(cbi, cs);
+    cs.known &= ~(usage[i].writes | usage[i].delayed_writes);
+    if (result.has_value() && usage[i].writes != 0)
+    {
+      // Every instruction writes at most one register immediately.
+      const u32 written_reg = CountTrailingZeros(usage[i].writes);
+      cs.values[written_reg] = result.value();
+      cs.known |= usage[i].writes;
+
+      const std::optional<Reg> dest = GetPureALUDestination(cbi.instruction);
+      if (dest.has_value() && allow_elimination)
+      {
+        ii.constant_result = result.value();
+        ii.result_register = dest.value();
+        ii.has_constant_result = true;
+        num_constant_results++;
+      }
+    }
+  }
+
+  // Backward pass: liveness. Everything is live on exit, and wherever the register file can be observed.
+  u32 num_dead = 0;
+  u32 live = ALL_REGISTERS;
+  for (size_t i = count; i > 0; i--)
+  {
+    const CodeBlockInstruction& cbi = block.instructions[i - 1];
+    InstructionDataflowInfo& ii = (*info)[i - 1];
+
+    // The side exit of a superblock happens after the instruction.
+    if (cbi.is_superblock_exit)
+      live = ALL_REGISTERS;
+
+    if (!decoded[i - 1])
+    {
+      live = ALL_REGISTERS;
+      continue;
+    }
+
+    const std::optional<Reg> dest = GetPureALUDestination(cbi.instruction);
+    if (dest.has_value() && allow_elimination && !cbi.is_load_delay_slot && (live & RegBit(dest.value())) == 0)
+    {
+      ii.result_register = dest.value();
+      ii.has_constant_result = false;
+      ii.is_dead = true;
+      num_dead++;
+    }
+
+    // Delayed writes don't kill the old value, the delay slot can still read it.
+    live = (live & ~usage[i - 1].writes) | usage[i - 1].reads;
+    if (CanObserveRegisters(cbi, memory_exceptions))
+      live = ALL_REGISTERS;
+  }
+
+  // Load delays which can't be observed by the instruction in the delay slot.
+  u32 num_load_delays = 0;
+  for (size_t i = 0; (i + 1) < count; i++)
+  {
+    const CodeBlockInstruction& cbi = block.instructions[i];
+    if (!IsDelayedMemoryLoad(cbi.instruction) || cbi.is_last_instruction || cbi.is_superblock_exit || !decoded[i + 1])
+      continue;
+
+    const RegisterUsage& next = usage[i + 1];
+    if (((next.reads | next.writes | next.delayed_writes) & RegBit(cbi.instruction.i.rt)) != 0)
+      continue;
+
+    (*info)[i].skip_load_delay = true;
+    num_load_delays++;
+  }
+
+  Log_ProfilePrintf("Dataflow for block 0x%08X: %u constant addresses, %u constant results, %u dead, %u load delays",
+                    block.GetPC(), num_constant_addresses, num_constant_results, num_dead, num_load_delays);
+}
+
+void CountBlockRegisterUses(const CodeBlock& block, std::array<u32, 32>* uses)
+{
+  for (const CodeBlockInstruction& cbi : block.instructions)
+  {
+    RegisterUsage usage;
+    if (!GetRegisterUsage(cbi.instruction, &usage))
+      continue;
+
+    u32 mask = usage.reads | usage.writes | usage.delayed_writes;
+    while (mask != 0)
+    {
+      const u32 reg = CountTrailingZeros(mask);
+      (*uses)[reg]++;
+      mask &= mask - 1;
+    }
+  }
+}
+
+} // namespace CPU::Recompiler
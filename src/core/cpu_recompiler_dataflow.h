@@ -0,0 +1,39 @@
+#pragma once
+#include "cpu_code_cache.h"
+#include "cpu_types.h"
+#include <array>
+#include <vector>
+
+namespace CPU::Recompiler {
+
+// Facts about a single instruction, derived from constant propagation and liveness over the whole block.
+// The code generator uses these to skip work which the register cache can't prove redundant on its own, e.g. when a
+// fallback instruction has flushed and invalidated every guest register.
+struct InstructionDataflowInfo
+{
+  // Effective address of a load/store, when the base register is known at compile time.
+  u32 constant_address;
+
+  // Value written to result_register by an ALU instruction, when all inputs are known at compile time.
+  u32 constant_result;
+  Reg result_register;
+
+  bool has_constant_address : 1;
+  bool has_constant_result : 1;
+
+  // Result is overwritten before it is read, and nothing in between can observe the register file.
+  bool is_dead : 1;
+
+  // The instruction in the load delay slot neither reads nor writes the destination, so the loaded value can be
+  // written straight away instead of being tracked as a pending load delay.
+  bool skip_load_delay : 1;
+};
+
+/// Analyzes the instructions in the block, producing one entry per instruction.
+void AnalyzeBlockDataflow(const CodeBlock& block, bool memory_exceptions, bool pgxp_enable,
+                          std::vector<InstructionDataflowInfo>* info);
+
+/// Adds the number of instructions in the block which read or write each guest register to uses.
+void CountBlockRegisterUses(const CodeBlock& block, std::array<u32, 32>* uses);
+
+} // namespace CPU::Recompiler
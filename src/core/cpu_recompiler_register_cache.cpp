@@ -102,6 +102,7 @@ void Value::Undiscard()
 RegisterCache::RegisterCache(CodeGenerator& code_generator) : m_code_generator(code_generator)
 {
   m_state.guest_reg_order.fill(Reg::count);
+  m_pinned_host_regs.fill(HostReg_Invalid);
 }
 
 RegisterCache::~RegisterCache()
@@ -474,6 +475,19 @@ void RegisterCache::PopState()
   m_state_stack.pop();
 }
 
+void RegisterCache::PinGuestRegister(Reg guest_reg, HostReg host_reg)
+{
+  DebugAssert(guest_reg != Reg::zero && !IsGuestRegisterCached(guest_reg));
+  if (!AllocateHostReg(host_reg))
+    Panic("Failed to allocate host register for pinned guest register");
+
+  // The CPU state is never up to date while in compiled code, so the register is always dirty.
+  m_pinned_host_regs[static_cast<u8>(guest_reg)] = host_reg;
+  Value& cache_value = m_state.guest_reg_state[static_cast<u8>(guest_reg)];
+  cache_value.SetHostReg(this, host_reg, RegSize_32);
+  cache_value.SetDirty();
+}
+
 Value RegisterCache::ReadGuestRegister(Reg guest_reg, bool cache /* = true */, bool force_host_register /* = false */,
                                        HostReg forced_host_reg /* = HostReg_Invalid */)
 {
@@ -492,6 +506,25 @@ Value RegisterCache::ReadGuestRegister(Reg guest_reg, bool cache /* = true */, b
   }
 
   Value& cache_value = m_state.guest_reg_state[static_cast<u8>(guest_reg)];
+  const HostReg pinned_host_reg = m_pinned_host_regs[static_cast<u8>(guest_reg)];
+  if (pinned_host_reg != HostReg_Invalid)
+  {
+    // reload after it was flushed and invalidated, e.g. by a fallback
+    if (!cache_value.IsValid())
+    {
+      m_code_generator.EmitLoadGuestRegister(pinned_host_reg, guest_reg);
+      cache_value.SetHostReg(this, pinned_host_reg, RegSize_32);
+      cache_value.SetDirty();
+    }
+
+    if (cache && (forced_host_reg == HostReg_Invalid || forced_host_reg == pinned_host_reg))
+      return cache_value;
+
+    Value temp = AllocateScratch(RegSize_32, forced_host_reg);
+    m_code_generator.EmitCopyValue(temp.GetHostRegister(), cache_value);
+    return temp;
+  }
+
   if (cache_value.IsValid())
   {
     if (cache_value.IsInHostRegister())
@@ -624,6 +657,20 @@ Value RegisterCache::WriteGuestRegister(Reg guest_reg, Value&& value)
   }
 
   Value& cache_value = m_state.guest_reg_state[static_cast<u8>(guest_reg)];
+  const HostReg pinned_host_reg = m_pinned_host_regs[static_cast<u8>(guest_reg)];
+  if (pinned_host_reg != HostReg_Invalid)
+  {
+    // A pinned register isn't written back to the CPU state at the end of the block, so the flush of an interpreter
+    // load delay can't be left to lose against the cached value. Cancel it, like the interpreter does.
+    m_code_generator.EmitCancelInterpreterLoadDelayForReg(guest_reg);
+    if (!value.IsInHostRegister() || value.GetHostRegister() != pinned_host_reg)
+      m_code_generator.EmitCopyValue(pinned_host_reg, value);
+
+    cache_value.SetHostReg(this, pinned_host_reg, RegSize_32);
+    cache_value.SetDirty();
+    return Value::FromHostReg(this, pinned_host_reg, RegSize_32);
+  }
+
   if (cache_value.IsInHostRegister() && value.IsInHostRegister() && cache_value.host_reg == value.host_reg)
   {
     // updating the register value.
@@ -760,6 +807,11 @@ void RegisterCache::FlushLoadDelay(bool clear)
     // if this is an exception exit, write the new value to the CPU register file, but keep it tracked for the next
     // non-exception-raised path. TODO: push/pop whole state would avoid this issue
     m_code_generator.EmitStoreGuestRegister(m_state.load_delay_register, m_state.load_delay_value);
+    if (IsGuestRegisterPinned(m_state.load_delay_register))
+    {
+      m_code_generator.EmitCopyValue(m_pinned_host_regs[static_cast<u8>(m_state.load_delay_register)],
+                                     m_state.load_delay_value);
+    }
 
     if (clear)
     {
@@ -785,7 +837,7 @@ void RegisterCache::FlushGuestRegister(Reg guest_reg, bool invalidate, bool clea
                       cache_value.constant_value);
     }
     m_code_generator.EmitStoreGuestRegister(guest_reg, cache_value);
-    if (clear_dirty)
+    if (clear_dirty && !IsGuestRegisterPinned(guest_reg))
       cache_value.ClearDirty();
   }
 
@@ -799,7 +851,8 @@ void RegisterCache::InvalidateGuestRegister(Reg guest_reg)
   if (!cache_value.IsValid())
     return;
 
-  if (cache_value.IsInHostRegister())
+  // pinned registers keep their host register, and are reloaded on the next read
+  if (cache_value.IsInHostRegister() && !IsGuestRegisterPinned(guest_reg))
   {
     FreeHostReg(cache_value.host_reg);
     ClearRegisterFromOrder(guest_reg);
@@ -825,6 +878,30 @@ void RegisterCache::FlushAllGuestRegisters(bool invalidate, bool clear_dirty)
     FlushGuestRegister(static_cast<Reg>(reg), invalidate, clear_dirty);
 }
 
+void RegisterCache::FlushAllGuestRegistersForBlockExit(bool commit)
+{
+  for (u8 reg = 0; reg < static_cast<u8>(Reg::count); reg++)
+  {
+    const HostReg pinned_host_reg = m_pinned_host_regs[reg];
+    if (pinned_host_reg == HostReg_Invalid)
+    {
+      FlushGuestRegister(static_cast<Reg>(reg), commit, commit);
+      continue;
+    }
+
+    Value& cache_value = m_state.guest_reg_state[reg];
+    if (cache_value.IsValid())
+      continue;
+
+    m_code_generator.EmitLoadGuestRegister(pinned_host_reg, static_cast<Reg>(reg));
+    if (commit)
+    {
+      cache_value.SetHostReg(this, pinned_host_reg, RegSize_32);
+      cache_value.SetDirty();
+    }
+  }
+}
+
 void RegisterCache::FlushCallerSavedGuestRegisters(bool invalidate, bool clear_dirty)
 {
   for (u8 reg = 0; reg < static_cast<u8>(Reg::count); reg++)
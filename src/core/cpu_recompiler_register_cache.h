@@ -292,6 +292,16 @@ public:
     return m_state.guest_reg_state[static_cast<u8>(guest_reg)].GetHostRegister();
   }
 
+  /// Returns true if the guest register lives in a fixed host register for the whole block.
+  bool IsGuestRegisterPinned(Reg guest_reg) const
+  {
+    return m_pinned_host_regs[static_cast<u8>(guest_reg)] != HostReg_Invalid;
+  }
+
+  /// Keeps the guest register in the host register for the whole block. The value is in the host register on entry,
+  /// and has to be left there on exit, rather than being loaded from/stored to the CPU state.
+  void PinGuestRegister(Reg guest_reg, HostReg host_reg);
+
   /// Returns true if there is a load delay which will be stored at the end of the instruction.
   bool HasLoadDelay() const { return m_state.load_delay_register != Reg::count; }
 
@@ -326,6 +336,10 @@ public:
 
   void InvalidateAllNonDirtyGuestRegisters();
   void FlushAllGuestRegisters(bool invalidate, bool clear_dirty);
+
+  /// Flushes all guest registers apart from pinned registers, which are reloaded if they were invalidated. Use when
+  /// leaving the block, since pinned registers are expected to be in their host registers.
+  void FlushAllGuestRegistersForBlockExit(bool commit);
   void FlushCallerSavedGuestRegisters(bool invalidate, bool clear_dirty);
   bool EvictOneGuestRegister();
 
@@ -344,6 +358,8 @@ private:
 
   HostReg m_cpu_ptr_host_register = {};
 
+  std::array<HostReg, static_cast<u8>(Reg::count)> m_pinned_host_regs{};
+
   struct RegAllocState
   {
     std::array<HostRegState, HostReg_Count> host_reg_state{};
@@ -77,9 +77,15 @@ constexpr RegSize HostPointerSize = RegSize_64;
 constexpr u32 MAX_NEAR_HOST_BYTES_PER_INSTRUCTION = 64;
 constexpr u32 MAX_FAR_HOST_BYTES_PER_INSTRUCTION = 128;
 
+// RTPS, RTPT, MVMVA and the NCxx lighting commands are emitted inline, NCDT is around 2.7KB.
+constexpr u32 MAX_NEAR_HOST_BYTES_PER_GTE_INSTRUCTION = 3072;
+
 // Alignment of code stoarge.
 constexpr u32 CODE_STORAGE_ALIGNMENT = 4096;
 
+// Number of guest registers which can be kept in host registers across blocks.
+constexpr u32 MAX_PINNED_GUEST_REGISTERS = 3;
+
 // ABI selection
 #if defined(WIN32)
 #define ABI_WIN64 1
@@ -105,9 +111,15 @@ constexpr RegSize HostPointerSize = RegSize_32;
 constexpr u32 MAX_NEAR_HOST_BYTES_PER_INSTRUCTION = 64;
 constexpr u32 MAX_FAR_HOST_BYTES_PER_INSTRUCTION = 128;
 
+// GTE commands are always calls to the GTE.
+constexpr u32 MAX_NEAR_HOST_BYTES_PER_GTE_INSTRUCTION = MAX_NEAR_HOST_BYTES_PER_INSTRUCTION;
+
 // Alignment of code stoarge.
 constexpr u32 CODE_STORAGE_ALIGNMENT = 4096;
 
+// Number of guest registers which can be kept in host registers across blocks.
+constexpr u32 MAX_PINNED_GUEST_REGISTERS = 0;
+
 #elif defined(CPU_AARCH64)
 
 using HostReg = unsigned;
@@ -124,9 +136,15 @@ constexpr RegSize HostPointerSize = RegSize_64;
 constexpr u32 MAX_NEAR_HOST_BYTES_PER_INSTRUCTION = 64;
 constexpr u32 MAX_FAR_HOST_BYTES_PER_INSTRUCTION = 128;
 
+// RTPS, RTPT, MVMVA and the NCxx lighting commands are emitted inline, NCDT is around 2.1KB.
+constexpr u32 MAX_NEAR_HOST_BYTES_PER_GTE_INSTRUCTION = 3072;
+
 // Alignment of code stoarge.
 constexpr u32 CODE_STORAGE_ALIGNMENT = 4096;
 
+// Number of guest registers which can be kept in host registers across blocks.
+constexpr u32 MAX_PINNED_GUEST_REGISTERS = 3;
+
 #else
 
 using HostReg = int;
@@ -143,6 +161,7 @@ enum : u32
 constexpr HostReg HostReg_Invalid = static_cast<HostReg>(HostReg_Count);
 constexpr RegSize HostPointerSize = RegSize_64;
 constexpr bool SHIFTS_ARE_IMPLICITLY_MASKED = false;
+constexpr u32 MAX_PINNED_GUEST_REGISTERS = 0;
 
 #endif
 
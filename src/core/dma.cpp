@@ -28,8 +28,10 @@ void DMA::Initialize()
   m_halt_ticks = g_settings.dma_halt_ticks;
 
   m_transfer_buffer.resize(32);
-  m_unhalt_event = TimingEvents::CreateTimingEvent("DMA Transfer Unhalt", 1, m_max_slice_ticks,
-                                                   std::bind(&DMA::UnhaltTransfer, this, std::placeholders::_1), false);
+  m_unhalt_event = TimingEvents::CreateTimingEvent(
+    "DMA Transfer Unhalt", 1, m_max_slice_ticks,
+    [](void* param, TickCount ticks, TickCount ticks_late) { static_cast<DMA*>(param)->UnhaltTransfer(ticks); }, this,
+    false);
 
   Reset();
 }
@@ -494,6 +496,7 @@ TickCount DMA::TransferDeviceToMemory(Channel channel, u32 address, u32 incremen
   {
     // clear ordering table
     u8* ram_pointer = Bus::g_ram;
+    const u32 start_address = address;
     const u32 word_count_less_1 = word_count - 1;
     for (u32 i = 0; i < word_count_less_1; i++)
     {
@@ -504,7 +507,7 @@ TickCount DMA::TransferDeviceToMemory(Channel channel, u32 address, u32 incremen
 
     const u32 terminator = UINT32_C(0xFFFFFF);
     std::memcpy(&ram_pointer[address], &terminator, sizeof(terminator));
-    CPU::CodeCache::InvalidateCodePages(address, word_count);
+    InvalidateCodeForTransfer(start_address, static_cast<u32>(-4), word_count);
     return Bus::GetDMARAMTickCount(word_count);
   }
 
@@ -545,17 +548,54 @@ TickCount DMA::TransferDeviceToMemory(Channel channel, u32 address, u32 incremen
   if (dest_pointer == m_transfer_buffer.data())
   {
     u8* ram_pointer = Bus::g_ram;
+    u32 write_address = address;
     for (u32 i = 0; i < word_count; i++)
     {
-      std::memcpy(&ram_pointer[address], &m_transfer_buffer[i], sizeof(u32));
-      address = (address + increment) & ADDRESS_MASK;
+      std::memcpy(&ram_pointer[write_address], &m_transfer_buffer[i], sizeof(u32));
+      write_address = (write_address + increment) & ADDRESS_MASK;
     }
   }
 
-  CPU::CodeCache::InvalidateCodePages(address, word_count);
+  InvalidateCodeForTransfer(address, increment, word_count);
   return Bus::GetDMARAMTickCount(word_count);
 }
 
+void DMA::InvalidateCodeForTransfer(u32 address, u32 increment, u32 word_count)
+{
+  // The written range is split where the transfer wraps around RAM, so that each part goes upwards from its lowest
+  // address. Decrementing transfers end at the lowest address, and wrap past the bottom of RAM rather than the top.
+  static constexpr u32 RAM_WORD_COUNT = (ADDRESS_MASK + sizeof(u32)) / sizeof(u32);
+  word_count = std::min(word_count, RAM_WORD_COUNT);
+
+  if (static_cast<s32>(increment) < 0)
+  {
+    const u32 words_from_bottom = (address / sizeof(u32)) + 1;
+    if (word_count > words_from_bottom)
+    {
+      const u32 wrapped_word_count = word_count - words_from_bottom;
+      CPU::CodeCache::InvalidateCodeLines(0, words_from_bottom);
+      CPU::CodeCache::InvalidateCodeLines((RAM_WORD_COUNT - wrapped_word_count) * sizeof(u32), wrapped_word_count);
+    }
+    else
+    {
+      CPU::CodeCache::InvalidateCodeLines(address - ((word_count - 1) * sizeof(u32)), word_count);
+    }
+  }
+  else
+  {
+    const u32 words_to_top = RAM_WORD_COUNT - (address / sizeof(u32));
+    if (word_count > words_to_top)
+    {
+      CPU::CodeCache::InvalidateCodeLines(address, words_to_top);
+      CPU::CodeCache::InvalidateCodeLines(0, word_count - words_to_top);
+    }
+    else
+    {
+      CPU::CodeCache::InvalidateCodeLines(address, word_count);
+    }
+  }
+}
+
 void DMA::DrawDebugStateWindow()
 {
 #ifdef WITH_IMGUI
@@ -76,6 +76,9 @@ private:
   // from memory -> device
   TickCount TransferMemoryToDevice(Channel channel, u32 address, u32 increment, u32 word_count);
 
+  // invalidates recompiled code in the RAM written by a transfer
+  static void InvalidateCodeForTransfer(u32 address, u32 increment, u32 word_count);
+
   // configuration
   TickCount m_max_slice_ticks = 1000;
   TickCount m_halt_ticks = 100;
@@ -10,6 +10,7 @@
 #include "stb_image_write.h"
 #include "system.h"
 #include "timers.h"
+#include "xxhash.h"
 #include <cmath>
 #ifdef WITH_IMGUI
 #include "imgui.h"
@@ -30,9 +31,13 @@ bool GPU::Initialize(HostDisplay* host_display)
   m_force_progressive_scan = g_settings.gpu_disable_interlacing;
   m_force_ntsc_timings = g_settings.gpu_force_ntsc_timings;
   m_crtc_tick_event = TimingEvents::CreateTimingEvent(
-    "GPU CRTC Tick", 1, 1, std::bind(&GPU::CRTCTickEvent, this, std::placeholders::_1), true);
+    "GPU CRTC Tick", 1, 1,
+    [](void* param, TickCount ticks, TickCount ticks_late) { static_cast<GPU*>(param)->CRTCTickEvent(ticks); }, this,
+    true);
   m_command_tick_event = TimingEvents::CreateTimingEvent(
-    "GPU Command Tick", 1, 1, std::bind(&GPU::CommandTickEvent, this, std::placeholders::_1), true);
+    "GPU Command Tick", 1, 1,
+    [](void* param, TickCount ticks, TickCount ticks_late) { static_cast<GPU*>(param)->CommandTickEvent(ticks); },
+    this, true);
   m_fifo_size = g_settings.gpu_fifo_size;
   m_max_run_ahead = g_settings.gpu_max_run_ahead;
   m_console_is_pal = System::IsPALRegion();
@@ -71,6 +76,16 @@ std::tuple<u32, u32> GPU::GetEffectiveDisplayResolution()
 
 void GPU::Reset()
 {
+  FlushVRAMRead();
+  m_save_state_vram_read_pending = false;
+
+  // dumps can't represent a reset, so end it here
+  if (m_dump_recorder)
+  {
+    Log_WarningPrintf("GPU reset, stopping dump");
+    StopDumping();
+  }
+
   SoftReset();
   m_set_texture_disable_mask = false;
   m_GPUREAD_latch = 0;
@@ -235,13 +250,24 @@ bool GPU::DoState(StateWrapper& sw, bool update_display)
   }
   else
   {
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+    if (m_save_state_vram_read_pending)
+      FlushVRAMRead();
+    else
+      ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+
+    m_save_state_vram_read_pending = false;
     sw.DoBytes(m_vram_ptr, VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16));
   }
 
   return !sw.HasError();
 }
 
+void GPU::BeginSaveStateVRAMRead()
+{
+  BeginVRAMRead(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+  m_save_state_vram_read_pending = true;
+}
+
 void GPU::ResetGraphicsAPIState() {}
 
 void GPU::RestoreGraphicsAPIState() {}
@@ -341,12 +367,18 @@ void GPU::WriteRegister(u32 offset, u32 value)
   switch (offset)
   {
     case 0x00:
+      if (m_dump_recorder)
+        m_dump_recorder->WriteGP0(value);
+
       m_fifo.Push(value);
       ExecuteCommands();
       UpdateCommandTickEvent();
       return;
 
     case 0x04:
+      if (m_dump_recorder)
+        m_dump_recorder->WriteGP1(value);
+
       WriteGP1(value);
       return;
 
@@ -371,6 +403,9 @@ void GPU::DMARead(u32* words, u32 word_count)
 
 void GPU::EndDMAWrite()
 {
+  if (m_dump_recorder)
+    m_dump_recorder->EndDMA();
+
   m_fifo_pushed = true;
   if (!m_syncing)
   {
@@ -812,6 +847,9 @@ void GPU::CRTCTickEvent(TickCount ticks)
           m_crtc_state.interlaced_display_field = m_crtc_state.interlaced_field ^ 1u;
         else
           m_crtc_state.interlaced_display_field = 0;
+
+        if (m_dump_recorder)
+          m_dump_recorder->VSync(ConvertToBoolUnchecked(m_crtc_state.interlaced_display_field));
       }
 
       g_timers.SetGate(HBLANK_TIMER_INDEX, new_vblank);
@@ -905,6 +943,11 @@ u32 GPU::ReadGPUREAD()
   if (m_blitter_state != BlitterState::ReadingVRAM)
     return m_GPUREAD_latch;
 
+  if (m_dump_recorder)
+    m_dump_recorder->ReadGPUREAD();
+
+  FlushVRAMRead();
+
   // Read two pixels out of VRAM and combine them. Zero fill odd pixel counts.
   u32 value = 0;
   for (u32 i = 0; i < 2; i++)
@@ -936,6 +979,101 @@ u32 GPU::ReadGPUREAD()
   return value;
 }
 
+bool GPU::StartDumping(const char* filename)
+{
+  if (m_dump_recorder)
+    m_dump_recorder.reset();
+
+  std::unique_ptr<GPUDump::Recorder> recorder = std::make_unique<GPUDump::Recorder>();
+  if (!recorder->Open(filename, this))
+  {
+    Log_ErrorPrintf("Failed to open '%s'", filename);
+    return false;
+  }
+
+  m_dump_recorder = std::move(recorder);
+  return true;
+}
+
+bool GPU::StopDumping()
+{
+  if (!m_dump_recorder)
+    return false;
+
+  Log_InfoPrintf("Wrote %u frames to GPU dump", m_dump_recorder->GetFrameCount());
+  m_dump_recorder.reset();
+  return true;
+}
+
+void GPU::ReplayExecuteCommands()
+{
+  // Zero the pending ticks so the run-ahead limit never holds commands back, and keep going until the FIFO is empty
+  // or the remaining words are waiting on more data.
+  for (;;)
+  {
+    const u32 fifo_size = m_fifo.GetSize();
+    m_pending_command_ticks = 0;
+    ExecuteCommands();
+    if (m_fifo.IsEmpty() || m_fifo.GetSize() == fifo_size)
+      break;
+  }
+
+  m_pending_command_ticks = 0;
+}
+
+void GPU::ReplayGP0Write(const u32* words, u32 word_count)
+{
+  while (word_count > 0)
+  {
+    const u32 words_to_push = std::min(word_count, m_fifo.GetSpace());
+    if (words_to_push == 0)
+    {
+      Log_WarningPrintf("GPU FIFO overflow during replay, dropping %u words", word_count);
+      break;
+    }
+
+    for (u32 i = 0; i < words_to_push; i++)
+      m_fifo.Push(ZeroExtend64(words[i]));
+
+    words += words_to_push;
+    word_count -= words_to_push;
+    ReplayExecuteCommands();
+  }
+}
+
+void GPU::ReplayGP1Write(u32 value)
+{
+  WriteGP1(value);
+  ReplayExecuteCommands();
+}
+
+void GPU::ReplayGPUREADRead(u32 read_count)
+{
+  for (u32 i = 0; i < read_count; i++)
+    ReadGPUREAD();
+
+  ReplayExecuteCommands();
+}
+
+void GPU::ReplayVSync(bool interlaced_display_field)
+{
+  FlushRender();
+  UpdateDisplay();
+
+  // the CRTC isn't running, so update the field which is drawn to from the dump
+  m_crtc_state.interlaced_display_field = BoolToUInt8(interlaced_display_field);
+  m_crtc_state.active_line_lsb =
+    m_GPUSTAT.InInterleaved480iMode() ?
+      Truncate8((m_crtc_state.regs.Y + BoolToUInt32(m_crtc_state.interlaced_display_field)) & u32(1)) :
+      0;
+}
+
+u64 GPU::GetVRAMHash()
+{
+  ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+  return XXH64(m_vram_ptr, VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16), 0);
+}
+
 void GPU::WriteGP1(u32 value)
 {
   const u32 command = (value >> 24) & 0x3Fu;
@@ -1177,6 +1315,13 @@ void GPU::UpdateDisplay() {}
 
 void GPU::ReadVRAM(u32 x, u32 y, u32 width, u32 height) {}
 
+void GPU::BeginVRAMRead(u32 x, u32 y, u32 width, u32 height)
+{
+  ReadVRAM(x, y, width, height);
+}
+
+void GPU::CompleteVRAMRead() {}
+
 void GPU::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 {
   const u16 color16 = RGBA8888ToRGBA5551(color);
@@ -1259,6 +1404,11 @@ void GPU::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
   }
 }
 
+bool GPU::IsVRAMWriteRedundant(u32 x, u32 y, u32 width, u32 height, const void* data)
+{
+  return false;
+}
+
 void GPU::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
 {
   // Break up oversized copies. This behavior has not been verified on console.
@@ -2,6 +2,7 @@
 #include "common/bitfield.h"
 #include "common/fifo_queue.h"
 #include "common/rectangle.h"
+#include "gpu_dump.h"
 #include "gpu_types.h"
 #include "timers.h"
 #include "types.h"
@@ -66,6 +67,9 @@ public:
   virtual void Reset();
   virtual bool DoState(StateWrapper& sw, bool update_display);
 
+  // Starts reading back VRAM for the next DoState() call, so the transfer overlaps with saving the other components.
+  void BeginSaveStateVRAMRead();
+
   // Graphics API state reset/restore - call when drawing the UI etc.
   virtual void ResetGraphicsAPIState();
   virtual void RestoreGraphicsAPIState();
@@ -86,6 +90,8 @@ public:
   ALWAYS_INLINE void DMAWrite(u32 address, u32 value)
   {
     m_fifo.Push((ZeroExtend64(address) << 32) | ZeroExtend64(value));
+    if (m_dump_recorder)
+      m_dump_recorder->WriteDMA(value);
   }
   void EndDMAWrite();
 
@@ -147,6 +153,24 @@ public:
   // Returns the video clock frequency.
   TickCount GetCRTCFrequency() const;
 
+  /// Returns true if currently dumping GPU commands.
+  ALWAYS_INLINE bool IsDumping() const { return static_cast<bool>(m_dump_recorder); }
+
+  /// Starts dumping GPU commands to file, beginning with the current GPU state.
+  bool StartDumping(const char* filename);
+
+  /// Stops dumping GPU commands to file, if started.
+  bool StopDumping();
+
+  /// Replays writes from a GPU dump. Commands are executed immediately, since dumps don't contain command timing.
+  void ReplayGP0Write(const u32* words, u32 word_count);
+  void ReplayGP1Write(u32 value);
+  void ReplayGPUREADRead(u32 read_count);
+  void ReplayVSync(bool interlaced_display_field);
+
+  /// Returns a hash of the contents of VRAM, used to check dump replays for regressions.
+  u64 GetVRAMHash();
+
 protected:
   TickCount CRTCTicksToSystemTicks(TickCount crtc_ticks, TickCount fractional_ticks) const;
   TickCount SystemTicksToCRTCTicks(TickCount sysclk_ticks, TickCount* fractional_ticks) const;
@@ -268,12 +292,16 @@ protected:
   void WriteGP1(u32 value);
   void EndCommand();
   void ExecuteCommands();
+  void ReplayExecuteCommands();
   void HandleGetGPUInfoCommand(u32 value);
 
   // Rendering in the backend
   virtual void ReadVRAM(u32 x, u32 y, u32 width, u32 height);
+  virtual void BeginVRAMRead(u32 x, u32 y, u32 width, u32 height);
+  virtual void CompleteVRAMRead();
   virtual void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color);
   virtual void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data);
+  virtual bool IsVRAMWriteRedundant(u32 x, u32 y, u32 width, u32 height, const void* data);
   virtual void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height);
   virtual void DispatchRenderCommand();
   virtual void FlushRender();
@@ -281,6 +309,16 @@ protected:
   virtual void UpdateDisplay();
   virtual void DrawRendererStats(bool is_idle_frame);
 
+  /// Waits for the readback started by BeginVRAMRead(), if any. Must be called before the VRAM shadow is accessed.
+  ALWAYS_INLINE void FlushVRAMRead()
+  {
+    if (!m_vram_read_pending)
+      return;
+
+    m_vram_read_pending = false;
+    CompleteVRAMRead();
+  }
+
   ALWAYS_INLINE void AddDrawTriangleTicks(s32 x1, s32 y1, s32 x2, s32 y2, s32 x3, s32 y3, bool shaded, bool textured,
                                           bool semitransparent)
   {
@@ -518,6 +556,12 @@ protected:
   /// GPUREAD value for non-VRAM-reads.
   u32 m_GPUREAD_latch = 0;
 
+  /// True if a VRAM readback has been started, but not yet copied to the VRAM shadow.
+  bool m_vram_read_pending = false;
+
+  /// True if all of VRAM is being read back for a save state, and no commands have been executed since.
+  bool m_save_state_vram_read_pending = false;
+
   /// True if currently executing/syncing.
   bool m_syncing = false;
   bool m_fifo_pushed = false;
@@ -556,6 +600,8 @@ protected:
   Stats m_stats = {};
   Stats m_last_stats = {};
 
+  std::unique_ptr<GPUDump::Recorder> m_dump_recorder;
+
 private:
   using GP0CommandHandler = bool (GPU::*)();
   using GP0CommandHandlerTable = std::array<GP0CommandHandler, 256>;
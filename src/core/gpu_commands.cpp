@@ -24,6 +24,7 @@ static constexpr u32 ReplaceZero(u32 value, u32 value_for_zero)
 void GPU::ExecuteCommands()
 {
   m_syncing = true;
+  m_save_state_vram_read_pending = false;
 
   for (;;)
   {
@@ -507,15 +508,21 @@ void GPU::FinishVRAMWrite()
   if (IsInterlacedRenderingEnabled() && IsCRTCScanlinePending())
     SynchronizeCRTC();
 
-  FlushRender();
-
   if (m_blit_remaining_words == 0)
   {
-    UpdateVRAM(m_vram_transfer.x, m_vram_transfer.y, m_vram_transfer.width, m_vram_transfer.height,
-               m_blit_buffer.data());
+    // Re-uploads of unchanged data (e.g. static FMV frames) don't need the batch flushed.
+    if (!IsVRAMWriteRedundant(m_vram_transfer.x, m_vram_transfer.y, m_vram_transfer.width, m_vram_transfer.height,
+                              m_blit_buffer.data()))
+    {
+      FlushRender();
+      UpdateVRAM(m_vram_transfer.x, m_vram_transfer.y, m_vram_transfer.width, m_vram_transfer.height,
+                 m_blit_buffer.data());
+    }
   }
   else
   {
+    FlushRender();
+
     const u32 num_pixels = ZeroExtend32(m_vram_transfer.width) * ZeroExtend32(m_vram_transfer.height);
     const u32 num_words = (num_pixels + 1) / 2;
     const u32 transferred_words = num_words - m_blit_remaining_words;
@@ -562,11 +569,12 @@ bool GPU::HandleCopyRectangleVRAMToCPUCommand()
   // all rendering should be done first...
   FlushRender();
 
-  // ensure VRAM shadow is up to date
-  ReadVRAM(m_vram_transfer.x, m_vram_transfer.y, m_vram_transfer.width, m_vram_transfer.height);
+  // start updating the VRAM shadow, it's waited on when the data is first read
+  BeginVRAMRead(m_vram_transfer.x, m_vram_transfer.y, m_vram_transfer.width, m_vram_transfer.height);
 
   if (g_settings.debugging.dump_vram_to_cpu_copies)
   {
+    FlushVRAMRead();
     DumpVRAMToFile(StringUtil::StdStringFromFormat("vram_to_cpu_copy_%u.png", s_vram_to_cpu_dump_id++).c_str(),
                    m_vram_transfer.width, m_vram_transfer.height, sizeof(u16) * VRAM_WIDTH,
                    &m_vram_ptr[m_vram_transfer.y * VRAM_WIDTH + m_vram_transfer.x], true);
@@ -0,0 +1,356 @@
+#include "gpu_dump.h"
+#include "common/byte_stream.h"
+#include "common/log.h"
+#include "common/state_wrapper.h"
+#include "gpu.h"
+#include "save_state_version.h"
+#include <cstring>
+Log_SetChannel(GPUDump);
+
+namespace GPUDump {
+
+static constexpr char MAGIC[8] = {'D', 'S', 'G', 'P', 'U', 'D', 'M', 'P'};
+
+Recorder::Recorder() = default;
+
+Recorder::~Recorder()
+{
+  Close();
+}
+
+bool Recorder::Open(const char* filename, GPU* gpu)
+{
+  std::unique_ptr<GrowableMemoryByteStream> state_stream = ByteStream_CreateGrowableMemoryStream();
+  StateWrapper sw(state_stream.get(), StateWrapper::Mode::Write, SAVE_STATE_VERSION);
+  if (!gpu->DoState(sw, false))
+  {
+    Log_ErrorPrintf("Failed to save GPU state");
+    return false;
+  }
+
+  m_stream = ByteStream_OpenFileStream(filename, BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE |
+                                                   BYTESTREAM_OPEN_TRUNCATE | BYTESTREAM_OPEN_CREATE_PATH |
+                                                   BYTESTREAM_OPEN_STREAMED);
+  if (!m_stream)
+    return false;
+
+  Header header = {};
+  std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+  header.format_version = Header::FORMAT_VERSION;
+  header.state_version = SAVE_STATE_VERSION;
+  header.state_size = static_cast<u32>(state_stream->GetSize());
+  if (!m_stream->Write2(&header, sizeof(header)) ||
+      !m_stream->Write2(state_stream->GetMemoryPointer(), header.state_size))
+  {
+    Log_ErrorPrintf("Failed to write GPU dump header");
+    m_stream.reset();
+    return false;
+  }
+
+  m_buffer.reserve(1024 * 1024);
+  return true;
+}
+
+void Recorder::Close()
+{
+  if (!m_stream)
+    return;
+
+  // write out any packets for the partial frame
+  Flush();
+  if (m_stream)
+    m_stream->Commit();
+
+  m_stream.reset();
+}
+
+void Recorder::BeginPacket(PacketType type)
+{
+  m_packet_type = type;
+  WriteU8(static_cast<u8>(type));
+}
+
+void Recorder::BeginCountedPacket(PacketType type)
+{
+  BeginPacket(type);
+  m_packet_count_offset = m_buffer.size();
+  WriteU32(0);
+}
+
+void Recorder::WriteU8(u8 value)
+{
+  m_buffer.push_back(value);
+}
+
+void Recorder::WriteU32(u32 value)
+{
+  const size_t offset = m_buffer.size();
+  m_buffer.resize(offset + sizeof(value));
+  std::memcpy(&m_buffer[offset], &value, sizeof(value));
+}
+
+void Recorder::IncrementPacketCount()
+{
+  u32 count;
+  std::memcpy(&count, &m_buffer[m_packet_count_offset], sizeof(count));
+  count++;
+  std::memcpy(&m_buffer[m_packet_count_offset], &count, sizeof(count));
+}
+
+void Recorder::WriteGP0(u32 value)
+{
+  if (m_packet_type != PacketType::GP0Write)
+    BeginCountedPacket(PacketType::GP0Write);
+
+  IncrementPacketCount();
+  WriteU32(value);
+}
+
+void Recorder::WriteGP1(u32 value)
+{
+  BeginPacket(PacketType::GP1Write);
+  WriteU32(value);
+}
+
+void Recorder::WriteDMA(u32 value)
+{
+  // DMA blocks can be started from inside EndDMAWrite(), so each block is kept as a separate packet.
+  if (!m_dma_block_open)
+  {
+    BeginCountedPacket(PacketType::DMAWrite);
+    m_dma_block_open = true;
+  }
+
+  IncrementPacketCount();
+  WriteU32(value);
+}
+
+void Recorder::EndDMA()
+{
+  m_dma_block_open = false;
+}
+
+void Recorder::ReadGPUREAD()
+{
+  if (m_packet_type != PacketType::GPUREADRead)
+    BeginCountedPacket(PacketType::GPUREADRead);
+
+  IncrementPacketCount();
+}
+
+void Recorder::VSync(bool interlaced_display_field)
+{
+  BeginPacket(PacketType::VSync);
+  WriteU8(BoolToUInt8(interlaced_display_field));
+  m_frame_count++;
+  Flush();
+}
+
+bool Recorder::Flush()
+{
+  if (m_buffer.empty() || !m_stream)
+  {
+    m_buffer.clear();
+    return static_cast<bool>(m_stream);
+  }
+
+  if (!m_stream->Write2(m_buffer.data(), static_cast<u32>(m_buffer.size())))
+  {
+    Log_ErrorPrintf("Failed to write %zu bytes to GPU dump, further packets will be discarded", m_buffer.size());
+    m_buffer.clear();
+    m_stream.reset();
+    return false;
+  }
+
+  m_buffer.clear();
+  return true;
+}
+
+Player::Player() = default;
+
+Player::~Player() = default;
+
+bool Player::Open(const char* filename, GPU* gpu)
+{
+  m_stream = ByteStream_OpenFileStream(filename, BYTESTREAM_OPEN_READ | BYTESTREAM_OPEN_SEEKABLE);
+  if (!m_stream)
+  {
+    Log_ErrorPrintf("Failed to open '%s'", filename);
+    return false;
+  }
+
+  Header header;
+  if (!m_stream->Read2(&header, sizeof(header)) || std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0)
+  {
+    Log_ErrorPrintf("'%s' is not a GPU dump", filename);
+    Close();
+    return false;
+  }
+
+  if (header.format_version != Header::FORMAT_VERSION || header.state_version < SAVE_STATE_MINIMUM_VERSION ||
+      header.state_version > SAVE_STATE_VERSION)
+  {
+    Log_ErrorPrintf("Unsupported GPU dump version %u (state version %u)", header.format_version,
+                    header.state_version);
+    Close();
+    return false;
+  }
+
+  m_state_version = header.state_version;
+  m_state_size = header.state_size;
+  m_packets_offset = sizeof(header) + static_cast<u64>(header.state_size);
+  if (!LoadState(gpu))
+  {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+void Player::Close()
+{
+  m_stream.reset();
+  m_frame_data.clear();
+  m_frame_count = 0;
+}
+
+bool Player::Rewind(GPU* gpu)
+{
+  if (!m_stream)
+    return false;
+
+  m_frame_data.clear();
+  m_frame_count = 0;
+  return LoadState(gpu);
+}
+
+bool Player::LoadState(GPU* gpu)
+{
+  // reading to the end of the dump leaves the stream in the error state
+  m_stream->ClearErrorState();
+
+  std::vector<u8> state_data(m_state_size);
+  if (!m_stream->SeekAbsolute(sizeof(Header)) || !m_stream->Read2(state_data.data(), m_state_size))
+  {
+    Log_ErrorPrintf("Failed to read GPU state from dump");
+    return false;
+  }
+
+  std::unique_ptr<ReadOnlyMemoryByteStream> state_stream =
+    ByteStream_CreateReadOnlyMemoryStream(state_data.data(), m_state_size);
+  StateWrapper sw(state_stream.get(), StateWrapper::Mode::Read, m_state_version);
+  if (!gpu->DoState(sw, true))
+  {
+    Log_ErrorPrintf("Failed to load GPU state from dump");
+    return false;
+  }
+
+  return m_stream->SeekAbsolute(m_packets_offset);
+}
+
+bool Player::ReadFrame()
+{
+  m_frame_data.clear();
+  if (!m_stream)
+    return false;
+
+  // packets are expanded to words so the GP0 data can be passed straight to the GPU
+  for (;;)
+  {
+    u8 type;
+    if (m_stream->GetPosition() >= m_stream->GetSize() || !m_stream->Read2(&type, sizeof(type)))
+      break;
+
+    m_frame_data.push_back(type);
+    switch (static_cast<PacketType>(type))
+    {
+      case PacketType::GP0Write:
+      case PacketType::DMAWrite:
+      {
+        u32 word_count;
+        if (!m_stream->Read2(&word_count, sizeof(word_count)))
+          return false;
+
+        const size_t offset = m_frame_data.size();
+        m_frame_data.resize(offset + 1 + word_count);
+        m_frame_data[offset] = word_count;
+        if (!m_stream->Read2(&m_frame_data[offset + 1], word_count * sizeof(u32)))
+          return false;
+      }
+      break;
+
+      case PacketType::GP1Write:
+      case PacketType::GPUREADRead:
+      {
+        u32 value;
+        if (!m_stream->Read2(&value, sizeof(value)))
+          return false;
+
+        m_frame_data.push_back(value);
+      }
+      break;
+
+      case PacketType::VSync:
+      {
+        u8 interlaced_display_field;
+        if (!m_stream->Read2(&interlaced_display_field, sizeof(interlaced_display_field)))
+          return false;
+
+        m_frame_data.push_back(interlaced_display_field);
+        m_frame_count++;
+        return true;
+      }
+
+      default:
+        Log_ErrorPrintf("Unknown packet type %u in GPU dump", ZeroExtend32(type));
+        m_frame_data.clear();
+        return false;
+    }
+  }
+
+  // the last frame may not end in a vsync if dumping stopped mid-frame
+  if (m_frame_data.empty())
+    return false;
+
+  m_frame_count++;
+  return true;
+}
+
+void Player::ReplayFrame(GPU* gpu)
+{
+  const u32* ptr = m_frame_data.data();
+  const u32* end = ptr + m_frame_data.size();
+  while (ptr < end)
+  {
+    const PacketType type = static_cast<PacketType>(*(ptr++));
+    switch (type)
+    {
+      case PacketType::GP0Write:
+      case PacketType::DMAWrite:
+      {
+        const u32 word_count = *(ptr++);
+        gpu->ReplayGP0Write(ptr, word_count);
+        ptr += word_count;
+      }
+      break;
+
+      case PacketType::GP1Write:
+        gpu->ReplayGP1Write(*(ptr++));
+        break;
+
+      case PacketType::GPUREADRead:
+        gpu->ReplayGPUREADRead(*(ptr++));
+        break;
+
+      case PacketType::VSync:
+        gpu->ReplayVSync(*(ptr++) != 0);
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+} // namespace GPUDump
@@ -0,0 +1,112 @@
+#pragma once
+#include "types.h"
+#include <memory>
+#include <vector>
+
+class ByteStream;
+
+class GPU;
+
+namespace GPUDump {
+
+// A dump starts with a header and a GPU save state, which includes VRAM and all registers. It is followed by the
+// packets written to the GPU. Each frame ends with a VSync packet, so the player can replay one frame at a time.
+#pragma pack(push, 1)
+struct Header
+{
+  enum : u32
+  {
+    FORMAT_VERSION = 1
+  };
+
+  char magic[8];
+  u32 format_version;
+  u32 state_version;
+  u32 state_size;
+};
+#pragma pack(pop)
+
+enum class PacketType : u8
+{
+  GP0Write,    // u32 word_count, word_count * u32 words
+  GP1Write,    // u32 value
+  DMAWrite,    // u32 word_count, word_count * u32 words
+  GPUREADRead, // u32 read_count
+  VSync,       // u8 interlaced_display_field
+  Count
+};
+
+class Recorder
+{
+public:
+  Recorder();
+  ~Recorder();
+
+  ALWAYS_INLINE u32 GetFrameCount() const { return m_frame_count; }
+
+  /// Creates the dump file, and writes the current state of the GPU to it.
+  bool Open(const char* filename, GPU* gpu);
+  void Close();
+
+  void WriteGP0(u32 value);
+  void WriteGP1(u32 value);
+  void WriteDMA(u32 value);
+  void EndDMA();
+  void ReadGPUREAD();
+
+  /// Ends the current frame, and writes the buffered packets to the file.
+  void VSync(bool interlaced_display_field);
+
+private:
+  void BeginPacket(PacketType type);
+  void BeginCountedPacket(PacketType type);
+  void WriteU8(u8 value);
+  void WriteU32(u32 value);
+  void IncrementPacketCount();
+  bool Flush();
+
+  std::unique_ptr<ByteStream> m_stream;
+
+  // Packets are buffered for a frame, consecutive words or reads are merged into a single packet.
+  std::vector<u8> m_buffer;
+  size_t m_packet_count_offset = 0;
+  PacketType m_packet_type = PacketType::Count;
+  bool m_dma_block_open = false;
+
+  u32 m_frame_count = 0;
+};
+
+class Player
+{
+public:
+  Player();
+  ~Player();
+
+  ALWAYS_INLINE u32 GetFrameCount() const { return m_frame_count; }
+
+  /// Opens a dump, and reads the initial state into the specified GPU.
+  bool Open(const char* filename, GPU* gpu);
+  void Close();
+
+  /// Returns to the start of the dump, and restores the initial state.
+  bool Rewind(GPU* gpu);
+
+  /// Reads the packets for the next frame into memory. Returns false at the end of the dump.
+  bool ReadFrame();
+
+  /// Replays the packets read by ReadFrame() through the specified GPU.
+  void ReplayFrame(GPU* gpu);
+
+private:
+  bool LoadState(GPU* gpu);
+
+  std::unique_ptr<ByteStream> m_stream;
+  u64 m_packets_offset = 0;
+  u32 m_state_version = 0;
+  u32 m_state_size = 0;
+
+  std::vector<u32> m_frame_data;
+  u32 m_frame_count = 0;
+};
+
+} // namespace GPUDump
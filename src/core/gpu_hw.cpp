@@ -1,4 +1,5 @@
 #include "gpu_hw.h"
+#include "common/align.h"
 #include "common/assert.h"
 #include "common/log.h"
 #include "common/state_wrapper.h"
@@ -6,6 +7,7 @@
 #include "pgxp.h"
 #include "settings.h"
 #include "system.h"
+#include "xxhash.h"
 #include <cmath>
 #include <sstream>
 #include <tuple>
@@ -34,7 +36,11 @@ GPU_HW::GPU_HW() : GPU()
   m_vram_ptr = m_vram_shadow.data();
 }
 
-GPU_HW::~GPU_HW() = default;
+GPU_HW::~GPU_HW()
+{
+  // backends have to stop the thread before their resources are destroyed
+  DebugAssert(!m_render_thread.joinable());
+}
 
 bool GPU_HW::IsHardwareRenderer() const
 {
@@ -93,6 +99,7 @@ void GPU_HW::Reset()
   m_current_depth = 1;
 
   SetFullVRAMDirtyRectangle();
+  ClearVRAMWriteRecords();
 }
 
 bool GPU_HW::DoState(StateWrapper& sw, bool update_display)
@@ -105,6 +112,7 @@ bool GPU_HW::DoState(StateWrapper& sw, bool update_display)
   {
     m_batch_current_vertex_ptr = m_batch_start_vertex_ptr;
     SetFullVRAMDirtyRectangle();
+    ClearVRAMWriteRecords();
     ResetBatchVertexDepth();
   }
 
@@ -204,10 +212,147 @@ void GPU_HW::PrintSettingsToLog()
   Log_InfoPrintf("Using UV limits: %s", m_using_uv_limits ? "YES" : "NO");
 }
 
+void GPU_HW::IncludeVRAMTiles(VRAMTileMask& mask, const Common::Rectangle<u32>& rect)
+{
+  const u32 left = std::min<u32>(rect.left, VRAM_WIDTH);
+  const u32 right = std::min<u32>(rect.right, VRAM_WIDTH);
+  const u32 top = std::min<u32>(rect.top, VRAM_HEIGHT);
+  const u32 bottom = std::min<u32>(rect.bottom, VRAM_HEIGHT);
+  if (left >= right || top >= bottom)
+    return;
+
+  const u32 first_tile_x = left / VRAM_TILE_SIZE;
+  const u32 last_tile_x = (right - 1) / VRAM_TILE_SIZE;
+  const u16 row_bits = static_cast<u16>(((2u << last_tile_x) - 1u) & ~((1u << first_tile_x) - 1u));
+  for (u32 tile_y = top / VRAM_TILE_SIZE; tile_y <= (bottom - 1) / VRAM_TILE_SIZE; tile_y++)
+    mask[tile_y] |= row_bits;
+}
+
+bool GPU_HW::AreVRAMTilesDirty(const VRAMTileMask& mask) const
+{
+  for (u32 tile_y = 0; tile_y < VRAM_TILE_ROWS; tile_y++)
+  {
+    if (m_vram_dirty_tiles[tile_y] & mask[tile_y])
+      return true;
+  }
+
+  return false;
+}
+
+void GPU_HW::UpdateVRAMReadTexture(const Common::Rectangle<u32>& area)
+{
+  VRAMTileMask mask = {};
+  IncludeVRAMTiles(mask, area);
+  UpdateVRAMReadTexture(mask);
+}
+
 void GPU_HW::UpdateVRAMReadTexture()
 {
+  VRAMTileMask mask;
+  mask.fill(ALL_VRAM_TILES_IN_ROW);
+  UpdateVRAMReadTexture(mask);
+}
+
+void GPU_HW::UpdateVRAMReadTexture(const VRAMTileMask& mask)
+{
+  // Runs of dirty tiles in each row become a rectangle, which is extended downwards while the rows below have the same
+  // run. This keeps the number of copies low for the common case of a single dirty area.
+  std::array<Common::Rectangle<u32>, MAX_VRAM_READ_TEXTURE_COPIES> rects;
+  u32 num_rects = 0;
+
+  for (u32 tile_y = 0; tile_y < VRAM_TILE_ROWS; tile_y++)
+  {
+    const u16 row = m_vram_dirty_tiles[tile_y] & mask[tile_y];
+    m_vram_dirty_tiles[tile_y] &= ~row;
+
+    u32 tile_x = 0;
+    while (tile_x < (VRAM_WIDTH / VRAM_TILE_SIZE))
+    {
+      if (!(row & (1u << tile_x)))
+      {
+        tile_x++;
+        continue;
+      }
+
+      const u32 run_start = tile_x;
+      while (tile_x < (VRAM_WIDTH / VRAM_TILE_SIZE) && (row & (1u << tile_x)))
+        tile_x++;
+
+      const u32 left = std::max(run_start * VRAM_TILE_SIZE, m_vram_dirty_rect.left);
+      const u32 right = std::min(tile_x * VRAM_TILE_SIZE, m_vram_dirty_rect.right);
+      const u32 top = std::max(tile_y * VRAM_TILE_SIZE, m_vram_dirty_rect.top);
+      const u32 bottom = std::min((tile_y + 1) * VRAM_TILE_SIZE, m_vram_dirty_rect.bottom);
+      if (left >= right || top >= bottom)
+        continue;
+
+      // same horizontal span as a rectangle ending on the row above?
+      u32 i = 0;
+      for (; i < num_rects; i++)
+      {
+        if (rects[i].left == left && rects[i].right == right && rects[i].bottom == top)
+          break;
+      }
+      if (i < num_rects)
+        rects[i].bottom = bottom;
+      else
+        rects[num_rects++].Set(left, top, right, bottom);
+    }
+  }
+
+  if (num_rects == 0)
+    return;
+
+  u32 copy_area = 0;
+  for (u32 i = 0; i < num_rects; i++)
+    copy_area += rects[i].GetWidth() * rects[i].GetHeight();
+
   m_renderer_stats.num_vram_read_texture_updates++;
-  ClearVRAMDirtyRectangle();
+  m_renderer_stats.vram_read_texture_copy_area += copy_area;
+  m_renderer_stats.vram_read_texture_bounds_area += m_vram_dirty_rect.GetWidth() * m_vram_dirty_rect.GetHeight();
+
+  if (IsRenderThreadActive())
+  {
+    FlushRender();
+
+    CopyToVRAMReadTextureRenderCommand* cmd = static_cast<CopyToVRAMReadTextureRenderCommand*>(
+      AllocateRenderCommand(RenderCommandType::CopyToVRAMReadTexture,
+                            sizeof(CopyToVRAMReadTextureRenderCommand) + (num_rects * sizeof(Common::Rectangle<u32>))));
+    cmd->num_rects = num_rects;
+    std::copy_n(rects.begin(), num_rects, cmd->rects);
+    PushRenderCommand(cmd);
+  }
+  else
+  {
+    CopyToVRAMReadTexture(rects.data(), num_rects);
+  }
+
+  // shrink the bounding box to what's left, so later copies don't pick up the parts which were just copied
+  Common::Rectangle<u32> remaining;
+  for (u32 tile_y = 0; tile_y < VRAM_TILE_ROWS; tile_y++)
+  {
+    const u16 row = m_vram_dirty_tiles[tile_y];
+    if (row == 0)
+      continue;
+
+    u32 first_tile_x = 0;
+    while (!(row & (1u << first_tile_x)))
+      first_tile_x++;
+    u32 last_tile_x = (VRAM_WIDTH / VRAM_TILE_SIZE) - 1;
+    while (!(row & (1u << last_tile_x)))
+      last_tile_x--;
+
+    remaining.Include(first_tile_x * VRAM_TILE_SIZE, (last_tile_x + 1) * VRAM_TILE_SIZE, tile_y * VRAM_TILE_SIZE,
+                      (tile_y + 1) * VRAM_TILE_SIZE);
+  }
+
+  if (remaining.Valid())
+  {
+    m_vram_dirty_rect.Clamp(remaining.left, remaining.top, remaining.right, remaining.bottom);
+  }
+  else
+  {
+    m_vram_dirty_rect.SetInvalid();
+  }
 }
 
 void GPU_HW::HandleFlippedQuadTextureCoordinates(BatchVertex* vertices)
@@ -490,7 +635,7 @@ void GPU_HW::LoadVertices()
         const u32 clip_bottom =
           static_cast<u32>(std::clamp<s32>(max_y, m_drawing_area.top, m_drawing_area.bottom)) + 1u;
 
-        m_vram_dirty_rect.Include(clip_left, clip_right, clip_top, clip_bottom);
+        IncludeDrawnVRAMRectangle(clip_left, clip_right, clip_top, clip_bottom);
         AddDrawTriangleTicks(native_vertex_positions[0][0], native_vertex_positions[0][1],
                              native_vertex_positions[1][0], native_vertex_positions[1][1],
                              native_vertex_positions[2][0], native_vertex_positions[2][1], rc.shading_enable,
@@ -524,7 +669,7 @@ void GPU_HW::LoadVertices()
           const u32 clip_bottom =
             static_cast<u32>(std::clamp<s32>(max_y_123, m_drawing_area.top, m_drawing_area.bottom)) + 1u;
 
-          m_vram_dirty_rect.Include(clip_left, clip_right, clip_top, clip_bottom);
+          IncludeDrawnVRAMRectangle(clip_left, clip_right, clip_top, clip_bottom);
           AddDrawTriangleTicks(native_vertex_positions[2][0], native_vertex_positions[2][1],
                                native_vertex_positions[1][0], native_vertex_positions[1][1],
                                native_vertex_positions[3][0], native_vertex_positions[3][1], rc.shading_enable,
@@ -627,7 +772,7 @@ void GPU_HW::LoadVertices()
       const u32 clip_bottom =
         static_cast<u32>(std::clamp<s32>(pos_y + rectangle_height, m_drawing_area.top, m_drawing_area.bottom)) + 1u;
 
-      m_vram_dirty_rect.Include(clip_left, clip_right, clip_top, clip_bottom);
+      IncludeDrawnVRAMRectangle(clip_left, clip_right, clip_top, clip_bottom);
       AddDrawRectangleTicks(clip_right - clip_left, clip_bottom - clip_top, rc.texture_enable, rc.transparency_enable);
     }
     break;
@@ -675,7 +820,7 @@ void GPU_HW::LoadVertices()
         const u32 clip_bottom =
           static_cast<u32>(std::clamp<s32>(max_y, m_drawing_area.top, m_drawing_area.bottom)) + 1u;
 
-        m_vram_dirty_rect.Include(clip_left, clip_right, clip_top, clip_bottom);
+        IncludeDrawnVRAMRectangle(clip_left, clip_right, clip_top, clip_bottom);
         AddDrawLineTicks(clip_right - clip_left, clip_bottom - clip_top, rc.shading_enable);
 
         // TODO: Should we do a PGXP lookup here? Most lines are 2D.
@@ -721,7 +866,7 @@ void GPU_HW::LoadVertices()
             const u32 clip_bottom =
               static_cast<u32>(std::clamp<s32>(max_y, m_drawing_area.top, m_drawing_area.bottom)) + 1u;
 
-            m_vram_dirty_rect.Include(clip_left, clip_right, clip_top, clip_bottom);
+            IncludeDrawnVRAMRectangle(clip_left, clip_right, clip_top, clip_bottom);
             AddDrawLineTicks(clip_right - clip_left, clip_bottom - clip_top, rc.shading_enable);
 
             // TODO: Should we do a PGXP lookup here? Most lines are 2D.
@@ -745,10 +890,10 @@ void GPU_HW::LoadVertices()
 
 void GPU_HW::CalcScissorRect(int* left, int* top, int* right, int* bottom)
 {
-  *left = m_drawing_area.left * m_resolution_scale;
-  *right = std::max<u32>((m_drawing_area.right + 1) * m_resolution_scale, *left + 1);
-  *top = m_drawing_area.top * m_resolution_scale;
-  *bottom = std::max<u32>((m_drawing_area.bottom + 1) * m_resolution_scale, *top + 1);
+  *left = m_scissor_drawing_area.left * m_resolution_scale;
+  *right = std::max<u32>((m_scissor_drawing_area.right + 1) * m_resolution_scale, *left + 1);
+  *top = m_scissor_drawing_area.top * m_resolution_scale;
+  *bottom = std::max<u32>((m_scissor_drawing_area.bottom + 1) * m_resolution_scale, *top + 1);
 }
 
 GPU_HW::VRAMFillUBOData GPU_HW::GetVRAMFillUBOData(u32 x, u32 y, u32 width, u32 height, u32 color) const
@@ -821,9 +966,12 @@ GPU_HW::VRAMCopyUBOData GPU_HW::GetVRAMCopyUBOData(u32 src_x, u32 src_y, u32 dst
   return uniforms;
 }
 
-void GPU_HW::IncludeVRAMDityRectangle(const Common::Rectangle<u32>& rect)
+void GPU_HW::IncludeVRAMDityRectangle(const Common::Rectangle<u32>& rect, bool invalidate_write_records)
 {
   m_vram_dirty_rect.Include(rect);
+  IncludeVRAMTiles(m_vram_dirty_tiles, rect);
+  if (invalidate_write_records && m_num_vram_write_records > 0)
+    InvalidateVRAMWriteRecords(rect);
 
   // the vram area can include the texture page, but the game can leave it as-is. in this case, set it as dirty so the
   // shadow texture is updated
@@ -845,7 +993,7 @@ void GPU_HW::EnsureVertexBufferSpace(u32 required_vertices)
     FlushRender();
   }
 
-  MapBatchVertexPointer(required_vertices);
+  MapBatchVertices(required_vertices);
 }
 
 void GPU_HW::EnsureVertexBufferSpaceForCurrentCommand()
@@ -879,18 +1027,49 @@ void GPU_HW::EnsureVertexBufferSpaceForCurrentCommand()
     FlushRender();
   }
 
-  MapBatchVertexPointer(required_vertices);
+  MapBatchVertices(required_vertices);
+}
+
+void GPU_HW::MapBatchVertices(u32 required_vertices)
+{
+  if (!IsRenderThreadActive())
+  {
+    MapBatchVertexPointer(required_vertices);
+    return;
+  }
+
+  // The vertices are written straight into the command, which is trimmed to the used vertices when it's pushed.
+  DebugAssert(!m_queued_batch && required_vertices <= MAX_BATCH_VERTEX_COUNT);
+  m_queued_batch = static_cast<DrawBatchRenderCommand*>(AllocateRenderCommand(
+    RenderCommandType::DrawBatch, sizeof(DrawBatchRenderCommand) + (MAX_BATCH_VERTEX_COUNT * sizeof(BatchVertex))));
+  m_batch_start_vertex_ptr = m_queued_batch->vertices;
+  m_batch_current_vertex_ptr = m_batch_start_vertex_ptr;
+  m_batch_end_vertex_ptr = m_batch_start_vertex_ptr + MAX_BATCH_VERTEX_COUNT;
 }
 
 void GPU_HW::ResetBatchVertexDepth()
 {
   Log_PerfPrint("Resetting batch vertex depth");
   FlushRender();
-  UpdateDepthBufferFromMaskBit();
+
+  if (IsRenderThreadActive())
+  {
+    PushRenderCommand(AllocateRenderCommand(RenderCommandType::UpdateDepthBufferFromMaskBit, sizeof(RenderCommand)));
+  }
+  else
+  {
+    UpdateDepthBufferFromMaskBit();
+  }
 
   m_current_depth = 1;
 }
 
+void GPU_HW::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
+{
+  BeginVRAMRead(x, y, width, height);
+  FlushVRAMRead();
+}
+
 void GPU_HW::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 {
   IncludeVRAMDityRectangle(
@@ -902,6 +1081,19 @@ void GPU_HW::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
   DebugAssert((x + width) <= VRAM_WIDTH && (y + height) <= VRAM_HEIGHT);
   IncludeVRAMDityRectangle(Common::Rectangle<u32>::FromExtents(x, y, width, height));
 
+  // overlapping records were invalidated above, so the new data can be remembered now
+  if (m_pending_vram_write_record.bounds.Valid())
+  {
+    if (m_num_vram_write_records == MAX_VRAM_WRITE_RECORDS)
+    {
+      std::move(m_vram_write_records.begin() + 1, m_vram_write_records.end(), m_vram_write_records.begin());
+      m_num_vram_write_records--;
+    }
+
+    m_vram_write_records[m_num_vram_write_records++] = m_pending_vram_write_record;
+    m_pending_vram_write_record = {};
+  }
+
   if (m_GPUSTAT.check_mask_before_draw)
   {
     // set new vertex counter since we want this to take into consideration previous masked pixels
@@ -909,6 +1101,56 @@ void GPU_HW::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
   }
 }
 
+bool GPU_HW::IsVRAMWriteRedundant(u32 x, u32 y, u32 width, u32 height, const void* data)
+{
+  // Writing the same data again leaves VRAM unchanged as long as nothing else has touched the area, and the mask
+  // settings are the same. Masked pixels are preserved both times, and the rest end up with the same values.
+  const u32 size = width * height * sizeof(u16);
+  const u64 hash = XXH64(data, size, 0);
+  for (u32 i = 0; i < m_num_vram_write_records; i++)
+  {
+    const VRAMWriteRecord& rec = m_vram_write_records[i];
+    if (rec.hash == hash && rec.x == x && rec.y == y && rec.width == width && rec.height == height &&
+        rec.check_mask_before_draw == m_GPUSTAT.check_mask_before_draw &&
+        rec.set_mask_while_drawing == m_GPUSTAT.set_mask_while_drawing)
+    {
+      // The read texture is still refreshed as if the write had happened, since games can rely on re-uploading a
+      // texture page to pick up what has been drawn to it.
+      IncludeVRAMDityRectangle(rec.bounds, false);
+      m_renderer_stats.num_vram_writes_skipped++;
+      m_renderer_stats.num_vram_write_bytes_skipped += size;
+      return true;
+    }
+  }
+
+  m_pending_vram_write_record.bounds = GetVRAMTransferBounds(x, y, width, height);
+  m_pending_vram_write_record.hash = hash;
+  m_pending_vram_write_record.x = Truncate16(x);
+  m_pending_vram_write_record.y = Truncate16(y);
+  m_pending_vram_write_record.width = Truncate16(width);
+  m_pending_vram_write_record.height = Truncate16(height);
+  m_pending_vram_write_record.check_mask_before_draw = m_GPUSTAT.check_mask_before_draw;
+  m_pending_vram_write_record.set_mask_while_drawing = m_GPUSTAT.set_mask_while_drawing;
+  return false;
+}
+
+void GPU_HW::InvalidateVRAMWriteRecords(const Common::Rectangle<u32>& rect)
+{
+  u32 count = 0;
+  for (u32 i = 0; i < m_num_vram_write_records; i++)
+  {
+    if (!m_vram_write_records[i].bounds.Intersects(rect))
+      m_vram_write_records[count++] = m_vram_write_records[i];
+  }
+  m_num_vram_write_records = count;
+}
+
+void GPU_HW::ClearVRAMWriteRecords()
+{
+  m_num_vram_write_records = 0;
+  m_pending_vram_write_record = {};
+}
+
 void GPU_HW::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
 {
   IncludeVRAMDityRectangle(
@@ -932,15 +1174,22 @@ void GPU_HW::DispatchRenderCommand()
     if (m_draw_mode.IsTexturePageChanged())
     {
       m_draw_mode.ClearTexturePageChangedFlag();
-      if (m_vram_dirty_rect.Valid() && (m_draw_mode.mode_reg.GetTexturePageRectangle().Intersects(m_vram_dirty_rect) ||
-                                        (m_draw_mode.mode_reg.IsUsingPalette() &&
-                                         m_draw_mode.GetTexturePaletteRectangle().Intersects(m_vram_dirty_rect))))
+      if (m_vram_dirty_rect.Valid())
       {
-        // Log_DevPrintf("Invalidating VRAM read cache due to drawing area overlap");
-        if (!IsFlushed())
-          FlushRender();
+        // only the tiles which are going to be sampled need to be copied
+        VRAMTileMask texture_tiles = {};
+        IncludeVRAMTiles(texture_tiles, m_draw_mode.mode_reg.GetTexturePageRectangle());
+        if (m_draw_mode.mode_reg.IsUsingPalette())
+          IncludeVRAMTiles(texture_tiles, m_draw_mode.GetTexturePaletteRectangle());
 
-        UpdateVRAMReadTexture();
+        if (AreVRAMTilesDirty(texture_tiles))
+        {
+          // Log_DevPrintf("Invalidating VRAM read cache due to drawing area overlap");
+          if (!IsFlushed())
+            FlushRender();
+
+          UpdateVRAMReadTexture(texture_tiles);
+        }
       }
     }
 
@@ -1019,33 +1268,287 @@ void GPU_HW::FlushRender()
     return;
 
   const u32 vertex_count = GetBatchVertexCount();
-  UnmapBatchVertexPointer(vertex_count);
+  if (m_queued_batch)
+  {
+    // an empty batch is dropped by not pushing it
+    DrawBatchRenderCommand* cmd = m_queued_batch;
+    m_queued_batch = nullptr;
+    m_batch_start_vertex_ptr = nullptr;
+    m_batch_end_vertex_ptr = nullptr;
+    m_batch_current_vertex_ptr = nullptr;
+    if (vertex_count == 0)
+      return;
 
-  if (vertex_count == 0)
-    return;
+    const u32 size = static_cast<u32>(sizeof(DrawBatchRenderCommand) + (vertex_count * sizeof(BatchVertex)));
+    cmd->size = Common::AlignUpPow2(size, RENDER_COMMAND_ALIGNMENT);
+    cmd->batch = m_batch;
+    cmd->update_drawing_area = m_drawing_area_changed;
+    cmd->update_ubo = m_batch_ubo_dirty;
+    cmd->num_vertices = vertex_count;
+    cmd->drawing_area = m_drawing_area;
+    cmd->ubo_data = m_batch_ubo_data;
+    PushRenderCommand(cmd);
+  }
+  else
+  {
+    UnmapBatchVertexPointer(vertex_count);
+    if (vertex_count == 0)
+      return;
+
+    DrawBatch(m_batch, m_batch_base_vertex, vertex_count, m_drawing_area_changed ? &m_drawing_area : nullptr,
+              m_batch_ubo_dirty ? &m_batch_ubo_data : nullptr);
+  }
+
+  m_renderer_stats.num_batches += m_batch.NeedsTwoPassRendering() ? 2 : 1;
+  m_renderer_stats.num_uniform_buffer_updates += BoolToUInt32(m_batch_ubo_dirty);
+  m_drawing_area_changed = false;
+  m_batch_ubo_dirty = false;
+}
 
-  if (m_drawing_area_changed)
+void GPU_HW::DrawBatch(const BatchConfig& batch, u32 base_vertex, u32 num_vertices,
+                       const Common::Rectangle<u32>* drawing_area, const BatchUBOData* ubo_data)
+{
+  if (drawing_area)
   {
-    m_drawing_area_changed = false;
+    m_scissor_drawing_area = *drawing_area;
     SetScissorFromDrawingArea();
   }
 
-  if (m_batch_ubo_dirty)
+  if (ubo_data)
+    UploadUniformBuffer(ubo_data, sizeof(BatchUBOData));
+
+  if (batch.NeedsTwoPassRendering())
   {
-    UploadUniformBuffer(&m_batch_ubo_data, sizeof(m_batch_ubo_data));
-    m_batch_ubo_dirty = false;
+    DrawBatchVertices(batch, BatchRenderMode::OnlyOpaque, base_vertex, num_vertices);
+    DrawBatchVertices(batch, BatchRenderMode::OnlyTransparent, base_vertex, num_vertices);
   }
-
-  if (m_batch.NeedsTwoPassRendering())
+  else
   {
-    m_renderer_stats.num_batches += 2;
-    DrawBatchVertices(BatchRenderMode::OnlyOpaque, m_batch_base_vertex, vertex_count);
-    DrawBatchVertices(BatchRenderMode::OnlyTransparent, m_batch_base_vertex, vertex_count);
+    DrawBatchVertices(batch, batch.GetRenderMode(), base_vertex, num_vertices);
   }
+}
+
+u32 GPU_HW::UploadBatchVertices(const BatchVertex* vertices, u32 num_vertices)
+{
+  Panic("Render thread is not supported by this backend");
+  return 0;
+}
+
+void GPU_HW::UpdateRenderThread()
+{
+  // the context can't be moved while a frame is being rendered, the next call picks the change up
+  if (IsOnRenderThread())
+    return;
+
+  const bool use_render_thread = g_settings.gpu_use_render_thread && m_supports_render_thread;
+  if (use_render_thread == m_render_thread.joinable())
+    return;
+
+  if (use_render_thread)
+    StartRenderThread();
   else
+    StopRenderThread();
+}
+
+void GPU_HW::StartRenderThread()
+{
+  if (!m_render_command_queue)
+    m_render_command_queue = std::make_unique<u8[]>(RENDER_COMMAND_QUEUE_SIZE);
+
+  m_render_command_read_ptr.store(0);
+  m_render_command_write_ptr.store(0);
+  m_render_thread_done.store(false);
+  m_render_thread = std::thread(&GPU_HW::RunRenderThreadLoop, this);
+  m_render_thread_id = m_render_thread.get_id();
+  Log_InfoPrint("Render thread started.");
+}
+
+void GPU_HW::StopRenderThread()
+{
+  if (!m_render_thread.joinable())
+    return;
+
+  // hand the context back to this thread
+  RunOnRenderThread([]() {}, RenderThreadContextChange::Release);
+
+  m_render_thread_done.store(true);
+  WakeRenderThread();
+  m_render_thread.join();
+  m_render_thread_id = {};
+  Log_InfoPrint("Render thread stopped.");
+}
+
+void GPU_HW::CallOnRenderThread(void (*func)(const void*), const void* param, RenderThreadContextChange context_change)
+{
+  // Everything drawn so far has to be executed first. This also pushes the open batch, which has to happen before
+  // any other command is allocated.
+  FlushRender();
+
+  if (context_change == RenderThreadContextChange::Acquire)
+  {
+    if (m_render_thread_has_context)
+      context_change = RenderThreadContextChange::None;
+    else
+      m_host_display->DoneRenderContextCurrent();
+  }
+
+  CallRenderCommand* cmd =
+    static_cast<CallRenderCommand*>(AllocateRenderCommand(RenderCommandType::Call, sizeof(CallRenderCommand)));
+  cmd->func = func;
+  cmd->param = param;
+  cmd->context_change = context_change;
+  PushRenderCommand(cmd);
+
+  m_render_thread_sync_event.Wait();
+  m_render_thread_sync_event.Reset();
+
+  if (context_change == RenderThreadContextChange::Acquire)
   {
-    m_renderer_stats.num_batches++;
-    DrawBatchVertices(m_batch.GetRenderMode(), m_batch_base_vertex, vertex_count);
+    m_render_thread_has_context = true;
+  }
+  else if (context_change == RenderThreadContextChange::Release)
+  {
+    m_render_thread_has_context = false;
+    m_host_display->MakeRenderContextCurrent();
+  }
+}
+
+GPU_HW::RenderCommand* GPU_HW::AllocateRenderCommand(RenderCommandType type, u32 size)
+{
+  size = Common::AlignUpPow2(size, RENDER_COMMAND_ALIGNMENT);
+
+  // There always has to be space left for a wraparound command after the new one, and the write pointer can't catch
+  // up with the read pointer, since that would look like an empty queue.
+  for (;;)
+  {
+    const u32 read_ptr = m_render_command_read_ptr.load();
+    const u32 write_ptr = m_render_command_write_ptr.load();
+    if (read_ptr > write_ptr)
+    {
+      if ((read_ptr - write_ptr) <= size)
+      {
+        WakeRenderThread();
+        std::this_thread::yield();
+        continue;
+      }
+    }
+    else if ((size + sizeof(RenderCommand)) > (RENDER_COMMAND_QUEUE_SIZE - write_ptr))
+    {
+      // the render thread has to move off the start of the queue before it can be wrapped around
+      if (read_ptr == 0)
+      {
+        WakeRenderThread();
+        std::this_thread::yield();
+        continue;
+      }
+
+      RenderCommand* wraparound_cmd = reinterpret_cast<RenderCommand*>(&m_render_command_queue[write_ptr]);
+      wraparound_cmd->size = RENDER_COMMAND_QUEUE_SIZE - write_ptr;
+      wraparound_cmd->type = RenderCommandType::Wraparound;
+      m_render_command_write_ptr.store(0);
+      continue;
+    }
+
+    RenderCommand* cmd = reinterpret_cast<RenderCommand*>(&m_render_command_queue[write_ptr]);
+    cmd->size = size;
+    cmd->type = type;
+    return cmd;
+  }
+}
+
+void GPU_HW::PushRenderCommand(RenderCommand* cmd)
+{
+  m_render_command_write_ptr.fetch_add(cmd->size);
+  WakeRenderThread();
+}
+
+void GPU_HW::WakeRenderThread()
+{
+  if (!m_render_thread_sleeping.load())
+    return;
+
+  std::unique_lock<std::mutex> lock(m_render_thread_mutex);
+  m_render_thread_wake_cv.notify_one();
+}
+
+void GPU_HW::RunRenderThreadLoop()
+{
+  for (;;)
+  {
+    u32 read_ptr = m_render_command_read_ptr.load();
+    if (read_ptr == m_render_command_write_ptr.load())
+    {
+      std::unique_lock<std::mutex> lock(m_render_thread_mutex);
+      m_render_thread_sleeping.store(true);
+      m_render_thread_wake_cv.wait(lock, [this, read_ptr]() {
+        return m_render_thread_done.load() || m_render_command_write_ptr.load() != read_ptr;
+      });
+      m_render_thread_sleeping.store(false);
+
+      if (m_render_thread_done.load())
+        break;
+      else
+        continue;
+    }
+
+    // the read pointer is only advanced once the command has executed, so its memory isn't reused before then
+    const RenderCommand* cmd = reinterpret_cast<const RenderCommand*>(&m_render_command_queue[read_ptr]);
+    if (cmd->type == RenderCommandType::Wraparound)
+    {
+      read_ptr = 0;
+    }
+    else
+    {
+      read_ptr += cmd->size;
+      HandleRenderCommand(cmd);
+    }
+
+    m_render_command_read_ptr.store(read_ptr);
+  }
+}
+
+void GPU_HW::HandleRenderCommand(const RenderCommand* cmd)
+{
+  switch (cmd->type)
+  {
+    case RenderCommandType::Call:
+    {
+      const CallRenderCommand* ccmd = static_cast<const CallRenderCommand*>(cmd);
+      if (ccmd->context_change == RenderThreadContextChange::Acquire)
+        m_host_display->MakeRenderContextCurrent();
+
+      ccmd->func(ccmd->param);
+
+      if (ccmd->context_change == RenderThreadContextChange::Release)
+        m_host_display->DoneRenderContextCurrent();
+
+      m_render_thread_sync_event.Signal();
+    }
+    break;
+
+    case RenderCommandType::DrawBatch:
+    {
+      const DrawBatchRenderCommand* ccmd = static_cast<const DrawBatchRenderCommand*>(cmd);
+      const u32 base_vertex = UploadBatchVertices(ccmd->vertices, ccmd->num_vertices);
+      DrawBatch(ccmd->batch, base_vertex, ccmd->num_vertices, ccmd->update_drawing_area ? &ccmd->drawing_area : nullptr,
+                ccmd->update_ubo ? &ccmd->ubo_data : nullptr);
+    }
+    break;
+
+    case RenderCommandType::CopyToVRAMReadTexture:
+    {
+      const CopyToVRAMReadTextureRenderCommand* ccmd = static_cast<const CopyToVRAMReadTextureRenderCommand*>(cmd);
+      CopyToVRAMReadTexture(ccmd->rects, ccmd->num_rects);
+    }
+    break;
+
+    case RenderCommandType::UpdateDepthBufferFromMaskBit:
+      UpdateDepthBufferFromMaskBit();
+      break;
+
+    default:
+      UnreachableCode();
+      break;
   }
 }
 
@@ -1119,11 +1622,21 @@ void GPU_HW::DrawRendererStats(bool is_idle_frame)
     ImGui::Text("%u", stats.num_vram_read_texture_updates);
     ImGui::NextColumn();
 
+    ImGui::TextUnformatted("VRAM Read Texture Copy Area:");
+    ImGui::NextColumn();
+    ImGui::Text("%u of %u texels", stats.vram_read_texture_copy_area, stats.vram_read_texture_bounds_area);
+    ImGui::NextColumn();
+
     ImGui::TextUnformatted("Uniform Buffer Updates: ");
     ImGui::NextColumn();
     ImGui::Text("%u", stats.num_uniform_buffer_updates);
     ImGui::NextColumn();
 
+    ImGui::TextUnformatted("Skipped VRAM Writes:");
+    ImGui::NextColumn();
+    ImGui::Text("%u (%u bytes)", stats.num_vram_writes_skipped, stats.num_vram_write_bytes_skipped);
+    ImGui::NextColumn();
+
     ImGui::Columns(1);
   }
 #endif
@@ -1,13 +1,26 @@
 #pragma once
+#include "common/event.h"
 #include "common/heap_array.h"
 #include "gpu.h"
 #include "host_display.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
 
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4200) // warning C4200: nonstandard extension used: zero-sized array in struct/union
+#pragma warning(disable : 4324) // warning C4324: 'GPU_HW': structure was padded due to alignment specifier
+#endif
+
 class GPU_HW : public GPU
 {
 public:
@@ -26,6 +39,13 @@ public:
     SeparateFields
   };
 
+  enum class RenderThreadContextChange : u8
+  {
+    None,
+    Acquire,
+    Release
+  };
+
   GPU_HW();
   virtual ~GPU_HW();
 
@@ -160,11 +180,27 @@ protected:
     float u_depth_value;
   };
 
+  enum : u32
+  {
+    VRAM_TILE_SIZE = 64,
+    VRAM_TILE_ROWS = VRAM_HEIGHT / VRAM_TILE_SIZE,
+    ALL_VRAM_TILES_IN_ROW = (1u << (VRAM_WIDTH / VRAM_TILE_SIZE)) - 1u,
+    MAX_VRAM_READ_TEXTURE_COPIES = VRAM_TILE_ROWS * (VRAM_WIDTH / VRAM_TILE_SIZE)
+  };
+
+  /// One bit for each tile in a row, and one element for each row.
+  using VRAMTileMask = std::array<u16, VRAM_TILE_ROWS>;
+  static_assert((VRAM_WIDTH / VRAM_TILE_SIZE) <= 16, "VRAM tile row fits in mask");
+
   struct RendererStats
   {
     u32 num_batches;
     u32 num_vram_read_texture_updates;
     u32 num_uniform_buffer_updates;
+    u32 num_vram_writes_skipped;
+    u32 num_vram_write_bytes_skipped;
+    u32 vram_read_texture_copy_area;
+    u32 vram_read_texture_bounds_area;
   };
 
   static constexpr std::tuple<float, float, float, float> RGBA8ToFloat(u32 rgba)
@@ -177,13 +213,44 @@ protected:
 
   void UpdateHWSettings(bool* framebuffer_changed, bool* shaders_changed);
 
-  virtual void UpdateVRAMReadTexture();
+  /// Copies the specified areas of the VRAM texture to the read texture, in native (unscaled) coordinates.
+  virtual void CopyToVRAMReadTexture(const Common::Rectangle<u32>* rects, u32 num_rects) = 0;
   virtual void UpdateDepthBufferFromMaskBit() = 0;
   virtual void SetScissorFromDrawingArea() = 0;
   virtual void MapBatchVertexPointer(u32 required_vertices) = 0;
   virtual void UnmapBatchVertexPointer(u32 used_vertices) = 0;
   virtual void UploadUniformBuffer(const void* uniforms, u32 uniforms_size) = 0;
-  virtual void DrawBatchVertices(BatchRenderMode render_mode, u32 base_vertex, u32 num_vertices) = 0;
+  virtual void DrawBatchVertices(const BatchConfig& batch, BatchRenderMode render_mode, u32 base_vertex,
+                                 u32 num_vertices) = 0;
+
+  /// Copies vertices to the vertex buffer, and returns the index of the first one. Only used by the render thread,
+  /// which receives batches through the command queue instead of building them in a mapped vertex buffer.
+  virtual u32 UploadBatchVertices(const BatchVertex* vertices, u32 num_vertices);
+
+  /// Returns true if the calling thread is the render thread.
+  ALWAYS_INLINE bool IsOnRenderThread() const { return std::this_thread::get_id() == m_render_thread_id; }
+
+  /// Returns true if work issued by the calling thread has to be queued for the render thread.
+  ALWAYS_INLINE bool IsRenderThreadActive() const { return !IsOnRenderThread() && m_render_thread_has_context; }
+
+  /// Runs a backend function on the render thread and waits for it, when the render thread owns the graphics context
+  /// or is acquiring it. Returns false if the caller should run the function itself.
+  template<typename T>
+  bool RunOnRenderThread(const T& func, RenderThreadContextChange context_change = RenderThreadContextChange::None)
+  {
+    if (IsOnRenderThread() || !m_render_thread.joinable() ||
+        (!m_render_thread_has_context && context_change != RenderThreadContextChange::Acquire))
+    {
+      return false;
+    }
+
+    CallOnRenderThread([](const void* param) { (*static_cast<const T*>(param))(); }, &func, context_change);
+    return true;
+  }
+
+  /// Starts or stops the render thread to match the settings. Must be called outside of a frame.
+  void UpdateRenderThread();
+  void StopRenderThread();
 
   u32 CalculateResolutionScale() const;
 
@@ -192,10 +259,31 @@ protected:
   void SetFullVRAMDirtyRectangle()
   {
     m_vram_dirty_rect.Set(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+    m_vram_dirty_tiles.fill(ALL_VRAM_TILES_IN_ROW);
     m_draw_mode.SetTexturePageChanged();
   }
-  void ClearVRAMDirtyRectangle() { m_vram_dirty_rect.SetInvalid(); }
-  void IncludeVRAMDityRectangle(const Common::Rectangle<u32>& rect);
+  void ClearVRAMDirtyRectangle()
+  {
+    m_vram_dirty_rect.SetInvalid();
+    m_vram_dirty_tiles.fill(0);
+  }
+  void IncludeVRAMDityRectangle(const Common::Rectangle<u32>& rect, bool invalidate_write_records = true);
+
+  /// Includes an area drawn to by a primitive in the dirty rectangle.
+  ALWAYS_INLINE void IncludeDrawnVRAMRectangle(u32 left, u32 right, u32 top, u32 bottom)
+  {
+    const Common::Rectangle<u32> rect(left, top, right, bottom);
+    m_vram_dirty_rect.Include(rect);
+    IncludeVRAMTiles(m_vram_dirty_tiles, rect);
+    if (m_num_vram_write_records > 0)
+      InvalidateVRAMWriteRecords(rect);
+  }
+
+  /// Copies any parts of the specified area which have been written to since the last copy to the read texture.
+  void UpdateVRAMReadTexture(const Common::Rectangle<u32>& area);
+
+  /// Copies everything which has been written to since the last copy to the read texture.
+  void UpdateVRAMReadTexture();
 
   bool IsFlushed() const { return m_batch_current_vertex_ptr == m_batch_start_vertex_ptr; }
 
@@ -247,13 +335,17 @@ protected:
     return true;
   }
 
+  void ReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
+  void BeginVRAMRead(u32 x, u32 y, u32 width, u32 height) override = 0;
   void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color) override;
   void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data) override;
+  bool IsVRAMWriteRedundant(u32 x, u32 y, u32 width, u32 height, const void* data) override;
   void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height) override;
   void DispatchRenderCommand() override;
   void FlushRender() override;
   void DrawRendererStats(bool is_idle_frame) override;
 
+  /// Computes the scissor rectangle for the drawing area of the most recently drawn batch.
   void CalcScissorRect(int* left, int* top, int* right, int* bottom);
 
   std::tuple<s32, s32> ScaleVRAMCoordinates(s32 x, s32 y) const
@@ -302,6 +394,7 @@ protected:
   bool m_supports_per_sample_shading = false;
   bool m_supports_dual_source_blend = false;
   bool m_using_uv_limits = false;
+  bool m_supports_render_thread = false;
 
   BatchConfig m_batch = {};
   BatchUBOData m_batch_ubo_data = {};
@@ -309,6 +402,15 @@ protected:
   // Bounding box of VRAM area that the GPU has drawn into.
   Common::Rectangle<u32> m_vram_dirty_rect;
 
+  // Tiles of VRAM which have been drawn into, so only these need to be copied to the read texture.
+  VRAMTileMask m_vram_dirty_tiles = {};
+
+  // Area of VRAM being read back by BeginVRAMRead(), written to the shadow once it completes.
+  Common::Rectangle<u32> m_pending_vram_read_rect;
+
+  // Drawing area which the scissor is set from. Lags m_drawing_area until the next batch is drawn.
+  Common::Rectangle<u32> m_scissor_drawing_area;
+
   // Statistics
   RendererStats m_renderer_stats = {};
   RendererStats m_last_renderer_stats = {};
@@ -320,11 +422,89 @@ private:
   enum : u32
   {
     MIN_BATCH_VERTEX_COUNT = 6,
-    MAX_BATCH_VERTEX_COUNT = VERTEX_BUFFER_SIZE / sizeof(BatchVertex)
+    MAX_BATCH_VERTEX_COUNT = VERTEX_BUFFER_SIZE / sizeof(BatchVertex),
+    MAX_VRAM_WRITE_RECORDS = 8,
+    RENDER_COMMAND_QUEUE_SIZE = 8 * 1024 * 1024,
+    RENDER_COMMAND_ALIGNMENT = 8
   };
 
+  enum class RenderCommandType : u8
+  {
+    Wraparound,
+    Call,
+    DrawBatch,
+    CopyToVRAMReadTexture,
+    UpdateDepthBufferFromMaskBit
+  };
+
+  struct RenderCommand
+  {
+    u32 size;
+    RenderCommandType type;
+  };
+
+  struct CallRenderCommand : public RenderCommand
+  {
+    void (*func)(const void* param);
+    const void* param;
+    RenderThreadContextChange context_change;
+  };
+
+  struct DrawBatchRenderCommand : public RenderCommand
+  {
+    BatchConfig batch;
+    bool update_drawing_area;
+    bool update_ubo;
+    u32 num_vertices;
+    Common::Rectangle<u32> drawing_area;
+    BatchUBOData ubo_data;
+    BatchVertex vertices[0];
+  };
+
+  struct CopyToVRAMReadTextureRenderCommand : public RenderCommand
+  {
+    u32 num_rects;
+    Common::Rectangle<u32> rects[0];
+  };
+
+  /// A CPU->VRAM write whose data is still resident, i.e. nothing has been drawn or written over it since.
+  struct VRAMWriteRecord
+  {
+    Common::Rectangle<u32> bounds;
+    u64 hash;
+    u16 x;
+    u16 y;
+    u16 width;
+    u16 height;
+    bool check_mask_before_draw;
+    bool set_mask_while_drawing;
+  };
+
+  void InvalidateVRAMWriteRecords(const Common::Rectangle<u32>& rect);
+  void ClearVRAMWriteRecords();
+
+  /// Marks the tiles covered by a rectangle, clamped to VRAM.
+  static void IncludeVRAMTiles(VRAMTileMask& mask, const Common::Rectangle<u32>& rect);
+  bool AreVRAMTilesDirty(const VRAMTileMask& mask) const;
+  void UpdateVRAMReadTexture(const VRAMTileMask& mask);
+
   void LoadVertices();
 
+  /// Starts a new batch, in the vertex buffer or the render command queue.
+  void MapBatchVertices(u32 required_vertices);
+
+  /// Sets the state for a batch and draws it, in one or two passes.
+  void DrawBatch(const BatchConfig& batch, u32 base_vertex, u32 num_vertices,
+                 const Common::Rectangle<u32>* drawing_area, const BatchUBOData* ubo_data);
+
+  void StartRenderThread();
+  void CallOnRenderThread(void (*func)(const void*), const void* param, RenderThreadContextChange context_change);
+  RenderCommand* AllocateRenderCommand(RenderCommandType type, u32 size);
+  void PushRenderCommand(RenderCommand* cmd);
+  void WakeRenderThread();
+  void RunRenderThreadLoop();
+  void HandleRenderCommand(const RenderCommand* cmd);
+
   ALWAYS_INLINE void AddVertex(const BatchVertex& v)
   {
     std::memcpy(m_batch_current_vertex_ptr, &v, sizeof(BatchVertex));
@@ -339,4 +519,34 @@ private:
   }
 
   void PrintSettingsToLog();
+
+  // Most recent CPU->VRAM writes, oldest first, for skipping identical re-uploads.
+  std::array<VRAMWriteRecord, MAX_VRAM_WRITE_RECORDS> m_vram_write_records;
+  u32 m_num_vram_write_records = 0;
+
+  // Write which was found not to be redundant, recorded once it reaches UpdateVRAM().
+  VRAMWriteRecord m_pending_vram_write_record = {};
+
+  // Batch being built in the render command queue, pushed by FlushRender().
+  DrawBatchRenderCommand* m_queued_batch = nullptr;
+
+  // The render thread only uses the graphics context between RestoreGraphicsAPIState() and ResetGraphicsAPIState(),
+  // the frontend keeps using it on its own thread outside of frames.
+  std::thread m_render_thread;
+  std::thread::id m_render_thread_id;
+  bool m_render_thread_has_context = false;
+
+  Common::Event m_render_thread_sync_event;
+  std::atomic_bool m_render_thread_sleeping{false};
+  std::atomic_bool m_render_thread_done{false};
+  std::mutex m_render_thread_mutex;
+  std::condition_variable m_render_thread_wake_cv;
+
+  std::unique_ptr<u8[]> m_render_command_queue;
+  alignas(64) std::atomic<u32> m_render_command_read_ptr{0};
+  alignas(64) std::atomic<u32> m_render_command_write_ptr{0};
 };
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
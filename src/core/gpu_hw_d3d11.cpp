@@ -2,10 +2,12 @@
 #include "common/assert.h"
 #include "common/d3d11/shader_compiler.h"
 #include "common/log.h"
+#include "common/parallel_for.h"
 #include "common/timer.h"
 #include "gpu_hw_shadergen.h"
 #include "host_display.h"
 #include "host_interface.h"
+#include "host_interface_progress_callback.h"
 #include "system.h"
 Log_SetChannel(GPU_HW_D3D11);
 
@@ -395,18 +397,9 @@ bool GPU_HW_D3D11::CompileShaders()
                              m_supports_dual_source_blend);
 
   Common::Timer compile_time;
-  const int progress_total = 1 + 1 + 2 + (4 * 9 * 2 * 2) + 7 + (2 * 3);
-  int progress_value = 0;
-#define UPDATE_PROGRESS()                                                                                              \
-  do                                                                                                                   \
-  {                                                                                                                    \
-    progress_value++;                                                                                                  \
-    if (compile_time.GetTimeSeconds() >= 1.0f)                                                                         \
-    {                                                                                                                  \
-      compile_time.Reset();                                                                                            \
-      g_host_interface->DisplayLoadingScreen("Compiling Shaders", 0, progress_total, progress_value);                  \
-    }                                                                                                                  \
-  } while (0)
+  HostInterfaceProgressCallback progress(1.0f);
+  progress.SetStatusText("Compiling Shaders");
+  progress.SetProgressRange(1 + 1 + 2 + (4 * 9 * 2 * 2) + 7 + (2 * 3));
 
   // input layout
   {
@@ -434,25 +427,22 @@ bool GPU_HW_D3D11::CompileShaders()
     }
   }
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   m_screen_quad_vertex_shader =
     shader_cache.GetVertexShader(m_device.Get(), shadergen.GenerateScreenQuadVertexShader());
   if (!m_screen_quad_vertex_shader)
     return false;
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
+  // The batch shaders are nearly all of the work, so they're compiled on all cores. The sources are generated up front
+  // on this thread.
+  std::array<std::string, 2> batch_vertex_shader_sources;
   for (u8 textured = 0; textured < 2; textured++)
-  {
-    const std::string vs = shadergen.GenerateBatchVertexShader(ConvertToBoolUnchecked(textured));
-    m_batch_vertex_shaders[textured] = shader_cache.GetVertexShader(m_device.Get(), vs);
-    if (!m_batch_vertex_shaders[textured])
-      return false;
-
-    UPDATE_PROGRESS();
-  }
+    batch_vertex_shader_sources[textured] = shadergen.GenerateBatchVertexShader(ConvertToBoolUnchecked(textured));
 
+  std::array<std::array<std::array<std::array<std::string, 2>, 2>, 9>, 4> batch_pixel_shader_sources;
   for (u8 render_mode = 0; render_mode < 4; render_mode++)
   {
     for (u8 texture_mode = 0; texture_mode < 9; texture_mode++)
@@ -461,65 +451,83 @@ bool GPU_HW_D3D11::CompileShaders()
       {
         for (u8 interlacing = 0; interlacing < 2; interlacing++)
         {
-          const std::string ps = shadergen.GenerateBatchFragmentShader(
-            static_cast<BatchRenderMode>(render_mode), static_cast<GPUTextureMode>(texture_mode),
-            ConvertToBoolUnchecked(dithering), ConvertToBoolUnchecked(interlacing));
-
-          m_batch_pixel_shaders[render_mode][texture_mode][dithering][interlacing] =
-            shader_cache.GetPixelShader(m_device.Get(), ps);
-          if (!m_batch_pixel_shaders[render_mode][texture_mode][dithering][interlacing])
-            return false;
-
-          UPDATE_PROGRESS();
+          batch_pixel_shader_sources[render_mode][texture_mode][dithering][interlacing] =
+            shadergen.GenerateBatchFragmentShader(static_cast<BatchRenderMode>(render_mode),
+                                                  static_cast<GPUTextureMode>(texture_mode),
+                                                  ConvertToBoolUnchecked(dithering), ConvertToBoolUnchecked(interlacing));
         }
       }
     }
   }
 
+  const u32 num_workers = Common::GetParallelWorkerCount();
+  const bool batch_shaders_compiled = Common::ParallelFor(
+    2 + (4 * 9 * 2 * 2),
+    [this, &shader_cache, &batch_vertex_shader_sources, &batch_pixel_shader_sources](u32 index) {
+      if (index < 2)
+      {
+        m_batch_vertex_shaders[index] = shader_cache.GetVertexShader(m_device.Get(), batch_vertex_shader_sources[index]);
+        return static_cast<bool>(m_batch_vertex_shaders[index]);
+      }
+
+      index -= 2;
+      const u8 interlacing = static_cast<u8>(index % 2);
+      const u8 dithering = static_cast<u8>((index / 2) % 2);
+      const u8 texture_mode = static_cast<u8>((index / (2 * 2)) % 9);
+      const u8 render_mode = static_cast<u8>(index / (2 * 2 * 9));
+      auto& ps = m_batch_pixel_shaders[render_mode][texture_mode][dithering][interlacing];
+      ps = shader_cache.GetPixelShader(m_device.Get(),
+                                       batch_pixel_shader_sources[render_mode][texture_mode][dithering][interlacing]);
+      return static_cast<bool>(ps);
+    },
+    &progress, num_workers);
+  if (!batch_shaders_compiled)
+    return false;
+
   m_copy_pixel_shader = shader_cache.GetPixelShader(m_device.Get(), shadergen.GenerateCopyFragmentShader());
   if (!m_copy_pixel_shader)
     return false;
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   m_vram_fill_pixel_shader = shader_cache.GetPixelShader(m_device.Get(), shadergen.GenerateFillFragmentShader());
   if (!m_vram_fill_pixel_shader)
     return false;
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   m_vram_interlaced_fill_pixel_shader =
     shader_cache.GetPixelShader(m_device.Get(), shadergen.GenerateInterlacedFillFragmentShader());
   if (!m_vram_interlaced_fill_pixel_shader)
     return false;
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   m_vram_read_pixel_shader = shader_cache.GetPixelShader(m_device.Get(), shadergen.GenerateVRAMReadFragmentShader());
   if (!m_vram_read_pixel_shader)
     return false;
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   m_vram_write_pixel_shader =
     shader_cache.GetPixelShader(m_device.Get(), shadergen.GenerateVRAMWriteFragmentShader(false));
   if (!m_vram_write_pixel_shader)
     return false;
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   m_vram_copy_pixel_shader = shader_cache.GetPixelShader(m_device.Get(), shadergen.GenerateVRAMCopyFragmentShader());
   if (!m_vram_copy_pixel_shader)
     return false;
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   m_vram_update_depth_pixel_shader =
     shader_cache.GetPixelShader(m_device.Get(), shadergen.GenerateVRAMUpdateDepthFragmentShader());
   if (!m_vram_update_depth_pixel_shader)
     return false;
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   for (u8 depth_24bit = 0; depth_24bit < 2; depth_24bit++)
   {
@@ -532,14 +540,13 @@ bool GPU_HW_D3D11::CompileShaders()
       if (!m_display_pixel_shaders[depth_24bit][interlacing])
         return false;
 
-      UPDATE_PROGRESS();
+      progress.IncrementProgressValue();
     }
   }
 
-  UPDATE_PROGRESS();
-
-#undef UPDATE_PROGRESS
+  progress.IncrementProgressValue();
 
+  Log_InfoPrintf("Compiled shaders in %.2f ms using %u threads", compile_time.GetTimeMilliseconds(), num_workers);
   return true;
 }
 
@@ -569,8 +576,6 @@ void GPU_HW_D3D11::UploadUniformBuffer(const void* data, u32 data_size)
 
   m_context->VSSetConstantBuffers(0, 1, m_uniform_stream_buffer.GetD3DBufferArray());
   m_context->PSSetConstantBuffers(0, 1, m_uniform_stream_buffer.GetD3DBufferArray());
-
-  m_renderer_stats.num_uniform_buffer_updates++;
 }
 
 void GPU_HW_D3D11::SetViewport(u32 x, u32 y, u32 width, u32 height)
@@ -608,22 +613,23 @@ void GPU_HW_D3D11::DrawUtilityShader(ID3D11PixelShader* shader, const void* unif
   m_context->Draw(3, 0);
 }
 
-void GPU_HW_D3D11::DrawBatchVertices(BatchRenderMode render_mode, u32 base_vertex, u32 num_vertices)
+void GPU_HW_D3D11::DrawBatchVertices(const BatchConfig& batch, BatchRenderMode render_mode, u32 base_vertex,
+                                     u32 num_vertices)
 {
-  const bool textured = (m_batch.texture_mode != GPUTextureMode::Disabled);
+  const bool textured = (batch.texture_mode != GPUTextureMode::Disabled);
 
   m_context->VSSetShader(m_batch_vertex_shaders[BoolToUInt8(textured)].Get(), nullptr, 0);
 
-  m_context->PSSetShader(m_batch_pixel_shaders[static_cast<u8>(render_mode)][static_cast<u8>(m_batch.texture_mode)]
-                                              [BoolToUInt8(m_batch.dithering)][BoolToUInt8(m_batch.interlacing)]
+  m_context->PSSetShader(m_batch_pixel_shaders[static_cast<u8>(render_mode)][static_cast<u8>(batch.texture_mode)]
+                                              [BoolToUInt8(batch.dithering)][BoolToUInt8(batch.interlacing)]
                                                 .Get(),
                          nullptr, 0);
 
   const GPUTransparencyMode transparency_mode =
-    (render_mode == BatchRenderMode::OnlyOpaque) ? GPUTransparencyMode::Disabled : m_batch.transparency_mode;
+    (render_mode == BatchRenderMode::OnlyOpaque) ? GPUTransparencyMode::Disabled : batch.transparency_mode;
   m_context->OMSetBlendState(m_batch_blend_states[static_cast<u8>(transparency_mode)].Get(), nullptr, 0xFFFFFFFFu);
   m_context->OMSetDepthStencilState(
-    m_batch.check_mask_before_draw ? m_depth_test_less_state.Get() : m_depth_test_always_state.Get(), 0);
+    batch.check_mask_before_draw ? m_depth_test_less_state.Get() : m_depth_test_always_state.Get(), 0);
 
   m_context->Draw(num_vertices, base_vertex);
 }
@@ -725,8 +731,11 @@ void GPU_HW_D3D11::UpdateDisplay()
   }
 }
 
-void GPU_HW_D3D11::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
+void GPU_HW_D3D11::BeginVRAMRead(u32 x, u32 y, u32 width, u32 height)
 {
+  // There's only one staging texture, so any previous readback has to finish first.
+  FlushVRAMRead();
+
   // Get bounds with wrap-around handled.
   const Common::Rectangle<u32> copy_rect = GetVRAMTransferBounds(x, y, width, height);
   const u32 encoded_width = (copy_rect.GetWidth() + 1) / 2;
@@ -744,10 +753,22 @@ void GPU_HW_D3D11::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
   // Stage the readback.
   m_vram_readback_texture.CopyFromTexture(m_context.Get(), m_vram_encoding_texture.GetD3DTexture(), 0, 0, 0, 0, 0,
                                           encoded_width, encoded_height);
+
+  // Kick off the copy, it's only mapped when the data is needed.
+  m_context->Flush();
+  m_pending_vram_read_rect = copy_rect;
+  m_vram_read_pending = true;
+
+  RestoreGraphicsAPIState();
+}
+
+void GPU_HW_D3D11::CompleteVRAMRead()
+{
   // And copy it into our shadow buffer.
+  const Common::Rectangle<u32>& copy_rect = m_pending_vram_read_rect;
   if (m_vram_readback_texture.Map(m_context.Get(), false))
   {
-    m_vram_readback_texture.ReadPixels(0, 0, encoded_width * 2, encoded_height, VRAM_WIDTH,
+    m_vram_readback_texture.ReadPixels(0, 0, ((copy_rect.GetWidth() + 1) / 2) * 2, copy_rect.GetHeight(), VRAM_WIDTH,
                                        &m_vram_shadow[copy_rect.top * VRAM_WIDTH + copy_rect.left]);
     m_vram_readback_texture.Unmap(m_context.Get());
   }
@@ -755,8 +776,6 @@ void GPU_HW_D3D11::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
   {
     Log_ErrorPrintf("Failed to map VRAM readback texture");
   }
-
-  RestoreGraphicsAPIState();
 }
 
 void GPU_HW_D3D11::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
@@ -816,8 +835,7 @@ void GPU_HW_D3D11::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 widt
   {
     const Common::Rectangle<u32> src_bounds = GetVRAMTransferBounds(src_x, src_y, width, height);
     const Common::Rectangle<u32> dst_bounds = GetVRAMTransferBounds(dst_x, dst_y, width, height);
-    if (m_vram_dirty_rect.Intersects(src_bounds))
-      UpdateVRAMReadTexture();
+    UpdateVRAMReadTexture(src_bounds);
     IncludeVRAMDityRectangle(dst_bounds);
 
     const VRAMCopyUBOData uniforms = GetVRAMCopyUBOData(src_x, src_y, dst_x, dst_y, width, height);
@@ -840,8 +858,7 @@ void GPU_HW_D3D11::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 widt
   // We can't CopySubresourceRegion to the same resource. So use the shadow texture if we can, but that may need to be
   // updated first. Copying to the same resource seemed to work on Windows 10, but breaks on Windows 7. But, it's
   // against the API spec, so better to be safe than sorry.
-  if (m_vram_dirty_rect.Intersects(Common::Rectangle<u32>::FromExtents(src_x, src_y, width, height)))
-    UpdateVRAMReadTexture();
+  UpdateVRAMReadTexture(Common::Rectangle<u32>::FromExtents(src_x, src_y, width, height));
 
   GPU_HW::CopyVRAM(src_x, src_y, dst_x, dst_y, width, height);
 
@@ -856,23 +873,23 @@ void GPU_HW_D3D11::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 widt
   m_context->CopySubresourceRegion(m_vram_texture, 0, dst_x, dst_y, 0, m_vram_read_texture, 0, &src_box);
 }
 
-void GPU_HW_D3D11::UpdateVRAMReadTexture()
+void GPU_HW_D3D11::CopyToVRAMReadTexture(const Common::Rectangle<u32>* rects, u32 num_rects)
 {
-  const auto scaled_rect = m_vram_dirty_rect * m_resolution_scale;
-  const CD3D11_BOX src_box(scaled_rect.left, scaled_rect.top, 0, scaled_rect.right, scaled_rect.bottom, 1);
-
   if (m_vram_texture.IsMultisampled())
   {
+    // resolves always cover the whole texture
     m_context->ResolveSubresource(m_vram_read_texture.GetD3DTexture(), 0, m_vram_texture.GetD3DTexture(), 0,
                                   m_vram_texture.GetFormat());
+    return;
   }
-  else
+
+  for (u32 i = 0; i < num_rects; i++)
   {
+    const auto scaled_rect = rects[i] * m_resolution_scale;
+    const CD3D11_BOX src_box(scaled_rect.left, scaled_rect.top, 0, scaled_rect.right, scaled_rect.bottom, 1);
     m_context->CopySubresourceRegion(m_vram_read_texture, 0, scaled_rect.left, scaled_rect.top, 0, m_vram_texture, 0,
                                      &src_box);
   }
-
-  GPU_HW::UpdateVRAMReadTexture();
 }
 
 void GPU_HW_D3D11::UpdateDepthBufferFromMaskBit()
@@ -4,6 +4,7 @@
 #include "common/timer.h"
 #include "gpu_hw_shadergen.h"
 #include "host_display.h"
+#include "host_interface_progress_callback.h"
 #include "system.h"
 Log_SetChannel(GPU_HW_OpenGL);
 
@@ -11,6 +12,9 @@ GPU_HW_OpenGL::GPU_HW_OpenGL() : GPU_HW() {}
 
 GPU_HW_OpenGL::~GPU_HW_OpenGL()
 {
+  // Takes the context back if the render thread has it.
+  StopRenderThread();
+
   // Destroy objects which don't have destructors to clean them up
   if (m_vram_fbo_id != 0)
     glDeleteFramebuffers(1, &m_vram_fbo_id);
@@ -20,6 +24,10 @@ GPU_HW_OpenGL::~GPU_HW_OpenGL()
     glDeleteVertexArrays(1, &m_attributeless_vao_id);
   if (m_texture_buffer_r16ui_texture != 0)
     glDeleteTextures(1, &m_texture_buffer_r16ui_texture);
+  if (m_vram_readback_fence)
+    glDeleteSync(m_vram_readback_fence);
+  if (m_vram_readback_buffer_id != 0)
+    glDeleteBuffers(1, &m_vram_readback_buffer_id);
 
   if (m_host_display)
   {
@@ -83,6 +91,12 @@ bool GPU_HW_OpenGL::Initialize(HostDisplay* host_display)
     return false;
   }
 
+  if (!CreateVRAMReadbackBuffer())
+  {
+    Log_ErrorPrintf("Failed to create VRAM readback buffer");
+    return false;
+  }
+
   if (!CompilePrograms())
   {
     Log_ErrorPrintf("Failed to compile programs");
@@ -90,11 +104,15 @@ bool GPU_HW_OpenGL::Initialize(HostDisplay* host_display)
   }
 
   RestoreGraphicsAPIState();
+  UpdateRenderThread();
   return true;
 }
 
 void GPU_HW_OpenGL::Reset()
 {
+  if (RunOnRenderThread([this]() { Reset(); }))
+    return;
+
   GPU_HW::Reset();
 
   ClearFramebuffer();
@@ -102,6 +120,9 @@ void GPU_HW_OpenGL::Reset()
 
 void GPU_HW_OpenGL::ResetGraphicsAPIState()
 {
+  if (RunOnRenderThread([this]() { ResetGraphicsAPIState(); }, RenderThreadContextChange::Release))
+    return;
+
   GPU_HW::ResetGraphicsAPIState();
 
   glEnable(GL_CULL_FACE);
@@ -113,6 +134,9 @@ void GPU_HW_OpenGL::ResetGraphicsAPIState()
 
 void GPU_HW_OpenGL::RestoreGraphicsAPIState()
 {
+  if (RunOnRenderThread([this]() { RestoreGraphicsAPIState(); }, RenderThreadContextChange::Acquire))
+    return;
+
   glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_vram_fbo_id);
   glViewport(0, 0, m_vram_texture.GetWidth(), m_vram_texture.GetHeight());
 
@@ -131,6 +155,9 @@ void GPU_HW_OpenGL::RestoreGraphicsAPIState()
 
 void GPU_HW_OpenGL::UpdateSettings()
 {
+  if (RunOnRenderThread([this]() { UpdateSettings(); }))
+    return;
+
   GPU_HW::UpdateSettings();
 
   bool framebuffer_changed, shaders_changed;
@@ -155,6 +182,8 @@ void GPU_HW_OpenGL::UpdateSettings()
     UpdateDisplay();
     ResetGraphicsAPIState();
   }
+
+  UpdateRenderThread();
 }
 
 void GPU_HW_OpenGL::MapBatchVertexPointer(u32 required_vertices)
@@ -181,6 +210,16 @@ void GPU_HW_OpenGL::UnmapBatchVertexPointer(u32 used_vertices)
   m_batch_current_vertex_ptr = nullptr;
 }
 
+u32 GPU_HW_OpenGL::UploadBatchVertices(const BatchVertex* vertices, u32 num_vertices)
+{
+  const u32 size = num_vertices * sizeof(BatchVertex);
+  const GL::StreamBuffer::MappingResult res = m_vertex_stream_buffer->Map(sizeof(BatchVertex), size);
+  std::memcpy(res.pointer, vertices, size);
+  m_vertex_stream_buffer->Unmap(size);
+  m_vertex_stream_buffer->Bind();
+  return res.index_aligned;
+}
+
 std::tuple<s32, s32> GPU_HW_OpenGL::ConvertToFramebufferCoordinates(s32 x, s32 y)
 {
   return std::make_tuple(x, static_cast<s32>(static_cast<s32>(VRAM_HEIGHT) - y));
@@ -270,6 +309,13 @@ void GPU_HW_OpenGL::SetCapabilities(HostDisplay* host_display)
 
     m_max_resolution_scale = std::min<int>(m_max_resolution_scale, line_width_range[1]);
   }
+
+  m_supports_async_vram_readback = (GLAD_GL_VERSION_3_2 || GLAD_GL_ARB_sync || GLAD_GL_ES_VERSION_3_0);
+  if (!m_supports_async_vram_readback)
+    Log_WarningPrintf("Sync objects are not supported, VRAM readbacks will stall the CPU.");
+
+  // the context is moved between threads with the host display
+  m_supports_render_thread = true;
 }
 
 bool GPU_HW_OpenGL::CreateFramebuffer()
@@ -377,6 +423,18 @@ bool GPU_HW_OpenGL::CreateTextureBuffer()
   return true;
 }
 
+bool GPU_HW_OpenGL::CreateVRAMReadbackBuffer()
+{
+  if (!m_supports_async_vram_readback)
+    return true;
+
+  glGenBuffers(1, &m_vram_readback_buffer_id);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, m_vram_readback_buffer_id);
+  glBufferData(GL_PIXEL_PACK_BUFFER, VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16), nullptr, GL_STREAM_READ);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  return (m_vram_readback_buffer_id != 0);
+}
+
 bool GPU_HW_OpenGL::CompilePrograms()
 {
   GL::ShaderCache shader_cache;
@@ -387,19 +445,12 @@ bool GPU_HW_OpenGL::CompilePrograms()
                              m_true_color, m_scaled_dithering, m_texture_filtering, m_using_uv_limits,
                              m_supports_dual_source_blend);
 
+  // GL objects can only be created on the context's thread, so unlike the other renderers this can't be spread over
+  // worker threads. Programs which were linked before come from the binary cache instead.
   Common::Timer compile_time;
-  const int progress_total = (4 * 9 * 2 * 2) + (2 * 3) + 5;
-  int progress_value = 0;
-#define UPDATE_PROGRESS()                                                                                              \
-  do                                                                                                                   \
-  {                                                                                                                    \
-    progress_value++;                                                                                                  \
-    if (compile_time.GetTimeSeconds() >= 1.0f)                                                                         \
-    {                                                                                                                  \
-      compile_time.Reset();                                                                                            \
-      g_host_interface->DisplayLoadingScreen("Compiling Shaders", 0, progress_total, progress_value);                  \
-    }                                                                                                                  \
-  } while (0)
+  HostInterfaceProgressCallback progress(1.0f);
+  progress.SetStatusText("Compiling Shaders");
+  progress.SetProgressRange((4 * 9 * 2 * 2) + (2 * 3) + 5);
 
   for (u32 render_mode = 0; render_mode < 4; render_mode++)
   {
@@ -458,7 +509,7 @@ bool GPU_HW_OpenGL::CompilePrograms()
 
           m_render_programs[render_mode][texture_mode][dithering][interlacing] = std::move(*prog);
 
-          UPDATE_PROGRESS();
+          progress.IncrementProgressValue();
         }
       }
     }
@@ -487,7 +538,7 @@ bool GPU_HW_OpenGL::CompilePrograms()
         prog->Uniform1i("samp0", 0);
       }
       m_display_programs[depth_24bit][interlaced] = std::move(*prog);
-      UPDATE_PROGRESS();
+      progress.IncrementProgressValue();
     }
   }
 
@@ -504,7 +555,7 @@ bool GPU_HW_OpenGL::CompilePrograms()
     prog->BindUniformBlock("UBOBlock", 1);
 
   m_vram_interlaced_fill_program = std::move(*prog);
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   prog =
     shader_cache.GetProgram(shadergen.GenerateScreenQuadVertexShader(), {}, shadergen.GenerateVRAMReadFragmentShader(),
@@ -522,7 +573,7 @@ bool GPU_HW_OpenGL::CompilePrograms()
     prog->Uniform1i("samp0", 0);
   }
   m_vram_read_program = std::move(*prog);
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   prog =
     shader_cache.GetProgram(shadergen.GenerateScreenQuadVertexShader(), {}, shadergen.GenerateVRAMCopyFragmentShader(),
@@ -540,7 +591,7 @@ bool GPU_HW_OpenGL::CompilePrograms()
     prog->Uniform1i("samp0", 0);
   }
   m_vram_copy_program = std::move(*prog);
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   prog = shader_cache.GetProgram(shadergen.GenerateScreenQuadVertexShader(), {},
                                  shadergen.GenerateVRAMUpdateDepthFragmentShader());
@@ -550,7 +601,7 @@ bool GPU_HW_OpenGL::CompilePrograms()
   prog->Bind();
   prog->Uniform1i("samp0", 0);
   m_vram_update_depth_program = std::move(*prog);
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   if (m_supports_texture_buffer || m_use_ssbo_for_vram_writes)
   {
@@ -572,32 +623,33 @@ bool GPU_HW_OpenGL::CompilePrograms()
     m_vram_write_program = std::move(*prog);
   }
 
-  UPDATE_PROGRESS();
-#undef UPDATE_PROGRESS
+  progress.IncrementProgressValue();
 
+  Log_InfoPrintf("Compiled programs in %.2f ms", compile_time.GetTimeMilliseconds());
   return true;
 }
 
-void GPU_HW_OpenGL::DrawBatchVertices(BatchRenderMode render_mode, u32 base_vertex, u32 num_vertices)
+void GPU_HW_OpenGL::DrawBatchVertices(const BatchConfig& batch, BatchRenderMode render_mode, u32 base_vertex,
+                                      u32 num_vertices)
 {
-  const GL::Program& prog = m_render_programs[static_cast<u8>(render_mode)][static_cast<u8>(m_batch.texture_mode)]
-                                             [BoolToUInt8(m_batch.dithering)][BoolToUInt8(m_batch.interlacing)];
+  const GL::Program& prog = m_render_programs[static_cast<u8>(render_mode)][static_cast<u8>(batch.texture_mode)]
+                                             [BoolToUInt8(batch.dithering)][BoolToUInt8(batch.interlacing)];
   prog.Bind();
 
-  if (m_current_transparency_mode != m_batch.transparency_mode || m_current_render_mode != render_mode)
+  if (m_current_transparency_mode != batch.transparency_mode || m_current_render_mode != render_mode)
   {
-    m_current_transparency_mode = m_batch.transparency_mode;
+    m_current_transparency_mode = batch.transparency_mode;
     m_current_render_mode = render_mode;
     SetBlendMode();
   }
 
-  if (m_current_check_mask_before_draw != m_batch.check_mask_before_draw)
+  if (m_current_check_mask_before_draw != batch.check_mask_before_draw)
   {
-    m_current_check_mask_before_draw = m_batch.check_mask_before_draw;
+    m_current_check_mask_before_draw = batch.check_mask_before_draw;
     SetDepthFunc();
   }
 
-  glDrawArrays(GL_TRIANGLES, m_batch_base_vertex, num_vertices);
+  glDrawArrays(GL_TRIANGLES, base_vertex, num_vertices);
 }
 
 void GPU_HW_OpenGL::SetBlendMode()
@@ -643,12 +695,13 @@ void GPU_HW_OpenGL::UploadUniformBuffer(const void* data, u32 data_size)
   m_uniform_stream_buffer->Unmap(data_size);
 
   glBindBufferRange(GL_UNIFORM_BUFFER, 1, m_uniform_stream_buffer->GetGLBufferId(), res.buffer_offset, data_size);
-
-  m_renderer_stats.num_uniform_buffer_updates++;
 }
 
 void GPU_HW_OpenGL::ClearDisplay()
 {
+  if (RunOnRenderThread([this]() { ClearDisplay(); }))
+    return;
+
   GPU_HW::ClearDisplay();
 
   m_display_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
@@ -661,6 +714,9 @@ void GPU_HW_OpenGL::ClearDisplay()
 
 void GPU_HW_OpenGL::UpdateDisplay()
 {
+  if (RunOnRenderThread([this]() { UpdateDisplay(); }))
+    return;
+
   GPU_HW::UpdateDisplay();
 
   if (g_settings.debugging.show_vram)
@@ -760,8 +816,14 @@ void GPU_HW_OpenGL::UpdateDisplay()
   }
 }
 
-void GPU_HW_OpenGL::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
+void GPU_HW_OpenGL::BeginVRAMRead(u32 x, u32 y, u32 width, u32 height)
 {
+  if (RunOnRenderThread([&]() { BeginVRAMRead(x, y, width, height); }))
+    return;
+
+  // There's only one readback buffer, so any previous readback has to finish first.
+  FlushVRAMRead();
+
   // Get bounds with wrap-around handled.
   const Common::Rectangle<u32> copy_rect = GetVRAMTransferBounds(x, y, width, height);
   const u32 encoded_width = (copy_rect.GetWidth() + 1) / 2;
@@ -783,16 +845,72 @@ void GPU_HW_OpenGL::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
   // Readback encoded texture.
   m_vram_encoding_texture.BindFramebuffer(GL_READ_FRAMEBUFFER);
   glPixelStorei(GL_PACK_ALIGNMENT, 2);
-  glPixelStorei(GL_PACK_ROW_LENGTH, VRAM_WIDTH / 2);
-  glReadPixels(0, 0, encoded_width, encoded_height, GL_RGBA, GL_UNSIGNED_BYTE,
-               &m_vram_shadow[copy_rect.top * VRAM_WIDTH + copy_rect.left]);
+  if (m_supports_async_vram_readback)
+  {
+    // Copy to the pack buffer, it's written to the shadow after the fence is signaled.
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_vram_readback_buffer_id);
+    glReadPixels(0, 0, encoded_width, encoded_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_vram_readback_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    m_pending_vram_read_rect = copy_rect;
+    m_vram_read_pending = true;
+  }
+  else
+  {
+    glPixelStorei(GL_PACK_ROW_LENGTH, VRAM_WIDTH / 2);
+    glReadPixels(0, 0, encoded_width, encoded_height, GL_RGBA, GL_UNSIGNED_BYTE,
+                 &m_vram_shadow[copy_rect.top * VRAM_WIDTH + copy_rect.left]);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+  }
   glPixelStorei(GL_PACK_ALIGNMENT, 4);
-  glPixelStorei(GL_PACK_ROW_LENGTH, 0);
   RestoreGraphicsAPIState();
 }
 
+void GPU_HW_OpenGL::CompleteVRAMRead()
+{
+  if (RunOnRenderThread([this]() { CompleteVRAMRead(); }))
+    return;
+
+  GLenum wait_result;
+  do
+  {
+    wait_result = glClientWaitSync(m_vram_readback_fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_C(1000000000));
+  } while (wait_result == GL_TIMEOUT_EXPIRED);
+  glDeleteSync(m_vram_readback_fence);
+  m_vram_readback_fence = nullptr;
+
+  const Common::Rectangle<u32>& copy_rect = m_pending_vram_read_rect;
+  const u32 encoded_row_size = ((copy_rect.GetWidth() + 1) / 2) * sizeof(u32);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, m_vram_readback_buffer_id);
+  const u8* map_ptr = static_cast<const u8*>(
+    glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, encoded_row_size * copy_rect.GetHeight(), GL_MAP_READ_BIT));
+  if (map_ptr)
+  {
+    u16* dst_ptr = &m_vram_shadow[copy_rect.top * VRAM_WIDTH + copy_rect.left];
+    for (u32 row = 0; row < copy_rect.GetHeight(); row++)
+    {
+      std::memcpy(dst_ptr, map_ptr, encoded_row_size);
+      map_ptr += encoded_row_size;
+      dst_ptr += VRAM_WIDTH;
+    }
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  else
+  {
+    Log_ErrorPrintf("Failed to map VRAM readback buffer");
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
 void GPU_HW_OpenGL::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 {
+  if (RunOnRenderThread([&]() { FillVRAM(x, y, width, height, color); }))
+    return;
+
   if ((x + width) > VRAM_WIDTH || (y + height) > VRAM_HEIGHT)
   {
     // CPU round trip if oversized for now.
@@ -839,6 +957,9 @@ void GPU_HW_OpenGL::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 
 void GPU_HW_OpenGL::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
 {
+  if (RunOnRenderThread([&]() { UpdateVRAM(x, y, width, height, data); }))
+    return;
+
   const u32 num_pixels = width * height;
   if (num_pixels < m_max_texture_buffer_size || m_use_ssbo_for_vram_writes)
   {
@@ -944,12 +1065,14 @@ void GPU_HW_OpenGL::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void*
 
 void GPU_HW_OpenGL::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
 {
+  if (RunOnRenderThread([&]() { CopyVRAM(src_x, src_y, dst_x, dst_y, width, height); }))
+    return;
+
   if (UseVRAMCopyShader(src_x, src_y, dst_x, dst_y, width, height))
   {
     const Common::Rectangle<u32> src_bounds = GetVRAMTransferBounds(src_x, src_y, width, height);
     const Common::Rectangle<u32> dst_bounds = GetVRAMTransferBounds(dst_x, dst_y, width, height);
-    if (m_vram_dirty_rect.Intersects(src_bounds))
-      UpdateVRAMReadTexture();
+    UpdateVRAMReadTexture(src_bounds);
     IncludeVRAMDityRectangle(dst_bounds);
 
     VRAMCopyUBOData uniforms = GetVRAMCopyUBOData(src_x, src_y, dst_x, dst_y, width, height);
@@ -1015,41 +1138,51 @@ void GPU_HW_OpenGL::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wid
   }
 }
 
-void GPU_HW_OpenGL::UpdateVRAMReadTexture()
+void GPU_HW_OpenGL::CopyToVRAMReadTexture(const Common::Rectangle<u32>* rects, u32 num_rects)
 {
-  const auto scaled_rect = m_vram_dirty_rect * m_resolution_scale;
-  const u32 width = scaled_rect.GetWidth();
-  const u32 height = scaled_rect.GetHeight();
-  const u32 x = scaled_rect.left;
-  const u32 y = m_vram_texture.GetHeight() - scaled_rect.top - height;
   const bool multisampled = m_vram_texture.IsMultisampled();
-
-  if (!multisampled && GLAD_GL_VERSION_4_3)
-  {
-    glCopyImageSubData(m_vram_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0,
-                       m_vram_read_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0, width, height, 1);
-  }
-  else if (!multisampled && GLAD_GL_EXT_copy_image)
+  const bool use_blit = multisampled || (!GLAD_GL_VERSION_4_3 && !GLAD_GL_EXT_copy_image && !GLAD_GL_OES_copy_image);
+  if (use_blit)
   {
-    glCopyImageSubDataEXT(m_vram_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0,
-                          m_vram_read_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0, width, height, 1);
+    m_vram_read_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_vram_fbo_id);
+    glDisable(GL_SCISSOR_TEST);
   }
-  else if (!multisampled && GLAD_GL_OES_copy_image)
+
+  for (u32 i = 0; i < num_rects; i++)
   {
-    glCopyImageSubDataOES(m_vram_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0,
-                          m_vram_read_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0, width, height, 1);
+    const auto scaled_rect = rects[i] * m_resolution_scale;
+    const u32 width = scaled_rect.GetWidth();
+    const u32 height = scaled_rect.GetHeight();
+    const u32 x = scaled_rect.left;
+    const u32 y = m_vram_texture.GetHeight() - scaled_rect.top - height;
+
+    if (use_blit)
+    {
+      glBlitFramebuffer(x, y, x + width, y + height, x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    else if (GLAD_GL_VERSION_4_3)
+    {
+      glCopyImageSubData(m_vram_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0,
+                         m_vram_read_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0, width, height, 1);
+    }
+    else if (GLAD_GL_EXT_copy_image)
+    {
+      glCopyImageSubDataEXT(m_vram_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0,
+                            m_vram_read_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0, width, height, 1);
+    }
+    else
+    {
+      glCopyImageSubDataOES(m_vram_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0,
+                            m_vram_read_texture.GetGLId(), m_vram_texture.GetGLTarget(), 0, x, y, 0, width, height, 1);
+    }
   }
-  else
+
+  if (use_blit)
   {
-    m_vram_read_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_vram_fbo_id);
-    glDisable(GL_SCISSOR_TEST);
-    glBlitFramebuffer(x, y, x + width, y + height, x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
     glEnable(GL_SCISSOR_TEST);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_vram_fbo_id);
   }
-
-  GPU_HW::UpdateVRAMReadTexture();
 }
 
 void GPU_HW_OpenGL::UpdateDepthBufferFromMaskBit()
@@ -25,17 +25,20 @@ public:
 protected:
   void ClearDisplay() override;
   void UpdateDisplay() override;
-  void ReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
+  void BeginVRAMRead(u32 x, u32 y, u32 width, u32 height) override;
+  void CompleteVRAMRead() override;
   void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color) override;
   void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data) override;
   void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height) override;
-  void UpdateVRAMReadTexture() override;
+  void CopyToVRAMReadTexture(const Common::Rectangle<u32>* rects, u32 num_rects) override;
   void UpdateDepthBufferFromMaskBit() override;
   void SetScissorFromDrawingArea() override;
   void MapBatchVertexPointer(u32 required_vertices) override;
   void UnmapBatchVertexPointer(u32 used_vertices) override;
   void UploadUniformBuffer(const void* data, u32 data_size) override;
-  void DrawBatchVertices(BatchRenderMode render_mode, u32 base_vertex, u32 num_vertices) override;
+  void DrawBatchVertices(const BatchConfig& batch, BatchRenderMode render_mode, u32 base_vertex,
+                         u32 num_vertices) override;
+  u32 UploadBatchVertices(const BatchVertex* vertices, u32 num_vertices) override;
 
 private:
   struct GLStats
@@ -59,6 +62,7 @@ private:
   bool CreateVertexBuffer();
   bool CreateUniformBuffer();
   bool CreateTextureBuffer();
+  bool CreateVRAMReadbackBuffer();
 
   bool CompilePrograms();
 
@@ -82,6 +86,10 @@ private:
   std::unique_ptr<GL::StreamBuffer> m_texture_stream_buffer;
   GLuint m_texture_buffer_r16ui_texture = 0;
 
+  // pixel pack buffer which readbacks are copied into, and the fence for when the copy is complete
+  GLuint m_vram_readback_buffer_id = 0;
+  GLsync m_vram_readback_fence = nullptr;
+
   std::array<std::array<std::array<std::array<GL::Program, 2>, 2>, 9>, 4>
     m_render_programs;                                          // [render_mode][texture_mode][dithering][interlacing]
   std::array<std::array<GL::Program, 3>, 2> m_display_programs; // [depth_24][interlaced]
@@ -97,6 +105,7 @@ private:
   bool m_supports_texture_buffer = false;
   bool m_supports_geometry_shaders = false;
   bool m_use_ssbo_for_vram_writes = false;
+  bool m_supports_async_vram_readback = false;
 
   bool m_current_check_mask_before_draw = false;
   GPUTransparencyMode m_current_transparency_mode = GPUTransparencyMode::Disabled;
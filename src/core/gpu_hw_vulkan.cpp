@@ -1,6 +1,7 @@
 #include "gpu_hw_vulkan.h"
 #include "common/assert.h"
 #include "common/log.h"
+#include "common/parallel_for.h"
 #include "common/scope_guard.h"
 #include "common/timer.h"
 #include "common/vulkan/builders.h"
@@ -10,6 +11,7 @@
 #include "gpu_hw_shadergen.h"
 #include "host_display.h"
 #include "host_interface.h"
+#include "host_interface_progress_callback.h"
 #include "system.h"
 Log_SetChannel(GPU_HW_Vulkan);
 
@@ -600,18 +602,9 @@ bool GPU_HW_Vulkan::CompilePipelines()
                              m_supports_dual_source_blend);
 
   Common::Timer compile_time;
-  const int progress_total = 2 + (4 * 9 * 2 * 2) + (2 * 4 * 5 * 9 * 2 * 2) + 1 + 2 + 2 + 2 + 2 + (2 * 3);
-  int progress_value = 0;
-#define UPDATE_PROGRESS()                                                                                              \
-  do                                                                                                                   \
-  {                                                                                                                    \
-    progress_value++;                                                                                                  \
-    if (compile_time.GetTimeSeconds() >= 1.0f)                                                                         \
-    {                                                                                                                  \
-      compile_time.Reset();                                                                                            \
-      g_host_interface->DisplayLoadingScreen("Compiling Shaders", 0, progress_total, progress_value);                  \
-    }                                                                                                                  \
-  } while (0)
+  HostInterfaceProgressCallback progress(1.0f);
+  progress.SetStatusText("Compiling Shaders");
+  progress.SetProgressRange(2 + (4 * 9 * 2 * 2) + (2 * 4 * 5 * 9 * 2 * 2) + 1 + 2 + 2 + 2 + 2 + (2 * 3));
 
   // vertex shaders - [textured]
   // fragment shaders - [render_mode][texture_mode][dithering][interlacing]
@@ -622,15 +615,22 @@ bool GPU_HW_Vulkan::CompilePipelines()
     batch_fragment_shaders.enumerate(Vulkan::Util::SafeDestroyShaderModule);
   });
 
-  for (u8 textured = 0; textured < 2; textured++)
+  // The batch shaders and pipelines are nearly all of the work, so they're compiled on all cores. The sources are
+  // generated up front on this thread.
+  struct BatchShader
   {
-    const std::string vs = shadergen.GenerateBatchVertexShader(ConvertToBoolUnchecked(textured));
-    VkShaderModule shader = g_vulkan_shader_cache->GetVertexShader(vs);
-    if (shader == VK_NULL_HANDLE)
-      return false;
+    Vulkan::ShaderCompiler::Type type;
+    std::string source;
+    VkShaderModule* module;
+  };
+  std::vector<BatchShader> batch_shaders;
+  batch_shaders.reserve(2 + (4 * 9 * 2 * 2));
 
-    batch_vertex_shaders[textured] = shader;
-    UPDATE_PROGRESS();
+  for (u8 textured = 0; textured < 2; textured++)
+  {
+    batch_shaders.push_back({Vulkan::ShaderCompiler::Type::Vertex,
+                             shadergen.GenerateBatchVertexShader(ConvertToBoolUnchecked(textured)),
+                             &batch_vertex_shaders[textured]});
   }
 
   for (u8 render_mode = 0; render_mode < 4; render_mode++)
@@ -641,102 +641,102 @@ bool GPU_HW_Vulkan::CompilePipelines()
       {
         for (u8 interlacing = 0; interlacing < 2; interlacing++)
         {
-          const std::string fs = shadergen.GenerateBatchFragmentShader(
-            static_cast<BatchRenderMode>(render_mode), static_cast<GPUTextureMode>(texture_mode),
-            ConvertToBoolUnchecked(dithering), ConvertToBoolUnchecked(interlacing));
-
-          VkShaderModule shader = g_vulkan_shader_cache->GetFragmentShader(fs);
-          if (shader == VK_NULL_HANDLE)
-            return false;
-
-          batch_fragment_shaders[render_mode][texture_mode][dithering][interlacing] = shader;
-          UPDATE_PROGRESS();
+          batch_shaders.push_back({Vulkan::ShaderCompiler::Type::Fragment,
+                                   shadergen.GenerateBatchFragmentShader(
+                                     static_cast<BatchRenderMode>(render_mode), static_cast<GPUTextureMode>(texture_mode),
+                                     ConvertToBoolUnchecked(dithering), ConvertToBoolUnchecked(interlacing)),
+                                   &batch_fragment_shaders[render_mode][texture_mode][dithering][interlacing]});
         }
       }
     }
   }
 
-  Vulkan::GraphicsPipelineBuilder gpbuilder;
+  const u32 num_workers = Common::GetParallelWorkerCount();
+  if (!Common::ParallelFor(
+        static_cast<u32>(batch_shaders.size()),
+        [&batch_shaders](u32 index) {
+          BatchShader& bs = batch_shaders[index];
+          *bs.module = g_vulkan_shader_cache->GetShaderModule(bs.type, bs.source);
+          return (*bs.module != VK_NULL_HANDLE);
+        },
+        &progress, num_workers))
+  {
+    return false;
+  }
 
   // [depth_test][render_mode][texture_mode][transparency_mode][dithering][interlacing]
-  for (u8 depth_test = 0; depth_test < 2; depth_test++)
-  {
-    for (u8 render_mode = 0; render_mode < 4; render_mode++)
-    {
-      for (u8 transparency_mode = 0; transparency_mode < 5; transparency_mode++)
+  const bool batch_pipelines_created = Common::ParallelFor(
+    2 * 4 * 5 * 9 * 2 * 2,
+    [this, device, pipeline_cache, &batch_vertex_shaders, &batch_fragment_shaders](u32 index) {
+      const u8 interlacing = static_cast<u8>(index % 2);
+      const u8 dithering = static_cast<u8>((index / 2) % 2);
+      const u8 texture_mode = static_cast<u8>((index / (2 * 2)) % 9);
+      const u8 transparency_mode = static_cast<u8>((index / (2 * 2 * 9)) % 5);
+      const u8 render_mode = static_cast<u8>((index / (2 * 2 * 9 * 5)) % 4);
+      const u8 depth_test = static_cast<u8>(index / (2 * 2 * 9 * 5 * 4));
+      const bool textured = (static_cast<GPUTextureMode>(texture_mode) != GPUTextureMode::Disabled);
+
+      Vulkan::GraphicsPipelineBuilder gpbuilder;
+      gpbuilder.SetPipelineLayout(m_batch_pipeline_layout);
+      gpbuilder.SetRenderPass(m_vram_render_pass, 0);
+
+      gpbuilder.AddVertexBuffer(0, sizeof(BatchVertex), VK_VERTEX_INPUT_RATE_VERTEX);
+      gpbuilder.AddVertexAttribute(0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(BatchVertex, x));
+      gpbuilder.AddVertexAttribute(1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(BatchVertex, color));
+      if (textured)
       {
-        for (u8 texture_mode = 0; texture_mode < 9; texture_mode++)
-        {
-          for (u8 dithering = 0; dithering < 2; dithering++)
-          {
-            for (u8 interlacing = 0; interlacing < 2; interlacing++)
-            {
-              const bool textured = (static_cast<GPUTextureMode>(texture_mode) != GPUTextureMode::Disabled);
-
-              gpbuilder.SetPipelineLayout(m_batch_pipeline_layout);
-              gpbuilder.SetRenderPass(m_vram_render_pass, 0);
-
-              gpbuilder.AddVertexBuffer(0, sizeof(BatchVertex), VK_VERTEX_INPUT_RATE_VERTEX);
-              gpbuilder.AddVertexAttribute(0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(BatchVertex, x));
-              gpbuilder.AddVertexAttribute(1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(BatchVertex, color));
-              if (textured)
-              {
-                gpbuilder.AddVertexAttribute(2, 0, VK_FORMAT_R32_UINT, offsetof(BatchVertex, u));
-                gpbuilder.AddVertexAttribute(3, 0, VK_FORMAT_R32_UINT, offsetof(BatchVertex, texpage));
-                if (m_using_uv_limits)
-                  gpbuilder.AddVertexAttribute(4, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(BatchVertex, uv_limits));
-              }
-
-              gpbuilder.SetPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
-              gpbuilder.SetVertexShader(batch_vertex_shaders[BoolToUInt8(textured)]);
-              gpbuilder.SetFragmentShader(batch_fragment_shaders[render_mode][texture_mode][dithering][interlacing]);
-
-              gpbuilder.SetRasterizationState(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE);
-              gpbuilder.SetDepthState(true, true,
-                                      (depth_test != 0) ? VK_COMPARE_OP_GREATER_OR_EQUAL : VK_COMPARE_OP_ALWAYS);
-              gpbuilder.SetNoBlendingState();
-              gpbuilder.SetMultisamples(m_multisamples, m_per_sample_shading);
-
-              if ((static_cast<GPUTransparencyMode>(transparency_mode) != GPUTransparencyMode::Disabled &&
-                   (static_cast<BatchRenderMode>(render_mode) != BatchRenderMode::TransparencyDisabled &&
-                    static_cast<BatchRenderMode>(render_mode) != BatchRenderMode::OnlyOpaque)) ||
-                  m_texture_filtering != GPUTextureFilter::Nearest)
-              {
-                gpbuilder.SetBlendAttachment(
-                  0, true, VK_BLEND_FACTOR_ONE,
-                  m_supports_dual_source_blend ? VK_BLEND_FACTOR_SRC1_ALPHA : VK_BLEND_FACTOR_SRC_ALPHA,
-                  (static_cast<GPUTransparencyMode>(transparency_mode) == GPUTransparencyMode::BackgroundMinusForeground &&
-                   static_cast<BatchRenderMode>(render_mode) != BatchRenderMode::TransparencyDisabled &&
-                   static_cast<BatchRenderMode>(render_mode) != BatchRenderMode::OnlyOpaque) ?
-                    VK_BLEND_OP_REVERSE_SUBTRACT :
-                    VK_BLEND_OP_ADD,
-                  VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD);
-              }
-
-              gpbuilder.SetDynamicViewportAndScissorState();
-
-              VkPipeline pipeline = gpbuilder.Create(device, pipeline_cache);
-              if (pipeline == VK_NULL_HANDLE)
-                return false;
-
-              m_batch_pipelines[depth_test][render_mode][texture_mode][transparency_mode][dithering][interlacing] =
-                pipeline;
-              UPDATE_PROGRESS();
-            }
-          }
-        }
+        gpbuilder.AddVertexAttribute(2, 0, VK_FORMAT_R32_UINT, offsetof(BatchVertex, u));
+        gpbuilder.AddVertexAttribute(3, 0, VK_FORMAT_R32_UINT, offsetof(BatchVertex, texpage));
+        if (m_using_uv_limits)
+          gpbuilder.AddVertexAttribute(4, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(BatchVertex, uv_limits));
+      }
+
+      gpbuilder.SetPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+      gpbuilder.SetVertexShader(batch_vertex_shaders[BoolToUInt8(textured)]);
+      gpbuilder.SetFragmentShader(batch_fragment_shaders[render_mode][texture_mode][dithering][interlacing]);
+
+      gpbuilder.SetRasterizationState(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE);
+      gpbuilder.SetDepthState(true, true, (depth_test != 0) ? VK_COMPARE_OP_GREATER_OR_EQUAL : VK_COMPARE_OP_ALWAYS);
+      gpbuilder.SetNoBlendingState();
+      gpbuilder.SetMultisamples(m_multisamples, m_per_sample_shading);
+
+      if ((static_cast<GPUTransparencyMode>(transparency_mode) != GPUTransparencyMode::Disabled &&
+           (static_cast<BatchRenderMode>(render_mode) != BatchRenderMode::TransparencyDisabled &&
+            static_cast<BatchRenderMode>(render_mode) != BatchRenderMode::OnlyOpaque)) ||
+          m_texture_filtering != GPUTextureFilter::Nearest)
+      {
+        gpbuilder.SetBlendAttachment(
+          0, true, VK_BLEND_FACTOR_ONE,
+          m_supports_dual_source_blend ? VK_BLEND_FACTOR_SRC1_ALPHA : VK_BLEND_FACTOR_SRC_ALPHA,
+          (static_cast<GPUTransparencyMode>(transparency_mode) == GPUTransparencyMode::BackgroundMinusForeground &&
+           static_cast<BatchRenderMode>(render_mode) != BatchRenderMode::TransparencyDisabled &&
+           static_cast<BatchRenderMode>(render_mode) != BatchRenderMode::OnlyOpaque) ?
+            VK_BLEND_OP_REVERSE_SUBTRACT :
+            VK_BLEND_OP_ADD,
+          VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD);
       }
-    }
-  }
+
+      gpbuilder.SetDynamicViewportAndScissorState();
+
+      // pipeline caches are internally synchronized, so they can be shared between threads
+      VkPipeline pipeline = gpbuilder.Create(device, pipeline_cache);
+      m_batch_pipelines[depth_test][render_mode][texture_mode][transparency_mode][dithering][interlacing] = pipeline;
+      return (pipeline != VK_NULL_HANDLE);
+    },
+    &progress, num_workers);
+  if (!batch_pipelines_created)
+    return false;
 
   batch_shader_guard.Exit();
 
+  Vulkan::GraphicsPipelineBuilder gpbuilder;
+
   VkShaderModule fullscreen_quad_vertex_shader =
     g_vulkan_shader_cache->GetVertexShader(shadergen.GenerateScreenQuadVertexShader());
   if (fullscreen_quad_vertex_shader == VK_NULL_HANDLE)
     return false;
 
-  UPDATE_PROGRESS();
+  progress.IncrementProgressValue();
 
   Common::ScopeGuard fullscreen_quad_vertex_shader_guard([&fullscreen_quad_vertex_shader]() {
     vkDestroyShaderModule(g_vulkan_context->GetDevice(), fullscreen_quad_vertex_shader, nullptr);
@@ -770,7 +770,7 @@ bool GPU_HW_Vulkan::CompilePipelines()
       if (m_vram_fill_pipelines[interlaced] == VK_NULL_HANDLE)
         return false;
 
-      UPDATE_PROGRESS();
+      progress.IncrementProgressValue();
     }
   }
 
@@ -794,7 +794,7 @@ bool GPU_HW_Vulkan::CompilePipelines()
         return false;
       }
 
-      UPDATE_PROGRESS();
+      progress.IncrementProgressValue();
     }
 
     vkDestroyShaderModule(device, fs, nullptr);
@@ -819,7 +819,7 @@ bool GPU_HW_Vulkan::CompilePipelines()
         return false;
       }
 
-      UPDATE_PROGRESS();
+      progress.IncrementProgressValue();
     }
 
     vkDestroyShaderModule(device, fs, nullptr);
@@ -843,7 +843,7 @@ bool GPU_HW_Vulkan::CompilePipelines()
     if (m_vram_update_depth_pipeline == VK_NULL_HANDLE)
       return false;
 
-    UPDATE_PROGRESS();
+    progress.IncrementProgressValue();
   }
 
   gpbuilder.Clear();
@@ -868,7 +868,7 @@ bool GPU_HW_Vulkan::CompilePipelines()
     if (m_vram_readback_pipeline == VK_NULL_HANDLE)
       return false;
 
-    UPDATE_PROGRESS();
+    progress.IncrementProgressValue();
   }
 
   gpbuilder.Clear();
@@ -899,13 +899,15 @@ bool GPU_HW_Vulkan::CompilePipelines()
         if (m_display_pipelines[depth_24][interlace_mode] == VK_NULL_HANDLE)
           return false;
 
-        UPDATE_PROGRESS();
+        progress.IncrementProgressValue();
       }
     }
   }
 
-#undef UPDATE_PROGRESS
+  // save the new pipelines now rather than at shutdown, in case we don't get there
+  g_vulkan_shader_cache->FlushPipelineCache();
 
+  Log_InfoPrintf("Compiled pipelines in %.2f ms using %u threads", compile_time.GetTimeMilliseconds(), num_workers);
   return true;
 }
 
@@ -928,7 +930,8 @@ void GPU_HW_Vulkan::DestroyPipelines()
   m_display_pipelines.enumerate(Vulkan::Util::SafeDestroyPipeline);
 }
 
-void GPU_HW_Vulkan::DrawBatchVertices(BatchRenderMode render_mode, u32 base_vertex, u32 num_vertices)
+void GPU_HW_Vulkan::DrawBatchVertices(const BatchConfig& batch, BatchRenderMode render_mode, u32 base_vertex,
+                                      u32 num_vertices)
 {
   BeginVRAMRenderPass();
 
@@ -936,9 +939,9 @@ void GPU_HW_Vulkan::DrawBatchVertices(BatchRenderMode render_mode, u32 base_vert
 
   // [primitive][depth_test][render_mode][texture_mode][transparency_mode][dithering][interlacing]
   VkPipeline pipeline =
-    m_batch_pipelines[BoolToUInt8(m_batch.check_mask_before_draw)][static_cast<u8>(render_mode)]
-                     [static_cast<u8>(m_batch.texture_mode)][static_cast<u8>(m_batch.transparency_mode)]
-                     [BoolToUInt8(m_batch.dithering)][BoolToUInt8(m_batch.interlacing)];
+    m_batch_pipelines[BoolToUInt8(batch.check_mask_before_draw)][static_cast<u8>(render_mode)]
+                     [static_cast<u8>(batch.texture_mode)][static_cast<u8>(batch.transparency_mode)]
+                     [BoolToUInt8(batch.dithering)][BoolToUInt8(batch.interlacing)];
 
   vkCmdBindPipeline(cmdbuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
   vkCmdDraw(cmdbuf, num_vertices, 1, base_vertex, 0);
@@ -1062,8 +1065,11 @@ void GPU_HW_Vulkan::UpdateDisplay()
   }
 }
 
-void GPU_HW_Vulkan::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
+void GPU_HW_Vulkan::BeginVRAMRead(u32 x, u32 y, u32 width, u32 height)
 {
+  // There's only one staging texture, so any previous readback has to finish first.
+  FlushVRAMRead();
+
   // Get bounds with wrap-around handled.
   const Common::Rectangle<u32> copy_rect = GetVRAMTransferBounds(x, y, width, height);
   const u32 encoded_width = (copy_rect.GetWidth() + 1) / 2;
@@ -1099,14 +1105,23 @@ void GPU_HW_Vulkan::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
   m_vram_readback_staging_texture.CopyFromTexture(m_vram_readback_texture, 0, 0, 0, 0, 0, 0, encoded_width,
                                                   encoded_height);
 
-  // And copy it into our shadow buffer (will execute command buffer and stall).
-  m_vram_readback_staging_texture.ReadTexels(0, 0, encoded_width, encoded_height,
-                                             &m_vram_shadow[copy_rect.top * VRAM_WIDTH + copy_rect.left],
-                                             VRAM_WIDTH * sizeof(u16));
+  // Submit the copy now, but only wait for it when the data is needed.
+  g_vulkan_context->ExecuteCommandBuffer(false);
+  m_pending_vram_read_rect = copy_rect;
+  m_vram_read_pending = true;
 
   RestoreGraphicsAPIState();
 }
 
+void GPU_HW_Vulkan::CompleteVRAMRead()
+{
+  // And copy it into our shadow buffer (will wait for the command buffer's fence).
+  const Common::Rectangle<u32>& copy_rect = m_pending_vram_read_rect;
+  m_vram_readback_staging_texture.ReadTexels(0, 0, (copy_rect.GetWidth() + 1) / 2, copy_rect.GetHeight(),
+                                             &m_vram_shadow[copy_rect.top * VRAM_WIDTH + copy_rect.left],
+                                             VRAM_WIDTH * sizeof(u16));
+}
+
 void GPU_HW_Vulkan::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 {
   if ((x + width) > VRAM_WIDTH || (y + height) > VRAM_HEIGHT)
@@ -1190,8 +1205,7 @@ void GPU_HW_Vulkan::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wid
   {
     const Common::Rectangle<u32> src_bounds = GetVRAMTransferBounds(src_x, src_y, width, height);
     const Common::Rectangle<u32> dst_bounds = GetVRAMTransferBounds(dst_x, dst_y, width, height);
-    if (m_vram_dirty_rect.Intersects(src_bounds))
-      UpdateVRAMReadTexture();
+    UpdateVRAMReadTexture(src_bounds);
     IncludeVRAMDityRectangle(dst_bounds);
 
     const VRAMCopyUBOData uniforms(GetVRAMCopyUBOData(src_x, src_y, dst_x, dst_y, width, height));
@@ -1243,7 +1257,7 @@ void GPU_HW_Vulkan::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wid
   m_vram_texture.TransitionToLayout(cmdbuf, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 }
 
-void GPU_HW_Vulkan::UpdateVRAMReadTexture()
+void GPU_HW_Vulkan::CopyToVRAMReadTexture(const Common::Rectangle<u32>* rects, u32 num_rects)
 {
   EndRenderPass();
 
@@ -1251,34 +1265,41 @@ void GPU_HW_Vulkan::UpdateVRAMReadTexture()
   m_vram_texture.TransitionToLayout(cmdbuf, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
   m_vram_read_texture.TransitionToLayout(cmdbuf, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-  const auto scaled_rect = m_vram_dirty_rect * m_resolution_scale;
-
   if (m_vram_texture.GetSamples() > VK_SAMPLE_COUNT_1_BIT)
   {
-    const VkImageResolve resolve{{VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u},
-                                 {static_cast<s32>(scaled_rect.left), static_cast<s32>(scaled_rect.top), 0},
-                                 {VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u},
-                                 {static_cast<s32>(scaled_rect.left), static_cast<s32>(scaled_rect.top), 0},
-                                 {scaled_rect.GetWidth(), scaled_rect.GetHeight(), 1u}};
+    std::array<VkImageResolve, MAX_VRAM_READ_TEXTURE_COPIES> resolves;
+    for (u32 i = 0; i < num_rects; i++)
+    {
+      const auto scaled_rect = rects[i] * m_resolution_scale;
+      resolves[i] = {{VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u},
+                     {static_cast<s32>(scaled_rect.left), static_cast<s32>(scaled_rect.top), 0},
+                     {VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u},
+                     {static_cast<s32>(scaled_rect.left), static_cast<s32>(scaled_rect.top), 0},
+                     {scaled_rect.GetWidth(), scaled_rect.GetHeight(), 1u}};
+    }
+
     vkCmdResolveImage(cmdbuf, m_vram_texture.GetImage(), m_vram_texture.GetLayout(), m_vram_read_texture.GetImage(),
-                      m_vram_read_texture.GetLayout(), 1, &resolve);
+                      m_vram_read_texture.GetLayout(), num_rects, resolves.data());
   }
   else
   {
-    const VkImageCopy copy{{VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u},
-                           {static_cast<s32>(scaled_rect.left), static_cast<s32>(scaled_rect.top), 0},
-                           {VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u},
-                           {static_cast<s32>(scaled_rect.left), static_cast<s32>(scaled_rect.top), 0},
-                           {scaled_rect.GetWidth(), scaled_rect.GetHeight(), 1u}};
+    std::array<VkImageCopy, MAX_VRAM_READ_TEXTURE_COPIES> copies;
+    for (u32 i = 0; i < num_rects; i++)
+    {
+      const auto scaled_rect = rects[i] * m_resolution_scale;
+      copies[i] = {{VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u},
+                   {static_cast<s32>(scaled_rect.left), static_cast<s32>(scaled_rect.top), 0},
+                   {VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u},
+                   {static_cast<s32>(scaled_rect.left), static_cast<s32>(scaled_rect.top), 0},
+                   {scaled_rect.GetWidth(), scaled_rect.GetHeight(), 1u}};
+    }
 
     vkCmdCopyImage(cmdbuf, m_vram_texture.GetImage(), m_vram_texture.GetLayout(), m_vram_read_texture.GetImage(),
-                   m_vram_read_texture.GetLayout(), 1u, &copy);
+                   m_vram_read_texture.GetLayout(), num_rects, copies.data());
   }
 
   m_vram_read_texture.TransitionToLayout(cmdbuf, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
   m_vram_texture.TransitionToLayout(cmdbuf, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-
-  GPU_HW::UpdateVRAMReadTexture();
 }
 
 void GPU_HW_Vulkan::UpdateDepthBufferFromMaskBit()
@@ -7,6 +7,9 @@
 #include "host_display.h"
 #include "system.h"
 #include <algorithm>
+#ifdef WITH_IMGUI
+#include "imgui.h"
+#endif
 Log_SetChannel(GPU_SW);
 
 #if defined(CPU_X64)
@@ -80,6 +83,8 @@ void GPU_SW::Reset()
   GPU::Reset();
 
   m_backend.Reset();
+  m_display_output = {};
+  MarkVRAMRowsDirty(0, VRAM_HEIGHT);
 }
 
 void GPU_SW::UpdateSettings()
@@ -231,127 +236,103 @@ ALWAYS_INLINE void CopyOutRow16<HostDisplayPixelFormat::BGRA8, u32>(const u16* s
 }
 
 template<HostDisplayPixelFormat display_format>
-void GPU_SW::CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved)
+u32 GPU_SW::CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved,
+                         bool dirty_rows_only)
 {
-  u8* dst_ptr;
-  u32 dst_stride;
-
   using OutputPixelType = std::conditional_t<
     display_format == HostDisplayPixelFormat::RGBA8 || display_format == HostDisplayPixelFormat::BGRA8, u32, u16>;
 
-  if (!interlaced)
-  {
-    if (!m_host_display->BeginSetDisplayPixels(display_format, width, height, reinterpret_cast<void**>(&dst_ptr),
-                                               &dst_stride))
-    {
-      return;
-    }
-  }
-  else
-  {
-    dst_stride = Common::AlignUpPow2<u32>(width * sizeof(OutputPixelType), 4);
-    dst_ptr = m_display_texture_buffer.data() + (field != 0 ? dst_stride : 0);
-  }
+  const u32 output_stride = Common::AlignUpPow2<u32>(width * sizeof(OutputPixelType), 4);
+  u8* dst_ptr = m_display_texture_buffer.data() + (field != 0 ? output_stride : 0);
 
-  const u32 output_stride = dst_stride;
   const u8 interlaced_shift = BoolToUInt8(interlaced);
   const u8 interleaved_shift = BoolToUInt8(interleaved);
+  const u32 rows = height >> interlaced_shift;
+  const u32 dst_stride = output_stride << interlaced_shift;
+  u32 rows_converted = 0;
 
   // Fast path when not wrapping around.
   if ((src_x + width) <= VRAM_WIDTH && (src_y + height) <= VRAM_HEIGHT)
   {
-    const u32 rows = height >> interlaced_shift;
-    dst_stride <<= interlaced_shift;
-
     const u16* src_ptr = &m_vram_ptr[src_y * VRAM_WIDTH + src_x];
     const u32 src_step = VRAM_WIDTH << interleaved_shift;
     for (u32 row = 0; row < rows; row++)
     {
-      CopyOutRow16<display_format>(src_ptr, reinterpret_cast<OutputPixelType*>(dst_ptr), width);
+      if (!dirty_rows_only || IsVRAMRowDirty(src_y + (row << interleaved_shift)))
+      {
+        CopyOutRow16<display_format>(src_ptr, reinterpret_cast<OutputPixelType*>(dst_ptr), width);
+        rows_converted++;
+      }
+
       src_ptr += src_step;
       dst_ptr += dst_stride;
     }
   }
   else
   {
-    const u32 rows = height >> interlaced_shift;
-    dst_stride <<= interlaced_shift;
-
     const u32 end_x = src_x + width;
     for (u32 row = 0; row < rows; row++)
     {
-      const u16* src_row_ptr = &m_vram_ptr[(src_y % VRAM_HEIGHT) * VRAM_WIDTH];
-      OutputPixelType* dst_row_ptr = reinterpret_cast<OutputPixelType*>(dst_ptr);
+      const u32 vram_row = src_y % VRAM_HEIGHT;
+      if (!dirty_rows_only || IsVRAMRowDirty(vram_row))
+      {
+        const u16* src_row_ptr = &m_vram_ptr[vram_row * VRAM_WIDTH];
+        OutputPixelType* dst_row_ptr = reinterpret_cast<OutputPixelType*>(dst_ptr);
+
+        for (u32 col = src_x; col < end_x; col++)
+          *(dst_row_ptr++) = VRAM16ToOutput<display_format, OutputPixelType>(src_row_ptr[col % VRAM_WIDTH]);
 
-      for (u32 col = src_x; col < end_x; col++)
-        *(dst_row_ptr++) = VRAM16ToOutput<display_format, OutputPixelType>(src_row_ptr[col % VRAM_WIDTH]);
+        rows_converted++;
+      }
 
       src_y += (1 << interleaved_shift);
       dst_ptr += dst_stride;
     }
   }
 
-  if (!interlaced)
-  {
-    m_host_display->EndSetDisplayPixels();
-  }
-  else
-  {
+  if (rows_converted > 0 || !dirty_rows_only)
     m_host_display->SetDisplayPixels(display_format, width, height, m_display_texture_buffer.data(), output_stride);
-  }
+
+  return rows_converted * width * static_cast<u32>(sizeof(OutputPixelType));
 }
 
-void GPU_SW::CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
-                          bool interlaced, bool interleaved)
+u32 GPU_SW::CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
+                         bool interlaced, bool interleaved, bool dirty_rows_only)
 {
   switch (display_format)
   {
     case HostDisplayPixelFormat::RGBA5551:
-      CopyOut15Bit<HostDisplayPixelFormat::RGBA5551>(src_x, src_y, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut15Bit<HostDisplayPixelFormat::RGBA5551>(src_x, src_y, width, height, field, interlaced, interleaved,
+                                                            dirty_rows_only);
     case HostDisplayPixelFormat::RGB565:
-      CopyOut15Bit<HostDisplayPixelFormat::RGB565>(src_x, src_y, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut15Bit<HostDisplayPixelFormat::RGB565>(src_x, src_y, width, height, field, interlaced, interleaved,
+                                                          dirty_rows_only);
     case HostDisplayPixelFormat::RGBA8:
-      CopyOut15Bit<HostDisplayPixelFormat::RGBA8>(src_x, src_y, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut15Bit<HostDisplayPixelFormat::RGBA8>(src_x, src_y, width, height, field, interlaced, interleaved,
+                                                         dirty_rows_only);
     case HostDisplayPixelFormat::BGRA8:
-      CopyOut15Bit<HostDisplayPixelFormat::BGRA8>(src_x, src_y, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut15Bit<HostDisplayPixelFormat::BGRA8>(src_x, src_y, width, height, field, interlaced, interleaved,
+                                                         dirty_rows_only);
     default:
-      break;
+      return 0;
   }
 }
 
 template<HostDisplayPixelFormat display_format>
-void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u32 field, bool interlaced,
-                          bool interleaved)
+u32 GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u32 field, bool interlaced,
+                         bool interleaved, bool dirty_rows_only)
 {
-  u8* dst_ptr;
-  u32 dst_stride;
-
   using OutputPixelType = std::conditional_t<
     display_format == HostDisplayPixelFormat::RGBA8 || display_format == HostDisplayPixelFormat::BGRA8, u32, u16>;
 
-  if (!interlaced)
-  {
-    if (!m_host_display->BeginSetDisplayPixels(display_format, width, height, reinterpret_cast<void**>(&dst_ptr),
-                                               &dst_stride))
-    {
-      return;
-    }
-  }
-  else
-  {
-    dst_stride = Common::AlignUpPow2<u32>(width * sizeof(OutputPixelType), 4);
-    dst_ptr = m_display_texture_buffer.data() + (field != 0 ? dst_stride : 0);
-  }
+  const u32 output_stride = Common::AlignUpPow2<u32>(width * sizeof(OutputPixelType), 4);
+  u8* dst_ptr = m_display_texture_buffer.data() + (field != 0 ? output_stride : 0);
 
-  const u32 output_stride = dst_stride;
   const u8 interlaced_shift = BoolToUInt8(interlaced);
   const u8 interleaved_shift = BoolToUInt8(interleaved);
   const u32 rows = height >> interlaced_shift;
-  dst_stride <<= interlaced_shift;
+  const u32 dst_stride = output_stride << interlaced_shift;
+  u32 rows_converted = 0;
 
   if ((src_x + width) <= VRAM_WIDTH && (src_y + (rows << interleaved_shift)) <= VRAM_HEIGHT)
   {
@@ -359,6 +340,14 @@ void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 heigh
     const u32 src_stride = (VRAM_WIDTH << interleaved_shift) * sizeof(u16);
     for (u32 row = 0; row < rows; row++)
     {
+      if (dirty_rows_only && !IsVRAMRowDirty(src_y + (row << interleaved_shift)))
+      {
+        src_ptr += src_stride;
+        dst_ptr += dst_stride;
+        continue;
+      }
+
+      rows_converted++;
       if constexpr (display_format == HostDisplayPixelFormat::RGBA8)
       {
         const u8* src_row_ptr = src_ptr;
@@ -415,7 +404,16 @@ void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 heigh
   {
     for (u32 row = 0; row < rows; row++)
     {
-      const u16* src_row_ptr = &m_vram_ptr[(src_y % VRAM_HEIGHT) * VRAM_WIDTH];
+      const u32 vram_row = src_y % VRAM_HEIGHT;
+      if (dirty_rows_only && !IsVRAMRowDirty(vram_row))
+      {
+        src_y += (1 << interleaved_shift);
+        dst_ptr += dst_stride;
+        continue;
+      }
+
+      rows_converted++;
+      const u16* src_row_ptr = &m_vram_ptr[vram_row * VRAM_WIDTH];
       OutputPixelType* dst_row_ptr = reinterpret_cast<OutputPixelType*>(dst_ptr);
 
       for (u32 col = 0; col < width; col++)
@@ -449,42 +447,87 @@ void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 heigh
     }
   }
 
-  if (!interlaced)
-  {
-    m_host_display->EndSetDisplayPixels();
-  }
-  else
-  {
+  if (rows_converted > 0 || !dirty_rows_only)
     m_host_display->SetDisplayPixels(display_format, width, height, m_display_texture_buffer.data(), output_stride);
-  }
+
+  return rows_converted * width * static_cast<u32>(sizeof(OutputPixelType));
 }
 
-void GPU_SW::CopyOut24Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 skip_x, u32 width,
-                          u32 height, u32 field, bool interlaced, bool interleaved)
+u32 GPU_SW::CopyOut24Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 skip_x, u32 width,
+                         u32 height, u32 field, bool interlaced, bool interleaved, bool dirty_rows_only)
 {
   switch (display_format)
   {
     case HostDisplayPixelFormat::RGBA5551:
-      CopyOut24Bit<HostDisplayPixelFormat::RGBA5551>(src_x, src_y, skip_x, width, height, field, interlaced,
-                                                     interleaved);
-      break;
+      return CopyOut24Bit<HostDisplayPixelFormat::RGBA5551>(src_x, src_y, skip_x, width, height, field, interlaced,
+                                                            interleaved, dirty_rows_only);
     case HostDisplayPixelFormat::RGB565:
-      CopyOut24Bit<HostDisplayPixelFormat::RGB565>(src_x, src_y, skip_x, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut24Bit<HostDisplayPixelFormat::RGB565>(src_x, src_y, skip_x, width, height, field, interlaced,
+                                                          interleaved, dirty_rows_only);
     case HostDisplayPixelFormat::RGBA8:
-      CopyOut24Bit<HostDisplayPixelFormat::RGBA8>(src_x, src_y, skip_x, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut24Bit<HostDisplayPixelFormat::RGBA8>(src_x, src_y, skip_x, width, height, field, interlaced,
+                                                         interleaved, dirty_rows_only);
     case HostDisplayPixelFormat::BGRA8:
-      CopyOut24Bit<HostDisplayPixelFormat::BGRA8>(src_x, src_y, skip_x, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut24Bit<HostDisplayPixelFormat::BGRA8>(src_x, src_y, skip_x, width, height, field, interlaced,
+                                                         interleaved, dirty_rows_only);
     default:
-      break;
+      return 0;
   }
 }
 
+void GPU_SW::DrawRendererStats(bool is_idle_frame)
+{
+  if (!is_idle_frame)
+  {
+    m_band_thread_utilization = m_backend.GetBandThreadUtilization();
+    m_last_texture_cache_stats = m_backend.GetTextureCacheStats();
+  }
+
+#ifdef WITH_IMGUI
+  if (ImGui::CollapsingHeader("Renderer Statistics", ImGuiTreeNodeFlags_DefaultOpen))
+  {
+    const auto& stats = m_last_texture_cache_stats;
+
+    ImGui::Columns(2);
+    ImGui::SetColumnWidth(0, 200.0f * ImGui::GetIO().DisplayFramebufferScale.x);
+
+    ImGui::TextUnformatted("Display Bytes Converted:");
+    ImGui::NextColumn();
+    ImGui::Text("%u", m_display_bytes_converted);
+    ImGui::NextColumn();
+
+    ImGui::TextUnformatted("Texture Cache Hits/Misses:");
+    ImGui::NextColumn();
+    ImGui::Text("%u / %u", stats.hits, stats.misses);
+    ImGui::NextColumn();
+
+    ImGui::TextUnformatted("Texture Cache Invalidations:");
+    ImGui::NextColumn();
+    ImGui::Text("%u", stats.invalidations);
+    ImGui::NextColumn();
+
+    ImGui::TextUnformatted("Texture Cache Decoded Rows:");
+    ImGui::NextColumn();
+    ImGui::Text("%u", stats.decoded_rows);
+    ImGui::NextColumn();
+
+    for (size_t i = 0; i < m_band_thread_utilization.size(); i++)
+    {
+      ImGui::Text("Band Thread %zu:", i);
+      ImGui::NextColumn();
+      ImGui::Text("%.1f%%", m_band_thread_utilization[i] * 100.0f);
+      ImGui::NextColumn();
+    }
+
+    ImGui::Columns(1);
+  }
+#endif
+}
+
 void GPU_SW::ClearDisplay()
 {
   std::memset(m_display_texture_buffer.data(), 0, m_display_texture_buffer.size());
+  m_display_output = {};
 }
 
 void GPU_SW::UpdateDisplay()
@@ -492,11 +535,15 @@ void GPU_SW::UpdateDisplay()
   // fill display texture
   m_backend.Sync();
 
+  u32 bytes_converted = 0;
   if (!g_settings.debugging.show_vram)
   {
     if (IsDisplayDisabled())
     {
       m_host_display->ClearDisplayTexture();
+      m_display_output = {};
+      m_display_bytes_converted = 0;
+      ClearVRAMDirtyRows();
       return;
     }
 
@@ -506,32 +553,47 @@ void GPU_SW::UpdateDisplay()
 
     if (IsInterlacedDisplayEnabled())
     {
+      // The buffer holds both fields, and each field is only updated every other frame, so the dirty rows can't be
+      // used here.
       const u32 field = GetInterlacedDisplayField();
       if (m_GPUSTAT.display_area_color_depth_24)
       {
-        CopyOut24Bit(m_24bit_display_format, m_crtc_state.regs.X, vram_offset_y + field,
-                     m_crtc_state.display_vram_left - m_crtc_state.regs.X, display_width, display_height, field, true,
-                     m_GPUSTAT.vertical_resolution);
+        bytes_converted = CopyOut24Bit(m_24bit_display_format, m_crtc_state.regs.X, vram_offset_y + field,
+                                       m_crtc_state.display_vram_left - m_crtc_state.regs.X, display_width,
+                                       display_height, field, true, m_GPUSTAT.vertical_resolution, false);
       }
       else
       {
-        CopyOut15Bit(m_16bit_display_format, m_crtc_state.display_vram_left, vram_offset_y + field, display_width,
-                     display_height, field, true, m_GPUSTAT.vertical_resolution);
+        bytes_converted = CopyOut15Bit(m_16bit_display_format, m_crtc_state.display_vram_left, vram_offset_y + field,
+                                       display_width, display_height, field, true, m_GPUSTAT.vertical_resolution,
+                                       false);
       }
+
+      m_display_output = {};
     }
     else
     {
-      if (m_GPUSTAT.display_area_color_depth_24)
+      const bool color_depth_24 = m_GPUSTAT.display_area_color_depth_24;
+      const DisplayOutput output = {color_depth_24 ? m_24bit_display_format : m_16bit_display_format,
+                                    color_depth_24 ? m_crtc_state.regs.X : m_crtc_state.display_vram_left,
+                                    vram_offset_y,
+                                    color_depth_24 ? (m_crtc_state.display_vram_left - m_crtc_state.regs.X) : 0u,
+                                    display_width,
+                                    display_height,
+                                    color_depth_24};
+      const bool dirty_rows_only = (output == m_display_output && m_host_display->HasDisplayTexture());
+      if (color_depth_24)
       {
-        CopyOut24Bit(m_24bit_display_format, m_crtc_state.regs.X, vram_offset_y,
-                     m_crtc_state.display_vram_left - m_crtc_state.regs.X, display_width, display_height, 0, false,
-                     false);
+        bytes_converted = CopyOut24Bit(output.format, output.src_x, output.src_y, output.skip_x, output.width,
+                                       output.height, 0, false, false, dirty_rows_only);
       }
       else
       {
-        CopyOut15Bit(m_16bit_display_format, m_crtc_state.display_vram_left, vram_offset_y, display_width,
-                     display_height, 0, false, false);
+        bytes_converted = CopyOut15Bit(output.format, output.src_x, output.src_y, output.width, output.height, 0,
+                                       false, false, dirty_rows_only);
       }
+
+      m_display_output = output;
     }
 
     m_host_display->SetDisplayParameters(m_crtc_state.display_width, m_crtc_state.display_height,
@@ -541,10 +603,53 @@ void GPU_SW::UpdateDisplay()
   }
   else
   {
-    CopyOut15Bit(m_16bit_display_format, 0, 0, VRAM_WIDTH, VRAM_HEIGHT, 0, false, false);
+    const DisplayOutput output = {m_16bit_display_format, 0, 0, 0, VRAM_WIDTH, VRAM_HEIGHT, false};
+    const bool dirty_rows_only = (output == m_display_output && m_host_display->HasDisplayTexture());
+    bytes_converted = CopyOut15Bit(m_16bit_display_format, 0, 0, VRAM_WIDTH, VRAM_HEIGHT, 0, false, false,
+                                   dirty_rows_only);
+    m_display_output = output;
+
     m_host_display->SetDisplayParameters(VRAM_WIDTH, VRAM_HEIGHT, 0, 0, VRAM_WIDTH, VRAM_HEIGHT,
                                          static_cast<float>(VRAM_WIDTH) / static_cast<float>(VRAM_HEIGHT));
   }
+
+  m_display_bytes_converted = bytes_converted;
+  ClearVRAMDirtyRows();
+}
+
+void GPU_SW::MarkVRAMRowsDirty(u32 y, u32 height)
+{
+  if (height >= VRAM_HEIGHT)
+  {
+    m_vram_dirty_rows.fill(~UINT64_C(0));
+    return;
+  }
+
+  // wrap around the bottom of VRAM
+  u32 start = y & VRAM_HEIGHT_MASK;
+  u32 remaining = height;
+  while (remaining > 0)
+  {
+    const u32 bit = start % 64;
+    const u32 count = std::min(std::min(64 - bit, remaining), VRAM_HEIGHT - start);
+    const u64 mask = (count == 64) ? ~UINT64_C(0) : (((UINT64_C(1) << count) - 1) << bit);
+    m_vram_dirty_rows[start / 64] |= mask;
+    start = (start + count) & VRAM_HEIGHT_MASK;
+    remaining -= count;
+  }
+}
+
+void GPU_SW::MarkDrawingAreaRowsDirty(s32 min_y, s32 max_y)
+{
+  const s32 top = std::max(min_y, static_cast<s32>(m_drawing_area.top));
+  const s32 bottom = std::min(max_y, static_cast<s32>(m_drawing_area.bottom));
+  if (top <= bottom)
+    MarkVRAMRowsDirty(static_cast<u32>(top), static_cast<u32>(bottom - top + 1));
+}
+
+void GPU_SW::ClearVRAMDirtyRows()
+{
+  m_vram_dirty_rows.fill(0);
 }
 
 void GPU_SW::FillBackendCommandParameters(GPUBackendCommand* cmd)
@@ -603,6 +708,15 @@ void GPU_SW::DispatchRenderCommand()
       if (!IsDrawingAreaIsValid())
         return;
 
+      s32 dirty_min_y = cmd->vertices[0].y;
+      s32 dirty_max_y = cmd->vertices[0].y;
+      for (u32 i = 1; i < num_vertices; i++)
+      {
+        dirty_min_y = std::min(dirty_min_y, cmd->vertices[i].y);
+        dirty_max_y = std::max(dirty_max_y, cmd->vertices[i].y);
+      }
+      MarkDrawingAreaRowsDirty(dirty_min_y, dirty_max_y);
+
       // Cull polygons which are too large.
       const auto [min_x_12, max_x_12] = MinMax(cmd->vertices[1].x, cmd->vertices[2].x);
       const auto [min_y_12, max_y_12] = MinMax(cmd->vertices[1].y, cmd->vertices[2].y);
@@ -713,6 +827,7 @@ void GPU_SW::DispatchRenderCommand()
 
       // cmd->bounds.Set(Truncate16(clip_left), Truncate16(clip_top), Truncate16(clip_right), Truncate16(clip_bottom));
       AddDrawRectangleTicks(clip_right - clip_left, clip_bottom - clip_top, rc.texture_enable, rc.transparency_enable);
+      MarkVRAMRowsDirty(clip_top, clip_bottom - clip_top);
 
       m_backend.PushCommand(cmd);
     }
@@ -772,6 +887,7 @@ void GPU_SW::DispatchRenderCommand()
         // cmd->bounds.Set(Truncate16(clip_left), Truncate16(clip_top), Truncate16(clip_right),
         // Truncate16(clip_bottom));
         AddDrawLineTicks(clip_right - clip_left, clip_bottom - clip_top, rc.shading_enable);
+        MarkVRAMRowsDirty(clip_top, clip_bottom - clip_top);
 
         m_backend.PushCommand(cmd);
       }
@@ -790,6 +906,8 @@ void GPU_SW::DispatchRenderCommand()
         // cmd->bounds.SetInvalid();
 
         const bool shaded = m_render_command.shading_enable;
+        s32 dirty_min_y = cmd->vertices[0].y;
+        s32 dirty_max_y = cmd->vertices[0].y;
         for (u32 i = 1; i < num_vertices; i++)
         {
           cmd->vertices[i].color =
@@ -797,6 +915,8 @@ void GPU_SW::DispatchRenderCommand()
           const GPUVertexPosition vp{m_blit_buffer[buffer_pos++]};
           cmd->vertices[i].x = m_drawing_offset.x + vp.x;
           cmd->vertices[i].y = m_drawing_offset.y + vp.y;
+          dirty_min_y = std::min(dirty_min_y, cmd->vertices[i].y);
+          dirty_max_y = std::max(dirty_max_y, cmd->vertices[i].y);
 
           const auto [min_x, max_x] = MinMax(cmd->vertices[i - 1].x, cmd->vertices[i].y);
           const auto [min_y, max_y] = MinMax(cmd->vertices[i - 1].x, cmd->vertices[i].y);
@@ -820,6 +940,9 @@ void GPU_SW::DispatchRenderCommand()
           }
         }
 
+        if (IsDrawingAreaIsValid())
+          MarkDrawingAreaRowsDirty(dirty_min_y, dirty_max_y);
+
         m_backend.PushCommand(cmd);
       }
     }
@@ -846,6 +969,7 @@ void GPU_SW::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
   cmd->height = static_cast<u16>(height);
   cmd->color = color;
   m_backend.PushCommand(cmd);
+  MarkVRAMRowsDirty(y, height);
 }
 
 void GPU_SW::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
@@ -859,6 +983,7 @@ void GPU_SW::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
   cmd->height = static_cast<u16>(height);
   std::memcpy(cmd->data, data, sizeof(u16) * num_words);
   m_backend.PushCommand(cmd);
+  MarkVRAMRowsDirty(y, height);
 }
 
 void GPU_SW::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
@@ -872,6 +997,7 @@ void GPU_SW::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32
   cmd->width = static_cast<u16>(width);
   cmd->height = static_cast<u16>(height);
   m_backend.PushCommand(cmd);
+  MarkVRAMRowsDirty(dst_y, height);
 }
 
 std::unique_ptr<GPU> GPU::CreateSoftwareRenderer()
@@ -27,21 +27,50 @@ protected:
   void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data) override;
   void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height) override;
 
+  /// Display area which was last converted into the display texture buffer.
+  struct DisplayOutput
+  {
+    HostDisplayPixelFormat format;
+    u32 src_x;
+    u32 src_y;
+    u32 skip_x;
+    u32 width;
+    u32 height;
+    bool color_depth_24;
+
+    ALWAYS_INLINE bool operator==(const DisplayOutput& rhs) const
+    {
+      return (format == rhs.format && src_x == rhs.src_x && src_y == rhs.src_y && skip_x == rhs.skip_x &&
+              width == rhs.width && height == rhs.height && color_depth_24 == rhs.color_depth_24);
+    }
+  };
+
+  // Converts the display area into the display texture buffer and uploads it, returning the number of bytes converted.
+  // When dirty_rows_only is set, rows which haven't changed since the last update are left as-is in the buffer, and
+  // the upload is skipped if there are no changed rows.
   template<HostDisplayPixelFormat display_format>
-  void CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved);
-  void CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
-                    bool interlaced, bool interleaved);
+  u32 CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved,
+                   bool dirty_rows_only);
+  u32 CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
+                   bool interlaced, bool interleaved, bool dirty_rows_only);
 
   template<HostDisplayPixelFormat display_format>
-  void CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u32 field, bool interlaced,
-                    bool interleaved);
-  void CopyOut24Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height,
-                    u32 field, bool interlaced, bool interleaved);
+  u32 CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u32 field, bool interlaced,
+                   bool interleaved, bool dirty_rows_only);
+  u32 CopyOut24Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height,
+                   u32 field, bool interlaced, bool interleaved, bool dirty_rows_only);
+
+  // Tracks which rows of VRAM have been written since the last display update. Rows wrap around the bottom of VRAM.
+  ALWAYS_INLINE bool IsVRAMRowDirty(u32 y) const { return ((m_vram_dirty_rows[y / 64] >> (y % 64)) & 1) != 0; }
+  void MarkVRAMRowsDirty(u32 y, u32 height);
+  void MarkDrawingAreaRowsDirty(s32 min_y, s32 max_y);
+  void ClearVRAMDirtyRows();
 
   void ClearDisplay() override;
   void UpdateDisplay() override;
 
   void DispatchRenderCommand() override;
+  void DrawRendererStats(bool is_idle_frame) override;
 
   void FillBackendCommandParameters(GPUBackendCommand* cmd);
   void FillDrawCommand(GPUBackendDrawCommand* cmd, GPURenderCommand rc);
@@ -49,6 +78,11 @@ protected:
   HeapArray<u8, VRAM_WIDTH * VRAM_HEIGHT * sizeof(u32)> m_display_texture_buffer;
   HostDisplayPixelFormat m_16bit_display_format = HostDisplayPixelFormat::RGB565;
   HostDisplayPixelFormat m_24bit_display_format = HostDisplayPixelFormat::RGBA8;
+  DisplayOutput m_display_output = {};
+  u32 m_display_bytes_converted = 0;
+  std::array<u64, VRAM_HEIGHT / 64> m_vram_dirty_rows = {};
 
   GPU_SW_Backend m_backend;
+  std::vector<float> m_band_thread_utilization;
+  GPU_SW_Backend::TextureCacheStats m_last_texture_cache_stats = {};
 };
@@ -1,23 +1,66 @@
 #include "gpu_sw_backend.h"
 #include "common/assert.h"
+#include "common/cpu_detect.h"
 #include "common/log.h"
 #include "gpu_sw_backend.h"
 #include "host_display.h"
+#include "settings.h"
 #include "system.h"
 #include <algorithm>
+#include <cstring>
 Log_SetChannel(GPU_SW_Backend);
 
+#if defined(CPU_X64)
+#include <immintrin.h>
+#define USE_VECTOR_SPANS 1
+#define USE_AVX2_SPANS 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#include <cpuid.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#elif defined(CPU_AARCH64)
+#ifdef _MSC_VER
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#define USE_VECTOR_SPANS 1
+#endif
+
 GPU_SW_Backend::GPU_SW_Backend() : GPUBackend()
 {
   m_vram.fill(0);
   m_vram_ptr = m_vram.data();
+  m_full_band.rows.fill(true);
+  m_vector_span_width = GetMaxVectorSpanWidth();
 }
 
 GPU_SW_Backend::~GPU_SW_Backend() = default;
 
 bool GPU_SW_Backend::Initialize()
 {
-  return GPUBackend::Initialize();
+  if (!GPUBackend::Initialize())
+    return false;
+
+  StartBandThreads(g_settings.gpu_sw_thread_count);
+  SetVectorSpanWidth(g_settings.gpu_sw_vector_span_width);
+  return true;
+}
+
+void GPU_SW_Backend::UpdateSettings()
+{
+  GPUBackend::UpdateSettings();
+
+  if (m_band_threads.size() != g_settings.gpu_sw_thread_count)
+  {
+    StopBandThreads();
+    StartBandThreads(g_settings.gpu_sw_thread_count);
+  }
+
+  SetVectorSpanWidth(g_settings.gpu_sw_vector_span_width);
 }
 
 void GPU_SW_Backend::Reset()
@@ -25,39 +68,527 @@ void GPU_SW_Backend::Reset()
   GPUBackend::Reset();
 
   m_vram.fill(0);
+  ClearTextureCache();
+}
+
+void GPU_SW_Backend::Shutdown()
+{
+  GPUBackend::Shutdown();
+  StopBandThreads();
+}
+
+void GPU_SW_Backend::StartBandThreads(u32 count)
+{
+  if (count == 0)
+    return;
+
+  m_band_command_buffer.resize(BAND_COMMAND_BUFFER_SIZE);
+  m_band_command_write_ptr.store(0);
+  m_band_threads_shutdown = false;
+
+  for (u32 i = 0; i < count; i++)
+  {
+    std::unique_ptr<BandThread> thread = std::make_unique<BandThread>();
+    for (u32 row = 0; row < VRAM_HEIGHT; row++)
+      thread->band.rows[row] = (((row / BAND_HEIGHT) % count) == i);
+
+    m_band_threads.push_back(std::move(thread));
+  }
+
+  for (std::unique_ptr<BandThread>& thread : m_band_threads)
+    thread->thread = std::thread(&GPU_SW_Backend::BandThreadLoop, this, thread.get());
+
+  m_band_utilization_timer.Reset();
+  Log_InfoPrintf("Started %u software renderer band threads.", count);
+}
+
+void GPU_SW_Backend::StopBandThreads()
+{
+  if (m_band_threads.empty())
+    return;
+
+  FlushRender();
+
+  {
+    std::unique_lock<std::mutex> lock(m_band_mutex);
+    m_band_threads_shutdown = true;
+    m_band_wake_cv.notify_all();
+  }
+
+  for (std::unique_ptr<BandThread>& thread : m_band_threads)
+    thread->thread.join();
+
+  m_band_threads.clear();
+  m_band_command_buffer = {};
+  Log_InfoPrint("Software renderer band threads stopped.");
+}
+
+void GPU_SW_Backend::BandThreadLoop(BandThread* thread)
+{
+  for (;;)
+  {
+    // The range is picked up under the lock, since FlushRender() rewinds the buffer once all threads are done with it.
+    u32 read_ptr, write_ptr;
+    {
+      std::unique_lock<std::mutex> lock(m_band_mutex);
+      if (thread->read_ptr.load() == m_band_command_write_ptr.load())
+      {
+        m_band_done_cv.notify_one();
+        m_band_threads_sleeping.fetch_add(1);
+        m_band_wake_cv.wait(lock, [this, thread]() {
+          return m_band_threads_shutdown || thread->read_ptr.load() != m_band_command_write_ptr.load();
+        });
+        m_band_threads_sleeping.fetch_sub(1);
+      }
+
+      if (m_band_threads_shutdown)
+        break;
+
+      read_ptr = thread->read_ptr.load();
+      write_ptr = m_band_command_write_ptr.load();
+    }
+
+    const Common::Timer::Value start_time = Common::Timer::GetValue();
+
+    while (read_ptr < write_ptr)
+    {
+      const GPUBackendCommand* cmd = reinterpret_cast<const GPUBackendCommand*>(&m_band_command_buffer[read_ptr]);
+      RasterizeCommand(cmd, thread->band);
+      read_ptr += cmd->size;
+    }
+
+    thread->busy_time.fetch_add(Common::Timer::GetValue() - start_time);
+    thread->read_ptr.store(write_ptr);
+  }
+}
+
+bool GPU_SW_Backend::ReadsFromDrawingArea(const GPUBackendDrawCommand* cmd) const
+{
+  // Does the horizontal span [start, start + length) overlap the drawing area, wrapping around the edge of VRAM?
+  const auto OverlapsColumns = [this](u32 start, u32 length) {
+    for (u32 i = 0; i < 2; i++)
+    {
+      const u32 end = std::min<u32>(start + length, VRAM_WIDTH);
+      if (start <= m_drawing_area.right && end > m_drawing_area.left)
+        return true;
+      if ((start + length) <= VRAM_WIDTH)
+        break;
+
+      length -= (VRAM_WIDTH - start);
+      start = 0;
+    }
+    return false;
+  };
+
+  const u32 page_x = cmd->draw_mode.GetTexturePageBaseX();
+  const u32 page_y = cmd->draw_mode.GetTexturePageBaseY();
+  switch (cmd->draw_mode.texture_mode)
+  {
+    case GPUTextureMode::Palette4Bit:
+    case GPUTextureMode::Palette8Bit:
+    {
+      const bool is_4bit = (cmd->draw_mode.texture_mode == GPUTextureMode::Palette4Bit);
+      const u32 palette_y = cmd->palette.GetYBase();
+      if (palette_y >= m_drawing_area.top && palette_y <= m_drawing_area.bottom &&
+          OverlapsColumns(cmd->palette.GetXBase(), is_4bit ? 16 : 256))
+      {
+        return true;
+      }
+
+      return (page_y <= m_drawing_area.bottom && (page_y + TEXTURE_PAGE_HEIGHT) > m_drawing_area.top &&
+              OverlapsColumns(page_x, is_4bit ? (TEXTURE_PAGE_WIDTH / 4) : (TEXTURE_PAGE_WIDTH / 2)));
+    }
+
+    default:
+      return (page_y <= m_drawing_area.bottom && (page_y + TEXTURE_PAGE_HEIGHT) > m_drawing_area.top &&
+              OverlapsColumns(page_x, TEXTURE_PAGE_WIDTH));
+  }
+}
+
+bool GPU_SW_Backend::QueueBandCommand(const GPUBackendDrawCommand* cmd)
+{
+  if (cmd->rc.texture_enable && ReadsFromDrawingArea(cmd))
+  {
+    FlushRender();
+    return false;
+  }
+
+  u32 write_ptr = m_band_command_write_ptr.load();
+  if ((write_ptr + cmd->size) > BAND_COMMAND_BUFFER_SIZE)
+  {
+    FlushRender();
+    write_ptr = 0;
+  }
+
+  std::memcpy(&m_band_command_buffer[write_ptr], cmd, cmd->size);
+  m_band_command_write_ptr.store(write_ptr + cmd->size);
+
+  if (m_band_threads_sleeping.load() > 0)
+  {
+    std::unique_lock<std::mutex> lock(m_band_mutex);
+    m_band_wake_cv.notify_all();
+  }
+
+  return true;
+}
+
+void GPU_SW_Backend::FlushRender()
+{
+  const u32 write_ptr = m_band_command_write_ptr.load();
+  if (write_ptr == 0)
+    return;
+
+  std::unique_lock<std::mutex> lock(m_band_mutex);
+  m_band_done_cv.wait(lock, [this, write_ptr]() {
+    return std::all_of(m_band_threads.begin(), m_band_threads.end(),
+                       [write_ptr](const std::unique_ptr<BandThread>& thread) {
+                         return thread->read_ptr.load() == write_ptr;
+                       });
+  });
+
+  for (std::unique_ptr<BandThread>& thread : m_band_threads)
+    thread->read_ptr.store(0);
+  m_band_command_write_ptr.store(0);
+}
+
+std::vector<float> GPU_SW_Backend::GetBandThreadUtilization()
+{
+  const double elapsed_ns = m_band_utilization_timer.GetTimeNanoseconds();
+  m_band_utilization_timer.Reset();
+
+  std::vector<float> utilization;
+  utilization.reserve(m_band_threads.size());
+  for (std::unique_ptr<BandThread>& thread : m_band_threads)
+  {
+    const Common::Timer::Value busy_time = thread->busy_time.load();
+    const double busy_ns = Common::Timer::ConvertValueToNanoseconds(busy_time - thread->last_busy_time);
+    thread->last_busy_time = busy_time;
+    utilization.push_back((elapsed_ns > 0.0) ? static_cast<float>(std::min(busy_ns / elapsed_ns, 1.0)) : 0.0f);
+  }
+
+  return utilization;
+}
+
+GPU_SW_Backend::TextureCacheStats GPU_SW_Backend::GetTextureCacheStats()
+{
+  TextureCacheStats stats;
+  stats.hits = m_texture_cache_hits.exchange(0, std::memory_order_relaxed);
+  stats.misses = m_texture_cache_misses.exchange(0, std::memory_order_relaxed);
+  stats.invalidations = m_texture_cache_invalidations.exchange(0, std::memory_order_relaxed);
+  stats.decoded_rows = m_texture_cache_decoded_rows.exchange(0, std::memory_order_relaxed);
+  return stats;
+}
+
+#ifdef USE_AVX2_SPANS
+
+static void CPUID(u32 leaf, u32 subleaf, u32 regs[4])
+{
+#ifdef _MSC_VER
+  __cpuidex(reinterpret_cast<int*>(regs), static_cast<int>(leaf), static_cast<int>(subleaf));
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static bool HostSupportsAVX2()
+{
+  u32 regs[4];
+  CPUID(0, 0, regs);
+  if (regs[0] < 7)
+    return false;
+
+  // The OS has to save the YMM registers as well, which is the case if XCR0 has the SSE and AVX state bits set.
+  CPUID(1, 0, regs);
+  const bool has_osxsave = (regs[2] & (1u << 27)) != 0;
+  const bool has_avx = (regs[2] & (1u << 28)) != 0;
+  if (!has_osxsave || !has_avx)
+    return false;
+
+#ifdef _MSC_VER
+  const u64 xcr0 = _xgetbv(0);
+#else
+  u32 xcr0_lo, xcr0_hi;
+  __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  const u64 xcr0 = (static_cast<u64>(xcr0_hi) << 32) | xcr0_lo;
+#endif
+  if ((xcr0 & 0x6) != 0x6)
+    return false;
+
+  CPUID(7, 0, regs);
+  return (regs[1] & (1u << 5)) != 0;
+}
+
+#endif
+
+u32 GPU_SW_Backend::GetMaxVectorSpanWidth()
+{
+#if defined(USE_AVX2_SPANS)
+  static const bool has_avx2 = HostSupportsAVX2();
+  return has_avx2 ? 16 : 8;
+#elif defined(USE_VECTOR_SPANS)
+  return 8;
+#else
+  return 0;
+#endif
+}
+
+u32 GPU_SW_Backend::GetSupportedVectorSpanWidth(u32 width)
+{
+  const u32 max_width = GetMaxVectorSpanWidth();
+  if (width >= 16 && max_width >= 16)
+    return 16;
+  else if (width >= 8 && max_width >= 8)
+    return 8;
+  else
+    return 0;
+}
+
+void GPU_SW_Backend::SetVectorSpanWidth(u32 width)
+{
+  m_vector_span_width = GetSupportedVectorSpanWidth(width);
+}
+
+u32 GPU_SW_Backend::GetTextureCacheKey(const GPUBackendDrawCommand* cmd)
+{
+  // Page X/Y and texture mode from the draw mode, top bit set so a zero key means an unused entry.
+  static constexpr u16 DRAW_MODE_KEY_MASK = 0b0000000110011111;
+  return 0x80000000u | (ZeroExtend32(cmd->draw_mode.bits & DRAW_MODE_KEY_MASK) << 16) |
+         ZeroExtend32(cmd->palette.bits & GPUTexturePaletteReg::MASK);
+}
+
+bool GPU_SW_Backend::UsesTextureCache(const GPUBackendDrawCommand* cmd) const
+{
+  // Draws which sample from the drawing area could see their own writes, so they have to read VRAM directly.
+  return cmd->rc.texture_enable && cmd->draw_mode.IsUsingPalette() && !ReadsFromDrawingArea(cmd);
+}
+
+void GPU_SW_Backend::PrepareTextureCache(const GPUBackendDrawCommand* cmd)
+{
+  // Anything sampling from the drawing area doesn't use the cache, so once the rows under it are invalidated, they
+  // won't be decoded again until the drawing area changes.
+  if (m_texture_cache_check_drawing_area)
+  {
+    m_texture_cache_check_drawing_area = false;
+    InvalidateTextureCache(m_drawing_area.left, m_drawing_area.top, m_drawing_area.right - m_drawing_area.left + 1,
+                           m_drawing_area.bottom - m_drawing_area.top + 1);
+  }
+
+  if (!UsesTextureCache(cmd))
+    return;
+
+  const u32 key = GetTextureCacheKey(cmd);
+  std::unique_ptr<TextureCacheEntry>* replace = nullptr;
+  for (std::unique_ptr<TextureCacheEntry>& entry : m_texture_cache)
+  {
+    if (!entry)
+    {
+      if (!replace || *replace)
+        replace = &entry;
+      continue;
+    }
+
+    if (entry->key == key)
+    {
+      entry->last_used = ++m_texture_cache_counter;
+      m_texture_cache_hits.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    if (!replace || (*replace && (*replace)->last_used > entry->last_used))
+      replace = &entry;
+  }
+
+  // Queued draws could still be sampling from the entry being replaced, or looking up the cache.
+  FlushRender();
+
+  if (!*replace)
+    *replace = std::make_unique<TextureCacheEntry>();
+
+  TextureCacheEntry* entry = replace->get();
+  for (std::atomic_bool& valid : entry->row_valid)
+    valid.store(false, std::memory_order_relaxed);
+  entry->draw_mode.bits = cmd->draw_mode.bits;
+  entry->palette.bits = cmd->palette.bits;
+  entry->key = key;
+  entry->last_used = ++m_texture_cache_counter;
+  m_texture_cache_misses.fetch_add(1, std::memory_order_relaxed);
+}
+
+GPU_SW_Backend::TextureCacheEntry* GPU_SW_Backend::LookupTextureCache(const GPUBackendDrawCommand* cmd)
+{
+  const u32 key = GetTextureCacheKey(cmd);
+  for (std::unique_ptr<TextureCacheEntry>& entry : m_texture_cache)
+  {
+    if (entry && entry->key == key)
+      return entry.get();
+  }
+
+  return nullptr;
+}
+
+void GPU_SW_Backend::DecodeTextureCacheRow(TextureCacheEntry* entry, u32 row)
+{
+  std::unique_lock<std::mutex> lock(entry->decode_mutex);
+  if (entry->row_valid[row].load(std::memory_order_relaxed))
+    return;
+
+  const u32 page_x = entry->draw_mode.GetTexturePageBaseX();
+  const u16* page_row = GetPixelPtr(0, (entry->draw_mode.GetTexturePageBaseY() + row) % VRAM_HEIGHT);
+  const u16* palette = GetPixelPtr(0, entry->palette.GetYBase());
+  const u32 palette_x = entry->palette.GetXBase();
+  u16* texels = &entry->texels[row * TEXTURE_PAGE_WIDTH];
+
+  if (entry->draw_mode.texture_mode == GPUTextureMode::Palette4Bit)
+  {
+    for (u32 x = 0; x < TEXTURE_PAGE_WIDTH; x++)
+    {
+      const u16 palette_value = page_row[(page_x + (x / 4)) % VRAM_WIDTH];
+      const u16 palette_index = (palette_value >> ((x % 4) * 4)) & 0x0Fu;
+      texels[x] = palette[(palette_x + ZeroExtend32(palette_index)) % VRAM_WIDTH];
+    }
+  }
+  else
+  {
+    for (u32 x = 0; x < TEXTURE_PAGE_WIDTH; x++)
+    {
+      const u16 palette_value = page_row[(page_x + (x / 2)) % VRAM_WIDTH];
+      const u16 palette_index = (palette_value >> ((x % 2) * 8)) & 0xFFu;
+      texels[x] = palette[(palette_x + ZeroExtend32(palette_index)) % VRAM_WIDTH];
+    }
+  }
+
+  entry->row_valid[row].store(true, std::memory_order_release);
+  m_texture_cache_decoded_rows.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Do the ranges overlap, wrapping around at size? Size must be a power of two.
+static bool RangesOverlap(u32 a_start, u32 a_length, u32 b_start, u32 b_length, u32 size)
+{
+  return ((b_start - a_start) & (size - 1)) < a_length || ((a_start - b_start) & (size - 1)) < b_length;
+}
+
+void GPU_SW_Backend::InvalidateTextureCache(u32 x, u32 y, u32 width, u32 height)
+{
+  for (std::unique_ptr<TextureCacheEntry>& entry : m_texture_cache)
+  {
+    if (!entry || entry->key == 0)
+      continue;
+
+    const bool is_4bit = (entry->draw_mode.texture_mode == GPUTextureMode::Palette4Bit);
+    bool invalidated = false;
+    if (RangesOverlap(entry->palette.GetYBase(), 1, y, height, VRAM_HEIGHT) &&
+        RangesOverlap(entry->palette.GetXBase(), is_4bit ? 16 : 256, x, width, VRAM_WIDTH))
+    {
+      for (std::atomic_bool& valid : entry->row_valid)
+        invalidated |= valid.exchange(false, std::memory_order_relaxed);
+    }
+    else if (RangesOverlap(entry->draw_mode.GetTexturePageBaseX(),
+                           is_4bit ? (TEXTURE_PAGE_WIDTH / 4) : (TEXTURE_PAGE_WIDTH / 2), x, width, VRAM_WIDTH))
+    {
+      const u32 page_y = entry->draw_mode.GetTexturePageBaseY();
+      for (u32 row = 0; row < TEXTURE_PAGE_HEIGHT; row++)
+      {
+        if (((page_y + row - y) & (VRAM_HEIGHT - 1)) < height)
+          invalidated |= entry->row_valid[row].exchange(false, std::memory_order_relaxed);
+      }
+    }
+
+    if (invalidated)
+      m_texture_cache_invalidations.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void GPU_SW_Backend::ClearTextureCache()
+{
+  for (std::unique_ptr<TextureCacheEntry>& entry : m_texture_cache)
+  {
+    if (entry)
+      entry->key = 0;
+  }
+
+  m_texture_cache_check_drawing_area = true;
 }
 
 void GPU_SW_Backend::DrawPolygon(const GPUBackendDrawPolygonCommand* cmd)
+{
+  PrepareTextureCache(cmd);
+  if (!m_band_threads.empty() && QueueBandCommand(cmd))
+    return;
+
+  RasterizePolygon(cmd, m_full_band);
+}
+
+void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
+{
+  PrepareTextureCache(cmd);
+  if (!m_band_threads.empty() && QueueBandCommand(cmd))
+    return;
+
+  RasterizeRectangle(cmd, m_full_band);
+}
+
+void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd)
+{
+  PrepareTextureCache(cmd);
+  if (!m_band_threads.empty() && QueueBandCommand(cmd))
+    return;
+
+  RasterizeLine(cmd, m_full_band);
+}
+
+void GPU_SW_Backend::RasterizeCommand(const GPUBackendCommand* cmd, const DrawBand& band)
+{
+  switch (cmd->type)
+  {
+    case GPUBackendCommandType::DrawPolygon:
+      RasterizePolygon(static_cast<const GPUBackendDrawPolygonCommand*>(cmd), band);
+      break;
+
+    case GPUBackendCommandType::DrawRectangle:
+      RasterizeRectangle(static_cast<const GPUBackendDrawRectangleCommand*>(cmd), band);
+      break;
+
+    case GPUBackendCommandType::DrawLine:
+      RasterizeLine(static_cast<const GPUBackendDrawLineCommand*>(cmd), band);
+      break;
+
+    default:
+      break;
+  }
+}
+
+void GPU_SW_Backend::RasterizePolygon(const GPUBackendDrawPolygonCommand* cmd, const DrawBand& band)
 {
   const GPURenderCommand rc{cmd->rc.bits};
   const bool dithering_enable = rc.IsDitheringEnabled() && cmd->draw_mode.dither_enable;
 
   const DrawTriangleFunction DrawFunction = GetDrawTriangleFunction(
     rc.shading_enable, rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable, dithering_enable);
+  TextureCacheEntry* const texture_cache = UsesTextureCache(cmd) ? LookupTextureCache(cmd) : nullptr;
 
-  (this->*DrawFunction)(cmd, &cmd->vertices[0], &cmd->vertices[1], &cmd->vertices[2]);
+  (this->*DrawFunction)(cmd, band, texture_cache, &cmd->vertices[0], &cmd->vertices[1], &cmd->vertices[2]);
   if (rc.quad_polygon)
-    (this->*DrawFunction)(cmd, &cmd->vertices[2], &cmd->vertices[1], &cmd->vertices[3]);
+    (this->*DrawFunction)(cmd, band, texture_cache, &cmd->vertices[2], &cmd->vertices[1], &cmd->vertices[3]);
 }
 
-void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
+void GPU_SW_Backend::RasterizeRectangle(const GPUBackendDrawRectangleCommand* cmd, const DrawBand& band)
 {
   const GPURenderCommand rc{cmd->rc.bits};
-  const bool dithering_enable = rc.IsDitheringEnabled() && cmd->draw_mode.dither_enable;
 
   const DrawRectangleFunction DrawFunction =
     GetDrawRectangleFunction(rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable);
+  TextureCacheEntry* const texture_cache = UsesTextureCache(cmd) ? LookupTextureCache(cmd) : nullptr;
 
-  (this->*DrawFunction)(cmd);
+  (this->*DrawFunction)(cmd, band, texture_cache);
 }
 
-void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd)
+void GPU_SW_Backend::RasterizeLine(const GPUBackendDrawLineCommand* cmd, const DrawBand& band)
 {
   const DrawLineFunction DrawFunction =
     GetDrawLineFunction(cmd->rc.shading_enable, cmd->rc.transparency_enable, cmd->IsDitheringEnabled());
 
   for (u16 i = 1; i < cmd->num_vertices; i++)
-    (this->*DrawFunction)(cmd, &cmd->vertices[i - 1], &cmd->vertices[i]);
+    (this->*DrawFunction)(cmd, band, &cmd->vertices[i - 1], &cmd->vertices[i]);
 }
 
 constexpr GPU_SW_Backend::DitherLUT GPU_SW_Backend::ComputeDitherLUT()
@@ -79,53 +610,61 @@ constexpr GPU_SW_Backend::DitherLUT GPU_SW_Backend::ComputeDitherLUT()
 
 static constexpr GPU_SW_Backend::DitherLUT s_dither_lut = GPU_SW_Backend::ComputeDitherLUT();
 
-template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
-void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawCommand* cmd, u32 x, u32 y, u8 color_r,
-                                                      u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y)
+ALWAYS_INLINE_RELEASE u16 GPU_SW_Backend::FetchTexel(const GPUBackendDrawCommand* cmd,
+                                                     TextureCacheEntry* texture_cache, u8 texcoord_x, u8 texcoord_y)
 {
-  VRAMPixel color;
-  bool transparent;
-  if constexpr (texture_enable)
+  // Apply texture window
+  // TODO: Precompute the second half
+  texcoord_x = (texcoord_x & cmd->window.and_x) | cmd->window.or_x;
+  texcoord_y = (texcoord_y & cmd->window.and_y) | cmd->window.or_y;
+
+  if (texture_cache)
   {
-    // Apply texture window
-    // TODO: Precompute the second half
-    texcoord_x = (texcoord_x & cmd->window.and_x) | cmd->window.or_x;
-    texcoord_y = (texcoord_y & cmd->window.and_y) | cmd->window.or_y;
+    if (!texture_cache->row_valid[texcoord_y].load(std::memory_order_acquire))
+      DecodeTextureCacheRow(texture_cache, texcoord_y);
 
-    VRAMPixel texture_color;
-    switch (cmd->draw_mode.texture_mode)
+    return texture_cache->texels[ZeroExtend32(texcoord_y) * TEXTURE_PAGE_WIDTH + ZeroExtend32(texcoord_x)];
+  }
+
+  switch (cmd->draw_mode.texture_mode)
+  {
+    case GPUTextureMode::Palette4Bit:
     {
-      case GPUTextureMode::Palette4Bit:
-      {
-        const u16 palette_value =
-          GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 4)) % VRAM_WIDTH,
-                   (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
-        const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
+      const u16 palette_value =
+        GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 4)) % VRAM_WIDTH,
+                 (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
+      const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
 
-        texture_color.bits =
-          GetPixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH, cmd->palette.GetYBase());
-      }
-      break;
+      return GetPixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH, cmd->palette.GetYBase());
+    }
 
-      case GPUTextureMode::Palette8Bit:
-      {
-        const u16 palette_value =
-          GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 2)) % VRAM_WIDTH,
-                   (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
-        const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
-        texture_color.bits =
-          GetPixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH, cmd->palette.GetYBase());
-      }
-      break;
+    case GPUTextureMode::Palette8Bit:
+    {
+      const u16 palette_value =
+        GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 2)) % VRAM_WIDTH,
+                 (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
+      const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
+      return GetPixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH, cmd->palette.GetYBase());
+    }
 
-      default:
-      {
-        texture_color.bits = GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x)) % VRAM_WIDTH,
-                                      (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
-      }
-      break;
+    default:
+    {
+      return GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x)) % VRAM_WIDTH,
+                      (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
     }
+  }
+}
 
+template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
+void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawCommand* cmd,
+                                                      TextureCacheEntry* texture_cache, u32 x, u32 y, u8 color_r,
+                                                      u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y)
+{
+  VRAMPixel color;
+  bool transparent;
+  if constexpr (texture_enable)
+  {
+    const VRAMPixel texture_color{FetchTexel(cmd, texture_cache, texcoord_x, texcoord_y)};
     if (texture_color.bits == 0)
       return;
 
@@ -211,7 +750,8 @@ void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawComman
 }
 
 template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
+void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd, const DrawBand& band,
+                                   TextureCacheEntry* texture_cache)
 {
   const s32 origin_x = cmd->x;
   const s32 origin_y = cmd->y;
@@ -221,7 +761,7 @@ void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
   for (u32 offset_y = 0; offset_y < cmd->height; offset_y++)
   {
     const s32 y = origin_y + static_cast<s32>(offset_y);
-    if (y < static_cast<s32>(m_drawing_area.top) || y > static_cast<s32>(m_drawing_area.bottom) ||
+    if (y < static_cast<s32>(m_drawing_area.top) || y > static_cast<s32>(m_drawing_area.bottom) || !band.rows[y] ||
         (cmd->params.interlaced_rendering && cmd->params.active_line_lsb == (Truncate8(static_cast<u32>(y)) & 1u)))
     {
       continue;
@@ -238,7 +778,7 @@ void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
       const u8 texcoord_x = Truncate8(ZeroExtend32(origin_texcoord_x) + offset_x);
 
       ShadePixel<texture_enable, raw_texture_enable, transparency_enable, false>(
-        cmd, static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
+        cmd, texture_cache, static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
     }
   }
 }
@@ -349,10 +889,233 @@ void ALWAYS_INLINE_RELEASE GPU_SW_Backend::AddIDeltas_DY(i_group& ig, const i_de
   }
 }
 
+#ifdef USE_VECTOR_SPANS
+
+// Each vector has one 16-bit lane per pixel, and the interpolated colours are calculated in two halves with 32-bit lanes.
+namespace VectorSpan {
+
+// SSE2 on x64, NEON on AArch64.
+namespace V128 {
+
+static constexpr u32 PIXELS = 8;
+
+#if defined(CPU_X64)
+
+using VecU16 = __m128i;
+using VecU32 = __m128i;
+
+static ALWAYS_INLINE VecU16 LoadU16(const u16* ptr)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+static ALWAYS_INLINE void StoreU16(u16* ptr, VecU16 v)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), v);
+}
+static ALWAYS_INLINE VecU16 SetU16(u16 v) { return _mm_set1_epi16(static_cast<s16>(v)); }
+template<int lane>
+static ALWAYS_INLINE VecU16 InsertU16(VecU16 v, u16 value)
+{
+  return _mm_insert_epi16(v, value, lane);
+}
+static ALWAYS_INLINE VecU32 SetU32Ramp(u32 start, u32 step)
+{
+  return _mm_set_epi32(static_cast<s32>(start + step * 3), static_cast<s32>(start + step * 2),
+                       static_cast<s32>(start + step), static_cast<s32>(start));
+}
+static ALWAYS_INLINE VecU32 SetU32(u32 v) { return _mm_set1_epi32(static_cast<s32>(v)); }
+static ALWAYS_INLINE VecU32 AddU32(VecU32 a, VecU32 b) { return _mm_add_epi32(a, b); }
+template<int shift>
+static ALWAYS_INLINE VecU32 ShrU32(VecU32 v)
+{
+  return _mm_srli_epi32(v, shift);
+}
+// Values must be below 0x8000.
+static ALWAYS_INLINE VecU16 NarrowU32(VecU32 lo, VecU32 hi) { return _mm_packs_epi32(lo, hi); }
+static ALWAYS_INLINE VecU16 AddU16(VecU16 a, VecU16 b) { return _mm_add_epi16(a, b); }
+static ALWAYS_INLINE VecU16 SubSatU16(VecU16 a, VecU16 b) { return _mm_subs_epu16(a, b); }
+static ALWAYS_INLINE VecU16 MulU16(VecU16 a, VecU16 b) { return _mm_mullo_epi16(a, b); }
+static ALWAYS_INLINE VecU16 MinS16(VecU16 a, VecU16 b) { return _mm_min_epi16(a, b); }
+static ALWAYS_INLINE VecU16 MaxS16(VecU16 a, VecU16 b) { return _mm_max_epi16(a, b); }
+static ALWAYS_INLINE VecU16 AndU16(VecU16 a, VecU16 b) { return _mm_and_si128(a, b); }
+static ALWAYS_INLINE VecU16 OrU16(VecU16 a, VecU16 b) { return _mm_or_si128(a, b); }
+static ALWAYS_INLINE VecU16 CmpEqU16(VecU16 a, VecU16 b) { return _mm_cmpeq_epi16(a, b); }
+template<int shift>
+static ALWAYS_INLINE VecU16 ShlU16(VecU16 v)
+{
+  return _mm_slli_epi16(v, shift);
+}
+template<int shift>
+static ALWAYS_INLINE VecU16 ShrU16(VecU16 v)
+{
+  return _mm_srli_epi16(v, shift);
+}
+template<int shift>
+static ALWAYS_INLINE VecU16 SarS16(VecU16 v)
+{
+  return _mm_srai_epi16(v, shift);
+}
+static ALWAYS_INLINE VecU16 Select(VecU16 mask, VecU16 a, VecU16 b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+#elif defined(CPU_AARCH64)
+
+using VecU16 = uint16x8_t;
+using VecU32 = uint32x4_t;
+
+static ALWAYS_INLINE VecU16 LoadU16(const u16* ptr) { return vld1q_u16(ptr); }
+static ALWAYS_INLINE void StoreU16(u16* ptr, VecU16 v) { vst1q_u16(ptr, v); }
+static ALWAYS_INLINE VecU16 SetU16(u16 v) { return vdupq_n_u16(v); }
+template<int lane>
+static ALWAYS_INLINE VecU16 InsertU16(VecU16 v, u16 value)
+{
+  return vsetq_lane_u16(value, v, lane);
+}
+static ALWAYS_INLINE VecU32 SetU32Ramp(u32 start, u32 step)
+{
+  const u32 values[4] = {start, start + step, start + step * 2, start + step * 3};
+  return vld1q_u32(values);
+}
+static ALWAYS_INLINE VecU32 SetU32(u32 v) { return vdupq_n_u32(v); }
+static ALWAYS_INLINE VecU32 AddU32(VecU32 a, VecU32 b) { return vaddq_u32(a, b); }
+template<int shift>
+static ALWAYS_INLINE VecU32 ShrU32(VecU32 v)
+{
+  return vshrq_n_u32(v, shift);
+}
+static ALWAYS_INLINE VecU16 NarrowU32(VecU32 lo, VecU32 hi) { return vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)); }
+static ALWAYS_INLINE VecU16 AddU16(VecU16 a, VecU16 b) { return vaddq_u16(a, b); }
+static ALWAYS_INLINE VecU16 SubSatU16(VecU16 a, VecU16 b) { return vqsubq_u16(a, b); }
+static ALWAYS_INLINE VecU16 MulU16(VecU16 a, VecU16 b) { return vmulq_u16(a, b); }
+static ALWAYS_INLINE VecU16 MinS16(VecU16 a, VecU16 b)
+{
+  return vreinterpretq_u16_s16(vminq_s16(vreinterpretq_s16_u16(a), vreinterpretq_s16_u16(b)));
+}
+static ALWAYS_INLINE VecU16 MaxS16(VecU16 a, VecU16 b)
+{
+  return vreinterpretq_u16_s16(vmaxq_s16(vreinterpretq_s16_u16(a), vreinterpretq_s16_u16(b)));
+}
+static ALWAYS_INLINE VecU16 AndU16(VecU16 a, VecU16 b) { return vandq_u16(a, b); }
+static ALWAYS_INLINE VecU16 OrU16(VecU16 a, VecU16 b) { return vorrq_u16(a, b); }
+static ALWAYS_INLINE VecU16 CmpEqU16(VecU16 a, VecU16 b) { return vceqq_u16(a, b); }
+template<int shift>
+static ALWAYS_INLINE VecU16 ShlU16(VecU16 v)
+{
+  return vshlq_n_u16(v, shift);
+}
+template<int shift>
+static ALWAYS_INLINE VecU16 ShrU16(VecU16 v)
+{
+  return vshrq_n_u16(v, shift);
+}
+template<int shift>
+static ALWAYS_INLINE VecU16 SarS16(VecU16 v)
+{
+  return vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(v), shift));
+}
+static ALWAYS_INLINE VecU16 Select(VecU16 mask, VecU16 a, VecU16 b) { return vbslq_u16(mask, a, b); }
+
+#endif
+
+} // namespace V128
+
+#ifdef USE_AVX2_SPANS
+
+// AVX2 on x64, only used when the CPU supports it.
+namespace V256 {
+
+static constexpr u32 PIXELS = 16;
+
+using VecU16 = __m256i;
+using VecU32 = __m256i;
+
+static AVX2_TARGET ALWAYS_INLINE VecU16 LoadU16(const u16* ptr)
+{
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+}
+static AVX2_TARGET ALWAYS_INLINE void StoreU16(u16* ptr, VecU16 v)
+{
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), v);
+}
+static AVX2_TARGET ALWAYS_INLINE VecU16 SetU16(u16 v) { return _mm256_set1_epi16(static_cast<s16>(v)); }
+template<int lane>
+static AVX2_TARGET ALWAYS_INLINE VecU16 InsertU16(VecU16 v, u16 value)
+{
+  return _mm256_insert_epi16(v, static_cast<s16>(value), lane);
+}
+static AVX2_TARGET ALWAYS_INLINE VecU32 SetU32Ramp(u32 start, u32 step)
+{
+  return _mm256_set_epi32(static_cast<s32>(start + step * 7), static_cast<s32>(start + step * 6),
+                          static_cast<s32>(start + step * 5), static_cast<s32>(start + step * 4),
+                          static_cast<s32>(start + step * 3), static_cast<s32>(start + step * 2),
+                          static_cast<s32>(start + step), static_cast<s32>(start));
+}
+static AVX2_TARGET ALWAYS_INLINE VecU32 SetU32(u32 v) { return _mm256_set1_epi32(static_cast<s32>(v)); }
+static AVX2_TARGET ALWAYS_INLINE VecU32 AddU32(VecU32 a, VecU32 b) { return _mm256_add_epi32(a, b); }
+template<int shift>
+static AVX2_TARGET ALWAYS_INLINE VecU32 ShrU32(VecU32 v)
+{
+  return _mm256_srli_epi32(v, shift);
+}
+// Values must be below 0x8000. The pack works within each 128-bit lane, so the 64-bit halves are put back in order.
+static AVX2_TARGET ALWAYS_INLINE VecU16 NarrowU32(VecU32 lo, VecU32 hi)
+{
+  return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+}
+static AVX2_TARGET ALWAYS_INLINE VecU16 AddU16(VecU16 a, VecU16 b) { return _mm256_add_epi16(a, b); }
+static AVX2_TARGET ALWAYS_INLINE VecU16 SubSatU16(VecU16 a, VecU16 b) { return _mm256_subs_epu16(a, b); }
+static AVX2_TARGET ALWAYS_INLINE VecU16 MulU16(VecU16 a, VecU16 b) { return _mm256_mullo_epi16(a, b); }
+static AVX2_TARGET ALWAYS_INLINE VecU16 MinS16(VecU16 a, VecU16 b) { return _mm256_min_epi16(a, b); }
+static AVX2_TARGET ALWAYS_INLINE VecU16 MaxS16(VecU16 a, VecU16 b) { return _mm256_max_epi16(a, b); }
+static AVX2_TARGET ALWAYS_INLINE VecU16 AndU16(VecU16 a, VecU16 b) { return _mm256_and_si256(a, b); }
+static AVX2_TARGET ALWAYS_INLINE VecU16 OrU16(VecU16 a, VecU16 b) { return _mm256_or_si256(a, b); }
+static AVX2_TARGET ALWAYS_INLINE VecU16 CmpEqU16(VecU16 a, VecU16 b) { return _mm256_cmpeq_epi16(a, b); }
+template<int shift>
+static AVX2_TARGET ALWAYS_INLINE VecU16 ShlU16(VecU16 v)
+{
+  return _mm256_slli_epi16(v, shift);
+}
+template<int shift>
+static AVX2_TARGET ALWAYS_INLINE VecU16 ShrU16(VecU16 v)
+{
+  return _mm256_srli_epi16(v, shift);
+}
+template<int shift>
+static AVX2_TARGET ALWAYS_INLINE VecU16 SarS16(VecU16 v)
+{
+  return _mm256_srai_epi16(v, shift);
+}
+static AVX2_TARGET ALWAYS_INLINE VecU16 Select(VecU16 mask, VecU16 a, VecU16 b)
+{
+  return _mm256_blendv_epi8(b, a, mask);
+}
+
+} // namespace V256
+
+#endif
+
+} // namespace VectorSpan
+
+#define VECTOR_SPAN_ISA V128
+#define VECTOR_SPAN_TARGET
+#define VECTOR_SPAN_FUNCTION DrawSpanVector
+#include "gpu_sw_backend_span.inl"
+
+#ifdef USE_AVX2_SPANS
+#define VECTOR_SPAN_ISA V256
+#define VECTOR_SPAN_TARGET AVX2_TARGET
+#define VECTOR_SPAN_FUNCTION DrawSpanVectorAVX2
+#include "gpu_sw_backend_span.inl"
+#endif
+
+#endif
+
 template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
          bool dithering_enable>
-void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s32 x_start, s32 x_bound, i_group ig,
-                              const i_deltas& idl)
+void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, TextureCacheEntry* texture_cache, s32 y,
+                              s32 x_start, s32 x_bound, i_group ig, const i_deltas& idl, u32 vector_span_width)
 {
   if (cmd->params.interlaced_rendering && cmd->params.active_line_lsb == (Truncate8(static_cast<u32>(y)) & 1u))
     return;
@@ -378,7 +1141,29 @@ void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s3
   AddIDeltas_DX<shading_enable, texture_enable>(ig, idl, x_ig_adjust);
   AddIDeltas_DY<shading_enable, texture_enable>(ig, idl, y);
 
-  do
+#ifdef USE_VECTOR_SPANS
+  if (vector_span_width != 0 && w >= 8)
+  {
+    u32 vector_x = static_cast<u32>(x);
+#ifdef USE_AVX2_SPANS
+    if (vector_span_width >= 16 && w >= 16)
+    {
+      DrawSpanVectorAVX2<shading_enable, texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
+        cmd, texture_cache, static_cast<u32>(y), vector_x, w, ig, idl);
+    }
+#endif
+    if (w >= 8)
+    {
+      DrawSpanVector<shading_enable, texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
+        cmd, texture_cache, static_cast<u32>(y), vector_x, w, ig, idl);
+    }
+    x = static_cast<s32>(vector_x);
+  }
+#else
+  UNREFERENCED_VARIABLE(vector_span_width);
+#endif
+
+  for (; w > 0; w--)
   {
     const u32 r = ig.r >> (COORD_FBS + COORD_POST_PADDING);
     const u32 g = ig.g >> (COORD_FBS + COORD_POST_PADDING);
@@ -387,18 +1172,18 @@ void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s3
     const u32 v = ig.v >> (COORD_FBS + COORD_POST_PADDING);
 
     ShadePixel<texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-      cmd, static_cast<u32>(x), static_cast<u32>(y), Truncate8(r), Truncate8(g), Truncate8(b), Truncate8(u),
-      Truncate8(v));
+      cmd, texture_cache, static_cast<u32>(x), static_cast<u32>(y), Truncate8(r), Truncate8(g), Truncate8(b),
+      Truncate8(u), Truncate8(v));
 
     x++;
     AddIDeltas_DX<shading_enable, texture_enable>(ig, idl);
-  } while (--w > 0);
+  }
 }
 
 template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
          bool dithering_enable>
-void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
-                                  const GPUBackendDrawPolygonCommand::Vertex* v0,
+void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd, const DrawBand& band,
+                                  TextureCacheEntry* texture_cache, const GPUBackendDrawPolygonCommand::Vertex* v0,
                                   const GPUBackendDrawPolygonCommand::Vertex* v1,
                                   const GPUBackendDrawPolygonCommand::Vertex* v2)
 {
@@ -534,6 +1319,10 @@ void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
     tp->dec_mode = vp;
   }
 
+  // Spans which could sample pixels written earlier in the same span have to be drawn one pixel at a time.
+  const u32 vector_span_width =
+    (!texture_enable || texture_cache || !ReadsFromDrawingArea(cmd)) ? m_vector_span_width : 0;
+
   for (u32 i = 0; i < 2; i++)
   {
     s32 yi = tripart[i].y_coord;
@@ -558,11 +1347,11 @@ void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
         if (y < static_cast<s32>(m_drawing_area.top))
           break;
 
-        if (y > static_cast<s32>(m_drawing_area.bottom))
+        if (y > static_cast<s32>(m_drawing_area.bottom) || !band.rows[y])
           continue;
 
         DrawSpan<shading_enable, texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-          cmd, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
+          cmd, texture_cache, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl, vector_span_width);
       }
     }
     else
@@ -574,11 +1363,11 @@ void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
         if (y > static_cast<s32>(m_drawing_area.bottom))
           break;
 
-        if (y >= static_cast<s32>(m_drawing_area.top))
+        if (y >= static_cast<s32>(m_drawing_area.top) && band.rows[y])
         {
 
           DrawSpan<shading_enable, texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-            cmd, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
+            cmd, texture_cache, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl, vector_span_width);
         }
 
         yi++;
@@ -655,8 +1444,8 @@ static ALWAYS_INLINE_RELEASE s64 LineDivide(s64 delta, s32 dk)
 }
 
 template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBackendDrawLineCommand::Vertex* p0,
-                              const GPUBackendDrawLineCommand::Vertex* p1)
+void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const DrawBand& band,
+                              const GPUBackendDrawLineCommand::Vertex* p0, const GPUBackendDrawLineCommand::Vertex* p1)
 {
   const s32 i_dx = std::abs(p1->x - p0->x);
   const s32 i_dy = std::abs(p1->y - p0->y);
@@ -717,14 +1506,14 @@ void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBac
 
     if ((!cmd->params.interlaced_rendering || cmd->params.active_line_lsb != (Truncate8(static_cast<u32>(y)) & 1u)) &&
         x >= static_cast<s32>(m_drawing_area.left) && x <= static_cast<s32>(m_drawing_area.right) &&
-        y >= static_cast<s32>(m_drawing_area.top) && y <= static_cast<s32>(m_drawing_area.bottom))
+        y >= static_cast<s32>(m_drawing_area.top) && y <= static_cast<s32>(m_drawing_area.bottom) && band.rows[y])
     {
       const u8 r = shading_enable ? static_cast<u8>(cur_point.r >> Line_RGB_FractBits) : p0->r;
       const u8 g = shading_enable ? static_cast<u8>(cur_point.g >> Line_RGB_FractBits) : p0->g;
       const u8 b = shading_enable ? static_cast<u8>(cur_point.b >> Line_RGB_FractBits) : p0->b;
 
-      ShadePixel<false, false, transparency_enable, dithering_enable>(cmd, static_cast<u32>(x), static_cast<u32>(y), r,
-                                                                      g, b, 0, 0);
+      ShadePixel<false, false, transparency_enable, dithering_enable>(cmd, nullptr, static_cast<u32>(x),
+                                                                      static_cast<u32>(y), r, g, b, 0, 0);
     }
 
     cur_point.x += step.dx_dk;
@@ -769,6 +1558,8 @@ GPU_SW_Backend::GetDrawRectangleFunction(bool texture_enable, bool raw_texture_e
 
 void GPU_SW_Backend::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color, GPUBackendCommandParameters params)
 {
+  InvalidateTextureCache(x, y, width, height);
+
   const u16 color16 = RGBA8888ToRGBA5551(color);
   if ((x + width) <= VRAM_WIDTH && !params.interlaced_rendering)
   {
@@ -814,6 +1605,8 @@ void GPU_SW_Backend::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color, GP
 void GPU_SW_Backend::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data,
                                 GPUBackendCommandParameters params)
 {
+  InvalidateTextureCache(x, y, width, height);
+
   // Fast path when the copy is not oversized.
   if ((x + width) <= VRAM_WIDTH && (y + height) <= VRAM_HEIGHT && !params.IsMaskingEnabled())
   {
@@ -850,6 +1643,8 @@ void GPU_SW_Backend::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void*
 void GPU_SW_Backend::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height,
                               GPUBackendCommandParameters params)
 {
+  InvalidateTextureCache(dst_x, dst_y, width, height);
+
   // Break up oversized copies. This behavior has not been verified on console.
   if ((src_x + width) > VRAM_WIDTH || (dst_x + width) > VRAM_WIDTH)
   {
@@ -921,6 +1716,7 @@ void GPU_SW_Backend::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wi
   }
 }
 
-void GPU_SW_Backend::FlushRender() {}
-
-void GPU_SW_Backend::DrawingAreaChanged() {}
+void GPU_SW_Backend::DrawingAreaChanged()
+{
+  m_texture_cache_check_drawing_area = true;
+}
@@ -1,7 +1,12 @@
 #pragma once
+#include "common/timer.h"
 #include "gpu_backend.h"
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 class GPU_SW_Backend final : public GPUBackend
@@ -11,7 +16,33 @@ public:
   ~GPU_SW_Backend() override;
 
   bool Initialize() override;
+  void UpdateSettings() override;
   void Reset() override;
+  void Shutdown() override;
+
+  struct TextureCacheStats
+  {
+    u32 hits;
+    u32 misses;
+    u32 invalidations;
+    u32 decoded_rows;
+  };
+
+  /// Returns the fraction of time each band thread spent rasterizing since the last call.
+  std::vector<float> GetBandThreadUtilization();
+
+  /// Returns the texture cache counters accumulated since the last call.
+  TextureCacheStats GetTextureCacheStats();
+
+  /// Returns the widest vector path for polygon spans the host CPU supports, in pixels, or 0 if there is none.
+  static u32 GetMaxVectorSpanWidth();
+
+  /// Returns the vector span width SetVectorSpanWidth() would use for width.
+  static u32 GetSupportedVectorSpanWidth(u32 width);
+
+  /// Limits polygon spans to vector paths of at most this many pixels, 0 forces the scalar path. The paths can be
+  /// compared this way, widths above what the CPU supports are reduced.
+  void SetVectorSpanWidth(u32 width);
 
   ALWAYS_INLINE_RELEASE u16 GetPixel(const u32 x, const u32 y) const { return m_vram[VRAM_WIDTH * y + x]; }
   ALWAYS_INLINE_RELEASE const u16* GetPixelPtr(const u32 x, const u32 y) const { return &m_vram[VRAM_WIDTH * y + x]; }
@@ -102,17 +133,96 @@ protected:
   void FlushRender() override;
   void DrawingAreaChanged() override;
 
+  //////////////////////////////////////////////////////////////////////////
+  // Band threads
+  //////////////////////////////////////////////////////////////////////////
+  enum : u32
+  {
+    BAND_HEIGHT = 16,
+    BAND_COMMAND_BUFFER_SIZE = 4 * 1024 * 1024
+  };
+
+  // Rows of VRAM drawn by a rasterizer thread. Bands are interleaved, so the drawing area is split evenly.
+  struct DrawBand
+  {
+    std::array<bool, VRAM_HEIGHT> rows;
+  };
+
+  struct BandThread
+  {
+    DrawBand band;
+    std::thread thread;
+    std::atomic<u32> read_ptr{0};
+    std::atomic<Common::Timer::Value> busy_time{0};
+    Common::Timer::Value last_busy_time = 0;
+  };
+
+  void StartBandThreads(u32 count);
+  void StopBandThreads();
+  void BandThreadLoop(BandThread* thread);
+
+  /// Copies a draw command to the band threads. Returns false if the command has to be drawn on the calling thread,
+  /// because it samples from the drawing area which the band threads could be writing to.
+  bool QueueBandCommand(const GPUBackendDrawCommand* cmd);
+  bool ReadsFromDrawingArea(const GPUBackendDrawCommand* cmd) const;
+
+  void RasterizeCommand(const GPUBackendCommand* cmd, const DrawBand& band);
+  void RasterizePolygon(const GPUBackendDrawPolygonCommand* cmd, const DrawBand& band);
+  void RasterizeRectangle(const GPUBackendDrawRectangleCommand* cmd, const DrawBand& band);
+  void RasterizeLine(const GPUBackendDrawLineCommand* cmd, const DrawBand& band);
+
+  //////////////////////////////////////////////////////////////////////////
+  // Texture cache
+  //////////////////////////////////////////////////////////////////////////
+  enum : u32
+  {
+    TEXTURE_CACHE_SIZE = 32
+  };
+
+  // A 4-bit or 8-bit texture page decoded through its CLUT. Rows are decoded the first time they're sampled, which can
+  // be on any band thread, so each row has its own valid flag. The texture window is applied to the coordinates when
+  // sampling, so it isn't part of the key.
+  struct TextureCacheEntry
+  {
+    std::array<u16, TEXTURE_PAGE_WIDTH * TEXTURE_PAGE_HEIGHT> texels;
+    std::array<std::atomic_bool, TEXTURE_PAGE_HEIGHT> row_valid;
+    std::mutex decode_mutex;
+    GPUDrawModeReg draw_mode;
+    GPUTexturePaletteReg palette;
+    u32 key;
+    u32 last_used;
+  };
+
+  static u32 GetTextureCacheKey(const GPUBackendDrawCommand* cmd);
+  bool UsesTextureCache(const GPUBackendDrawCommand* cmd) const;
+
+  /// Called on the GPU thread before a draw is rasterized or queued. Invalidates any rows the draw could overwrite,
+  /// and creates the entry which the draw will sample from.
+  void PrepareTextureCache(const GPUBackendDrawCommand* cmd);
+
+  /// Finds the entry created by PrepareTextureCache(), safe to call from the band threads.
+  TextureCacheEntry* LookupTextureCache(const GPUBackendDrawCommand* cmd);
+
+  void DecodeTextureCacheRow(TextureCacheEntry* entry, u32 row);
+  void InvalidateTextureCache(u32 x, u32 y, u32 width, u32 height);
+  void ClearTextureCache();
+
   //////////////////////////////////////////////////////////////////////////
   // Rasterization
   //////////////////////////////////////////////////////////////////////////
+  /// Returns the texel at the specified coordinates after applying the texture window, looking up the CLUT if needed.
+  u16 FetchTexel(const GPUBackendDrawCommand* cmd, TextureCacheEntry* texture_cache, u8 texcoord_x, u8 texcoord_y);
+
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
-  void ShadePixel(const GPUBackendDrawCommand* cmd, u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x,
-                  u8 texcoord_y);
+  void ShadePixel(const GPUBackendDrawCommand* cmd, TextureCacheEntry* texture_cache, u32 x, u32 y, u8 color_r,
+                  u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y);
 
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-  void DrawRectangle(const GPUBackendDrawRectangleCommand* cmd);
+  void DrawRectangle(const GPUBackendDrawRectangleCommand* cmd, const DrawBand& band,
+                     TextureCacheEntry* texture_cache);
 
-  using DrawRectangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawRectangleCommand* cmd);
+  using DrawRectangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawRectangleCommand* cmd,
+                                                         const DrawBand& band, TextureCacheEntry* texture_cache);
   DrawRectangleFunction GetDrawRectangleFunction(bool texture_enable, bool raw_texture_enable,
                                                  bool transparency_enable);
 
@@ -146,15 +256,30 @@ protected:
 
   template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
            bool dithering_enable>
-  void DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s32 x_start, s32 x_bound, i_group ig,
-                const i_deltas& idl);
+  void DrawSpan(const GPUBackendDrawPolygonCommand* cmd, TextureCacheEntry* texture_cache, s32 y, s32 x_start,
+                s32 x_bound, i_group ig, const i_deltas& idl, u32 vector_span_width);
 
+  /// Shades the span eight pixels at a time, leaving fewer than eight pixels for the scalar path. Only usable when the
+  /// command doesn't sample from the drawing area, since all texels of a group are fetched before any are written.
   template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
            bool dithering_enable>
-  void DrawTriangle(const GPUBackendDrawPolygonCommand* cmd, const GPUBackendDrawPolygonCommand::Vertex* v0,
-                    const GPUBackendDrawPolygonCommand::Vertex* v1, const GPUBackendDrawPolygonCommand::Vertex* v2);
+  void DrawSpanVector(const GPUBackendDrawPolygonCommand* cmd, TextureCacheEntry* texture_cache, u32 y, u32& x, s32& w,
+                      i_group& ig, const i_deltas& idl);
 
-  using DrawTriangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawPolygonCommand* cmd,
+  /// Same as DrawSpanVector(), sixteen pixels at a time. x64 only, and only called when the CPU supports AVX2.
+  template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
+           bool dithering_enable>
+  void DrawSpanVectorAVX2(const GPUBackendDrawPolygonCommand* cmd, TextureCacheEntry* texture_cache, u32 y, u32& x,
+                          s32& w, i_group& ig, const i_deltas& idl);
+
+  template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
+           bool dithering_enable>
+  void DrawTriangle(const GPUBackendDrawPolygonCommand* cmd, const DrawBand& band, TextureCacheEntry* texture_cache,
+                    const GPUBackendDrawPolygonCommand::Vertex* v0, const GPUBackendDrawPolygonCommand::Vertex* v1,
+                    const GPUBackendDrawPolygonCommand::Vertex* v2);
+
+  using DrawTriangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawPolygonCommand* cmd, const DrawBand& band,
+                                                        TextureCacheEntry* texture_cache,
                                                         const GPUBackendDrawPolygonCommand::Vertex* v0,
                                                         const GPUBackendDrawPolygonCommand::Vertex* v1,
                                                         const GPUBackendDrawPolygonCommand::Vertex* v2);
@@ -162,13 +287,40 @@ protected:
                                                bool transparency_enable, bool dithering_enable);
 
   template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-  void DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBackendDrawLineCommand::Vertex* p0,
-                const GPUBackendDrawLineCommand::Vertex* p1);
+  void DrawLine(const GPUBackendDrawLineCommand* cmd, const DrawBand& band,
+                const GPUBackendDrawLineCommand::Vertex* p0, const GPUBackendDrawLineCommand::Vertex* p1);
 
-  using DrawLineFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawLineCommand* cmd,
+  using DrawLineFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawLineCommand* cmd, const DrawBand& band,
                                                     const GPUBackendDrawLineCommand::Vertex* p0,
                                                     const GPUBackendDrawLineCommand::Vertex* p1);
   DrawLineFunction GetDrawLineFunction(bool shading_enable, bool transparency_enable, bool dithering_enable);
 
   std::array<u16, VRAM_WIDTH * VRAM_HEIGHT> m_vram;
+
+  // Band used when drawing on the GPU thread, which covers all rows.
+  DrawBand m_full_band;
+
+  std::vector<std::unique_ptr<BandThread>> m_band_threads;
+  std::vector<u8> m_band_command_buffer;
+  std::atomic<u32> m_band_command_write_ptr{0};
+  std::atomic<u32> m_band_threads_sleeping{0};
+  std::mutex m_band_mutex;
+  std::condition_variable m_band_wake_cv;
+  std::condition_variable m_band_done_cv;
+  bool m_band_threads_shutdown = false;
+  Common::Timer m_band_utilization_timer;
+
+  std::array<std::unique_ptr<TextureCacheEntry>, TEXTURE_CACHE_SIZE> m_texture_cache;
+  u32 m_texture_cache_counter = 0;
+
+  // Set when the drawing area changes, draws only need to invalidate the cache once per drawing area.
+  bool m_texture_cache_check_drawing_area = true;
+
+  std::atomic<u32> m_texture_cache_hits{0};
+  std::atomic<u32> m_texture_cache_misses{0};
+  std::atomic<u32> m_texture_cache_invalidations{0};
+  std::atomic<u32> m_texture_cache_decoded_rows{0};
+
+  // Widest vector path used for polygon spans, in pixels.
+  u32 m_vector_span_width = 0;
 };
@@ -0,0 +1,181 @@
+// Shared body of the vector span functions, included once per vector width by gpu_sw_backend.cpp with:
+//   VECTOR_SPAN_ISA: namespace in VectorSpan with the vector type and helpers, and the number of PIXELS per vector.
+//   VECTOR_SPAN_TARGET: function attributes needed to use those helpers.
+//   VECTOR_SPAN_FUNCTION: name of the GPU_SW_Backend member to define.
+
+namespace VectorSpan::VECTOR_SPAN_ISA {
+
+/// Vector equivalent of the dither LUT: clamp((value + offset) >> 3, 0, 31).
+static VECTOR_SPAN_TARGET ALWAYS_INLINE VecU16 Dither(VecU16 value, VecU16 offset)
+{
+  return MinS16(MaxS16(SarS16<3>(AddU16(value, offset)), SetU16(0)), SetU16(0x1F));
+}
+
+/// Returns the top 8 bits of the interpolated value for each pixel.
+static VECTOR_SPAN_TARGET ALWAYS_INLINE VecU16 Interpolate(u32 start, u32 step)
+{
+  const VecU32 lo = SetU32Ramp(start, step);
+  const VecU32 hi = AddU32(lo, SetU32(step * (PIXELS / 2)));
+  return NarrowU32(ShrU32<24>(lo), ShrU32<24>(hi));
+}
+
+} // namespace VectorSpan::VECTOR_SPAN_ISA
+
+template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
+         bool dithering_enable>
+VECTOR_SPAN_TARGET void GPU_SW_Backend::VECTOR_SPAN_FUNCTION(const GPUBackendDrawPolygonCommand* cmd,
+                                                             TextureCacheEntry* texture_cache, u32 y, u32& x, s32& w,
+                                                             i_group& ig, const i_deltas& idl)
+{
+  using namespace VectorSpan::VECTOR_SPAN_ISA;
+  static_assert((COORD_FBS + COORD_POST_PADDING) == 24, "interpolants are shifted by 24 bits");
+
+  // The dither offsets repeat every four pixels, so they're the same for each group of pixels.
+  alignas(32) u16 dither_offsets[PIXELS];
+  for (u32 i = 0; i < PIXELS; i++)
+  {
+    dither_offsets[i] = static_cast<u16>(
+      dithering_enable ? DITHER_MATRIX[y & 3u][(x + i) & 3u] : DITHER_MATRIX[2][3]);
+  }
+
+  const VecU16 dither = LoadU16(dither_offsets);
+  const VecU16 zero = SetU16(0);
+  const VecU16 mask_5bit = SetU16(0x1F);
+  const VecU16 mask_and = SetU16(cmd->params.GetMaskAND());
+  const VecU16 mask_or = SetU16(cmd->params.GetMaskOR());
+
+  do
+  {
+    VecU16 color_r, color_g, color_b;
+    if constexpr (shading_enable)
+    {
+      color_r = Interpolate(ig.r, idl.dr_dx);
+      color_g = Interpolate(ig.g, idl.dg_dx);
+      color_b = Interpolate(ig.b, idl.db_dx);
+    }
+    else
+    {
+      color_r = SetU16(Truncate16(ig.r >> 24));
+      color_g = SetU16(Truncate16(ig.g >> 24));
+      color_b = SetU16(Truncate16(ig.b >> 24));
+    }
+
+    VecU16 color;
+    VecU16 texture_color;
+    if constexpr (texture_enable)
+    {
+      // No gathers here, so the texels are fetched one at a time.
+      const auto FetchNextTexel = [this, cmd, texture_cache, &ig, &idl]() {
+        const u16 texel = FetchTexel(cmd, texture_cache, Truncate8(ig.u >> 24), Truncate8(ig.v >> 24));
+        ig.u += idl.du_dx;
+        ig.v += idl.dv_dx;
+        return texel;
+      };
+
+      texture_color = SetU16(FetchNextTexel());
+      texture_color = InsertU16<1>(texture_color, FetchNextTexel());
+      texture_color = InsertU16<2>(texture_color, FetchNextTexel());
+      texture_color = InsertU16<3>(texture_color, FetchNextTexel());
+      texture_color = InsertU16<4>(texture_color, FetchNextTexel());
+      texture_color = InsertU16<5>(texture_color, FetchNextTexel());
+      texture_color = InsertU16<6>(texture_color, FetchNextTexel());
+      texture_color = InsertU16<7>(texture_color, FetchNextTexel());
+      if constexpr (PIXELS > 8)
+      {
+        texture_color = InsertU16<8>(texture_color, FetchNextTexel());
+        texture_color = InsertU16<9>(texture_color, FetchNextTexel());
+        texture_color = InsertU16<10>(texture_color, FetchNextTexel());
+        texture_color = InsertU16<11>(texture_color, FetchNextTexel());
+        texture_color = InsertU16<12>(texture_color, FetchNextTexel());
+        texture_color = InsertU16<13>(texture_color, FetchNextTexel());
+        texture_color = InsertU16<14>(texture_color, FetchNextTexel());
+        texture_color = InsertU16<15>(texture_color, FetchNextTexel());
+      }
+      if constexpr (raw_texture_enable)
+      {
+        color = texture_color;
+      }
+      else
+      {
+        const VecU16 r = Dither(ShrU16<4>(MulU16(AndU16(texture_color, mask_5bit), color_r)), dither);
+        const VecU16 g = Dither(ShrU16<4>(MulU16(AndU16(ShrU16<5>(texture_color), mask_5bit), color_g)), dither);
+        const VecU16 b = Dither(ShrU16<4>(MulU16(AndU16(ShrU16<10>(texture_color), mask_5bit), color_b)), dither);
+        color = OrU16(OrU16(r, ShlU16<5>(g)), OrU16(ShlU16<10>(b), AndU16(texture_color, SetU16(0x8000))));
+      }
+    }
+    else
+    {
+      color = OrU16(OrU16(Dither(color_r, dither), ShlU16<5>(Dither(color_g, dither))),
+                    ShlU16<10>(Dither(color_b, dither)));
+    }
+
+    u16* const pixels = GetPixelPtr(x, y);
+    const VecU16 bg_color = LoadU16(pixels);
+    if constexpr (transparency_enable)
+    {
+      const VecU16 bg_r = AndU16(bg_color, mask_5bit);
+      const VecU16 bg_g = AndU16(ShrU16<5>(bg_color), mask_5bit);
+      const VecU16 bg_b = AndU16(ShrU16<10>(bg_color), mask_5bit);
+      const VecU16 fg_r = AndU16(color, mask_5bit);
+      const VecU16 fg_g = AndU16(ShrU16<5>(color), mask_5bit);
+      const VecU16 fg_b = AndU16(ShrU16<10>(color), mask_5bit);
+
+      VecU16 r, g, b;
+      bool blend = true;
+      switch (cmd->draw_mode.transparency_mode)
+      {
+        case GPUTransparencyMode::HalfBackgroundPlusHalfForeground:
+          r = MinS16(AddU16(ShrU16<1>(bg_r), ShrU16<1>(fg_r)), mask_5bit);
+          g = MinS16(AddU16(ShrU16<1>(bg_g), ShrU16<1>(fg_g)), mask_5bit);
+          b = MinS16(AddU16(ShrU16<1>(bg_b), ShrU16<1>(fg_b)), mask_5bit);
+          break;
+        case GPUTransparencyMode::BackgroundPlusForeground:
+          r = MinS16(AddU16(bg_r, fg_r), mask_5bit);
+          g = MinS16(AddU16(bg_g, fg_g), mask_5bit);
+          b = MinS16(AddU16(bg_b, fg_b), mask_5bit);
+          break;
+        case GPUTransparencyMode::BackgroundMinusForeground:
+          r = SubSatU16(bg_r, fg_r);
+          g = SubSatU16(bg_g, fg_g);
+          b = SubSatU16(bg_b, fg_b);
+          break;
+        case GPUTransparencyMode::BackgroundPlusQuarterForeground:
+          r = MinS16(AddU16(bg_r, ShrU16<2>(fg_r)), mask_5bit);
+          g = MinS16(AddU16(bg_g, ShrU16<2>(fg_g)), mask_5bit);
+          b = MinS16(AddU16(bg_b, ShrU16<2>(fg_b)), mask_5bit);
+          break;
+        default:
+          r = g = b = zero;
+          blend = false;
+          break;
+      }
+
+      if (blend)
+      {
+        const VecU16 blended =
+          OrU16(OrU16(r, ShlU16<5>(g)), OrU16(ShlU16<10>(b), AndU16(color, SetU16(0x8000))));
+
+        // Textured pixels are only blended when the texel has the semi-transparency bit set.
+        if constexpr (texture_enable)
+          color = Select(SarS16<15>(texture_color), blended, color);
+        else
+          color = blended;
+      }
+    }
+
+    VecU16 result = Select(CmpEqU16(AndU16(bg_color, mask_and), zero), OrU16(color, mask_or), bg_color);
+    if constexpr (texture_enable)
+      result = Select(CmpEqU16(texture_color, zero), bg_color, result);
+
+    StoreU16(pixels, result);
+
+    AddIDeltas_DX<shading_enable, false>(ig, idl, PIXELS);
+    x += PIXELS;
+    w -= PIXELS;
+  } while (w >= static_cast<s32>(PIXELS));
+}
+
+
+#undef VECTOR_SPAN_FUNCTION
+#undef VECTOR_SPAN_TARGET
+#undef VECTOR_SPAN_ISA
@@ -16,9 +16,14 @@ void WriteRegister(u32 index, u32 value);
 // use with care, direct register access
 u32* GetRegisterPtr(u32 index);
 
+// reciprocal table for the RTPS/RTPT divide, for the recompiler
+const u8* GetUNRTable();
+
 void ExecuteInstruction(u32 inst_bits);
 
 using InstructionImpl = void (*)(Instruction);
-InstructionImpl GetInstructionImpl(u32 inst_bits);
+
+/// Takes the PGXP culling setting rather than reading it, so that blocks can be compiled off the CPU thread.
+InstructionImpl GetInstructionImpl(u32 inst_bits, bool pgxp_culling);
 
 } // namespace GTE
@@ -206,9 +206,11 @@ public:
   bool WriteDisplayTextureToBuffer(std::vector<u32>* buffer, u32 resize_width = 0, u32 resize_height = 0,
                                    bool clear_alpha = true);
 
+  /// Returns true if a display texture is set, i.e. the last frame which was set can be displayed again.
+  ALWAYS_INLINE bool HasDisplayTexture() const { return (m_display_texture_handle != nullptr); }
+
 protected:
   ALWAYS_INLINE bool HasSoftwareCursor() const { return static_cast<bool>(m_cursor_texture); }
-  ALWAYS_INLINE bool HasDisplayTexture() const { return (m_display_texture_handle != nullptr); }
 
   void CalculateDrawRect(s32 window_width, s32 window_height, s32* out_left, s32* out_top, s32* out_width,
                          s32* out_height, s32* out_left_padding, s32* out_top_padding, float* out_scale,
@@ -440,6 +440,7 @@ void HostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetBoolValue("GPU", "UseDebugDevice", false);
   si.SetBoolValue("GPU", "PerSampleShading", false);
   si.SetBoolValue("GPU", "UseThread", true);
+  si.SetIntValue("GPU", "SWThreadCount", 0);
   si.SetBoolValue("GPU", "TrueColor", false);
   si.SetBoolValue("GPU", "ScaledDithering", true);
   si.SetStringValue("GPU", "TextureFilter", Settings::GetTextureFilterName(Settings::DEFAULT_GPU_TEXTURE_FILTER));
@@ -644,12 +645,86 @@ void HostInterface::CheckForSettingsChanges(const Settings& old_settings)
       CPU::ClearICache();
     }
 
+    if (g_settings.cpu_execution_mode == CPUExecutionMode::Recompiler &&
+        g_settings.cpu_recompiler_block_cache != old_settings.cpu_recompiler_block_cache)
+    {
+      AddOSDMessage(g_settings.cpu_recompiler_block_cache ?
+                      TranslateStdString("OSDMessage", "Recompiler block cache enabled, flushing all blocks.") :
+                      TranslateStdString("OSDMessage", "Recompiler block cache disabled, flushing all blocks."),
+                    5.0f);
+      CPU::CodeCache::Flush();
+    }
+
+    if (g_settings.cpu_execution_mode == CPUExecutionMode::Recompiler &&
+        (g_settings.cpu_recompiler_tiering != old_settings.cpu_recompiler_tiering ||
+         (g_settings.cpu_recompiler_tiering &&
+          (g_settings.cpu_recompiler_tiering_threshold != old_settings.cpu_recompiler_tiering_threshold ||
+           g_settings.cpu_recompiler_superblock_max_blocks != old_settings.cpu_recompiler_superblock_max_blocks))))
+    {
+      AddOSDMessage(g_settings.cpu_recompiler_tiering ?
+                      TranslateStdString("OSDMessage", "Recompiler tiering enabled, flushing all blocks.") :
+                      TranslateStdString("OSDMessage", "Recompiler tiering disabled, flushing all blocks."),
+                    5.0f);
+      CPU::CodeCache::Flush();
+    }
+
+    if (g_settings.cpu_execution_mode != CPUExecutionMode::Interpreter &&
+        g_settings.cpu_recompiler_block_profiling != old_settings.cpu_recompiler_block_profiling)
+    {
+      AddOSDMessage(g_settings.cpu_recompiler_block_profiling ?
+                      TranslateStdString("OSDMessage", "Block profiling enabled, flushing all blocks.") :
+                      TranslateStdString("OSDMessage", "Block profiling disabled, flushing all blocks."),
+                    5.0f);
+      CPU::CodeCache::Flush();
+    }
+
+    if (g_settings.cpu_execution_mode == CPUExecutionMode::Recompiler &&
+        g_settings.cpu_recompiler_async_compile != old_settings.cpu_recompiler_async_compile)
+    {
+      AddOSDMessage(g_settings.cpu_recompiler_async_compile ?
+                      TranslateStdString("OSDMessage", "Background compilation enabled, flushing all blocks.") :
+                      TranslateStdString("OSDMessage", "Background compilation disabled, flushing all blocks."),
+                    5.0f);
+      CPU::CodeCache::Reinitialize();
+    }
+
+    if (g_settings.cpu_execution_mode == CPUExecutionMode::Recompiler &&
+        g_settings.cpu_recompiler_return_stack != old_settings.cpu_recompiler_return_stack)
+    {
+      AddOSDMessage(g_settings.cpu_recompiler_return_stack ?
+                      TranslateStdString("OSDMessage", "Return address prediction enabled, flushing all blocks.") :
+                      TranslateStdString("OSDMessage", "Return address prediction disabled, flushing all blocks."),
+                    5.0f);
+      CPU::CodeCache::Flush();
+    }
+
+    if (g_settings.cpu_execution_mode == CPUExecutionMode::Recompiler &&
+        g_settings.cpu_recompiler_pinned_registers != old_settings.cpu_recompiler_pinned_registers)
+    {
+      AddOSDMessage(TranslateStdString("OSDMessage", "Recompiler pinned registers changed, flushing all blocks."),
+                    5.0f);
+      CPU::CodeCache::Flush();
+    }
+
+    if (g_settings.cpu_execution_mode != CPUExecutionMode::Interpreter &&
+        g_settings.cpu_idle_loop_skipping != old_settings.cpu_idle_loop_skipping)
+    {
+      AddOSDMessage(g_settings.cpu_idle_loop_skipping ?
+                      TranslateStdString("OSDMessage", "Idle loop skipping enabled, flushing all blocks.") :
+                      TranslateStdString("OSDMessage", "Idle loop skipping disabled, flushing all blocks."),
+                    5.0f);
+      CPU::CodeCache::Flush();
+    }
+
     m_audio_stream->SetOutputVolume(GetAudioOutputVolume());
 
     if (g_settings.gpu_resolution_scale != old_settings.gpu_resolution_scale ||
         g_settings.gpu_multisamples != old_settings.gpu_multisamples ||
         g_settings.gpu_per_sample_shading != old_settings.gpu_per_sample_shading ||
         g_settings.gpu_use_thread != old_settings.gpu_use_thread ||
+        g_settings.gpu_sw_thread_count != old_settings.gpu_sw_thread_count ||
+        g_settings.gpu_sw_vector_span_width != old_settings.gpu_sw_vector_span_width ||
+        g_settings.gpu_use_render_thread != old_settings.gpu_use_render_thread ||
         g_settings.gpu_fifo_size != old_settings.gpu_fifo_size ||
         g_settings.gpu_max_run_ahead != old_settings.gpu_max_run_ahead ||
         g_settings.gpu_true_color != old_settings.gpu_true_color ||
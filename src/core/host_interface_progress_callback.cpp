@@ -2,7 +2,10 @@
 #include "common/log.h"
 Log_SetChannel(HostInterfaceProgressCallback);
 
-HostInterfaceProgressCallback::HostInterfaceProgressCallback() : BaseProgressCallback() {}
+HostInterfaceProgressCallback::HostInterfaceProgressCallback(float min_redraw_interval /* = 0.0f */)
+  : BaseProgressCallback(), m_min_redraw_interval(min_redraw_interval)
+{
+}
 
 void HostInterfaceProgressCallback::PushState() { BaseProgressCallback::PushState(); }
 
@@ -56,6 +59,14 @@ void HostInterfaceProgressCallback::Redraw(bool force)
   if (percent == m_last_progress_percent && !force)
     return;
 
+  if (m_min_redraw_interval > 0.0f)
+  {
+    if (m_redraw_timer.GetTimeSeconds() < m_min_redraw_interval)
+      return;
+
+    m_redraw_timer.Reset();
+  }
+
   m_last_progress_percent = percent;
   g_host_interface->DisplayLoadingScreen(m_status_text, 0, static_cast<int>(m_progress_range),
                                          static_cast<int>(m_progress_value));
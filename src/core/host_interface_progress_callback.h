@@ -1,11 +1,14 @@
 #pragma once
 #include "common/progress_callback.h"
+#include "common/timer.h"
 #include "host_interface.h"
 
 class HostInterfaceProgressCallback final : public BaseProgressCallback
 {
 public:
-  HostInterfaceProgressCallback();
+  /// When min_redraw_interval is set, nothing is drawn until that many seconds have passed, and then no more often
+  /// than that. This keeps quick operations from flashing the loading screen.
+  explicit HostInterfaceProgressCallback(float min_redraw_interval = 0.0f);
 
   void PushState() override;
   void PopState() override;
@@ -28,5 +31,7 @@ public:
 private:
   void Redraw(bool force);
 
+  Common::Timer m_redraw_timer;
+  float m_min_redraw_interval;
   int m_last_progress_percent = -1;
 };
@@ -131,6 +131,20 @@ void Settings::Load(SettingsInterface& si)
   UpdateOverclockActive();
   cpu_recompiler_memory_exceptions = si.GetBoolValue("CPU", "RecompilerMemoryExceptions", false);
   cpu_recompiler_icache = si.GetBoolValue("CPU", "RecompilerICache", false);
+  cpu_recompiler_block_cache = si.GetBoolValue("CPU", "RecompilerBlockCache", false);
+  cpu_recompiler_tiering = si.GetBoolValue("CPU", "RecompilerTiering", false);
+  cpu_recompiler_tiering_threshold = static_cast<u32>(
+    std::max(si.GetIntValue("CPU", "RecompilerTieringThreshold", DEFAULT_CPU_RECOMPILER_TIERING_THRESHOLD), 1));
+  cpu_recompiler_superblock_max_blocks = static_cast<u32>(std::max(
+    si.GetIntValue("CPU", "RecompilerSuperblockMaxBlocks", DEFAULT_CPU_RECOMPILER_SUPERBLOCK_MAX_BLOCKS), 2));
+  cpu_recompiler_block_profiling = si.GetBoolValue("CPU", "RecompilerBlockProfiling", false);
+  cpu_recompiler_async_compile = si.GetBoolValue("CPU", "RecompilerAsyncCompile", false);
+  cpu_recompiler_async_compile_queue_depth = static_cast<u32>(std::max(
+    si.GetIntValue("CPU", "RecompilerAsyncCompileQueueDepth", DEFAULT_CPU_RECOMPILER_ASYNC_COMPILE_QUEUE_DEPTH), 1));
+  cpu_recompiler_return_stack = si.GetBoolValue("CPU", "RecompilerReturnStack", false);
+  cpu_recompiler_pinned_registers =
+    static_cast<u32>(std::clamp(si.GetIntValue("CPU", "RecompilerPinnedRegisters", 0), 0, 3));
+  cpu_idle_loop_skipping = si.GetBoolValue("CPU", "IdleLoopSkipping", false);
   cpu_fastmem_mode = ParseCPUFastmemMode(
                        si.GetStringValue("CPU", "FastmemMode", GetCPUFastmemModeName(DEFAULT_CPU_FASTMEM_MODE)).c_str())
                        .value_or(DEFAULT_CPU_FASTMEM_MODE);
@@ -143,6 +157,9 @@ void Settings::Load(SettingsInterface& si)
   gpu_use_debug_device = si.GetBoolValue("GPU", "UseDebugDevice", false);
   gpu_per_sample_shading = si.GetBoolValue("GPU", "PerSampleShading", false);
   gpu_use_thread = si.GetBoolValue("GPU", "UseThread", true);
+  gpu_sw_thread_count = static_cast<u32>(std::clamp(si.GetIntValue("GPU", "SWThreadCount", 0), 0, 16));
+  gpu_sw_vector_span_width = static_cast<u32>(std::clamp(si.GetIntValue("GPU", "SWVectorSpanWidth", 16), 0, 16));
+  gpu_use_render_thread = si.GetBoolValue("GPU", "UseRenderThread", false);
   gpu_true_color = si.GetBoolValue("GPU", "TrueColor", true);
   gpu_scaled_dithering = si.GetBoolValue("GPU", "ScaledDithering", false);
   gpu_texture_filter =
@@ -245,12 +262,17 @@ void Settings::Load(SettingsInterface& si)
   debugging.show_vram = si.GetBoolValue("Debug", "ShowVRAM");
   debugging.dump_cpu_to_vram_copies = si.GetBoolValue("Debug", "DumpCPUToVRAMCopies");
   debugging.dump_vram_to_cpu_copies = si.GetBoolValue("Debug", "DumpVRAMToCPUCopies");
+  debugging.profile_timing_events = si.GetBoolValue("Debug", "ProfileTimingEvents", false);
+  debugging.timing_event_profile_dump_interval =
+    static_cast<u32>(std::max(si.GetIntValue("Debug", "TimingEventProfileDumpInterval", 0), 0));
   debugging.show_gpu_state = si.GetBoolValue("Debug", "ShowGPUState");
   debugging.show_cdrom_state = si.GetBoolValue("Debug", "ShowCDROMState");
   debugging.show_spu_state = si.GetBoolValue("Debug", "ShowSPUState");
   debugging.show_timers_state = si.GetBoolValue("Debug", "ShowTimersState");
   debugging.show_mdec_state = si.GetBoolValue("Debug", "ShowMDECState");
   debugging.show_dma_state = si.GetBoolValue("Debug", "ShowDMAState");
+  debugging.show_block_profile = si.GetBoolValue("Debug", "ShowBlockProfile");
+  debugging.show_timing_events = si.GetBoolValue("Debug", "ShowTimingEvents");
 }
 
 void Settings::Save(SettingsInterface& si) const
@@ -275,6 +297,16 @@ void Settings::Save(SettingsInterface& si) const
   si.SetIntValue("CPU", "OverclockDenominator", cpu_overclock_denominator);
   si.SetBoolValue("CPU", "RecompilerMemoryExceptions", cpu_recompiler_memory_exceptions);
   si.SetBoolValue("CPU", "RecompilerICache", cpu_recompiler_icache);
+  si.SetBoolValue("CPU", "RecompilerBlockCache", cpu_recompiler_block_cache);
+  si.SetBoolValue("CPU", "RecompilerTiering", cpu_recompiler_tiering);
+  si.SetIntValue("CPU", "RecompilerTieringThreshold", static_cast<int>(cpu_recompiler_tiering_threshold));
+  si.SetIntValue("CPU", "RecompilerSuperblockMaxBlocks", static_cast<int>(cpu_recompiler_superblock_max_blocks));
+  si.SetBoolValue("CPU", "RecompilerBlockProfiling", cpu_recompiler_block_profiling);
+  si.SetBoolValue("CPU", "RecompilerAsyncCompile", cpu_recompiler_async_compile);
+  si.SetIntValue("CPU", "RecompilerAsyncCompileQueueDepth", static_cast<int>(cpu_recompiler_async_compile_queue_depth));
+  si.SetBoolValue("CPU", "RecompilerReturnStack", cpu_recompiler_return_stack);
+  si.SetIntValue("CPU", "RecompilerPinnedRegisters", static_cast<int>(cpu_recompiler_pinned_registers));
+  si.SetBoolValue("CPU", "IdleLoopSkipping", cpu_idle_loop_skipping);
   si.SetStringValue("CPU", "FastmemMode", GetCPUFastmemModeName(cpu_fastmem_mode));
 
   si.SetStringValue("GPU", "Renderer", GetRendererName(gpu_renderer));
@@ -284,6 +316,9 @@ void Settings::Save(SettingsInterface& si) const
   si.SetBoolValue("GPU", "UseDebugDevice", gpu_use_debug_device);
   si.SetBoolValue("GPU", "PerSampleShading", gpu_per_sample_shading);
   si.SetBoolValue("GPU", "UseThread", gpu_use_thread);
+  si.SetIntValue("GPU", "SWThreadCount", static_cast<int>(gpu_sw_thread_count));
+  si.SetIntValue("GPU", "SWVectorSpanWidth", static_cast<int>(gpu_sw_vector_span_width));
+  si.SetBoolValue("GPU", "UseRenderThread", gpu_use_render_thread);
   si.SetBoolValue("GPU", "TrueColor", gpu_true_color);
   si.SetBoolValue("GPU", "ScaledDithering", gpu_scaled_dithering);
   si.SetStringValue("GPU", "TextureFilter", GetTextureFilterName(gpu_texture_filter));
@@ -369,12 +404,17 @@ void Settings::Save(SettingsInterface& si) const
   si.SetBoolValue("Debug", "ShowVRAM", debugging.show_vram);
   si.SetBoolValue("Debug", "DumpCPUToVRAMCopies", debugging.dump_cpu_to_vram_copies);
   si.SetBoolValue("Debug", "DumpVRAMToCPUCopies", debugging.dump_vram_to_cpu_copies);
+  si.SetBoolValue("Debug", "ProfileTimingEvents", debugging.profile_timing_events);
+  si.SetIntValue("Debug", "TimingEventProfileDumpInterval",
+                 static_cast<int>(debugging.timing_event_profile_dump_interval));
   si.SetBoolValue("Debug", "ShowGPUState", debugging.show_gpu_state);
   si.SetBoolValue("Debug", "ShowCDROMState", debugging.show_cdrom_state);
   si.SetBoolValue("Debug", "ShowSPUState", debugging.show_spu_state);
   si.SetBoolValue("Debug", "ShowTimersState", debugging.show_timers_state);
   si.SetBoolValue("Debug", "ShowMDECState", debugging.show_mdec_state);
   si.SetBoolValue("Debug", "ShowDMAState", debugging.show_dma_state);
+  si.SetBoolValue("Debug", "ShowBlockProfile", debugging.show_block_profile);
+  si.SetBoolValue("Debug", "ShowTimingEvents", debugging.show_timing_events);
 }
 
 static std::array<const char*, LOGLEVEL_COUNT> s_log_level_names = {
@@ -76,6 +76,16 @@ struct Settings
   bool cpu_overclock_active = false;
   bool cpu_recompiler_memory_exceptions = false;
   bool cpu_recompiler_icache = false;
+  bool cpu_recompiler_block_cache = false;
+  bool cpu_recompiler_tiering = false;
+  u32 cpu_recompiler_tiering_threshold = DEFAULT_CPU_RECOMPILER_TIERING_THRESHOLD;
+  u32 cpu_recompiler_superblock_max_blocks = DEFAULT_CPU_RECOMPILER_SUPERBLOCK_MAX_BLOCKS;
+  bool cpu_recompiler_block_profiling = false;
+  bool cpu_recompiler_async_compile = false;
+  u32 cpu_recompiler_async_compile_queue_depth = DEFAULT_CPU_RECOMPILER_ASYNC_COMPILE_QUEUE_DEPTH;
+  bool cpu_recompiler_return_stack = false;
+  u32 cpu_recompiler_pinned_registers = 0;
+  bool cpu_idle_loop_skipping = false;
   CPUFastmemMode cpu_fastmem_mode = CPUFastmemMode::Disabled;
 
   float emulation_speed = 1.0f;
@@ -96,6 +106,9 @@ struct Settings
   u32 gpu_resolution_scale = 1;
   u32 gpu_multisamples = 1;
   bool gpu_use_thread = true;
+  u32 gpu_sw_thread_count = 0;
+  u32 gpu_sw_vector_span_width = 16;
+  bool gpu_use_render_thread = false;
   bool gpu_use_debug_device = false;
   bool gpu_per_sample_shading = false;
   bool gpu_true_color = true;
@@ -159,6 +172,8 @@ struct Settings
     bool show_vram = false;
     bool dump_cpu_to_vram_copies = false;
     bool dump_vram_to_cpu_copies = false;
+    bool profile_timing_events = false;
+    u32 timing_event_profile_dump_interval = 0;
 
     // Mutable because the imgui window can close itself.
     mutable bool show_gpu_state = false;
@@ -167,6 +182,8 @@ struct Settings
     mutable bool show_timers_state = false;
     mutable bool show_mdec_state = false;
     mutable bool show_dma_state = false;
+    mutable bool show_block_profile = false;
+    mutable bool show_timing_events = false;
   } debugging;
 
   // TODO: Controllers, memory cards, etc.
@@ -222,7 +239,10 @@ struct Settings
     DEFAULT_DMA_MAX_SLICE_TICKS = 1000,
     DEFAULT_DMA_HALT_TICKS = 100,
     DEFAULT_GPU_FIFO_SIZE = 16,
-    DEFAULT_GPU_MAX_RUN_AHEAD = 128
+    DEFAULT_GPU_MAX_RUN_AHEAD = 128,
+    DEFAULT_CPU_RECOMPILER_TIERING_THRESHOLD = 1000,
+    DEFAULT_CPU_RECOMPILER_SUPERBLOCK_MAX_BLOCKS = 4,
+    DEFAULT_CPU_RECOMPILER_ASYNC_COMPILE_QUEUE_DEPTH = 32
   };
 
   void Load(SettingsInterface& si);
@@ -92,9 +92,15 @@ static float s_fps = 0.0f;
 static float s_speed = 0.0f;
 static float s_worst_frame_time = 0.0f;
 static float s_average_frame_time = 0.0f;
+static float s_block_invalidations_per_second = 0.0f;
+static float s_block_compiles_per_second = 0.0f;
+static float s_idle_loop_skipped_ticks_per_frame = 0.0f;
 static u32 s_last_frame_number = 0;
 static u32 s_last_internal_frame_number = 0;
 static u32 s_last_global_tick_counter = 0;
+static u32 s_last_block_invalidation_count = 0;
+static u32 s_last_block_compile_count = 0;
+static u64 s_last_idle_loop_skipped_ticks = 0;
 static Common::Timer s_fps_timer;
 static Common::Timer s_frame_timer;
 
@@ -218,6 +224,18 @@ float GetWorstFrameTime()
 {
   return s_worst_frame_time;
 }
+float GetBlockInvalidationsPerSecond()
+{
+  return s_block_invalidations_per_second;
+}
+float GetBlockCompilesPerSecond()
+{
+  return s_block_compiles_per_second;
+}
+float GetIdleLoopSkippedTicksPerFrame()
+{
+  return s_idle_loop_skipped_ticks_per_frame;
+}
 float GetThrottleFrequency()
 {
   return s_throttle_frequency;
@@ -722,9 +740,15 @@ bool Initialize(bool force_software_renderer)
   s_speed = 0.0f;
   s_worst_frame_time = 0.0f;
   s_average_frame_time = 0.0f;
+  s_block_invalidations_per_second = 0.0f;
+  s_block_compiles_per_second = 0.0f;
+  s_idle_loop_skipped_ticks_per_frame = 0.0f;
   s_last_frame_number = 0;
   s_last_internal_frame_number = 0;
   s_last_global_tick_counter = 0;
+  s_last_block_invalidation_count = CPU::CodeCache::GetInvalidationCount();
+  s_last_block_compile_count = CPU::CodeCache::GetCompileCount();
+  s_last_idle_loop_skipped_ticks = CPU::CodeCache::GetIdleLoopSkippedTicks();
   s_fps_timer.Reset();
   s_frame_timer.Reset();
 
@@ -1140,6 +1164,9 @@ bool SaveState(ByteStream* state, u32 screenshot_size /* = 128 */)
 
     g_gpu->RestoreGraphicsAPIState();
 
+    // Start reading back VRAM now, so it can complete while the components before the GPU are written.
+    g_gpu->BeginSaveStateVRAMRead();
+
     StateWrapper sw(state, StateWrapper::Mode::Write, SAVE_STATE_VERSION);
     const bool result = DoState(sw, false);
 
@@ -1192,6 +1219,8 @@ void RunFrame()
   // Generate any pending samples from the SPU before sleeping, this way we reduce the chances of underruns.
   g_spu.GeneratePendingSamples();
 
+  TimingEvents::ProfileFrameDone();
+
   if (s_cheat_list)
     s_cheat_list->Apply();
 
@@ -1281,6 +1310,7 @@ void UpdatePerformanceCounters()
     return;
 
   const float frames_presented = static_cast<float>(s_frame_number - s_last_frame_number);
+  const u32 internal_frames = s_internal_frame_number - s_last_internal_frame_number;
   const u32 global_tick_counter = TimingEvents::GetGlobalTickCounter();
 
   s_worst_frame_time = s_worst_frame_time_accumulator;
@@ -1289,16 +1319,34 @@ void UpdatePerformanceCounters()
   s_average_frame_time_accumulator = 0.0f;
   s_vps = static_cast<float>(frames_presented / time);
   s_last_frame_number = s_frame_number;
-  s_fps = static_cast<float>(s_internal_frame_number - s_last_internal_frame_number) / time;
+  s_fps = static_cast<float>(internal_frames) / time;
   s_last_internal_frame_number = s_internal_frame_number;
   s_speed = static_cast<float>(static_cast<double>(global_tick_counter - s_last_global_tick_counter) /
                                (static_cast<double>(g_ticks_per_second) * time)) *
             100.0f;
   s_last_global_tick_counter = global_tick_counter;
+
+  const u32 block_invalidation_count = CPU::CodeCache::GetInvalidationCount();
+  const u32 block_compile_count = CPU::CodeCache::GetCompileCount();
+  s_block_invalidations_per_second =
+    static_cast<float>(block_invalidation_count - s_last_block_invalidation_count) / time;
+  s_block_compiles_per_second = static_cast<float>(block_compile_count - s_last_block_compile_count) / time;
+  s_last_block_invalidation_count = block_invalidation_count;
+  s_last_block_compile_count = block_compile_count;
+
+  const u64 idle_loop_skipped_ticks = CPU::CodeCache::GetIdleLoopSkippedTicks();
+  s_idle_loop_skipped_ticks_per_frame =
+    (internal_frames > 0) ?
+      static_cast<float>(static_cast<double>(idle_loop_skipped_ticks - s_last_idle_loop_skipped_ticks) /
+                         static_cast<double>(internal_frames)) :
+      0.0f;
+  s_last_idle_loop_skipped_ticks = idle_loop_skipped_ticks;
   s_fps_timer.Reset();
 
   Log_VerbosePrintf("FPS: %.2f VPS: %.2f Average: %.2fms Worst: %.2fms", s_fps, s_vps, s_average_frame_time,
                     s_worst_frame_time);
+  Log_VerbosePrintf("Block invalidations: %.0f/s Block compiles: %.0f/s", s_block_invalidations_per_second,
+                    s_block_compiles_per_second);
 
   g_host_interface->OnSystemPerformanceCountersUpdated();
 }
@@ -1308,6 +1356,9 @@ void ResetPerformanceCounters()
   s_last_frame_number = s_frame_number;
   s_last_internal_frame_number = s_internal_frame_number;
   s_last_global_tick_counter = TimingEvents::GetGlobalTickCounter();
+  s_last_block_invalidation_count = CPU::CodeCache::GetInvalidationCount();
+  s_last_block_compile_count = CPU::CodeCache::GetCompileCount();
+  s_last_idle_loop_skipped_ticks = CPU::CodeCache::GetIdleLoopSkippedTicks();
   s_average_frame_time_accumulator = 0.0f;
   s_worst_frame_time_accumulator = 0.0f;
   s_fps_timer.Reset();
@@ -132,6 +132,9 @@ float GetVPS();
 float GetEmulationSpeed();
 float GetAverageFrameTime();
 float GetWorstFrameTime();
+float GetBlockInvalidationsPerSecond();
+float GetBlockCompilesPerSecond();
+float GetIdleLoopSkippedTicksPerFrame();
 float GetThrottleFrequency();
 
 bool Boot(const SystemBootParameters& params);
@@ -1,20 +1,34 @@
 #include "timing_event.h"
 #include "common/assert.h"
+#include "common/file_system.h"
 #include "common/log.h"
 #include "common/state_wrapper.h"
+#include "common/timer.h"
 #include "cpu_core.h"
 #include "cpu_core_private.h"
+#include "host_interface.h"
+#include "settings.h"
 #include "system.h"
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#ifdef WITH_IMGUI
+#include "imgui.h"
+#endif
 Log_SetChannel(TimingEvents);
 
 namespace TimingEvents {
 
-static TimingEvent* s_active_events_head;
-static TimingEvent* s_active_events_tail;
+// Active events, sorted by downcount. A newly added event runs before any events with the same downcount.
+static std::array<TimingEvent*, MAX_ACTIVE_EVENTS> s_active_events = {};
 static TimingEvent* s_current_event = nullptr;
 static u32 s_active_event_count = 0;
 static u32 s_global_tick_counter = 0;
 
+// Profiles are keyed by event name, so they survive the events being recreated when the system boots.
+static std::vector<TimingEventProfile> s_profiles;
+static u32 s_profile_frame_count = 0;
+
 u32 GetGlobalTickCounter()
 {
   return s_global_tick_counter;
@@ -36,10 +50,10 @@ void Shutdown()
 }
 
 std::unique_ptr<TimingEvent> CreateTimingEvent(std::string name, TickCount period, TickCount interval,
-                                               TimingEventCallback callback, bool activate)
+                                               TimingEventCallback callback, void* callback_param, bool activate)
 {
   std::unique_ptr<TimingEvent> event =
-    std::make_unique<TimingEvent>(std::move(name), period, interval, std::move(callback));
+    std::make_unique<TimingEvent>(std::move(name), period, interval, callback, callback_param);
   if (activate)
     event->Activate();
 
@@ -51,208 +65,157 @@ void UpdateCPUDowncount()
   if (!CPU::g_state.frame_done &&
       (!CPU::HasPendingInterrupt() || g_settings.cpu_execution_mode == CPUExecutionMode::Interpreter))
   {
-    CPU::g_state.downcount = s_active_events_head->GetDowncount();
+    CPU::g_state.downcount = s_active_events[0]->GetDowncount();
   }
 }
 
+TickCount FastForwardIdleLoop(TickCount iteration_ticks)
+{
+  const TickCount ticks_until_event = CPU::g_state.downcount - CPU::g_state.pending_ticks;
+  if (ticks_until_event <= iteration_ticks)
+    return 0;
+
+  const TickCount ticks = ((ticks_until_event - 1) / iteration_ticks) * iteration_ticks;
+  CPU::AddPendingTicks(ticks);
+  return ticks;
+}
+
 TimingEvent** GetHeadEventPtr()
 {
-  return &s_active_events_head;
+  return &s_active_events[0];
+}
+
+static ALWAYS_INLINE void SetActiveEvent(u32 index, TimingEvent* event)
+{
+  s_active_events[index] = event;
+  event->m_active_index = index;
 }
 
 static void SortEvent(TimingEvent* event)
 {
   const TickCount event_downcount = event->m_downcount;
+  const u32 index = event->m_active_index;
+  DebugAssert(s_active_events[index] == event);
 
-  if (event->prev && event->prev->m_downcount > event_downcount)
+  if (index > 0 && s_active_events[index - 1]->m_downcount > event_downcount)
   {
-    // move backwards
-    TimingEvent* current = event->prev;
-    while (current && current->m_downcount > event_downcount)
-      current = current->prev;
-
-    // unlink
-    if (event->prev)
-      event->prev->next = event->next;
-    else
-      s_active_events_head = event->next;
-    if (event->next)
-      event->next->prev = event->prev;
-    else
-      s_active_events_tail = event->prev;
-
-    // insert after current
-    if (current)
-    {
-      event->next = current->next;
-      if (current->next)
-        current->next->prev = event;
-      else
-        s_active_events_tail = event;
-
-      event->prev = current;
-      current->next = event;
-    }
-    else
-    {
-      // insert at front
-      DebugAssert(s_active_events_head);
-      s_active_events_head->prev = event;
-      event->prev = nullptr;
-      event->next = s_active_events_head;
-      s_active_events_head = event;
+    // move backwards, after any events with the same downcount
+    u32 new_index = index - 1;
+    while (new_index > 0 && s_active_events[new_index - 1]->m_downcount > event_downcount)
+      new_index--;
+
+    for (u32 i = index; i > new_index; i--)
+      SetActiveEvent(i, s_active_events[i - 1]);
+    SetActiveEvent(new_index, event);
+
+    if (new_index == 0)
       UpdateCPUDowncount();
-    }
   }
-  else if (event->next && event_downcount > event->next->m_downcount)
+  else if ((index + 1) < s_active_event_count && event_downcount > s_active_events[index + 1]->m_downcount)
   {
-    // move forwards
-    TimingEvent* current = event->next;
-    while (current && event_downcount > current->m_downcount)
-      current = current->next;
-
-    // unlink
-    if (event->prev)
-      event->prev->next = event->next;
-    else
-      s_active_events_head = event->next;
-    if (event->next)
-      event->next->prev = event->prev;
-    else
-      s_active_events_tail = event->prev;
-
-    // insert before current
-    if (current)
-    {
-      event->next = current;
-      event->prev = current->prev;
-
-      if (current->prev)
-        current->prev->next = event;
-      else
-        s_active_events_head = event;
-
-      current->prev = event;
-    }
-    else
-    {
-      // insert at back
-      DebugAssert(s_active_events_tail);
-      s_active_events_tail->next = event;
-      event->next = nullptr;
-      event->prev = s_active_events_tail;
-      s_active_events_tail = event;
-    }
+    // move forwards, before any events with the same downcount
+    u32 new_index = index + 1;
+    while ((new_index + 1) < s_active_event_count && event_downcount > s_active_events[new_index + 1]->m_downcount)
+      new_index++;
+
+    for (u32 i = index; i < new_index; i++)
+      SetActiveEvent(i, s_active_events[i + 1]);
+    SetActiveEvent(new_index, event);
   }
 }
 
 static void AddActiveEvent(TimingEvent* event)
 {
-  DebugAssert(!event->prev && !event->next);
-  s_active_event_count++;
+  Assert(s_active_event_count < MAX_ACTIVE_EVENTS);
 
-  TimingEvent* current = nullptr;
-  TimingEvent* next = s_active_events_head;
-  while (next && event->m_downcount > next->m_downcount)
+  // insert before any events with the same downcount
+  u32 index = s_active_event_count;
+  while (index > 0 && s_active_events[index - 1]->m_downcount >= event->m_downcount)
   {
-    current = next;
-    next = next->next;
+    SetActiveEvent(index, s_active_events[index - 1]);
+    index--;
   }
 
-  if (!next)
-  {
-    // new tail
-    event->prev = s_active_events_tail;
-    if (s_active_events_tail)
-    {
-      s_active_events_tail->next = event;
-      s_active_events_tail = event;
-    }
-    else
-    {
-      // first event
-      s_active_events_tail = event;
-      s_active_events_head = event;
-      UpdateCPUDowncount();
-    }
-  }
-  else if (!current)
-  {
-    // new head
-    event->next = s_active_events_head;
-    s_active_events_head->prev = event;
-    s_active_events_head = event;
+  SetActiveEvent(index, event);
+  s_active_event_count++;
+
+  if (index == 0)
     UpdateCPUDowncount();
-  }
-  else
-  {
-    // inbetween current < event > next
-    event->prev = current;
-    event->next = next;
-    current->next = event;
-    next->prev = event;
-  }
 }
 
 static void RemoveActiveEvent(TimingEvent* event)
 {
   DebugAssert(s_active_event_count > 0);
 
-  if (event->next)
-  {
-    event->next->prev = event->prev;
-  }
-  else
-  {
-    s_active_events_tail = event->prev;
-  }
-
-  if (event->prev)
-  {
-    event->prev->next = event->next;
-  }
-  else
-  {
-    s_active_events_head = event->next;
-    if (s_active_events_head)
-      UpdateCPUDowncount();
-  }
-
-  event->prev = nullptr;
-  event->next = nullptr;
+  const u32 index = event->m_active_index;
+  DebugAssert(s_active_events[index] == event);
 
   s_active_event_count--;
+  for (u32 i = index; i < s_active_event_count; i++)
+    SetActiveEvent(i, s_active_events[i + 1]);
+  s_active_events[s_active_event_count] = nullptr;
+
+  if (index == 0 && s_active_event_count > 0)
+    UpdateCPUDowncount();
 }
 
 static void SortEvents()
 {
-  std::vector<TimingEvent*> events;
-  events.reserve(s_active_event_count);
+  // Re-add the events in their current order, so that ties end up in the same order as a fresh insertion would give.
+  std::array<TimingEvent*, MAX_ACTIVE_EVENTS> events;
+  const u32 event_count = s_active_event_count;
+  std::copy_n(s_active_events.begin(), event_count, events.begin());
+  std::fill_n(s_active_events.begin(), event_count, nullptr);
+  s_active_event_count = 0;
+
+  for (u32 i = 0; i < event_count; i++)
+    AddActiveEvent(events[i]);
+}
 
-  TimingEvent* next = s_active_events_head;
-  while (next)
+static u32 GetProfileIndex(const std::string& name)
+{
+  for (u32 i = 0; i < static_cast<u32>(s_profiles.size()); i++)
   {
-    TimingEvent* current = next;
-    events.push_back(current);
-    next = current->next;
-    current->prev = nullptr;
-    current->next = nullptr;
+    if (s_profiles[i].name == name)
+      return i;
   }
 
-  s_active_events_head = nullptr;
-  s_active_events_tail = nullptr;
-  s_active_event_count = 0;
+  TimingEventProfile profile = {};
+  profile.name = name;
+  s_profiles.push_back(std::move(profile));
+  return static_cast<u32>(s_profiles.size() - 1);
+}
+
+static ALWAYS_INLINE void InvokeCallback(TimingEvent* event, TickCount ticks, TickCount ticks_late)
+{
+  if (!g_settings.debugging.profile_timing_events)
+  {
+    event->m_callback(event->m_callback_param, ticks, ticks_late);
+    return;
+  }
 
-  for (TimingEvent* event : events)
-    AddActiveEvent(event);
+  // the callback can create new events, so don't hold a reference to the profile across it
+  const u32 profile_index = event->m_profile_index;
+  const Common::Timer::Value start_time = Common::Timer::GetValue();
+  event->m_callback(event->m_callback_param, ticks, ticks_late);
+  const u64 host_time_ns =
+    static_cast<u64>(Common::Timer::ConvertValueToNanoseconds(Common::Timer::GetValue() - start_time));
+
+  TimingEventProfile& profile = s_profiles[profile_index];
+  profile.invocations++;
+  profile.frame_invocations++;
+  profile.total_ticks_late += static_cast<u64>(ticks_late);
+  profile.max_ticks_late = std::max(profile.max_ticks_late, ticks_late);
+  profile.host_time_ns += host_time_ns;
+  profile.max_host_time_ns = std::max(profile.max_host_time_ns, host_time_ns);
 }
 
 static TimingEvent* FindActiveEvent(const char* name)
 {
-  for (TimingEvent* event = s_active_events_head; event; event = event->next)
+  for (u32 i = 0; i < s_active_event_count; i++)
   {
-    if (event->GetName().compare(name) == 0)
-      return event;
+    if (s_active_events[i]->GetName().compare(name) == 0)
+      return s_active_events[i];
   }
 
   return nullptr;
@@ -266,23 +229,23 @@ void RunEvents()
   CPU::ResetPendingTicks();
   while (pending_ticks > 0)
   {
-    const TickCount time = std::min(pending_ticks, s_active_events_head->GetDowncount());
+    const TickCount time = std::min(pending_ticks, s_active_events[0]->GetDowncount());
     s_global_tick_counter += static_cast<u32>(time);
     pending_ticks -= time;
 
     // Apply downcount to all events.
     // This will result in a negative downcount for those events which are late.
-    for (TimingEvent* event = s_active_events_head; event; event = event->next)
+    for (u32 i = 0; i < s_active_event_count; i++)
     {
+      TimingEvent* event = s_active_events[i];
       event->m_downcount -= time;
       event->m_time_since_last_run += time;
     }
 
     // Now we can actually run the callbacks.
-    while (s_active_events_head->m_downcount <= 0)
+    while (s_active_events[0]->m_downcount <= 0)
     {
-      // move it to the end, since that'll likely be its new position
-      TimingEvent* event = s_active_events_head;
+      TimingEvent* event = s_active_events[0];
       s_current_event = event;
 
       // Factor late time into the time for the next invocation.
@@ -292,7 +255,7 @@ void RunEvents()
       event->m_time_since_last_run = 0;
 
       // The cycles_late is only an indicator, it doesn't modify the cycles to execute.
-      event->m_callback(ticks_to_execute, ticks_late);
+      InvokeCallback(event, ticks_to_execute, ticks_late);
       if (event->m_active)
         SortEvent(event);
     }
@@ -353,8 +316,9 @@ bool DoState(StateWrapper& sw)
 
     sw.Do(&s_active_event_count);
 
-    for (TimingEvent* event = s_active_events_head; event; event = event->next)
+    for (u32 i = 0; i < s_active_event_count; i++)
     {
+      TimingEvent* event = s_active_events[i];
       sw.Do(&event->m_name);
       sw.Do(&event->m_downcount);
       sw.Do(&event->m_time_since_last_run);
@@ -368,11 +332,214 @@ bool DoState(StateWrapper& sw)
   return !sw.HasError();
 }
 
+void ProfileFrameDone()
+{
+  if (!g_settings.debugging.profile_timing_events)
+    return;
+
+  s_profile_frame_count++;
+  for (TimingEventProfile& profile : s_profiles)
+  {
+    profile.last_frame_invocations = profile.frame_invocations;
+    profile.max_frame_invocations = std::max(profile.max_frame_invocations, profile.frame_invocations);
+    profile.frame_invocations = 0;
+  }
+
+  // each dump covers the frames since the last one
+  const u32 dump_interval = g_settings.debugging.timing_event_profile_dump_interval;
+  if (dump_interval == 0 || s_profile_frame_count < dump_interval)
+    return;
+
+  const std::vector<TimingEventProfile> profiles = GetProfiles();
+  const double frames = static_cast<double>(s_profile_frame_count);
+  Log_InfoPrintf("Timing event profile for %u frames:", s_profile_frame_count);
+  for (const TimingEventProfile& profile : profiles)
+  {
+    if (profile.invocations == 0)
+      continue;
+
+    Log_InfoPrintf("  %-24s %8.1f calls/frame, %6.1f avg/%d max ticks late, %8.1f us/frame", profile.name.c_str(),
+                   static_cast<double>(profile.invocations) / frames,
+                   static_cast<double>(profile.total_ticks_late) / static_cast<double>(profile.invocations),
+                   profile.max_ticks_late, static_cast<double>(profile.host_time_ns) / 1000.0 / frames);
+  }
+
+  const std::string& code = System::GetRunningCode();
+  const std::string filename =
+    g_host_interface->GetUserDirectoryRelativePath("timingevents_%s.csv", code.empty() ? "default" : code.c_str());
+  WriteProfileReport(filename.c_str());
+  ResetProfiles();
+}
+
+std::vector<TimingEventProfile> GetProfiles()
+{
+  std::vector<TimingEventProfile> profiles(s_profiles);
+  std::sort(profiles.begin(), profiles.end(), [](const TimingEventProfile& lhs, const TimingEventProfile& rhs) {
+    return lhs.host_time_ns > rhs.host_time_ns;
+  });
+  return profiles;
+}
+
+u32 GetProfileFrameCount()
+{
+  return s_profile_frame_count;
+}
+
+void ResetProfiles()
+{
+  for (TimingEventProfile& profile : s_profiles)
+  {
+    std::string name = std::move(profile.name);
+    profile = {};
+    profile.name = std::move(name);
+  }
+
+  s_profile_frame_count = 0;
+}
+
+bool WriteProfileReport(const char* filename)
+{
+  auto fp = FileSystem::OpenManagedCFile(filename, "ab");
+  if (!fp)
+  {
+    Log_ErrorPrintf("Failed to open '%s' for writing", filename);
+    return false;
+  }
+
+  if (std::ftell(fp.get()) <= 0)
+  {
+    std::fprintf(fp.get(), "frame_number,event,frames,invocations,invocations_per_frame,max_invocations_per_frame,"
+                           "avg_ticks_late,max_ticks_late,host_time_ns,host_ns_per_invocation\n");
+  }
+
+  const u32 frame_number = System::GetFrameNumber();
+  const double frames = static_cast<double>(std::max(s_profile_frame_count, 1u));
+  const std::vector<TimingEventProfile> profiles = GetProfiles();
+  for (const TimingEventProfile& profile : profiles)
+  {
+    const double invocations = static_cast<double>(std::max<u64>(profile.invocations, 1));
+    std::fprintf(fp.get(), "%u,\"%s\",%u,%" PRIu64 ",%.2f,%u,%.2f,%d,%" PRIu64 ",%.1f\n", frame_number,
+                 profile.name.c_str(), s_profile_frame_count, profile.invocations,
+                 static_cast<double>(profile.invocations) / frames, profile.max_frame_invocations,
+                 static_cast<double>(profile.total_ticks_late) / invocations, profile.max_ticks_late,
+                 profile.host_time_ns, static_cast<double>(profile.host_time_ns) / invocations);
+  }
+
+  Log_DevPrintf("Wrote profile of %zu timing events to '%s'", profiles.size(), filename);
+  return true;
+}
+
+void DrawDebugWindow()
+{
+#ifdef WITH_IMGUI
+  static constexpr u32 NUM_COLUMNS = 7;
+  static constexpr std::array<const char*, NUM_COLUMNS> column_names = {
+    {"Event", "Calls/Frame", "Last/Max Frame", "Avg Late", "Max Late", "Host us/Frame", "Host ns/Call"}};
+
+  const float framebuffer_scale = ImGui::GetIO().DisplayFramebufferScale.x;
+
+  ImGui::SetNextWindowSize(ImVec2(800.0f * framebuffer_scale, 400.0f * framebuffer_scale), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Timing Events", &g_settings.debugging.show_timing_events))
+  {
+    ImGui::End();
+    return;
+  }
+
+  if (ImGui::CollapsingHeader("Active Events", ImGuiTreeNodeFlags_DefaultOpen))
+  {
+    ImGui::Columns(4);
+    ImGui::TextUnformatted("Event");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Downcount");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Period");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Interval");
+    ImGui::NextColumn();
+    for (u32 i = 0; i < s_active_event_count; i++)
+    {
+      const TimingEvent* event = s_active_events[i];
+      ImGui::TextUnformatted(event->GetName().c_str());
+      ImGui::NextColumn();
+      ImGui::Text("%d", event->GetDowncount());
+      ImGui::NextColumn();
+      ImGui::Text("%d", event->GetPeriod());
+      ImGui::NextColumn();
+      ImGui::Text("%d", event->GetInterval());
+      ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+  }
+
+  if (!ImGui::CollapsingHeader("Profile", ImGuiTreeNodeFlags_DefaultOpen))
+  {
+    ImGui::End();
+    return;
+  }
+
+  if (!g_settings.debugging.profile_timing_events)
+  {
+    ImGui::TextUnformatted("Profiling requires the \"Enable Timing Event Profiling\" option in the advanced settings.");
+    ImGui::End();
+    return;
+  }
+
+  if (ImGui::Button("Reset"))
+    ResetProfiles();
+
+  ImGui::SameLine();
+  if (ImGui::Button("Save CSV"))
+  {
+    const std::string& code = System::GetRunningCode();
+    const std::string filename =
+      g_host_interface->GetUserDirectoryRelativePath("timingevents_%s.csv", code.empty() ? "default" : code.c_str());
+    if (WriteProfileReport(filename.c_str()))
+      g_host_interface->AddFormattedOSDMessage(5.0f, "Timing event profile saved to '%s'.", filename.c_str());
+  }
+
+  ImGui::SameLine();
+  ImGui::Text("%u frames", s_profile_frame_count);
+
+  ImGui::Columns(NUM_COLUMNS);
+  for (const char* title : column_names)
+  {
+    ImGui::TextUnformatted(title);
+    ImGui::NextColumn();
+  }
+
+  const double frames = static_cast<double>(std::max(s_profile_frame_count, 1u));
+  const std::vector<TimingEventProfile> profiles = GetProfiles();
+  for (const TimingEventProfile& profile : profiles)
+  {
+    const double invocations = static_cast<double>(std::max<u64>(profile.invocations, 1));
+    ImGui::TextUnformatted(profile.name.c_str());
+    ImGui::NextColumn();
+    ImGui::Text("%.1f", static_cast<double>(profile.invocations) / frames);
+    ImGui::NextColumn();
+    ImGui::Text("%u/%u", profile.last_frame_invocations, profile.max_frame_invocations);
+    ImGui::NextColumn();
+    ImGui::Text("%.1f", static_cast<double>(profile.total_ticks_late) / invocations);
+    ImGui::NextColumn();
+    ImGui::Text("%d", profile.max_ticks_late);
+    ImGui::NextColumn();
+    ImGui::Text("%.1f", static_cast<double>(profile.host_time_ns) / 1000.0 / frames);
+    ImGui::NextColumn();
+    ImGui::Text("%.0f", static_cast<double>(profile.host_time_ns) / invocations);
+    ImGui::NextColumn();
+  }
+
+  ImGui::Columns(1);
+  ImGui::End();
+#endif
+}
+
 } // namespace TimingEvents
 
-TimingEvent::TimingEvent(std::string name, TickCount period, TickCount interval, TimingEventCallback callback)
-  : m_downcount(interval), m_time_since_last_run(0), m_period(period), m_interval(interval),
-    m_callback(std::move(callback)), m_name(std::move(name)), m_active(false)
+TimingEvent::TimingEvent(std::string name, TickCount period, TickCount interval, TimingEventCallback callback,
+                         void* callback_param)
+  : m_downcount(interval), m_time_since_last_run(0), m_period(period), m_interval(interval), m_callback(callback),
+    m_callback_param(callback_param), m_active_index(0), m_profile_index(TimingEvents::GetProfileIndex(name)),
+    m_active(false), m_name(std::move(name))
 {
 }
 
@@ -449,7 +616,7 @@ void TimingEvent::InvokeEarly(bool force /* = false */)
 
   m_downcount = pending_ticks + m_interval;
   m_time_since_last_run -= ticks_to_execute;
-  m_callback(ticks_to_execute, 0);
+  TimingEvents::InvokeCallback(this, ticks_to_execute, 0);
 
   // Since we've changed the downcount, we need to re-sort the events.
   DebugAssert(TimingEvents::s_current_event != this);
@@ -1,5 +1,4 @@
 #pragma once
-#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -8,13 +7,15 @@
 
 class StateWrapper;
 
-// Event callback type. Second parameter is the number of cycles the event was executed "late".
-using TimingEventCallback = std::function<void(TickCount ticks, TickCount ticks_late)>;
+// Event callback type. First parameter is the pointer passed when creating the event, third parameter is the number of
+// cycles the event was executed "late".
+using TimingEventCallback = void (*)(void* param, TickCount ticks, TickCount ticks_late);
 
 class TimingEvent
 {
 public:
-  TimingEvent(std::string name, TickCount period, TickCount interval, TimingEventCallback callback);
+  TimingEvent(std::string name, TickCount period, TickCount interval, TimingEventCallback callback,
+              void* callback_param);
   ~TimingEvent();
 
   const std::string& GetName() const { return m_name; }
@@ -56,17 +57,36 @@ public:
   void SetInterval(TickCount interval) { m_interval = interval; }
   void SetPeriod(TickCount period) { m_period = period; }
 
-  TimingEvent* prev = nullptr;
-  TimingEvent* next = nullptr;
-
   TickCount m_downcount;
   TickCount m_time_since_last_run;
   TickCount m_period;
   TickCount m_interval;
 
   TimingEventCallback m_callback;
-  std::string m_name;
+  void* m_callback_param;
+
+  // Position in the active event array, only valid while the event is active.
+  u32 m_active_index;
+
+  // Index of the profile for this event's name.
+  u32 m_profile_index;
   bool m_active;
+
+  std::string m_name;
+};
+
+// Per-name event statistics, collected when timing event profiling is enabled.
+struct TimingEventProfile
+{
+  std::string name;
+  u64 invocations;
+  u32 frame_invocations;
+  u32 last_frame_invocations;
+  u32 max_frame_invocations;
+  u64 total_ticks_late;
+  TickCount max_ticks_late;
+  u64 host_time_ns;
+  u64 max_host_time_ns;
 };
 
 namespace TimingEvents {
@@ -77,9 +97,14 @@ void Initialize();
 void Reset();
 void Shutdown();
 
+enum : u32
+{
+  MAX_ACTIVE_EVENTS = 32
+};
+
 /// Creates a new event.
 std::unique_ptr<TimingEvent> CreateTimingEvent(std::string name, TickCount period, TickCount interval,
-                                               TimingEventCallback callback, bool activate);
+                                               TimingEventCallback callback, void* callback_param, bool activate);
 
 /// Serialization.
 bool DoState(StateWrapper& sw);
@@ -88,8 +113,33 @@ void RunEvents();
 
 void UpdateCPUDowncount();
 
+/// Fast-forwards the CPU over whole iterations of an idle loop, stopping before the next event is due. The final
+/// iteration still runs, so the loop exits at the same time it would have. Returns the number of ticks skipped.
+TickCount FastForwardIdleLoop(TickCount iteration_ticks);
+
+/// Returns a pointer to the first slot of the active event array, which is sorted by downcount. Used by the
+/// recompiler to read the downcount of the next event.
 TimingEvent** GetHeadEventPtr();
 
+/// Called at the end of each frame. Updates the per-frame invocation counts, and writes the profile to the log and
+/// CSV file when the dump interval is reached.
+void ProfileFrameDone();
+
+/// Returns all timing event profiles, sorted by host time spent in the callbacks.
+std::vector<TimingEventProfile> GetProfiles();
+
+/// Returns the number of frames covered by the profiles.
+u32 GetProfileFrameCount();
+
+/// Clears the counters of all timing event profiles.
+void ResetProfiles();
+
+/// Appends the current profiles to the specified CSV file, writing the header if the file is empty.
+bool WriteProfileReport(const char* filename);
+
+/// Draws the timing event window.
+void DrawDebugWindow();
+
 
 
 } // namespace TimingEventManager
\ No newline at end of file
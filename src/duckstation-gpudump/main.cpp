@@ -0,0 +1,468 @@
+#include "common/audio_stream.h"
+#include "common/byte_stream.h"
+#include "common/log.h"
+#include "common/string_util.h"
+#include "common/timer.h"
+#include "core/gpu.h"
+#include "core/gpu_dump.h"
+#include "core/gpu_sw_backend.h"
+#include "core/host_display.h"
+#include "core/host_interface.h"
+#include "core/settings.h"
+#include "core/timing_event.h"
+#include "frontend-common/opengl_headless_host_display.h"
+#include "frontend-common/vulkan_headless_host_display.h"
+#include "xxhash.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Display which accepts scanout from the software renderer and never presents it.
+class NullHostDisplay final : public HostDisplay
+{
+public:
+  RenderAPI GetRenderAPI() const override { return RenderAPI::None; }
+  void* GetRenderDevice() const override { return nullptr; }
+  void* GetRenderContext() const override { return nullptr; }
+
+  bool HasRenderDevice() const override { return true; }
+  bool HasRenderSurface() const override { return false; }
+
+  bool CreateRenderDevice(const WindowInfo& wi, std::string_view adapter_name, bool debug_device) override
+  {
+    return true;
+  }
+  bool InitializeRenderDevice(std::string_view shader_cache_directory, bool debug_device) override { return true; }
+  bool MakeRenderContextCurrent() override { return true; }
+  bool DoneRenderContextCurrent() override { return true; }
+  void DestroyRenderDevice() override {}
+  void DestroyRenderSurface() override {}
+  bool ChangeRenderWindow(const WindowInfo& wi) override { return true; }
+  bool SupportsFullscreen() const override { return false; }
+  bool IsFullscreen() override { return false; }
+  bool SetFullscreen(bool fullscreen, u32 width, u32 height, float refresh_rate) override { return false; }
+  bool CreateResources() override { return true; }
+  void DestroyResources() override {}
+
+  bool SetPostProcessingChain(const std::string_view& config) override { return false; }
+
+  void ResizeRenderWindow(s32 new_window_width, s32 new_window_height) override {}
+
+  std::unique_ptr<HostDisplayTexture> CreateTexture(u32 width, u32 height, const void* data, u32 data_stride,
+                                                    bool dynamic = false) override
+  {
+    return {};
+  }
+  void UpdateTexture(HostDisplayTexture* texture, u32 x, u32 y, u32 width, u32 height, const void* data,
+                     u32 data_stride) override
+  {
+  }
+
+  bool DownloadTexture(const void* texture_handle, u32 x, u32 y, u32 width, u32 height, void* out_data,
+                       u32 out_data_stride) override
+  {
+    return false;
+  }
+
+  bool Render() override { return true; }
+
+  void SetVSync(bool enabled) override {}
+
+  bool SupportsDisplayPixelFormat(HostDisplayPixelFormat format) const override
+  {
+    return (format == HostDisplayPixelFormat::RGBA8);
+  }
+
+  bool BeginSetDisplayPixels(HostDisplayPixelFormat format, u32 width, u32 height, void** out_buffer,
+                             u32* out_pitch) override
+  {
+    const u32 pitch = width * GetDisplayPixelFormatSize(format);
+    m_pixels.resize(pitch * height);
+    *out_buffer = m_pixels.data();
+    *out_pitch = pitch;
+
+    // the software renderer skips conversion of unchanged rows while a display texture is set
+    SetDisplayTexture(m_pixels.data(), format, width, height, 0, 0, width, height);
+    return true;
+  }
+
+  void EndSetDisplayPixels() override {}
+
+private:
+  std::vector<u8> m_pixels;
+};
+
+// The hardware renderers report errors and messages through the host interface.
+class ReplayHostInterface final : public HostInterface
+{
+public:
+  std::string GetStringSettingValue(const char* section, const char* key, const char* default_value = "") override
+  {
+    return default_value;
+  }
+
+  std::unique_ptr<ByteStream> OpenPackageFile(const char* path, u32 flags) override { return {}; }
+
+  // no shader cache, so every run compiles the same shaders
+  std::string GetShaderCacheBasePath() const override { return {}; }
+
+protected:
+  bool AcquireHostDisplay() override { return false; }
+  void ReleaseHostDisplay() override {}
+  std::unique_ptr<AudioStream> CreateAudioStream(AudioBackend backend) override { return {}; }
+  void LoadSettings() override {}
+};
+
+struct Options
+{
+  const char* filename = nullptr;
+  u32 loops = 1;
+  bool hash = false;
+  bool frame_hash = false;
+  bool frame_times = false;
+  bool compare_spans = false;
+};
+
+} // namespace
+
+static void PrintUsage(const char* progname)
+{
+  std::fprintf(stderr, "Usage: %s [options] <dump file>\n", progname);
+  std::fprintf(stderr, "Replays a GPU dump as fast as possible, without a window.\n\n");
+  std::fprintf(stderr, "  -renderer <name>: Renderer to use, Software (default), OpenGL or Vulkan.\n");
+  std::fprintf(stderr, "  -scale <factor>: Resolution scale for the hardware renderers.\n");
+  std::fprintf(stderr, "  -threads <count>: Number of software renderer band threads (0-16), 0 to disable.\n");
+  std::fprintf(stderr, "  -nothread: Render on the replay thread instead of the GPU thread.\n");
+  std::fprintf(stderr, "  -renderthread: Submit hardware renderer commands from a separate render thread.\n");
+  std::fprintf(stderr, "  -spanwidth <pixels>: Widest software renderer vector span path, 16, 8, or 0 for scalar.\n");
+  std::fprintf(stderr, "  -comparespans: Replays with each software renderer span path, and checks that VRAM matches.\n");
+  std::fprintf(stderr, "  -loops <count>: Number of times to replay the dump.\n");
+  std::fprintf(stderr, "  -hash: Prints a hash of VRAM at the end of each replay.\n");
+  std::fprintf(stderr, "  -framehash: Prints a hash of each frame read back from a hardware renderer.\n");
+  std::fprintf(stderr, "  -frametimes: Prints the time taken by each frame.\n");
+  std::fprintf(stderr, "  -verbose: Enables log output.\n");
+}
+
+static bool ParseCommandLine(int argc, char* argv[], Options* options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const bool has_value = (i + 1) < argc;
+    if (std::strcmp(arg, "-renderer") == 0 && has_value)
+    {
+      const std::optional<GPURenderer> renderer = Settings::ParseRendererName(argv[++i]);
+      if (!renderer.has_value())
+      {
+        std::fprintf(stderr, "Unknown renderer: '%s'\n", argv[i]);
+        return false;
+      }
+
+      g_settings.gpu_renderer = renderer.value();
+    }
+    else if (std::strcmp(arg, "-scale") == 0 && has_value)
+    {
+      g_settings.gpu_resolution_scale = std::max<u32>(StringUtil::FromChars<u32>(argv[++i]).value_or(1), 1);
+    }
+    else if (std::strcmp(arg, "-threads") == 0 && has_value)
+    {
+      g_settings.gpu_sw_thread_count = std::min<u32>(StringUtil::FromChars<u32>(argv[++i]).value_or(0), 16);
+    }
+    else if (std::strcmp(arg, "-nothread") == 0)
+    {
+      g_settings.gpu_use_thread = false;
+    }
+    else if (std::strcmp(arg, "-renderthread") == 0)
+    {
+      g_settings.gpu_use_render_thread = true;
+    }
+    else if (std::strcmp(arg, "-spanwidth") == 0 && has_value)
+    {
+      g_settings.gpu_sw_vector_span_width = std::min<u32>(StringUtil::FromChars<u32>(argv[++i]).value_or(16), 16);
+    }
+    else if (std::strcmp(arg, "-comparespans") == 0)
+    {
+      options->compare_spans = true;
+    }
+    else if (std::strcmp(arg, "-loops") == 0 && has_value)
+    {
+      options->loops = std::max<u32>(StringUtil::FromChars<u32>(argv[++i]).value_or(1), 1);
+    }
+    else if (std::strcmp(arg, "-hash") == 0)
+    {
+      options->hash = true;
+    }
+    else if (std::strcmp(arg, "-framehash") == 0)
+    {
+      options->frame_hash = true;
+    }
+    else if (std::strcmp(arg, "-frametimes") == 0)
+    {
+      options->frame_times = true;
+    }
+    else if (std::strcmp(arg, "-verbose") == 0)
+    {
+      Log::SetConsoleOutputParams(true, nullptr, LOGLEVEL_INFO);
+    }
+    else if (arg[0] != '-' && !options->filename)
+    {
+      options->filename = arg;
+    }
+    else
+    {
+      std::fprintf(stderr, "Unknown parameter: '%s'\n", arg);
+      return false;
+    }
+  }
+
+  if (!options->filename)
+  {
+    std::fprintf(stderr, "No dump file specified.\n");
+    return false;
+  }
+
+  if (options->compare_spans && g_settings.gpu_renderer != GPURenderer::Software)
+  {
+    std::fprintf(stderr, "Span paths can only be compared with the software renderer.\n");
+    return false;
+  }
+
+  return true;
+}
+
+static void PrintFrameHash(u32 frame_number, u32 width, u32 height, const void* pixels, u32 stride)
+{
+  std::printf("Frame %u: %ux%u, hash %016" PRIX64 "\n", frame_number, width, height,
+              XXH64(pixels, stride * height, 0));
+}
+
+static std::unique_ptr<HostDisplay> CreateDisplay(const Options& options)
+{
+  std::unique_ptr<HostDisplay> display;
+  switch (g_settings.gpu_renderer)
+  {
+    case GPURenderer::HardwareOpenGL:
+    {
+      std::unique_ptr<FrontendCommon::OpenGLHeadlessHostDisplay> gl_display =
+        std::make_unique<FrontendCommon::OpenGLHeadlessHostDisplay>();
+      if (options.frame_hash)
+        gl_display->SetFrameCallback(PrintFrameHash);
+      display = std::move(gl_display);
+    }
+    break;
+
+    case GPURenderer::HardwareVulkan:
+    {
+      std::unique_ptr<FrontendCommon::VulkanHeadlessHostDisplay> vk_display =
+        std::make_unique<FrontendCommon::VulkanHeadlessHostDisplay>();
+      if (options.frame_hash)
+        vk_display->SetFrameCallback(PrintFrameHash);
+      display = std::move(vk_display);
+    }
+    break;
+
+    case GPURenderer::Software:
+      return std::make_unique<NullHostDisplay>();
+
+    default:
+      std::fprintf(stderr, "%s renderer can't be used without a window.\n",
+                   Settings::GetRendererName(g_settings.gpu_renderer));
+      return {};
+  }
+
+  const WindowInfo wi;
+  if (!display->CreateRenderDevice(wi, g_settings.gpu_adapter, g_settings.gpu_use_debug_device) ||
+      !display->InitializeRenderDevice({}, g_settings.gpu_use_debug_device))
+  {
+    std::fprintf(stderr, "Failed to create headless %s device.\n", Settings::GetRendererName(g_settings.gpu_renderer));
+    display->DestroyRenderDevice();
+    return {};
+  }
+
+  return display;
+}
+
+static std::unique_ptr<GPU> CreateGPU()
+{
+  switch (g_settings.gpu_renderer)
+  {
+    case GPURenderer::HardwareOpenGL:
+      return GPU::CreateHardwareOpenGLRenderer();
+
+    case GPURenderer::HardwareVulkan:
+      return GPU::CreateHardwareVulkanRenderer();
+
+    case GPURenderer::Software:
+    default:
+      return GPU::CreateSoftwareRenderer();
+  }
+}
+
+static void FlushFrameReadbacks(HostDisplay* display)
+{
+  switch (g_settings.gpu_renderer)
+  {
+    case GPURenderer::HardwareOpenGL:
+      static_cast<FrontendCommon::OpenGLHeadlessHostDisplay*>(display)->FlushFrameReadbacks();
+      break;
+
+    case GPURenderer::HardwareVulkan:
+      static_cast<FrontendCommon::VulkanHeadlessHostDisplay*>(display)->FlushFrameReadbacks();
+      break;
+
+    default:
+      break;
+  }
+}
+
+static std::string GetRendererDescription()
+{
+  if (g_settings.gpu_renderer != GPURenderer::Software)
+  {
+    if (g_settings.gpu_use_render_thread)
+      return StringUtil::StdStringFromFormat("%s, render thread", Settings::GetRendererName(g_settings.gpu_renderer));
+    else
+      return Settings::GetRendererName(g_settings.gpu_renderer);
+  }
+
+  const u32 span_width = GPU_SW_Backend::GetSupportedVectorSpanWidth(g_settings.gpu_sw_vector_span_width);
+  if (span_width == 0)
+    return StringUtil::StdStringFromFormat("%s, scalar spans", Settings::GetRendererName(g_settings.gpu_renderer));
+  else
+    return StringUtil::StdStringFromFormat("%s, %u-pixel spans", Settings::GetRendererName(g_settings.gpu_renderer),
+                                           span_width);
+}
+
+// Replays the dump options.loops times, from the start if rewind is set. The VRAM hash after the last replay is
+// stored in out_vram_hash.
+static bool Replay(GPU* gpu, HostDisplay* display, GPUDump::Player* player, const Options& options, bool rewind,
+                   u64* out_vram_hash)
+{
+  std::vector<double> frame_times;
+  double total_time = 0.0;
+
+  for (u32 loop = 0; loop < options.loops; loop++)
+  {
+    if ((loop > 0 || rewind) && !player->Rewind(gpu))
+      return false;
+
+    // only the replay and presentation is timed, reading packets from the file isn't
+    while (player->ReadFrame())
+    {
+      Common::Timer frame_timer;
+      player->ReplayFrame(gpu);
+
+      // the display can't rely on any state the GPU leaves behind
+      gpu->ResetGraphicsAPIState();
+      display->Render();
+      gpu->RestoreGraphicsAPIState();
+      const double frame_time = frame_timer.GetTimeMilliseconds();
+      frame_times.push_back(frame_time);
+      total_time += frame_time;
+
+      if (options.frame_times)
+        std::printf("Frame %u: %.3f ms\n", player->GetFrameCount(), frame_time);
+    }
+
+    FlushFrameReadbacks(display);
+
+    *out_vram_hash = gpu->GetVRAMHash();
+    if (options.hash)
+      std::printf("Loop %u: %u frames, VRAM hash %016" PRIX64 "\n", loop + 1, player->GetFrameCount(), *out_vram_hash);
+  }
+
+  if (frame_times.empty())
+  {
+    std::fprintf(stderr, "Dump does not contain any frames.\n");
+    return false;
+  }
+
+  std::sort(frame_times.begin(), frame_times.end());
+  const double avg_time = total_time / static_cast<double>(frame_times.size());
+  std::printf("%zu frames in %.2f ms, %.2f frames/s (%s)\n", frame_times.size(), total_time,
+              (total_time > 0.0) ? (static_cast<double>(frame_times.size()) * 1000.0 / total_time) : 0.0,
+              GetRendererDescription().c_str());
+  std::printf("Frame time: min %.3f ms, avg %.3f ms, median %.3f ms, max %.3f ms\n", frame_times.front(), avg_time,
+              frame_times[frame_times.size() / 2], frame_times.back());
+  return true;
+}
+
+// Replays the dump once with each span path the CPU supports, from scalar up. All of them have to produce the same
+// VRAM as the scalar path.
+static bool CompareSpans(GPU* gpu, HostDisplay* display, GPUDump::Player* player, const Options& options)
+{
+  u64 scalar_vram_hash = 0;
+  bool result = true;
+  for (const u32 span_width : {0u, 8u, 16u})
+  {
+    if (span_width > GPU_SW_Backend::GetMaxVectorSpanWidth())
+      break;
+
+    g_settings.gpu_sw_vector_span_width = span_width;
+    gpu->UpdateSettings();
+
+    u64 vram_hash;
+    if (!Replay(gpu, display, player, options, span_width > 0, &vram_hash))
+      return false;
+
+    if (span_width == 0)
+    {
+      scalar_vram_hash = vram_hash;
+    }
+    else if (vram_hash != scalar_vram_hash)
+    {
+      std::fprintf(stderr, "VRAM hash %016" PRIX64 " with %u-pixel spans doesn't match the scalar path (%016" PRIX64
+                           ").\n",
+                   vram_hash, span_width, scalar_vram_hash);
+      result = false;
+    }
+  }
+
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  g_settings.gpu_renderer = GPURenderer::Software;
+
+  Options options;
+  if (!ParseCommandLine(argc, argv, &options))
+  {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  ReplayHostInterface host_interface;
+  TimingEvents::Initialize();
+
+  bool result = false;
+  std::unique_ptr<HostDisplay> display = CreateDisplay(options);
+  if (display)
+  {
+    std::unique_ptr<GPU> gpu = CreateGPU();
+    GPUDump::Player player;
+    u64 vram_hash;
+    if (!gpu || !gpu->Initialize(display.get()))
+      std::fprintf(stderr, "Failed to initialize GPU.\n");
+    else if (!player.Open(options.filename, gpu.get()))
+      std::fprintf(stderr, "Failed to open dump '%s'.\n", options.filename);
+    else if (options.compare_spans)
+      result = CompareSpans(gpu.get(), display.get(), &player, options);
+    else
+      result = Replay(gpu.get(), display.get(), &player, options, false, &vram_hash);
+
+    // the GPU's resources have to be released before the device
+    player.Close();
+    gpu.reset();
+    display->DestroyRenderDevice();
+  }
+
+  TimingEvents::Shutdown();
+  return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -160,6 +160,28 @@ AdvancedSettingsWidget::AdvancedSettingsWidget(QtHostInterface* host_interface,
                        static_cast<u32>(CPUFastmemMode::Count), Settings::DEFAULT_CPU_FASTMEM_MODE);
   addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler ICache"), "CPU",
                         "RecompilerICache", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Block Cache"), "CPU",
+                        "RecompilerBlockCache", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Tiering"), "CPU",
+                        "RecompilerTiering", false);
+  addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Recompiler Tiering Threshold"), "CPU",
+                         "RecompilerTieringThreshold", 1, 1000000, Settings::DEFAULT_CPU_RECOMPILER_TIERING_THRESHOLD);
+  addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Recompiler Superblock Max Blocks"), "CPU",
+                         "RecompilerSuperblockMaxBlocks", 2, 16,
+                         Settings::DEFAULT_CPU_RECOMPILER_SUPERBLOCK_MAX_BLOCKS);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Block Profiling"), "CPU",
+                        "RecompilerBlockProfiling", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Background Compilation"), "CPU",
+                        "RecompilerAsyncCompile", false);
+  addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Recompiler Background Compile Queue Depth"),
+                         "CPU", "RecompilerAsyncCompileQueueDepth", 1, 1024,
+                         Settings::DEFAULT_CPU_RECOMPILER_ASYNC_COMPILE_QUEUE_DEPTH);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Idle Loop Skipping"), "CPU",
+                        "IdleLoopSkipping", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Return Address Prediction"),
+                        "CPU", "RecompilerReturnStack", false);
+  addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Recompiler Pinned Guest Registers"), "CPU",
+                         "RecompilerPinnedRegisters", 0, 3, 0);
 
   addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("DMA Max Slice Ticks"), "Hacks",
                          "DMAMaxSliceTicks", 100, 10000, Settings::DEFAULT_DMA_MAX_SLICE_TICKS);
@@ -171,6 +193,12 @@ AdvancedSettingsWidget::AdvancedSettingsWidget(QtHostInterface* host_interface,
                          1000, Settings::DEFAULT_GPU_MAX_RUN_AHEAD);
   addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Use Debug Host GPU Device"), "GPU",
                         "UseDebugDevice", false);
+  addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Software Renderer Band Threads"), "GPU",
+                         "SWThreadCount", 0, 16, 0);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Timing Event Profiling"), "Debug",
+                        "ProfileTimingEvents", false);
+  addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Timing Event Profile Dump Interval (Frames)"),
+                         "Debug", "TimingEventProfileDumpInterval", 0, 36000, 0);
   addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Display FPS Limit"), "Display", "MaxFPS", 0, 1000,
                          0);
   addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Increase Timer Resolution"), "Main",
@@ -192,14 +220,30 @@ void AdvancedSettingsWidget::onResetToDefaultClicked()
   setBooleanTweakOption(m_ui.tweakOptionTable, 4, false);
   setChoiceTweakOption(m_ui.tweakOptionTable, 5, Settings::DEFAULT_CPU_FASTMEM_MODE);
   setBooleanTweakOption(m_ui.tweakOptionTable, 6, false);
-  setIntRangeTweakOption(m_ui.tweakOptionTable, 7, static_cast<int>(Settings::DEFAULT_DMA_MAX_SLICE_TICKS));
-  setIntRangeTweakOption(m_ui.tweakOptionTable, 8, static_cast<int>(Settings::DEFAULT_DMA_HALT_TICKS));
-  setIntRangeTweakOption(m_ui.tweakOptionTable, 9, static_cast<int>(Settings::DEFAULT_GPU_FIFO_SIZE));
-  setIntRangeTweakOption(m_ui.tweakOptionTable, 10, static_cast<int>(Settings::DEFAULT_GPU_MAX_RUN_AHEAD));
+  setBooleanTweakOption(m_ui.tweakOptionTable, 7, false);
+  setBooleanTweakOption(m_ui.tweakOptionTable, 8, false);
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 9,
+                         static_cast<int>(Settings::DEFAULT_CPU_RECOMPILER_TIERING_THRESHOLD));
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 10,
+                         static_cast<int>(Settings::DEFAULT_CPU_RECOMPILER_SUPERBLOCK_MAX_BLOCKS));
   setBooleanTweakOption(m_ui.tweakOptionTable, 11, false);
-  setIntRangeTweakOption(m_ui.tweakOptionTable, 12, 0);
-  setBooleanTweakOption(m_ui.tweakOptionTable, 13, true);
-#ifdef WIN32
+  setBooleanTweakOption(m_ui.tweakOptionTable, 12, false);
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 13,
+                         static_cast<int>(Settings::DEFAULT_CPU_RECOMPILER_ASYNC_COMPILE_QUEUE_DEPTH));
   setBooleanTweakOption(m_ui.tweakOptionTable, 14, false);
+  setBooleanTweakOption(m_ui.tweakOptionTable, 15, false);
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 16, 0);
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 17, static_cast<int>(Settings::DEFAULT_DMA_MAX_SLICE_TICKS));
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 18, static_cast<int>(Settings::DEFAULT_DMA_HALT_TICKS));
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 19, static_cast<int>(Settings::DEFAULT_GPU_FIFO_SIZE));
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 20, static_cast<int>(Settings::DEFAULT_GPU_MAX_RUN_AHEAD));
+  setBooleanTweakOption(m_ui.tweakOptionTable, 21, false);
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 22, 0);
+  setBooleanTweakOption(m_ui.tweakOptionTable, 23, false);
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 24, 0);
+  setIntRangeTweakOption(m_ui.tweakOptionTable, 25, 0);
+  setBooleanTweakOption(m_ui.tweakOptionTable, 26, true);
+#ifdef WIN32
+  setBooleanTweakOption(m_ui.tweakOptionTable, 27, false);
 #endif
 }
@@ -958,6 +958,12 @@ void MainWindow::connectSignals()
     else
       m_host_interface->stopDumpingAudio();
   });
+  connect(m_ui.actionDumpGPU, &QAction::toggled, [this](bool checked) {
+    if (checked)
+      m_host_interface->startDumpingGPU();
+    else
+      m_host_interface->stopDumpingGPU();
+  });
   connect(m_ui.actionDumpRAM, &QAction::triggered, [this]() {
     const QString filename = QFileDialog::getSaveFileName(this, tr("Destination File"));
     if (filename.isEmpty())
@@ -975,6 +981,10 @@ void MainWindow::connectSignals()
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.actionDebugShowMDECState, "Debug",
                                                "ShowMDECState");
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.actionDebugShowDMAState, "Debug", "ShowDMAState");
+  SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.actionDebugShowBlockProfile, "Debug",
+                                               "ShowBlockProfile");
+  SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.actionDebugShowTimingEvents, "Debug",
+                                               "ShowTimingEvents");
 
   addThemeToMenu(tr("Default"), QStringLiteral("default"));
   addThemeToMenu(tr("Fusion"), QStringLiteral("fusion"));
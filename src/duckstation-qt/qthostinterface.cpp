@@ -1213,6 +1213,28 @@ void QtHostInterface::stopDumpingAudio()
   StopDumpingAudio();
 }
 
+void QtHostInterface::startDumpingGPU()
+{
+  if (!isOnWorkerThread())
+  {
+    QMetaObject::invokeMethod(this, "startDumpingGPU");
+    return;
+  }
+
+  StartDumpingGPU();
+}
+
+void QtHostInterface::stopDumpingGPU()
+{
+  if (!isOnWorkerThread())
+  {
+    QMetaObject::invokeMethod(this, "stopDumpingGPU");
+    return;
+  }
+
+  StopDumpingGPU();
+}
+
 void QtHostInterface::dumpRAM(const QString& filename)
 {
   if (!isOnWorkerThread())
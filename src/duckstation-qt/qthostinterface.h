@@ -163,6 +163,8 @@ public Q_SLOTS:
   void setAudioOutputMuted(bool muted);
   void startDumpingAudio();
   void stopDumpingAudio();
+  void startDumpingGPU();
+  void stopDumpingGPU();
   void dumpRAM(const QString& filename);
   void saveScreenshot();
   void redrawDisplayWindow();
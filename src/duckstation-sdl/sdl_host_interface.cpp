@@ -1118,6 +1118,14 @@ void SDLHostInterface::DrawQuickSettingsMenu()
       StopDumpingAudio();
   }
 
+  if (ImGui::MenuItem("Dump GPU Commands", nullptr, IsDumpingGPU(), System::IsValid()))
+  {
+    if (!IsDumpingGPU())
+      StartDumpingGPU();
+    else
+      StopDumpingGPU();
+  }
+
   if (ImGui::MenuItem("Save Screenshot"))
     RunLater([this]() { SaveScreenshot(); });
 
@@ -1167,6 +1175,8 @@ void SDLHostInterface::DrawDebugMenu()
   settings_changed |= ImGui::MenuItem("Show Timers State", nullptr, &debug_settings.show_timers_state);
   settings_changed |= ImGui::MenuItem("Show MDEC State", nullptr, &debug_settings.show_mdec_state);
   settings_changed |= ImGui::MenuItem("Show DMA State", nullptr, &debug_settings.show_dma_state);
+  settings_changed |= ImGui::MenuItem("Show Block Profile", nullptr, &debug_settings.show_block_profile);
+  settings_changed |= ImGui::MenuItem("Show Timing Events", nullptr, &debug_settings.show_timing_events);
 
   if (settings_changed)
   {
@@ -1181,6 +1191,8 @@ void SDLHostInterface::DrawDebugMenu()
     debug_settings_copy.show_timers_state = debug_settings.show_timers_state;
     debug_settings_copy.show_mdec_state = debug_settings.show_mdec_state;
     debug_settings_copy.show_dma_state = debug_settings.show_dma_state;
+    debug_settings_copy.show_block_profile = debug_settings.show_block_profile;
+    debug_settings_copy.show_timing_events = debug_settings.show_timing_events;
     RunLater([this]() { SaveAndUpdateSettings(); });
   }
 }
@@ -18,6 +18,7 @@
 #include "core/spu.h"
 #include "core/system.h"
 #include "core/timers.h"
+#include "core/timing_event.h"
 #include "cubeb_audio_stream.h"
 #include "game_list.h"
 #include "icon.h"
@@ -804,7 +805,7 @@ void CommonHostInterface::DrawFPSWindow()
   }
 
   const ImVec2 window_size =
-    ImVec2(175.0f * ImGui::GetIO().DisplayFramebufferScale.x, 48.0f * ImGui::GetIO().DisplayFramebufferScale.y);
+    ImVec2(175.0f * ImGui::GetIO().DisplayFramebufferScale.x, 64.0f * ImGui::GetIO().DisplayFramebufferScale.y);
   ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - window_size.x, 0.0f), ImGuiCond_Always);
   ImGui::SetNextWindowSize(window_size);
 
@@ -868,6 +869,9 @@ void CommonHostInterface::DrawFPSWindow()
     ImGui::Text("%ux%u (%s)", effective_width, effective_height, interlaced ? "interlaced" : "progressive");
   }
 
+  if (g_settings.display_show_speed && g_settings.cpu_idle_loop_skipping && g_settings.IsUsingCodeCache())
+    ImGui::Text("Idle: %.0fK cyc/frame", System::GetIdleLoopSkippedTicksPerFrame() / 1000.0f);
+
   ImGui::End();
 }
 
@@ -955,6 +959,10 @@ void CommonHostInterface::DrawDebugWindows()
     g_mdec.DrawDebugStateWindow();
   if (g_settings.debugging.show_dma_state)
     g_dma.DrawDebugStateWindow();
+  if (g_settings.debugging.show_block_profile)
+    CPU::CodeCache::DrawDebugWindow();
+  if (g_settings.debugging.show_timing_events)
+    TimingEvents::DrawDebugWindow();
 }
 
 void CommonHostInterface::DoFrameStep()
@@ -2350,6 +2358,55 @@ void CommonHostInterface::StopDumpingAudio()
   AddOSDMessage(TranslateStdString("OSDMessage", "Stopped dumping audio."), 5.0f);
 }
 
+bool CommonHostInterface::IsDumpingGPU() const
+{
+  return g_gpu && g_gpu->IsDumping();
+}
+
+bool CommonHostInterface::StartDumpingGPU(const char* filename)
+{
+  if (System::IsShutdown())
+    return false;
+
+  std::string auto_filename;
+  if (!filename)
+  {
+    const auto& code = System::GetRunningCode();
+    if (code.empty())
+    {
+      auto_filename =
+        GetUserDirectoryRelativePath("dump/gpu/%s.gpudump", GetTimestampStringForFileName().GetCharArray());
+    }
+    else
+    {
+      auto_filename = GetUserDirectoryRelativePath("dump/gpu/%s_%s.gpudump", code.c_str(),
+                                                   GetTimestampStringForFileName().GetCharArray());
+    }
+
+    filename = auto_filename.c_str();
+  }
+
+  if (g_gpu->StartDumping(filename))
+  {
+    AddFormattedOSDMessage(5.0f, TranslateString("OSDMessage", "Started dumping GPU commands to '%s'."), filename);
+    return true;
+  }
+  else
+  {
+    AddFormattedOSDMessage(10.0f, TranslateString("OSDMessage", "Failed to start dumping GPU commands to '%s'."),
+                           filename);
+    return false;
+  }
+}
+
+void CommonHostInterface::StopDumpingGPU()
+{
+  if (System::IsShutdown() || !g_gpu->StopDumping())
+    return;
+
+  AddOSDMessage(TranslateStdString("OSDMessage", "Stopped dumping GPU commands."), 5.0f);
+}
+
 bool CommonHostInterface::SaveScreenshot(const char* filename /* = nullptr */, bool full_resolution /* = true */,
                                          bool apply_aspect_ratio /* = true */, bool compress_on_thread /* = true */)
 {
@@ -150,6 +150,15 @@ public:
   /// Stops dumping audio to file if it has been started.
   void StopDumpingAudio();
 
+  /// Returns true if currently dumping GPU commands.
+  bool IsDumpingGPU() const;
+
+  /// Starts dumping GPU commands to a file. If no file name is provided, one will be generated automatically.
+  bool StartDumpingGPU(const char* filename = nullptr);
+
+  /// Stops dumping GPU commands to file if it has been started.
+  void StopDumpingGPU();
+
   /// Saves a screenshot to the specified file. IF no file name is provided, one will be generated automatically.
   bool SaveScreenshot(const char* filename = nullptr, bool full_resolution = true, bool apply_aspect_ratio = true,
                       bool compress_on_thread = true);
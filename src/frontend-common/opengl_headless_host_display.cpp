@@ -0,0 +1,257 @@
+#include "opengl_headless_host_display.h"
+#include "common/assert.h"
+#include "common/log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+Log_SetChannel(OpenGLHeadlessHostDisplay);
+
+namespace FrontendCommon {
+
+OpenGLHeadlessHostDisplay::OpenGLHeadlessHostDisplay() = default;
+
+OpenGLHeadlessHostDisplay::~OpenGLHeadlessHostDisplay() = default;
+
+void OpenGLHeadlessHostDisplay::SetFrameCallback(FrameCallback callback)
+{
+  m_frame_callback = std::move(callback);
+}
+
+bool OpenGLHeadlessHostDisplay::CreateRenderDevice(const WindowInfo& wi, std::string_view adapter_name,
+                                                   bool debug_device)
+{
+  Assert(wi.type == WindowInfo::Type::Surfaceless);
+  if (!OpenGLHostDisplay::CreateRenderDevice(wi, adapter_name, debug_device))
+    return false;
+
+  // GLES2 has neither pixel pack buffers nor fences.
+  m_use_async_readback = (GetRenderAPI() == RenderAPI::OpenGLES) ? (GLAD_GL_ES_VERSION_3_0 != 0) :
+                                                                   (GLAD_GL_VERSION_3_2 || GLAD_GL_ARB_sync);
+  if (!m_use_async_readback)
+    Log_WarningPrintf("Fences are not supported, frames will be read back synchronously");
+
+  return true;
+}
+
+void OpenGLHeadlessHostDisplay::DestroyRenderDevice()
+{
+  OpenGLHostDisplay::DestroyRenderDevice();
+  m_frame_callback = {};
+}
+
+void OpenGLHeadlessHostDisplay::DestroyResources()
+{
+  // frames which haven't completed are dropped, FlushFrameReadbacks() should be called first if they're needed
+  for (FrameReadback& rb : m_frame_readbacks)
+  {
+    if (rb.fence)
+      glDeleteSync(rb.fence);
+    if (rb.buffer_id != 0)
+      glDeleteBuffers(1, &rb.buffer_id);
+
+    rb = {};
+  }
+  m_frame_readback_position = 0;
+  m_frame_readback_count = 0;
+
+  m_frame_texture.Destroy();
+  OpenGLHostDisplay::DestroyResources();
+}
+
+bool OpenGLHeadlessHostDisplay::CreateImGuiContext()
+{
+  // There's nowhere to show the OSD.
+  return true;
+}
+
+void OpenGLHeadlessHostDisplay::DestroyImGuiContext() {}
+
+bool OpenGLHeadlessHostDisplay::ChangeRenderWindow(const WindowInfo& new_wi)
+{
+  if (new_wi.type != WindowInfo::Type::Surfaceless)
+  {
+    Log_ErrorPrintf("Headless display can't render to a window");
+    return false;
+  }
+
+  m_window_info.surface_width = new_wi.surface_width;
+  m_window_info.surface_height = new_wi.surface_height;
+  return true;
+}
+
+void OpenGLHeadlessHostDisplay::ResizeRenderWindow(s32 new_window_width, s32 new_window_height)
+{
+  m_window_info.surface_width = static_cast<u32>(std::max(new_window_width, 0));
+  m_window_info.surface_height = static_cast<u32>(std::max(new_window_height, 0));
+}
+
+bool OpenGLHeadlessHostDisplay::Render()
+{
+  if (ShouldSkipDisplayingFrame())
+    return false;
+
+  // Without a fixed size, frames match the size of the display texture, i.e. the internal resolution. The view
+  // height is negative when the texture is stored bottom-up.
+  const u32 width = (m_window_info.surface_width > 0) ? m_window_info.surface_width :
+                                                        static_cast<u32>(std::abs(m_display_texture_view_width));
+  const u32 height = (m_window_info.surface_height > 0) ? m_window_info.surface_height :
+                                                          static_cast<u32>(std::abs(m_display_texture_view_height));
+  if (width == 0 || height == 0 || !CheckFrameTexture(width, height))
+    return false;
+
+  m_frame_texture.BindFramebuffer(GL_FRAMEBUFFER);
+  glDisable(GL_SCISSOR_TEST);
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  if (HasDisplayTexture())
+  {
+    const auto [left, top, draw_width, draw_height] =
+      CalculateDrawRect(static_cast<s32>(width), static_cast<s32>(height), 0, false);
+    RenderDisplay(left, static_cast<s32>(height) - top - draw_height, draw_width, draw_height,
+                  m_display_texture_handle, m_display_texture_width, m_display_texture_height,
+                  m_display_texture_view_x, m_display_texture_view_y, m_display_texture_view_width,
+                  m_display_texture_view_height, m_display_linear_filtering);
+  }
+
+  m_frame_count++;
+  if (m_frame_callback)
+  {
+    if (m_use_async_readback)
+      QueueFrameReadback(width, height);
+    else
+      ReadFrameSynchronously(width, height);
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  GL::Program::ResetLastProgram();
+
+  // hand completed frames over without waiting for the GPU
+  while (m_frame_readback_count > 0)
+  {
+    const GLenum result = glClientWaitSync(m_frame_readbacks[m_frame_readback_position].fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+      break;
+
+    CompleteFrameReadback(false);
+  }
+
+  return true;
+}
+
+void OpenGLHeadlessHostDisplay::FlushFrameReadbacks()
+{
+  while (m_frame_readback_count > 0)
+    CompleteFrameReadback(true);
+}
+
+bool OpenGLHeadlessHostDisplay::CheckFrameTexture(u32 width, u32 height)
+{
+  if (m_frame_texture.GetWidth() == width && m_frame_texture.GetHeight() == height)
+    return true;
+
+  if (!m_frame_texture.Create(width, height, 1, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE) ||
+      !m_frame_texture.CreateFramebuffer())
+  {
+    Log_ErrorPrintf("Failed to create %ux%u frame texture", width, height);
+    m_frame_texture.Destroy();
+    return false;
+  }
+
+  return true;
+}
+
+void OpenGLHeadlessHostDisplay::QueueFrameReadback(u32 width, u32 height)
+{
+  // all buffers are in flight, so the oldest has to be waited for
+  if (m_frame_readback_count == NUM_FRAME_READBACKS)
+    CompleteFrameReadback(true);
+
+  FrameReadback& rb = m_frame_readbacks[(m_frame_readback_position + m_frame_readback_count) % NUM_FRAME_READBACKS];
+  const u32 size = width * height * sizeof(u32);
+  if (rb.buffer_id == 0)
+    glGenBuffers(1, &rb.buffer_id);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.buffer_id);
+  if (rb.buffer_size < size)
+  {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    rb.buffer_size = size;
+  }
+
+  GLint old_alignment = 0, old_row_length = 0;
+  glGetIntegerv(GL_PACK_ALIGNMENT, &old_alignment);
+  glGetIntegerv(GL_PACK_ROW_LENGTH, &old_row_length);
+  glPixelStorei(GL_PACK_ALIGNMENT, sizeof(u32));
+  glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+  glPixelStorei(GL_PACK_ALIGNMENT, old_alignment);
+  glPixelStorei(GL_PACK_ROW_LENGTH, old_row_length);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  // flush so the fence actually gets signaled if nothing else is submitted
+  rb.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+
+  rb.frame_number = m_frame_count;
+  rb.width = width;
+  rb.height = height;
+  m_frame_readback_count++;
+}
+
+void OpenGLHeadlessHostDisplay::CompleteFrameReadback(bool wait)
+{
+  DebugAssert(m_frame_readback_count > 0);
+  FrameReadback& rb = m_frame_readbacks[m_frame_readback_position];
+  m_frame_readback_position = (m_frame_readback_position + 1) % NUM_FRAME_READBACKS;
+  m_frame_readback_count--;
+
+  if (wait)
+  {
+    while (glClientWaitSync(rb.fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_C(1000000000)) == GL_TIMEOUT_EXPIRED)
+      Log_WarningPrintf("Still waiting for frame %u readback", rb.frame_number);
+  }
+
+  glDeleteSync(rb.fence);
+  rb.fence = nullptr;
+
+  const u32 stride = rb.width * sizeof(u32);
+  const u32 size = stride * rb.height;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.buffer_id);
+  const u8* mapped = static_cast<const u8*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+  if (!mapped)
+  {
+    Log_ErrorPrintf("Failed to map readback buffer for frame %u", rb.frame_number);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return;
+  }
+
+  // GL framebuffers are bottom-up
+  m_frame_pixels.resize(size);
+  for (u32 row = 0; row < rb.height; row++)
+    std::memcpy(&m_frame_pixels[row * stride], mapped + (rb.height - row - 1) * stride, stride);
+
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  if (m_frame_callback)
+    m_frame_callback(rb.frame_number, rb.width, rb.height, m_frame_pixels.data(), stride);
+}
+
+void OpenGLHeadlessHostDisplay::ReadFrameSynchronously(u32 width, u32 height)
+{
+  const u32 stride = width * sizeof(u32);
+  std::vector<u8> pixels(stride * height);
+  glPixelStorei(GL_PACK_ALIGNMENT, sizeof(u32));
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+  m_frame_pixels.resize(pixels.size());
+  for (u32 row = 0; row < height; row++)
+    std::memcpy(&m_frame_pixels[row * stride], &pixels[(height - row - 1) * stride], stride);
+
+  m_frame_callback(m_frame_count, width, height, m_frame_pixels.data(), stride);
+}
+
+} // namespace FrontendCommon
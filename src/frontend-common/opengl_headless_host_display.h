@@ -0,0 +1,77 @@
+#pragma once
+#include "opengl_host_display.h"
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace FrontendCommon {
+
+// Display which renders to an offscreen framebuffer instead of a window, for running without a window system.
+// Frames are read back asynchronously, and handed to the frame callback once the GPU has finished with them.
+class OpenGLHeadlessHostDisplay final : public OpenGLHostDisplay
+{
+public:
+  /// Receives the RGBA8 pixels of a frame, top row first.
+  using FrameCallback = std::function<void(u32 frame_number, u32 width, u32 height, const void* pixels, u32 stride)>;
+
+  OpenGLHeadlessHostDisplay();
+  ~OpenGLHeadlessHostDisplay();
+
+  ALWAYS_INLINE u32 GetFrameCount() const { return m_frame_count; }
+
+  /// Sets the callback for completed frames. Frames are not read back without a callback.
+  void SetFrameCallback(FrameCallback callback);
+
+  /// Waits for all frames which have not been read back yet, and passes them to the callback.
+  void FlushFrameReadbacks();
+
+  bool CreateRenderDevice(const WindowInfo& wi, std::string_view adapter_name, bool debug_device) override;
+  void DestroyRenderDevice() override;
+
+  bool ChangeRenderWindow(const WindowInfo& new_wi) override;
+  void ResizeRenderWindow(s32 new_window_width, s32 new_window_height) override;
+
+  bool Render() override;
+
+protected:
+  void DestroyResources() override;
+
+  bool CreateImGuiContext() override;
+  void DestroyImGuiContext() override;
+
+private:
+  enum : u32
+  {
+    NUM_FRAME_READBACKS = 3
+  };
+
+  struct FrameReadback
+  {
+    GLuint buffer_id = 0;
+    u32 buffer_size = 0;
+    GLsync fence = nullptr;
+    u32 frame_number = 0;
+    u32 width = 0;
+    u32 height = 0;
+  };
+
+  bool CheckFrameTexture(u32 width, u32 height);
+  void QueueFrameReadback(u32 width, u32 height);
+  void CompleteFrameReadback(bool wait);
+  void ReadFrameSynchronously(u32 width, u32 height);
+
+  FrameCallback m_frame_callback;
+
+  GL::Texture m_frame_texture;
+  std::vector<u8> m_frame_pixels;
+
+  // Readbacks are completed in the order they were queued.
+  std::array<FrameReadback, NUM_FRAME_READBACKS> m_frame_readbacks;
+  u32 m_frame_readback_position = 0;
+  u32 m_frame_readback_count = 0;
+  bool m_use_async_readback = false;
+
+  u32 m_frame_count = 0;
+};
+
+} // namespace FrontendCommon
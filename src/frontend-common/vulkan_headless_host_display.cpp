@@ -0,0 +1,224 @@
+#include "vulkan_headless_host_display.h"
+#include "common/assert.h"
+#include "common/log.h"
+#include "common/vulkan/builders.h"
+#include "common/vulkan/context.h"
+#include "common/vulkan/util.h"
+#include <algorithm>
+Log_SetChannel(VulkanHeadlessHostDisplay);
+
+namespace FrontendCommon {
+
+VulkanHeadlessHostDisplay::VulkanHeadlessHostDisplay() = default;
+
+VulkanHeadlessHostDisplay::~VulkanHeadlessHostDisplay() = default;
+
+void VulkanHeadlessHostDisplay::SetFrameCallback(FrameCallback callback)
+{
+  m_frame_callback = std::move(callback);
+}
+
+bool VulkanHeadlessHostDisplay::CreateRenderDevice(const WindowInfo& wi, std::string_view adapter_name,
+                                                   bool debug_device)
+{
+  // No surface means no swap chain gets created.
+  Assert(wi.type == WindowInfo::Type::Surfaceless);
+  return VulkanHostDisplay::CreateRenderDevice(wi, adapter_name, debug_device);
+}
+
+void VulkanHeadlessHostDisplay::DestroyRenderDevice()
+{
+  VulkanHostDisplay::DestroyRenderDevice();
+  m_frame_callback = {};
+}
+
+bool VulkanHeadlessHostDisplay::CreateResources()
+{
+  m_frame_render_pass =
+    g_vulkan_context->GetRenderPass(FRAME_FORMAT, VK_FORMAT_UNDEFINED, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR);
+  if (m_frame_render_pass == VK_NULL_HANDLE)
+    return false;
+
+  return VulkanHostDisplay::CreateResources();
+}
+
+void VulkanHeadlessHostDisplay::DestroyResources()
+{
+  // frames which haven't completed are dropped, FlushFrameReadbacks() should be called first if they're needed
+  for (FrameReadback& rb : m_frame_readbacks)
+    rb.staging_texture.Destroy(false);
+  m_frame_readback_position = 0;
+  m_frame_readback_count = 0;
+
+  VulkanHostDisplay::DestroyResources();
+  Vulkan::Util::SafeDestroyFramebuffer(m_frame_framebuffer);
+  m_frame_texture.Destroy(false);
+}
+
+VkRenderPass VulkanHeadlessHostDisplay::GetRenderPassForDisplay() const
+{
+  return m_frame_render_pass;
+}
+
+bool VulkanHeadlessHostDisplay::CreateImGuiContext()
+{
+  // There's nowhere to show the OSD.
+  return true;
+}
+
+void VulkanHeadlessHostDisplay::DestroyImGuiContext() {}
+
+bool VulkanHeadlessHostDisplay::ChangeRenderWindow(const WindowInfo& new_wi)
+{
+  if (new_wi.type != WindowInfo::Type::Surfaceless)
+  {
+    Log_ErrorPrintf("Headless display can't render to a window");
+    return false;
+  }
+
+  m_window_info.surface_width = new_wi.surface_width;
+  m_window_info.surface_height = new_wi.surface_height;
+  return true;
+}
+
+void VulkanHeadlessHostDisplay::ResizeRenderWindow(s32 new_window_width, s32 new_window_height)
+{
+  m_window_info.surface_width = static_cast<u32>(std::max(new_window_width, 0));
+  m_window_info.surface_height = static_cast<u32>(std::max(new_window_height, 0));
+}
+
+bool VulkanHeadlessHostDisplay::Render()
+{
+  if (ShouldSkipDisplayingFrame())
+    return false;
+
+  // Without a fixed size, frames match the size of the display texture, i.e. the internal resolution.
+  const u32 width = (m_window_info.surface_width > 0) ? m_window_info.surface_width :
+                                                        static_cast<u32>(m_display_texture_view_width);
+  const u32 height = (m_window_info.surface_height > 0) ? m_window_info.surface_height :
+                                                          static_cast<u32>(m_display_texture_view_height);
+  if (width == 0 || height == 0 || !CheckFrameTexture(width, height))
+    return false;
+
+  VkCommandBuffer cmdbuffer = g_vulkan_context->GetCurrentCommandBuffer();
+  m_frame_texture.TransitionToLayout(cmdbuffer, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+  const VkClearValue clear_value = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+  const VkRenderPassBeginInfo rp = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                                    nullptr,
+                                    m_frame_render_pass,
+                                    m_frame_framebuffer,
+                                    {{0, 0}, {width, height}},
+                                    1u,
+                                    &clear_value};
+  vkCmdBeginRenderPass(cmdbuffer, &rp, VK_SUBPASS_CONTENTS_INLINE);
+
+  if (HasDisplayTexture())
+  {
+    const auto [left, top, draw_width, draw_height] =
+      CalculateDrawRect(static_cast<s32>(width), static_cast<s32>(height), 0, false);
+    RenderDisplay(left, top, draw_width, draw_height, m_display_texture_handle, m_display_texture_width,
+                  m_display_texture_height, m_display_texture_view_x, m_display_texture_view_y,
+                  m_display_texture_view_width, m_display_texture_view_height, m_display_linear_filtering);
+  }
+
+  vkCmdEndRenderPass(cmdbuffer);
+
+  m_frame_count++;
+  if (m_frame_callback)
+    QueueFrameReadback(width, height);
+
+  m_frame_texture.TransitionToLayout(cmdbuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+  g_vulkan_context->SubmitCommandBuffer();
+  g_vulkan_context->MoveToNextCommandBuffer();
+
+  // hand completed frames over without waiting for the GPU
+  while (m_frame_readback_count > 0 && g_vulkan_context->GetCompletedFenceCounter() >=
+                                         m_frame_readbacks[m_frame_readback_position].fence_counter)
+  {
+    CompleteFrameReadback();
+  }
+
+  return true;
+}
+
+void VulkanHeadlessHostDisplay::FlushFrameReadbacks()
+{
+  while (m_frame_readback_count > 0)
+    CompleteFrameReadback();
+}
+
+bool VulkanHeadlessHostDisplay::CheckFrameTexture(u32 width, u32 height)
+{
+  static constexpr VkImageUsageFlags usage =
+    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+  if (m_frame_texture.GetWidth() == width && m_frame_texture.GetHeight() == height)
+    return true;
+
+  g_vulkan_context->DeferFramebufferDestruction(m_frame_framebuffer);
+  m_frame_framebuffer = VK_NULL_HANDLE;
+  m_frame_texture.Destroy(true);
+
+  if (!m_frame_texture.Create(width, height, 1, 1, FRAME_FORMAT, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_VIEW_TYPE_2D,
+                              VK_IMAGE_TILING_OPTIMAL, usage))
+  {
+    Log_ErrorPrintf("Failed to create %ux%u frame texture", width, height);
+    return false;
+  }
+
+  Vulkan::FramebufferBuilder fbb;
+  fbb.SetRenderPass(m_frame_render_pass);
+  fbb.AddAttachment(m_frame_texture.GetView());
+  fbb.SetSize(width, height, 1);
+  m_frame_framebuffer = fbb.Create(g_vulkan_context->GetDevice(), false);
+  if (m_frame_framebuffer == VK_NULL_HANDLE)
+  {
+    m_frame_texture.Destroy(false);
+    return false;
+  }
+
+  return true;
+}
+
+void VulkanHeadlessHostDisplay::QueueFrameReadback(u32 width, u32 height)
+{
+  // all buffers are in flight, so the oldest has to be waited for
+  if (m_frame_readback_count == NUM_FRAME_READBACKS)
+    CompleteFrameReadback();
+
+  FrameReadback& rb = m_frame_readbacks[(m_frame_readback_position + m_frame_readback_count) % NUM_FRAME_READBACKS];
+  if ((rb.staging_texture.GetWidth() < width || rb.staging_texture.GetHeight() < height) &&
+      !rb.staging_texture.Create(Vulkan::StagingBuffer::Type::Readback, FRAME_FORMAT, width, height))
+  {
+    Log_ErrorPrintf("Failed to create %ux%u readback texture", width, height);
+    return;
+  }
+
+  // the copy completes when the current command buffer does
+  rb.staging_texture.CopyFromTexture(m_frame_texture, 0, 0, 0, 0, 0, 0, width, height);
+  rb.fence_counter = g_vulkan_context->GetCurrentFenceCounter();
+  rb.frame_number = m_frame_count;
+  rb.width = width;
+  rb.height = height;
+  m_frame_readback_count++;
+}
+
+void VulkanHeadlessHostDisplay::CompleteFrameReadback()
+{
+  DebugAssert(m_frame_readback_count > 0);
+  FrameReadback& rb = m_frame_readbacks[m_frame_readback_position];
+  m_frame_readback_position = (m_frame_readback_position + 1) % NUM_FRAME_READBACKS;
+  m_frame_readback_count--;
+
+  // waits for the fence if the GPU hasn't finished with it yet
+  const u32 stride = rb.width * sizeof(u32);
+  m_frame_pixels.resize(stride * rb.height);
+  rb.staging_texture.ReadTexels(0, 0, rb.width, rb.height, m_frame_pixels.data(), stride);
+
+  if (m_frame_callback)
+    m_frame_callback(rb.frame_number, rb.width, rb.height, m_frame_pixels.data(), stride);
+}
+
+} // namespace FrontendCommon
@@ -0,0 +1,80 @@
+#pragma once
+#include "vulkan_host_display.h"
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace FrontendCommon {
+
+// Display which renders to an offscreen framebuffer instead of a window, for running without a window system.
+// Frames are read back asynchronously, and handed to the frame callback once the GPU has finished with them.
+class VulkanHeadlessHostDisplay final : public VulkanHostDisplay
+{
+public:
+  /// Receives the RGBA8 pixels of a frame, top row first.
+  using FrameCallback = std::function<void(u32 frame_number, u32 width, u32 height, const void* pixels, u32 stride)>;
+
+  VulkanHeadlessHostDisplay();
+  ~VulkanHeadlessHostDisplay();
+
+  ALWAYS_INLINE u32 GetFrameCount() const { return m_frame_count; }
+
+  /// Sets the callback for completed frames. Frames are not read back without a callback.
+  void SetFrameCallback(FrameCallback callback);
+
+  /// Waits for all frames which have not been read back yet, and passes them to the callback.
+  void FlushFrameReadbacks();
+
+  bool CreateRenderDevice(const WindowInfo& wi, std::string_view adapter_name, bool debug_device) override;
+  void DestroyRenderDevice() override;
+
+  bool ChangeRenderWindow(const WindowInfo& new_wi) override;
+  void ResizeRenderWindow(s32 new_window_width, s32 new_window_height) override;
+
+  bool Render() override;
+
+protected:
+  bool CreateResources() override;
+  void DestroyResources() override;
+  VkRenderPass GetRenderPassForDisplay() const override;
+
+  bool CreateImGuiContext() override;
+  void DestroyImGuiContext() override;
+
+private:
+  enum : u32
+  {
+    NUM_FRAME_READBACKS = 3
+  };
+
+  static constexpr VkFormat FRAME_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+  struct FrameReadback
+  {
+    Vulkan::StagingTexture staging_texture;
+    u64 fence_counter = 0;
+    u32 frame_number = 0;
+    u32 width = 0;
+    u32 height = 0;
+  };
+
+  bool CheckFrameTexture(u32 width, u32 height);
+  void QueueFrameReadback(u32 width, u32 height);
+  void CompleteFrameReadback();
+
+  FrameCallback m_frame_callback;
+
+  Vulkan::Texture m_frame_texture;
+  VkFramebuffer m_frame_framebuffer = VK_NULL_HANDLE;
+  VkRenderPass m_frame_render_pass = VK_NULL_HANDLE;
+  std::vector<u8> m_frame_pixels;
+
+  // Readbacks are completed in the order they were queued.
+  std::array<FrameReadback, NUM_FRAME_READBACKS> m_frame_readbacks;
+  u32 m_frame_readback_position = 0;
+  u32 m_frame_readback_count = 0;
+
+  u32 m_frame_count = 0;
+};
+
+} // namespace FrontendCommon